@@ -0,0 +1,668 @@
+// Throughput of every message and method codec over a fixed corpus of
+// payload shapes, for encoding and decoding.
+//
+// Encoders write into a vector reused across iterations and decoders into an
+// arena reset between them, as a channel with pooled buffers would, so the
+// allocation counts show what a codec allocates beyond that.
+//
+// Usage: codec_benchmark [--json] [--filter=SUBSTRING] [--min-time-ms=N]
+//
+// --json prints one JSON object per line instead of a table. --filter keeps
+// the cases whose "codec/payload/op" name contains SUBSTRING.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "codec/arena.h"
+#include "codec/binary_codec.h"
+#include "codec/dedup_codec.h"
+#include "codec/extension_registry.h"
+#include "codec/json_message_codec.h"
+#include "codec/json_method_codec.h"
+#include "codec/method_call.h"
+#include "codec/standard_message_codec.h"
+#include "codec/standard_method_codec.h"
+#include "codec/string_codec.h"
+#include "codec/tensor.h"
+#include "codec/value.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::atomic<uint64_t> g_allocations{0};
+
+}  // namespace
+
+// Counts every allocation, including those of operator new and the arena,
+// by interposing the allocator entry points.
+#if defined(__GLIBC__)
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* pointer, size_t size);
+
+void* malloc(size_t size) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  return __libc_calloc(count, size);
+}
+
+void* realloc(void* pointer, size_t size) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  return __libc_realloc(pointer, size);
+}
+}
+#endif
+
+namespace {
+
+using platzi::Arena;
+using platzi::MapEntry;
+using platzi::MethodCall;
+using platzi::MethodError;
+using platzi::StandardField;
+using platzi::TensorView;
+using platzi::TypedDataView;
+using platzi::Value;
+using platzi::ValueType;
+
+struct Options {
+  bool json = false;
+  std::string filter;
+  int min_time_ms = 200;
+};
+
+struct Result {
+  double ns_per_op;
+  double allocations_per_op;
+};
+
+template <typename Function>
+Result Measure(int min_time_ms, Function function) {
+  // Warm up caches, pooled buffers and the arena.
+  for (int i = 0; i < 3; i++) {
+    function();
+  }
+  uint64_t allocations = g_allocations.load(std::memory_order_relaxed);
+  size_t iterations = 0;
+  Clock::time_point start = Clock::now();
+  Clock::duration elapsed;
+  do {
+    function();
+    iterations++;
+    elapsed = Clock::now() - start;
+  } while (elapsed < std::chrono::milliseconds(min_time_ms));
+  allocations = g_allocations.load(std::memory_order_relaxed) - allocations;
+  double ns = std::chrono::duration<double, std::nano>(elapsed).count();
+  return {ns / iterations, static_cast<double>(allocations) / iterations};
+}
+
+class Reporter {
+ public:
+  explicit Reporter(const Options& options) : options_(options) {}
+
+  // Runs |function| as the case codec/payload/op, which processes |bytes|
+  // of encoded message per call, unless the filter excludes it.
+  void Run(const char* codec,
+           const char* payload,
+           const char* op,
+           size_t bytes,
+           const std::function<void()>& function) {
+    std::string name = std::string(codec) + "/" + payload + "/" + op;
+    if (name.find(options_.filter) == std::string::npos) {
+      return;
+    }
+    if (!header_printed_ && !options_.json) {
+      std::printf("%-42s %10s %12s %10s %10s\n", "case", "bytes", "ns/op",
+                  "MB/s", "allocs/op");
+      header_printed_ = true;
+    }
+    Result result = Measure(options_.min_time_ms, function);
+    double mb_per_s = bytes / result.ns_per_op * 1e3;
+    if (options_.json) {
+      std::printf(
+          "{\"codec\":\"%s\",\"payload\":\"%s\",\"op\":\"%s\","
+          "\"bytes\":%zu,\"ns_per_op\":%.1f,\"mb_per_s\":%.1f,"
+          "\"allocs_per_op\":%.2f}\n",
+          codec, payload, op, bytes, result.ns_per_op, mb_per_s,
+          result.allocations_per_op);
+    } else {
+      std::printf("%-42s %10zu %12.1f %10.1f %10.2f\n", name.c_str(), bytes,
+                  result.ns_per_op, mb_per_s, result.allocations_per_op);
+    }
+    std::fflush(stdout);
+  }
+
+ private:
+  const Options& options_;
+  bool header_printed_ = false;
+};
+
+// Payloads and the strings they point to live for the whole run.
+struct Corpus {
+  Arena arena{1 << 20};
+  std::vector<double> doubles;
+  std::vector<int64_t> timestamps;
+  std::vector<uint8_t> image;
+
+  std::string_view Intern(std::string string) {
+    return arena.CopyString(string);
+  }
+
+  Value* List(size_t size) { return arena.NewArray<Value>(size); }
+  MapEntry* Map(size_t size) { return arena.NewArray<MapEntry>(size); }
+};
+
+// 32 entries of mixed scalars and short strings, like a settings snapshot or
+// a telemetry sample.
+Value MakeFlatMap(Corpus* corpus, size_t size = 32) {
+  MapEntry* entries = corpus->Map(size);
+  for (size_t i = 0; i < size; i++) {
+    char key[16];
+    std::snprintf(key, sizeof(key), "field_%02zu", i);
+    entries[i].key = Value::String(corpus->Intern(key));
+    switch (i % 4) {
+      case 0:
+        entries[i].value = Value::Int32(static_cast<int32_t>(i * 1000));
+        break;
+      case 1:
+        entries[i].value = Value::Float64(i * 0.125 + 3.5);
+        break;
+      case 2:
+        entries[i].value =
+            Value::String(corpus->Intern("value-" + std::to_string(i)));
+        break;
+      default:
+        entries[i].value = Value::Bool(i % 8 == 3);
+        break;
+    }
+  }
+  return Value::Map(entries, size);
+}
+
+// Maps and lists alternating 64 levels deep, each with a scalar beside the
+// nested container.
+Value MakeDeepNesting(Corpus* corpus) {
+  Value value = Value::Int32(0);
+  for (int depth = 64; depth > 0; depth--) {
+    if (depth % 2 == 0) {
+      MapEntry* entries = corpus->Map(2);
+      entries[0].key = Value::String("depth");
+      entries[0].value = Value::Int32(depth);
+      entries[1].key = Value::String("child");
+      entries[1].value = value;
+      value = Value::Map(entries, 2);
+    } else {
+      Value* items = corpus->List(2);
+      items[0] = Value::String("level");
+      items[1] = value;
+      value = Value::List(items, 2);
+    }
+  }
+  return value;
+}
+
+// 64K doubles, 512 KB: a sensor trace or a polyline. JSON cannot represent
+// typed data, so its codecs get the same numbers as a list.
+Value MakeTypedList(Corpus* corpus, bool as_list) {
+  constexpr size_t kCount = 65536;
+  auto element = [](size_t i) { return i * 0.001 + 0.5; };
+  if (as_list) {
+    Value* items = corpus->List(kCount);
+    for (size_t i = 0; i < kCount; i++) {
+      items[i] = Value::Float64(element(i));
+    }
+    return Value::List(items, kCount);
+  }
+  corpus->doubles.resize(kCount);
+  for (size_t i = 0; i < kCount; i++) {
+    corpus->doubles[i] = element(i);
+  }
+  TypedDataView view;
+  view.type = StandardField::kFloat64Data;
+  view.bytes = reinterpret_cast<const uint8_t*>(corpus->doubles.data());
+  view.element_count = kCount;
+  view.element_size = 8;
+  return Value::TypedData(view);
+}
+
+// 64K microsecond timestamps about a millisecond apart, as an Int64 list
+// and packed as an Int64DeltaData list.
+Value MakeTimestamps(Corpus* corpus, StandardField type) {
+  constexpr size_t kCount = 65536;
+  if (corpus->timestamps.empty()) {
+    int64_t timestamp = 1700000000000000;
+    for (size_t i = 0; i < kCount; i++) {
+      timestamp += 1000 + static_cast<int64_t>(i * 7919 % 41) - 20;
+      corpus->timestamps.push_back(timestamp);
+    }
+  }
+  TypedDataView view = TypedDataView::Of(corpus->timestamps.data(), kCount);
+  view.type = type;
+  return Value::TypedData(view);
+}
+
+// 4096 strings of 3 to 14 bytes, like identifiers or tags.
+Value MakeShortStrings(Corpus* corpus) {
+  constexpr size_t kCount = 4096;
+  Value* items = corpus->List(kCount);
+  for (size_t i = 0; i < kCount; i++) {
+    std::string string = "tag" + std::to_string(i * 7919 % 100000);
+    string.resize(3 + i % 12, 'x');
+    items[i] = Value::String(corpus->Intern(string));
+  }
+  return Value::List(items, kCount);
+}
+
+// 256 search results, each with its own copy of the same place
+// description.
+Value MakePlaces(Corpus* corpus) {
+  constexpr size_t kCount = 256;
+  const char* const keys[] = {"name", "address", "city", "country", "hours"};
+  const char* const values[] = {"Cafe Central", "Herrengasse 14", "Vienna",
+                                "Austria", "Mo-Sa 08:00-21:00"};
+  Value* items = corpus->List(kCount);
+  for (size_t i = 0; i < kCount; i++) {
+    MapEntry* place = corpus->Map(5);
+    for (size_t j = 0; j < 5; j++) {
+      place[j].key = Value::String(corpus->Intern(keys[j]));
+      place[j].value = Value::String(corpus->Intern(values[j]));
+    }
+    MapEntry* result = corpus->Map(3);
+    result[0].key = Value::String("id");
+    result[0].value = Value::Int32(static_cast<int32_t>(i));
+    result[1].key = Value::String("score");
+    result[1].value = Value::Float64(1.0 / (i + 1));
+    result[2].key = Value::String("place");
+    result[2].value = Value::Map(place, 5);
+    items[i] = Value::Map(result, 3);
+  }
+  return Value::List(items, kCount);
+}
+
+// The central 112x112 crop of a 224x224 RGB image, as a strided tensor view
+// of the whole image, like the input of an on-device vision model.
+Value MakeImageCrop(Corpus* corpus) {
+  constexpr uint32_t kSide = 224;
+  constexpr uint32_t kCrop = 112;
+  corpus->image.resize(kSide * kSide * 3);
+  for (size_t i = 0; i < corpus->image.size(); i++) {
+    corpus->image[i] = static_cast<uint8_t>(i * 7919 >> 4);
+  }
+  uint32_t* shape = corpus->arena.NewArray<uint32_t>(3);
+  shape[0] = kCrop;
+  shape[1] = kCrop;
+  shape[2] = 3;
+  int64_t* strides = corpus->arena.NewArray<int64_t>(3);
+  strides[0] = kSide * 3;
+  strides[1] = 3;
+  strides[2] = 1;
+  size_t origin = ((kSide - kCrop) / 2 * kSide + (kSide - kCrop) / 2) * 3;
+  TensorView* crop = corpus->arena.New<TensorView>(
+      TensorView::Of(corpus->image.data() + origin, shape, 3));
+  crop->strides = strides;
+  return Value::Tensor(crop);
+}
+
+struct Payload {
+  const char* name;
+  Value value;
+};
+
+void RunMessageCodecs(Corpus* corpus, Reporter* reporter) {
+  Payload standard_payloads[] = {
+      {"flat_map", MakeFlatMap(corpus)},
+      {"deep_nesting", MakeDeepNesting(corpus)},
+      {"typed_list", MakeTypedList(corpus, false)},
+      {"short_strings", MakeShortStrings(corpus)},
+      {"timestamps", MakeTimestamps(corpus, StandardField::kInt64Data)},
+      {"packed_timestamps",
+       MakeTimestamps(corpus, StandardField::kInt64DeltaData)},
+      {"places", MakePlaces(corpus)},
+      {"image_crop", MakeImageCrop(corpus)},
+  };
+  Payload json_payloads[] = {
+      standard_payloads[0],
+      standard_payloads[1],
+      {"typed_list", MakeTypedList(corpus, true)},
+      standard_payloads[3],
+  };
+
+  std::vector<uint8_t> encoded;
+  Arena arena;
+  volatile size_t sink = 0;
+
+  for (const Payload& payload : standard_payloads) {
+    platzi::StandardMessageCodec::EncodeMessage(payload.value, &encoded);
+    reporter->Run("standard_message", payload.name, "encode", encoded.size(),
+                  [&] {
+                    sink = platzi::StandardMessageCodec::EncodeMessage(
+                        payload.value, &encoded);
+                  });
+    std::vector<uint8_t> message = encoded;
+    reporter->Run("standard_message", payload.name, "decode", message.size(),
+                  [&] {
+                    arena.Reset();
+                    sink = platzi::StandardMessageCodec::DecodeMessage(
+                               message.data(), message.size(), &arena) !=
+                           nullptr;
+                  });
+  }
+
+  const Payload& places = standard_payloads[6];
+  platzi::DedupMessageCodec::EncodeMessage(places.value, &encoded);
+  reporter->Run("dedup_message", places.name, "encode", encoded.size(), [&] {
+    sink = platzi::DedupMessageCodec::EncodeMessage(places.value, &encoded);
+  });
+  std::vector<uint8_t> deduped = encoded;
+  reporter->Run("dedup_message", places.name, "decode", deduped.size(), [&] {
+    arena.Reset();
+    sink = platzi::DedupMessageCodec::DecodeMessage(
+               deduped.data(), deduped.size(), &arena) != nullptr;
+  });
+
+  for (const Payload& payload : json_payloads) {
+    platzi::JsonMessageCodec::EncodeMessage(payload.value, &encoded);
+    reporter->Run("json_message", payload.name, "encode", encoded.size(), [&] {
+      sink = platzi::JsonMessageCodec::EncodeMessage(payload.value, &encoded);
+    });
+    std::vector<uint8_t> message = encoded;
+    reporter->Run("json_message", payload.name, "decode", message.size(), [&] {
+      arena.Reset();
+      sink = platzi::JsonMessageCodec::DecodeMessage(
+                 message.data(), message.size(), &arena) != nullptr;
+    });
+  }
+}
+
+void RunMethodCodecs(Corpus* corpus, Reporter* reporter) {
+  MethodCall call{"updateLocation", MakeFlatMap(corpus, 8)};
+  Value result = MakeFlatMap(corpus, 8);
+  MethodError error{"UNAVAILABLE",
+                    Value::String("Location services are disabled"),
+                    MakeFlatMap(corpus, 4)};
+
+  std::vector<uint8_t> encoded;
+  Arena arena;
+  volatile size_t sink = 0;
+
+  using platzi::JsonMethodCodec;
+  using platzi::StandardMethodCodec;
+
+  // Method calls.
+  StandardMethodCodec::EncodeMethodCall(call, &encoded);
+  reporter->Run("standard_method", "method_call", "encode", encoded.size(),
+                [&] {
+                  sink = StandardMethodCodec::EncodeMethodCall(call, &encoded);
+                });
+  std::vector<uint8_t> message = encoded;
+  reporter->Run("standard_method", "method_call", "decode", message.size(),
+                [&] {
+                  arena.Reset();
+                  MethodCall decoded;
+                  sink = StandardMethodCodec::DecodeMethodCall(
+                      message.data(), message.size(), &arena, &decoded);
+                });
+  JsonMethodCodec::EncodeMethodCall(call, &encoded);
+  reporter->Run("json_method", "method_call", "encode", encoded.size(), [&] {
+    sink = JsonMethodCodec::EncodeMethodCall(call, &encoded);
+  });
+  message = encoded;
+  reporter->Run("json_method", "method_call", "decode", message.size(), [&] {
+    arena.Reset();
+    MethodCall decoded;
+    sink = JsonMethodCodec::DecodeMethodCall(message.data(), message.size(),
+                                             &arena, &decoded);
+  });
+
+  // Result envelopes.
+  StandardMethodCodec::EncodeSuccessEnvelope(result, &encoded);
+  reporter->Run("standard_method", "success_envelope", "encode",
+                encoded.size(), [&] {
+                  sink = StandardMethodCodec::EncodeSuccessEnvelope(result,
+                                                                    &encoded);
+                });
+  message = encoded;
+  reporter->Run("standard_method", "success_envelope", "decode",
+                message.size(), [&] {
+                  arena.Reset();
+                  platzi::Envelope envelope;
+                  sink = StandardMethodCodec::DecodeEnvelope(
+                      message.data(), message.size(), &arena, &envelope);
+                });
+  JsonMethodCodec::EncodeSuccessEnvelope(result, &encoded);
+  reporter->Run("json_method", "success_envelope", "encode", encoded.size(),
+                [&] {
+                  sink = JsonMethodCodec::EncodeSuccessEnvelope(result,
+                                                                &encoded);
+                });
+  message = encoded;
+  reporter->Run("json_method", "success_envelope", "decode", message.size(),
+                [&] {
+                  arena.Reset();
+                  platzi::Envelope envelope;
+                  sink = JsonMethodCodec::DecodeEnvelope(
+                      message.data(), message.size(), &arena, &envelope);
+                });
+
+  // Error envelopes.
+  StandardMethodCodec::EncodeErrorEnvelope(error, &encoded);
+  reporter->Run("standard_method", "error_envelope", "encode", encoded.size(),
+                [&] {
+                  sink = StandardMethodCodec::EncodeErrorEnvelope(error,
+                                                                  &encoded);
+                });
+  message = encoded;
+  reporter->Run("standard_method", "error_envelope", "decode", message.size(),
+                [&] {
+                  arena.Reset();
+                  platzi::Envelope envelope;
+                  sink = StandardMethodCodec::DecodeEnvelope(
+                      message.data(), message.size(), &arena, &envelope);
+                });
+  JsonMethodCodec::EncodeErrorEnvelope(error, &encoded);
+  reporter->Run("json_method", "error_envelope", "encode", encoded.size(),
+                [&] {
+                  sink = JsonMethodCodec::EncodeErrorEnvelope(error, &encoded);
+                });
+  message = encoded;
+  reporter->Run("json_method", "error_envelope", "decode", message.size(),
+                [&] {
+                  arena.Reset();
+                  platzi::Envelope envelope;
+                  sink = JsonMethodCodec::DecodeEnvelope(
+                      message.data(), message.size(), &arena, &envelope);
+                });
+
+  // A burst of 200 small calls and their replies, in one message each.
+  constexpr size_t kBatchSize = 200;
+  std::vector<MethodCall> calls(kBatchSize);
+  std::vector<platzi::Envelope> replies(kBatchSize);
+  for (size_t i = 0; i < kBatchSize; i++) {
+    calls[i] = {"ping", Value::Int32(static_cast<int32_t>(i))};
+    replies[i].result = Value::Int32(static_cast<int32_t>(i));
+  }
+  StandardMethodCodec::EncodeMethodCallBatch(calls.data(), kBatchSize,
+                                             &encoded);
+  reporter->Run("standard_method", "call_batch", "encode", encoded.size(),
+                [&] {
+                  sink = StandardMethodCodec::EncodeMethodCallBatch(
+                      calls.data(), kBatchSize, &encoded);
+                });
+  message = encoded;
+  reporter->Run("standard_method", "call_batch", "decode", message.size(),
+                [&] {
+                  arena.Reset();
+                  platzi::Span<MethodCall> decoded;
+                  sink = StandardMethodCodec::DecodeMethodCallBatch(
+                      message.data(), message.size(), &arena, &decoded);
+                });
+  StandardMethodCodec::EncodeEnvelopeBatch(replies.data(), kBatchSize,
+                                           &encoded);
+  reporter->Run("standard_method", "envelope_batch", "encode", encoded.size(),
+                [&] {
+                  sink = StandardMethodCodec::EncodeEnvelopeBatch(
+                      replies.data(), kBatchSize, &encoded);
+                });
+  message = encoded;
+  reporter->Run("standard_method", "envelope_batch", "decode", message.size(),
+                [&] {
+                  arena.Reset();
+                  platzi::Span<platzi::Envelope> decoded;
+                  sink = StandardMethodCodec::DecodeEnvelopeBatch(
+                      message.data(), message.size(), &arena, &decoded);
+                });
+}
+
+void RunByteCodecs(Reporter* reporter) {
+  std::vector<uint8_t> encoded;
+  volatile size_t sink = 0;
+
+  // A 1 MB blob, such as an image.
+  std::vector<uint8_t> blob(1 << 20);
+  for (size_t i = 0; i < blob.size(); i++) {
+    blob[i] = static_cast<uint8_t>(i * 2654435761u >> 24);
+  }
+  reporter->Run("binary", "blob", "encode", blob.size(), [&] {
+    platzi::BinaryCodec::EncodeMessage(blob.data(), blob.size(), &encoded);
+    sink = encoded.size();
+  });
+  reporter->Run("binary", "blob", "decode", blob.size(), [&] {
+    sink = platzi::BinaryCodec::DecodeMessage(blob.data(), blob.size()).size;
+  });
+
+  // 64 KB of mostly Latin-1 text, transcoded from and to UTF-16 as for
+  // NSString.
+  std::u16string text;
+  const std::u16string sample =
+      u"Un lugar increíble, la montaña y el río. ";
+  while (text.size() + sample.size() <= 32768) {
+    text += sample;
+  }
+  platzi::StringCodec::EncodeMessage(std::u16string_view(text), &encoded);
+  reporter->Run("string", "text", "encode", encoded.size(), [&] {
+    platzi::StringCodec::EncodeMessage(std::u16string_view(text), &encoded);
+    sink = encoded.size();
+  });
+  std::vector<uint8_t> message = encoded;
+  std::u16string decoded;
+  reporter->Run("string", "text", "decode", message.size(), [&] {
+    sink = platzi::StringCodec::DecodeMessage(message.data(), message.size(),
+                                              &decoded);
+  });
+}
+
+// A plugin-defined type with two coordinates, one of eight registered
+// extension types.
+template <int kTag>
+struct Point {
+  double x;
+  double y;
+};
+
+template <int kTag>
+void EncodePoint(const void* object, platzi::StandardWriter* writer) {
+  const auto* point = static_cast<const Point<kTag>*>(object);
+  writer->WriteValue(Value::Float64(point->x));
+  writer->WriteValue(Value::Float64(point->y));
+}
+
+template <int kTag>
+const void* DecodePoint(platzi::StandardReader* reader,
+                        Arena* arena,
+                        platzi::DecodeMode mode) {
+  const Value* x = platzi::DecodeValue(reader, arena, mode);
+  const Value* y = platzi::DecodeValue(reader, arena, mode);
+  if (x == nullptr || y == nullptr || x->type != ValueType::kFloat64 ||
+      y->type != ValueType::kFloat64) {
+    return nullptr;
+  }
+  return arena->New<Point<kTag>>(Point<kTag>{x->float64, y->float64});
+}
+
+template <int... kTags>
+void RegisterPoints(platzi::ExtensionRegistry* registry,
+                    std::integer_sequence<int, kTags...>) {
+  (registry->Register<Point<kTags>>(platzi::kFirstExtensionType + kTags,
+                                    EncodePoint<kTags>, DecodePoint<kTags>),
+   ...);
+}
+
+// 4096 points of the last registered type, which a chain of type checks
+// would reach last.
+void RunExtensionCodec(Corpus* corpus, Reporter* reporter) {
+  platzi::ExtensionRegistry registry;
+  RegisterPoints(&registry, std::make_integer_sequence<int, 8>());
+  platzi::ExtensionMessageCodec codec(&registry);
+
+  constexpr size_t kCount = 4096;
+  Point<7>* points = corpus->arena.NewArray<Point<7>>(kCount);
+  Value* items = corpus->List(kCount);
+  for (size_t i = 0; i < kCount; i++) {
+    points[i] = Point<7>{i * 0.5, i * -0.25};
+    items[i] = Value::Extension(&points[i]);
+  }
+  Value payload = Value::List(items, kCount);
+
+  std::vector<uint8_t> encoded;
+  Arena arena;
+  volatile size_t sink = 0;
+  codec.EncodeMessage(payload, &encoded);
+  reporter->Run("extension_message", "points", "encode", encoded.size(),
+                [&] { sink = codec.EncodeMessage(payload, &encoded); });
+  std::vector<uint8_t> message = encoded;
+  reporter->Run("extension_message", "points", "decode", message.size(),
+                [&] {
+                  arena.Reset();
+                  sink = codec.DecodeMessage(message.data(), message.size(),
+                                             &arena) != nullptr;
+                });
+}
+
+bool ParseOptions(int argc, char** argv, Options* options) {
+  for (int i = 1; i < argc; i++) {
+    const char* argument = argv[i];
+    if (std::strcmp(argument, "--json") == 0) {
+      options->json = true;
+    } else if (std::strncmp(argument, "--filter=", 9) == 0) {
+      options->filter = argument + 9;
+    } else if (std::strncmp(argument, "--min-time-ms=", 14) == 0) {
+      options->min_time_ms = std::atoi(argument + 14);
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  if (!ParseOptions(argc, argv, &options)) {
+    std::fprintf(stderr,
+                 "usage: %s [--json] [--filter=SUBSTRING] "
+                 "[--min-time-ms=N]\n",
+                 argv[0]);
+    return 2;
+  }
+  Reporter reporter(options);
+  Corpus corpus;
+  RunByteCodecs(&reporter);
+  RunMessageCodecs(&corpus, &reporter);
+  RunExtensionCodec(&corpus, &reporter);
+  RunMethodCodecs(&corpus, &reporter);
+  return 0;
+}
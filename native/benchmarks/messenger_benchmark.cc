@@ -0,0 +1,272 @@
+// Cost per message of the binary messenger's dispatch and send paths.
+//
+// Usage: messenger_benchmark [channels]
+//
+// Messages go round-robin over |channels| channels (512 by default) with
+// names like those of plugin channels, all with handlers.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "messenger/binary_messenger.h"
+#include "messenger/send_coalescer.h"
+#include "messenger/slot_map.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using platzi::BinaryMessage;
+using platzi::BinaryMessenger;
+using platzi::ChannelId;
+using platzi::MessageReply;
+
+// Drops everything, so that only the messenger is measured.
+class NullTransport : public platzi::MessengerTransport {
+ public:
+  void SendMessage(ChannelId, std::string_view, BinaryMessage,
+                   uint32_t response_id) override {
+    messages_++;
+    last_response_id_ = response_id;
+  }
+  void SendReply(uint32_t, BinaryMessage) override {}
+
+  uint64_t messages() const { return messages_; }
+  uint32_t last_response_id() const { return last_response_id_; }
+
+ private:
+  uint64_t messages_ = 0;
+  uint32_t last_response_id_ = 0;
+};
+
+// Returns nanoseconds per call of |function|, which handles |messages|
+// messages per call.
+template <typename Function>
+double MeasureNsPerMessage(size_t messages, Function function) {
+  function();
+  size_t iterations = 0;
+  Clock::time_point start = Clock::now();
+  Clock::duration elapsed;
+  do {
+    function();
+    iterations++;
+    elapsed = Clock::now() - start;
+  } while (elapsed < std::chrono::milliseconds(300));
+  double ns = std::chrono::duration<double, std::nano>(elapsed).count();
+  return ns / (static_cast<double>(iterations) * messages);
+}
+
+// Microseconds from the arrival of a burst of 256 64 KiB messages on an
+// upload channel, whose handler checksums each one, to the handling of a
+// keystroke that arrived in the middle of it, on average over |bursts|
+// bursts, with or without priority lanes.
+double KeystrokeDelayUs(bool lanes, size_t bursts) {
+  constexpr size_t kBurst = 256;
+  std::vector<uint8_t> chunk(64 * 1024, 1);
+  volatile uint32_t checksum = 0;
+  NullTransport transport;
+  BinaryMessenger messenger(&transport);
+  bool scheduled = false;
+  if (lanes) {
+    messenger.EnablePriorityLanes([&scheduled] { scheduled = true; });
+  }
+  ChannelId upload = messenger.Channel("plugins.example.com/upload");
+  messenger.SetChannelPriority(upload, platzi::ChannelPriority::kBulk);
+  messenger.SetMessageHandler(
+      upload, [&checksum](BinaryMessage message, MessageReply) {
+        uint32_t hash = 2166136261u;
+        for (uint8_t byte : message) {
+          hash = (hash ^ byte) * 16777619u;
+        }
+        checksum = checksum + hash;
+      });
+  ChannelId text_input = messenger.Channel("flutter/textinput");
+  Clock::time_point arrival;
+  Clock::duration delay{0};
+  messenger.SetMessageHandler(
+      text_input, [&arrival, &delay](BinaryMessage, MessageReply) {
+        delay += Clock::now() - arrival;
+      });
+  uint8_t key[16] = {};
+  for (size_t burst = 0; burst < bursts; burst++) {
+    arrival = Clock::now();
+    for (size_t i = 0; i < kBurst; i++) {
+      if (i == kBurst / 2) {
+        messenger.HandleMessage(text_input, BinaryMessage{key, sizeof(key)},
+                                0);
+      }
+      messenger.HandleMessage(upload,
+                              BinaryMessage{chunk.data(), chunk.size()}, 0);
+    }
+    // The run loop, calling back as asked.
+    while (scheduled) {
+      scheduled = false;
+      messenger.DispatchQueued();
+    }
+  }
+  return std::chrono::duration<double, std::micro>(delay).count() / bursts;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  size_t channel_count = argc > 1 ? std::atoi(argv[1]) : 512;
+  constexpr size_t kMessages = 65536;
+
+  std::vector<std::string> names;
+  for (size_t i = 0; i < channel_count; i++) {
+    names.push_back("plugins.example.com/feature_" + std::to_string(i) +
+                    "/events");
+  }
+  // The order messages arrive in, as names and as IDs.
+  std::vector<size_t> order(kMessages);
+  for (size_t i = 0; i < kMessages; i++) {
+    order[i] = i * 7919 % channel_count;
+  }
+  uint8_t payload[64] = {};
+  BinaryMessage message{payload, sizeof(payload)};
+  volatile size_t sink = 0;
+
+  NullTransport transport;
+  BinaryMessenger messenger(&transport);
+  std::vector<ChannelId> ids;
+  for (const std::string& name : names) {
+    ids.push_back(messenger.Channel(name));
+    messenger.SetMessageHandler(
+        ids.back(), [&sink](BinaryMessage message, MessageReply) {
+          sink = sink + message.size;
+        });
+  }
+
+  // What FlutterEngine does per message: make a string key of the channel
+  // name and look it up in a dictionary of handlers.
+  std::unordered_map<std::string, platzi::BinaryMessageHandler> dictionary;
+  for (const std::string& name : names) {
+    dictionary[name] = [&sink](BinaryMessage message, MessageReply) {
+      sink = sink + message.size;
+    };
+  }
+  double string_keys = MeasureNsPerMessage(kMessages, [&] {
+    for (size_t channel : order) {
+      std::string key(names[channel]);
+      auto handler = dictionary.find(key);
+      if (handler != dictionary.end()) {
+        handler->second(message, MessageReply());
+      }
+    }
+  });
+  double by_name = MeasureNsPerMessage(kMessages, [&] {
+    for (size_t channel : order) {
+      messenger.HandleMessage(std::string_view(names[channel]), message, 0);
+    }
+  });
+  double by_id = MeasureNsPerMessage(kMessages, [&] {
+    for (size_t channel : order) {
+      messenger.HandleMessage(ids[channel], message, 0);
+    }
+  });
+  double send_by_name = MeasureNsPerMessage(kMessages, [&] {
+    for (size_t channel : order) {
+      messenger.SendOnChannel(names[channel], message);
+    }
+  });
+  double send_by_id = MeasureNsPerMessage(kMessages, [&] {
+    for (size_t channel : order) {
+      messenger.Send(ids[channel], message);
+    }
+  });
+
+  // Round trips with 64 replies outstanding at any time, the peer replying
+  // to each message 64 sends later. First with the hash map of response IDs
+  // the messenger used to keep.
+  constexpr size_t kOutstanding = 64;
+  size_t replies = 0;
+  platzi::BinaryReply count_reply = [&replies](BinaryMessage) { replies++; };
+  std::unordered_map<uint32_t, platzi::BinaryReply> reply_map;
+  uint32_t next_response_id = 1;
+  double round_trip_map = MeasureNsPerMessage(kMessages, [&] {
+    for (size_t i = 0; i < kMessages; i++) {
+      uint32_t response_id = next_response_id++;
+      reply_map.emplace(response_id, count_reply);
+      if (response_id > kOutstanding) {
+        auto pending = reply_map.find(response_id - kOutstanding);
+        platzi::BinaryReply callback = std::move(pending->second);
+        reply_map.erase(pending);
+        callback(message);
+      }
+    }
+  });
+  platzi::SlotMap<platzi::BinaryReply> reply_slots;
+  std::vector<uint32_t> in_flight(kOutstanding, 0);
+  double round_trip_slots = MeasureNsPerMessage(kMessages, [&] {
+    for (size_t i = 0; i < kMessages; i++) {
+      uint32_t response_id = reply_slots.Insert(count_reply);
+      uint32_t& oldest = in_flight[i % kOutstanding];
+      platzi::BinaryReply callback;
+      if (oldest != 0 && reply_slots.Take(oldest, &callback)) {
+        callback(message);
+      }
+      oldest = response_id;
+    }
+  });
+  // Then through the messenger, sending included.
+  in_flight.assign(kOutstanding, 0);
+  double round_trip = MeasureNsPerMessage(kMessages, [&] {
+    for (size_t i = 0; i < kMessages; i++) {
+      messenger.Send(ids[order[i]], message, count_reply);
+      uint32_t& oldest = in_flight[i % kOutstanding];
+      if (oldest != 0) {
+        messenger.HandleReply(oldest, message);
+      }
+      oldest = transport.last_response_id();
+    }
+  });
+
+  // A location and a progress channel each sent on 300 times a frame,
+  // flushed once per frame.
+  constexpr size_t kSendsPerFrame = 300;
+  constexpr size_t kFrames = 64;
+  ChannelId location = messenger.Channel("plugins.example.com/location");
+  ChannelId progress = messenger.Channel("plugins.example.com/progress");
+  uint64_t messages_before = transport.messages();
+  platzi::SendCoalescer coalescer(&messenger);
+  coalescer.SetPolicy(location, platzi::CoalescePolicy::kKeepLatest);
+  coalescer.SetPolicy(progress, platzi::CoalescePolicy::kBatch);
+  double coalesced = MeasureNsPerMessage(2 * kSendsPerFrame * kFrames, [&] {
+    for (size_t frame = 0; frame < kFrames; frame++) {
+      for (size_t i = 0; i < kSendsPerFrame; i++) {
+        coalescer.Send(location, message);
+        coalescer.Send(progress, message);
+      }
+      coalescer.Flush();
+    }
+  });
+  double sent_per_received =
+      static_cast<double>(transport.messages() - messages_before) /
+      coalescer.messages_received();
+
+  constexpr size_t kBursts = 20;
+  double keystroke_fifo = KeystrokeDelayUs(false, kBursts);
+  double keystroke_lanes = KeystrokeDelayUs(true, kBursts);
+
+  std::printf("%zu channels\n", channel_count);
+  std::printf("%-28s %10s\n", "case", "ns/message");
+  std::printf("%-28s %10.1f\n", "dispatch/string_dictionary", string_keys);
+  std::printf("%-28s %10.1f\n", "dispatch/by_name", by_name);
+  std::printf("%-28s %10.1f\n", "dispatch/by_id", by_id);
+  std::printf("%-28s %10.1f\n", "send/by_name", send_by_name);
+  std::printf("%-28s %10.1f\n", "send/by_id", send_by_id);
+  std::printf("%-28s %10.1f\n", "round_trip/hash_map", round_trip_map);
+  std::printf("%-28s %10.1f\n", "round_trip/slot_map", round_trip_slots);
+  std::printf("%-28s %10.1f\n", "round_trip/messenger", round_trip);
+  std::printf("%-28s %10.1f  (%.4f messages sent per send)\n",
+              "send/coalesced", coalesced, sent_per_received);
+  std::printf("%-28s %10s\n", "case", "us");
+  std::printf("%-28s %10.1f\n", "keystroke_delay/fifo", keystroke_fifo);
+  std::printf("%-28s %10.1f\n", "keystroke_delay/lanes", keystroke_lanes);
+  return 0;
+}
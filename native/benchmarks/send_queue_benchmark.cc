@@ -0,0 +1,237 @@
+// Throughput of sending on the binary messenger from many threads through
+// a |SendQueue|, against a mutex-protected queue that wakes the platform
+// thread per message, as dispatch_async to the main queue does. Linux only:
+// the platform thread sleeps on an eventfd.
+//
+// Doubles as a stress test of the queue: every message carries its
+// producer and sequence number, and the run fails if any message is lost,
+// duplicated or out of order for its producer, or any reply callback is
+// lost.
+//
+// Usage: send_queue_benchmark [producers] [messages per producer]
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "messenger/binary_messenger.h"
+#include "messenger/send_queue.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using platzi::BinaryMessage;
+using platzi::BinaryMessenger;
+using platzi::ChannelId;
+
+// Every this many messages asks for a reply.
+constexpr uint32_t kReplyEvery = 16;
+
+struct Stamp {
+  uint32_t producer;
+  uint32_t sequence;
+};
+
+// Checks what reaches the peer, and replies at once.
+class CheckingTransport : public platzi::MessengerTransport {
+ public:
+  explicit CheckingTransport(size_t producers) : expected_(producers, 0) {}
+
+  void set_messenger(BinaryMessenger* messenger) { messenger_ = messenger; }
+
+  void SendMessage(ChannelId channel,
+                   std::string_view,
+                   BinaryMessage message,
+                   uint32_t response_id) override {
+    Stamp stamp;
+    if (message.size != sizeof(stamp)) {
+      failed_ = true;
+      return;
+    }
+    std::memcpy(&stamp, message.data, sizeof(stamp));
+    if (stamp.producer >= expected_.size() || channel != stamp.producer ||
+        stamp.sequence != expected_[stamp.producer]++ ||
+        (response_id != 0) != (stamp.sequence % kReplyEvery == 0)) {
+      failed_ = true;
+    }
+    received_++;
+    if (response_id != 0) {
+      messenger_->HandleReply(response_id, message);
+    }
+  }
+
+  void SendReply(uint32_t, BinaryMessage) override {}
+
+  size_t received() const { return received_; }
+  bool failed() const { return failed_; }
+
+ private:
+  BinaryMessenger* messenger_ = nullptr;
+  std::vector<uint32_t> expected_;
+  size_t received_ = 0;
+  bool failed_ = false;
+};
+
+struct RunResult {
+  double seconds;
+  size_t wakeups;
+  bool ok;
+};
+
+// Runs |producers| threads sending |count| messages each with |send|, on
+// the platform thread that runs |drain| whenever |wakeup| is signaled.
+template <typename Send, typename Drain>
+RunResult Run(size_t producers,
+              size_t count,
+              int wakeup,
+              CheckingTransport* transport,
+              Send send,
+              Drain drain) {
+  Clock::time_point start = Clock::now();
+  std::vector<std::thread> threads;
+  for (size_t p = 0; p < producers; p++) {
+    threads.emplace_back([p, count, &send] {
+      for (uint32_t i = 0; i < count; i++) {
+        Stamp stamp{static_cast<uint32_t>(p), i};
+        send(static_cast<ChannelId>(p), stamp);
+      }
+    });
+  }
+  size_t total = producers * count;
+  size_t wakeups = 0;
+  while (transport->received() < total && !transport->failed()) {
+    uint64_t signals;
+    if (read(wakeup, &signals, sizeof(signals)) != sizeof(signals)) {
+      return {0, 0, false};
+    }
+    wakeups++;
+    drain();
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  return {seconds, wakeups, !transport->failed()};
+}
+
+void Signal(int wakeup) {
+  uint64_t one = 1;
+  if (write(wakeup, &one, sizeof(one)) != sizeof(one)) {
+    std::abort();
+  }
+}
+
+void Report(const char* name, size_t total, const RunResult& result) {
+  std::printf("%-14s %10.1f %12.2f %10.4f\n", name,
+              result.seconds * 1e9 / total, total / result.seconds / 1e6,
+              static_cast<double>(result.wakeups) / total);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  size_t producers = argc > 1 ? std::atoi(argv[1]) : 4;
+  size_t count = argc > 2 ? std::atoi(argv[2]) : 250000;
+  size_t total = producers * count;
+  int wakeup = eventfd(0, EFD_CLOEXEC);
+  if (wakeup < 0) {
+    std::perror("eventfd");
+    return 1;
+  }
+
+  std::printf("%zu producers, %zu messages each\n", producers, count);
+  std::printf("%-14s %10s %12s %10s\n", "case", "ns/message", "M messages/s",
+              "wakeups/message");
+
+  RunResult queued;
+  size_t replies = 0;
+  {
+    CheckingTransport transport(producers);
+    BinaryMessenger messenger(&transport);
+    transport.set_messenger(&messenger);
+    for (size_t p = 0; p < producers; p++) {
+      messenger.Channel("sensors/" + std::to_string(p));
+    }
+    platzi::SendQueue queue(&messenger, [wakeup] { Signal(wakeup); });
+    queued = Run(
+        producers, count, wakeup, &transport,
+        [&queue, &replies](ChannelId channel, const Stamp& stamp) {
+          BinaryMessage message{reinterpret_cast<const uint8_t*>(&stamp),
+                                sizeof(stamp)};
+          if (stamp.sequence % kReplyEvery == 0) {
+            // Runs on the platform thread, like every reply callback.
+            queue.Send(channel, message, [&replies](BinaryMessage) {
+              replies++;
+            });
+          } else {
+            queue.Send(channel, message);
+          }
+        },
+        [&queue] { queue.Drain(); });
+  }
+  Report("send_queue", total, queued);
+
+  RunResult locked;
+  {
+    CheckingTransport transport(producers);
+    BinaryMessenger messenger(&transport);
+    transport.set_messenger(&messenger);
+    for (size_t p = 0; p < producers; p++) {
+      messenger.Channel("sensors/" + std::to_string(p));
+    }
+    struct Pending {
+      ChannelId channel;
+      Stamp stamp;
+    };
+    std::mutex mutex;
+    std::deque<Pending> pending;
+    locked = Run(
+        producers, count, wakeup, &transport,
+        [&](ChannelId channel, const Stamp& stamp) {
+          {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending.push_back({channel, stamp});
+          }
+          Signal(wakeup);
+        },
+        [&] {
+          while (true) {
+            Pending next;
+            {
+              std::lock_guard<std::mutex> lock(mutex);
+              if (pending.empty()) {
+                return;
+              }
+              next = pending.front();
+              pending.pop_front();
+            }
+            BinaryMessage message{
+                reinterpret_cast<const uint8_t*>(&next.stamp),
+                sizeof(next.stamp)};
+            if (next.stamp.sequence % kReplyEvery == 0) {
+              messenger.Send(next.channel, message, [](BinaryMessage) {});
+            } else {
+              messenger.Send(next.channel, message);
+            }
+          }
+        });
+  }
+  Report("mutex_queue", total, locked);
+  close(wakeup);
+
+  size_t expected_replies = producers * ((count + kReplyEvery - 1) /
+                                         kReplyEvery);
+  if (!queued.ok || !locked.ok || replies != expected_replies) {
+    std::fprintf(stderr, "FAILED: messages lost, duplicated or reordered\n");
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,332 @@
+// Round trips and one-way throughput between binary messengers in two
+// processes over an |ShmTransport|, against the same round trips over a
+// Unix socket, which copies every message through the kernel twice. Linux
+// only. The peer is a forked stand-in that echoes every message back, and
+// can be loaded with any message size and window of messages in flight.
+//
+// Doubles as a test of the transport: every reply must match its message,
+// and every one-way message must arrive.
+//
+// Usage: shm_transport_benchmark [round trips] [one-way messages]
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "messenger/binary_messenger.h"
+#include "messenger/shm_transport.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using platzi::BinaryMessage;
+using platzi::BinaryMessenger;
+using platzi::ChannelId;
+using platzi::MessageReply;
+using platzi::ShmEndpoint;
+using platzi::ShmTransport;
+
+constexpr size_t kRingCapacity = ShmTransport::kDefaultRingCapacity;
+
+// Sleeps until |transport| has something to do, and does it.
+bool Wait(ShmTransport* transport) {
+  pollfd wake = {transport->wake_fd(), POLLIN, 0};
+  if (poll(&wake, 1, 5000) <= 0) {
+    std::fprintf(stderr, "peer stopped responding\n");
+    return false;
+  }
+  return transport->Poll();
+}
+
+// The stand-in peer: echoes "bench/echo", counts "bench/sink" and reports
+// the count on "bench/count", until told to quit.
+int RunPeer(ShmEndpoint* endpoint) {
+  ShmTransport transport;
+  if (!transport.Open(endpoint)) {
+    return 1;
+  }
+  BinaryMessenger messenger(&transport);
+  transport.set_messenger(&messenger);
+  bool done = false;
+  uint64_t received = 0;
+  messenger.SetMessageHandlerOnChannel(
+      "bench/echo",
+      [](BinaryMessage message, MessageReply reply) { reply.Send(message); });
+  messenger.SetMessageHandlerOnChannel(
+      "bench/sink",
+      [&received](BinaryMessage, MessageReply) { received++; });
+  messenger.SetMessageHandlerOnChannel(
+      "bench/count", [&received](BinaryMessage, MessageReply reply) {
+        reply.Send(BinaryMessage{reinterpret_cast<const uint8_t*>(&received),
+                                 sizeof(received)});
+      });
+  messenger.SetMessageHandlerOnChannel(
+      "bench/quit",
+      [&done](BinaryMessage, MessageReply) { done = true; });
+  while (!done) {
+    if (!Wait(&transport)) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+void Fill(std::vector<uint8_t>* message, uint32_t sequence) {
+  for (size_t i = 0; i < message->size(); i += 64) {
+    (*message)[i] = static_cast<uint8_t>(sequence + i);
+  }
+}
+
+bool Matches(const std::vector<uint8_t>& sent, BinaryMessage reply) {
+  return reply.data != nullptr && reply.size == sent.size() &&
+         std::memcmp(reply.data, sent.data(), sent.size()) == 0;
+}
+
+struct RunResult {
+  double seconds;
+  uint64_t wakeups;
+  bool ok;
+};
+
+// Sends |count| messages of |size| bytes on "bench/echo", keeping up to
+// |window| in flight, and checks every reply.
+RunResult RunShmRoundTrips(ShmTransport* transport,
+                           BinaryMessenger* messenger,
+                           size_t size,
+                           size_t count,
+                           size_t window) {
+  ChannelId echo = messenger->Channel("bench/echo");
+  std::vector<std::vector<uint8_t>> messages(window,
+                                             std::vector<uint8_t>(size));
+  size_t sent = 0;
+  size_t replied = 0;
+  bool ok = true;
+  uint64_t wakeups = transport->wakeups();
+  Clock::time_point start = Clock::now();
+  while (replied < count && ok) {
+    while (sent < count && sent - replied < window) {
+      std::vector<uint8_t>* message = &messages[sent % window];
+      Fill(message, static_cast<uint32_t>(sent));
+      messenger->Send(echo, BinaryMessage{message->data(), message->size()},
+                      [message, &replied, &ok](BinaryMessage reply) {
+                        ok = ok && Matches(*message, reply);
+                        replied++;
+                      });
+      sent++;
+    }
+    ok = ok && Wait(transport);
+  }
+  double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  return {seconds, transport->wakeups() - wakeups, ok};
+}
+
+// Sends |count| messages of |size| bytes on "bench/sink", encoding them in
+// the ring, then asks the peer how many arrived.
+RunResult RunShmOneWay(ShmTransport* transport,
+                       BinaryMessenger* messenger,
+                       size_t size,
+                       size_t count,
+                       uint64_t* expected) {
+  ChannelId sink = messenger->Channel("bench/sink");
+  uint64_t wakeups = transport->wakeups();
+  Clock::time_point start = Clock::now();
+  for (size_t i = 0; i < count; i++) {
+    uint8_t* message = transport->ReserveMessage(sink, size);
+    if (message == nullptr) {
+      return {0, 0, false};
+    }
+    for (size_t j = 0; j < size; j += 64) {
+      message[j] = static_cast<uint8_t>(i + j);
+    }
+    transport->CommitMessage();
+    // Lets the peer catch up when the ring is full.
+    while (transport->backlog() > 0) {
+      if (!Wait(transport)) {
+        return {0, 0, false};
+      }
+    }
+  }
+  *expected += count;
+  uint64_t received = 0;
+  bool replied = false;
+  messenger->SendOnChannel("bench/count", BinaryMessage(),
+                           [&received, &replied](BinaryMessage reply) {
+                             if (reply.size == sizeof(received)) {
+                               std::memcpy(&received, reply.data,
+                                           sizeof(received));
+                             }
+                             replied = true;
+                           });
+  while (!replied) {
+    if (!Wait(transport)) {
+      return {0, 0, false};
+    }
+  }
+  double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  return {seconds, transport->wakeups() - wakeups, received == *expected};
+}
+
+bool ReadAll(int fd, uint8_t* data, size_t size) {
+  while (size > 0) {
+    ssize_t done = read(fd, data, size);
+    if (done <= 0) {
+      return false;
+    }
+    data += done;
+    size -= static_cast<size_t>(done);
+  }
+  return true;
+}
+
+bool WriteAll(int fd, const uint8_t* data, size_t size) {
+  while (size > 0) {
+    ssize_t done = write(fd, data, size);
+    if (done <= 0) {
+      return false;
+    }
+    data += done;
+    size -= static_cast<size_t>(done);
+  }
+  return true;
+}
+
+// Echoes size-prefixed messages until the socket closes.
+int RunSocketPeer(int fd) {
+  std::vector<uint8_t> message;
+  uint32_t size;
+  while (ReadAll(fd, reinterpret_cast<uint8_t*>(&size), sizeof(size))) {
+    message.resize(size);
+    if (!ReadAll(fd, message.data(), size) ||
+        !WriteAll(fd, reinterpret_cast<uint8_t*>(&size), sizeof(size)) ||
+        !WriteAll(fd, message.data(), size)) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+// One message in flight at a time, so that neither side blocks writing.
+RunResult RunSocketRoundTrips(int fd, size_t size, size_t count) {
+  std::vector<uint8_t> message(size);
+  std::vector<uint8_t> reply(size);
+  Clock::time_point start = Clock::now();
+  for (size_t i = 0; i < count; i++) {
+    Fill(&message, static_cast<uint32_t>(i));
+    uint32_t reply_size = static_cast<uint32_t>(size);
+    if (!WriteAll(fd, reinterpret_cast<uint8_t*>(&reply_size),
+                  sizeof(reply_size)) ||
+        !WriteAll(fd, message.data(), size) ||
+        !ReadAll(fd, reinterpret_cast<uint8_t*>(&reply_size),
+                 sizeof(reply_size)) ||
+        reply_size != size || !ReadAll(fd, reply.data(), size) ||
+        reply != message) {
+      return {0, 0, false};
+    }
+  }
+  double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  return {seconds, 0, true};
+}
+
+void Report(const char* name,
+            size_t size,
+            size_t window,
+            size_t count,
+            const RunResult& result) {
+  std::printf("%-16s %8zu %6zu %12.2f %10.1f %10.3f\n", name, size, window,
+              result.seconds * 1e6 / count,
+              count * size / result.seconds / (1 << 20),
+              static_cast<double>(result.wakeups) / count);
+}
+
+bool Reap(pid_t child) {
+  int status;
+  return waitpid(child, &status, 0) == child && WIFEXITED(status) &&
+         WEXITSTATUS(status) == 0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  size_t round_trips = argc > 1 ? std::atoi(argv[1]) : 20000;
+  size_t one_way = argc > 2 ? std::atoi(argv[2]) : 200000;
+  const size_t kSizes[] = {64, 4096, 256 << 10};
+  bool ok = true;
+
+  std::printf("%-16s %8s %6s %12s %10s %10s\n", "case", "bytes", "window",
+              "us/message", "MiB/s", "wakeups/message");
+
+  ShmEndpoint endpoint;
+  ShmEndpoint peer_endpoint;
+  if (!ShmTransport::CreateConnection(kRingCapacity, &endpoint,
+                                      &peer_endpoint)) {
+    std::perror("CreateConnection");
+    return 1;
+  }
+  pid_t peer = fork();
+  if (peer == 0) {
+    ShmTransport::CloseEndpoint(&endpoint);
+    _exit(RunPeer(&peer_endpoint));
+  }
+  ShmTransport::CloseEndpoint(&peer_endpoint);
+  {
+    ShmTransport transport;
+    BinaryMessenger messenger(&transport);
+    transport.set_messenger(&messenger);
+    if (peer < 0 || !transport.Open(&endpoint)) {
+      std::perror("fork");
+      return 1;
+    }
+    for (size_t size : kSizes) {
+      size_t count = size > 4096 ? round_trips / 20 : round_trips;
+      for (size_t window : {1, 32}) {
+        RunResult result =
+            RunShmRoundTrips(&transport, &messenger, size, count, window);
+        ok = ok && result.ok;
+        Report("shm_round_trip", size, window, count, result);
+      }
+    }
+    uint64_t expected = 0;
+    for (size_t size : kSizes) {
+      size_t count = size > 4096 ? one_way / 100 : one_way;
+      RunResult result =
+          RunShmOneWay(&transport, &messenger, size, count, &expected);
+      ok = ok && result.ok;
+      Report("shm_one_way", size, 0, count, result);
+    }
+    messenger.SendOnChannel("bench/quit", BinaryMessage());
+  }
+  ok = Reap(peer) && ok;
+
+  int sockets[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sockets) != 0) {
+    std::perror("socketpair");
+    return 1;
+  }
+  peer = fork();
+  if (peer == 0) {
+    close(sockets[0]);
+    _exit(RunSocketPeer(sockets[1]));
+  }
+  close(sockets[1]);
+  for (size_t size : kSizes) {
+    size_t count = size > 4096 ? round_trips / 20 : round_trips;
+    RunResult result = RunSocketRoundTrips(sockets[0], size, count);
+    ok = ok && result.ok;
+    Report("socket_round_trip", size, 1, count, result);
+  }
+  close(sockets[0]);
+  ok = Reap(peer) && ok;
+
+  if (!ok) {
+    std::fprintf(stderr, "FAILED: messages lost or corrupted\n");
+    return 1;
+  }
+  return 0;
+}
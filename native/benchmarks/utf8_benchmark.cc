@@ -0,0 +1,90 @@
+// Throughput of the UTF-8 kernels behind the string paths of the codecs.
+//
+// Usage: utf8_benchmark [megabytes]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "codec/utf8.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Fills |size| bytes by repeating |sample|, cut at a code point boundary.
+std::string MakeCorpus(const std::string& sample, size_t size) {
+  std::string corpus;
+  while (corpus.size() + sample.size() <= size) {
+    corpus += sample;
+  }
+  return corpus;
+}
+
+template <typename Function>
+double MeasureGBps(size_t bytes, Function function) {
+  // Repeat until at least half a second has passed.
+  size_t iterations = 0;
+  Clock::time_point start = Clock::now();
+  Clock::duration elapsed;
+  do {
+    function();
+    iterations++;
+    elapsed = Clock::now() - start;
+  } while (elapsed < std::chrono::milliseconds(500));
+  double seconds = std::chrono::duration<double>(elapsed).count();
+  return static_cast<double>(bytes) * iterations / seconds / 1e9;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  size_t size = (argc > 1 ? std::atoi(argv[1]) : 4) * 1024 * 1024;
+
+  struct Sample {
+    const char* name;
+    std::string text;
+  };
+  const Sample samples[] = {
+      {"ascii", "The best place to watch the sunset over the river. "},
+      {"latin", "Un lugar increíble, la montaña y el río al atardecer. "},
+      {"cyrillic",
+       "Лучшее место, чтобы смотреть "
+       "закат над рекой. "},
+      {"cjk", "在河边看日落的最佳地点，山景非常美丽。"},
+      {"emoji", "Sunset \xF0\x9F\x8C\x85 beach \xF0\x9F\x8F\x96 palm "},
+  };
+
+  std::printf("%-8s %12s %12s %12s\n", "corpus", "validate", "to_utf16",
+              "to_utf8");
+  for (const Sample& sample : samples) {
+    std::string corpus = MakeCorpus(sample.text, size);
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(corpus.data());
+    std::vector<char16_t> utf16(corpus.size());
+    size_t utf16_size = 0;
+    if (!platzi::Utf8ToUtf16(bytes, corpus.size(), utf16.data(),
+                             &utf16_size)) {
+      std::fprintf(stderr, "%s: invalid corpus\n", sample.name);
+      return 1;
+    }
+    std::vector<uint8_t> utf8(
+        platzi::Utf8LengthOfUtf16(utf16.data(), utf16_size));
+
+    volatile bool sink = false;
+    double validate = MeasureGBps(corpus.size(), [&] {
+      sink = platzi::ValidateUtf8(bytes, corpus.size());
+    });
+    double to_utf16 = MeasureGBps(corpus.size(), [&] {
+      size_t length;
+      sink = platzi::Utf8ToUtf16(bytes, corpus.size(), utf16.data(), &length);
+    });
+    double to_utf8 = MeasureGBps(corpus.size(), [&] {
+      sink = platzi::Utf16ToUtf8(utf16.data(), utf16_size, utf8.data()) > 0;
+    });
+    std::printf("%-8s %9.2f GB/s %7.2f GB/s %7.2f GB/s\n", sample.name,
+                validate, to_utf16, to_utf8);
+  }
+  return 0;
+}
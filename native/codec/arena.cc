@@ -0,0 +1,85 @@
+#include "codec/arena.h"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace platzi {
+
+namespace {
+
+// Block headers are padded so that block storage is maximally aligned.
+constexpr size_t kHeaderSize = alignof(std::max_align_t) * 2;
+
+}  // namespace
+
+Arena::Arena(size_t block_size) : block_size_(block_size) {}
+
+Arena::~Arena() {
+  FreeBlocks();
+}
+
+void* Arena::Allocate(size_t size, size_t alignment) {
+  uintptr_t start = (cursor_ + alignment - 1) & ~(alignment - 1);
+  if (head_ == nullptr || start > limit_ || limit_ - start < size) {
+    AddBlock(size + alignment);
+    start = (cursor_ + alignment - 1) & ~(alignment - 1);
+  }
+  cursor_ = start + size;
+  bytes_used_ += size;
+  return reinterpret_cast<void*>(start);
+}
+
+const uint8_t* Arena::CopyBytes(const uint8_t* bytes,
+                                size_t size,
+                                size_t alignment) {
+  void* copy = Allocate(size, alignment);
+  if (size > 0) {
+    std::memcpy(copy, bytes, size);
+  }
+  return static_cast<const uint8_t*>(copy);
+}
+
+std::string_view Arena::CopyString(std::string_view string) {
+  const uint8_t* copy = CopyBytes(
+      reinterpret_cast<const uint8_t*>(string.data()), string.size(), 1);
+  return std::string_view(reinterpret_cast<const char*>(copy), string.size());
+}
+
+void Arena::Reset() {
+  if (head_ != nullptr && head_->next != nullptr) {
+    // Coalesce into one block that fits everything this arena held.
+    size_t total = bytes_reserved_;
+    FreeBlocks();
+    AddBlock(total - kHeaderSize);
+  } else if (head_ != nullptr) {
+    cursor_ = reinterpret_cast<uintptr_t>(head_) + kHeaderSize;
+  }
+  bytes_used_ = 0;
+}
+
+void Arena::AddBlock(size_t min_size) {
+  size_t size = min_size > block_size_ ? min_size : block_size_;
+  Block* block = static_cast<Block*>(std::malloc(kHeaderSize + size));
+  if (block == nullptr) {
+    throw std::bad_alloc();
+  }
+  block->next = head_;
+  block->size = size;
+  head_ = block;
+  cursor_ = reinterpret_cast<uintptr_t>(block) + kHeaderSize;
+  limit_ = cursor_ + size;
+  bytes_reserved_ += kHeaderSize + size;
+}
+
+void Arena::FreeBlocks() {
+  while (head_ != nullptr) {
+    Block* next = head_->next;
+    std::free(head_);
+    head_ = next;
+  }
+  cursor_ = 0;
+  limit_ = 0;
+  bytes_reserved_ = 0;
+}
+
+}  // namespace platzi
@@ -0,0 +1,87 @@
+#ifndef NATIVE_CODEC_ARENA_H_
+#define NATIVE_CODEC_ARENA_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace platzi {
+
+// A bump allocator for everything decoded from one message.
+//
+// Allocations are never freed individually; |Reset| releases all of them in
+// one step, typically from the reply callback of the handler that consumed
+// the message. After a reset the arena keeps a single block as large as
+// everything it held, so a channel that reuses one arena stops calling malloc
+// once it has seen its largest message.
+//
+// Only trivially destructible types may be placed in an arena.
+class Arena {
+ public:
+  static constexpr size_t kDefaultBlockSize = 4096;
+
+  explicit Arena(size_t block_size = kDefaultBlockSize);
+  ~Arena();
+
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  // Returns |size| bytes aligned to |alignment|, which must be a power of two.
+  void* Allocate(size_t size, size_t alignment);
+
+  template <typename T, typename... Args>
+  T* New(Args&&... args) {
+    static_assert(std::is_trivially_destructible<T>::value,
+                  "Arena objects are never destroyed");
+    return new (Allocate(sizeof(T), alignof(T)))
+        T(std::forward<Args>(args)...);
+  }
+
+  // Returns |count| default-constructed objects.
+  template <typename T>
+  T* NewArray(size_t count) {
+    static_assert(std::is_trivially_destructible<T>::value,
+                  "Arena objects are never destroyed");
+    T* array = static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+    for (size_t i = 0; i < count; i++) {
+      new (&array[i]) T();
+    }
+    return array;
+  }
+
+  // Copies |bytes| into the arena.
+  const uint8_t* CopyBytes(const uint8_t* bytes, size_t size, size_t alignment);
+  std::string_view CopyString(std::string_view string);
+
+  // Releases every allocation.
+  void Reset();
+
+  // Bytes handed out since construction or the last reset.
+  size_t bytes_used() const { return bytes_used_; }
+
+  // Bytes currently held from the system allocator.
+  size_t bytes_reserved() const { return bytes_reserved_; }
+
+ private:
+  struct Block {
+    Block* next;
+    size_t size;
+  };
+
+  void AddBlock(size_t min_size);
+  void FreeBlocks();
+
+  size_t block_size_;
+  Block* head_ = nullptr;
+  uintptr_t cursor_ = 0;
+  uintptr_t limit_ = 0;
+  size_t bytes_used_ = 0;
+  size_t bytes_reserved_ = 0;
+};
+
+}  // namespace platzi
+
+#endif  // NATIVE_CODEC_ARENA_H_
@@ -0,0 +1,11 @@
+#include "codec/binary_codec.h"
+
+namespace platzi {
+
+void BinaryCodec::EncodeMessage(const uint8_t* data,
+                                size_t size,
+                                std::vector<uint8_t>* encoded) {
+  encoded->assign(data, data + size);
+}
+
+}  // namespace platzi
@@ -0,0 +1,29 @@
+#ifndef NATIVE_CODEC_BINARY_CODEC_H_
+#define NATIVE_CODEC_BINARY_CODEC_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "codec/typed_data.h"
+
+namespace platzi {
+
+// The counterpart of FlutterBinaryCodec: messages are passed through
+// untouched. Decoding returns a view of the message without copying it.
+class BinaryCodec {
+ public:
+  static void EncodeMessage(const uint8_t* data,
+                            size_t size,
+                            std::vector<uint8_t>* encoded);
+  static ByteSpan DecodeMessage(const uint8_t* data, size_t size) {
+    return ByteSpan{data, size};
+  }
+
+ private:
+  BinaryCodec() = delete;
+};
+
+}  // namespace platzi
+
+#endif  // NATIVE_CODEC_BINARY_CODEC_H_
@@ -0,0 +1,101 @@
+#include "codec/compressed_codec.h"
+
+#include <cstring>
+
+#include "codec/lz_block.h"
+
+namespace platzi {
+
+void EncodeFrame(const uint8_t* data,
+                 size_t size,
+                 std::vector<uint8_t>* frame,
+                 size_t threshold) {
+  frame->clear();
+  if (size >= threshold && size <= UINT32_MAX) {
+    frame->resize(kFrameHeaderSize + LzCompressBound(size));
+    size_t compressed_size =
+        LzCompress(data, size, frame->data() + kFrameHeaderSize);
+    if (compressed_size < size) {
+      frame->resize(kFrameHeaderSize + compressed_size);
+      uint32_t payload_size = static_cast<uint32_t>(size);
+      std::memset(frame->data(), 0, kFrameHeaderSize);
+      (*frame)[0] = kCompressedFrameFlag;
+      std::memcpy(frame->data() + 4, &payload_size, sizeof(payload_size));
+      return;
+    }
+  }
+  frame->resize(kFrameHeaderSize + size);
+  std::memset(frame->data(), 0, kFrameHeaderSize);
+  if (size > 0) {
+    std::memcpy(frame->data() + kFrameHeaderSize, data, size);
+  }
+}
+
+bool ReadFrameHeader(const uint8_t* frame,
+                     size_t size,
+                     bool* compressed,
+                     size_t* payload_size) {
+  if (size < kFrameHeaderSize || (frame[0] & ~kCompressedFrameFlag) != 0) {
+    return false;
+  }
+  *compressed = frame[0] == kCompressedFrameFlag;
+  if (!*compressed) {
+    *payload_size = size - kFrameHeaderSize;
+    return true;
+  }
+  uint32_t decompressed_size;
+  std::memcpy(&decompressed_size, frame + 4, sizeof(decompressed_size));
+  // No block expands more than 255-fold, which keeps a corrupt size from
+  // making callers allocate gigabytes for a small frame.
+  if (decompressed_size / 255 > size - kFrameHeaderSize) {
+    return false;
+  }
+  *payload_size = decompressed_size;
+  return true;
+}
+
+bool DecodeFrame(const uint8_t* frame,
+                 size_t size,
+                 uint8_t* out,
+                 size_t capacity) {
+  bool compressed;
+  size_t payload_size;
+  if (!ReadFrameHeader(frame, size, &compressed, &payload_size) ||
+      payload_size > capacity) {
+    return false;
+  }
+  const uint8_t* payload = frame + kFrameHeaderSize;
+  if (!compressed) {
+    if (payload_size > 0) {
+      std::memcpy(out, payload, payload_size);
+    }
+    return true;
+  }
+  size_t decompressed_size;
+  return LzDecompress(payload, size - kFrameHeaderSize, out, capacity,
+                      &decompressed_size) &&
+         decompressed_size == payload_size;
+}
+
+bool OpenFrame(const uint8_t* frame,
+               size_t size,
+               Arena* arena,
+               ByteSpan* payload) {
+  bool compressed;
+  size_t payload_size;
+  if (!ReadFrameHeader(frame, size, &compressed, &payload_size)) {
+    return false;
+  }
+  if (!compressed) {
+    *payload = ByteSpan{frame + kFrameHeaderSize, payload_size};
+    return true;
+  }
+  uint8_t* bytes = static_cast<uint8_t*>(arena->Allocate(payload_size, 8));
+  if (!DecodeFrame(frame, size, bytes, payload_size)) {
+    return false;
+  }
+  *payload = ByteSpan{bytes, payload_size};
+  return true;
+}
+
+}  // namespace platzi
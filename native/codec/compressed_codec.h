@@ -0,0 +1,201 @@
+#ifndef NATIVE_CODEC_COMPRESSED_CODEC_H_
+#define NATIVE_CODEC_COMPRESSED_CODEC_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "codec/arena.h"
+#include "codec/binary_codec.h"
+#include "codec/typed_data.h"
+
+namespace platzi {
+
+// A frame around message bytes that compresses them with |LzCompress| when
+// they are large enough for it to pay off. |CompressedMessageCodec| puts
+// the messages of a codec in frames.
+//
+// A frame starts with an 8-byte header, so that the payload keeps the
+// alignment of the frame and typed data decoded in place stays aligned:
+//
+//   flags     1 byte   kCompressedFrameFlag, or 0 for stored bytes
+//   reserved  3 bytes  zero
+//   size      4 bytes  size of a compressed payload once decompressed;
+//                      zero for stored ones, which fill the rest of the frame
+//
+// Payloads below the threshold, and those that compression would not
+// shrink, are stored as they are.
+constexpr uint8_t kCompressedFrameFlag = 1;
+constexpr size_t kFrameHeaderSize = 8;
+constexpr size_t kDefaultCompressionThreshold = 4096;
+
+// Replaces the contents of |frame| with a frame holding the |size| bytes at
+// |data|.
+void EncodeFrame(const uint8_t* data,
+                 size_t size,
+                 std::vector<uint8_t>* frame,
+                 size_t threshold = kDefaultCompressionThreshold);
+
+// Reads the header of the |size|-byte |frame|. Returns false if it is
+// malformed.
+bool ReadFrameHeader(const uint8_t* frame,
+                     size_t size,
+                     bool* compressed,
+                     size_t* payload_size);
+
+// Writes the payload of |frame| into the |capacity| bytes at |out|, which
+// must hold at least the payload size from |ReadFrameHeader|. Returns false
+// if the frame is malformed.
+bool DecodeFrame(const uint8_t* frame,
+                 size_t size,
+                 uint8_t* out,
+                 size_t capacity);
+
+// Finds the payload of the |size|-byte |frame|: in place if it is stored,
+// decompressed into |arena| if it is compressed. Returns false if the frame
+// is malformed.
+bool OpenFrame(const uint8_t* frame,
+               size_t size,
+               Arena* arena,
+               ByteSpan* payload);
+
+// A codec whose messages are the output of |Codec| in a frame. The frame
+// works on bytes, so any codec can be wrapped:
+//
+//  * codecs of |Value| trees, such as
+//    CompressedMessageCodec<JsonMessageCodec>;
+//  * BinaryCodec and StringCodec, whose messages are bytes and strings;
+//  * stateful codecs such as InterningMessageCodec, through the overloads
+//    that take the codec instance first.
+//
+// |DecodeMessage| takes an arena for compressed payloads, then what
+// |Codec::DecodeMessage| takes after the message bytes; the arena is passed
+// on too if |Codec| takes one there. Compressed messages are decompressed
+// into the arena, so decoding them in |DecodeMode::kBorrow| does not tie the
+// result to the frame; stored ones are decoded in place without a copy.
+// Malformed frames decode to what |Codec| returns for malformed messages:
+// nullptr, false, or for BinaryCodec a nil message.
+template <typename Codec>
+class CompressedMessageCodec {
+ public:
+  // Replaces the contents of |encoded| with the framed encoding of
+  // |message|, a |Value| or, for StringCodec, a string. Returns false if
+  // |Codec| cannot encode it.
+  template <typename Message>
+  static bool EncodeMessage(const Message& message,
+                            std::vector<uint8_t>* encoded,
+                            size_t threshold = kDefaultCompressionThreshold) {
+    return Frame(
+        [&](std::vector<uint8_t>* payload) {
+          return Codec::EncodeMessage(message, payload);
+        },
+        encoded, threshold);
+  }
+
+  // As above, for BinaryCodec, whose messages are framed as they are.
+  static bool EncodeMessage(const uint8_t* data,
+                            size_t size,
+                            std::vector<uint8_t>* encoded,
+                            size_t threshold = kDefaultCompressionThreshold) {
+    static_assert(std::is_same_v<Codec, BinaryCodec>,
+                  "Only BinaryCodec encodes byte ranges");
+    EncodeFrame(data, size, encoded, threshold);
+    return true;
+  }
+
+  // As above, with the instance |codec| of a stateful codec.
+  template <typename Message>
+  static bool EncodeMessage(Codec* codec,
+                            const Message& message,
+                            std::vector<uint8_t>* encoded,
+                            size_t threshold = kDefaultCompressionThreshold) {
+    return Frame(
+        [&](std::vector<uint8_t>* payload) {
+          return codec->EncodeMessage(message, payload);
+        },
+        encoded, threshold);
+  }
+
+  template <typename... Args>
+  static auto DecodeMessage(const uint8_t* data,
+                            size_t size,
+                            Arena* arena,
+                            Args&&... args) {
+    return Unframe(
+        [](auto&&... decode_args)
+            -> decltype(Codec::DecodeMessage(
+                std::forward<decltype(decode_args)>(decode_args)...)) {
+          return Codec::DecodeMessage(
+              std::forward<decltype(decode_args)>(decode_args)...);
+        },
+        data, size, arena, std::forward<Args>(args)...);
+  }
+
+  template <typename... Args>
+  static auto DecodeMessage(Codec* codec,
+                            const uint8_t* data,
+                            size_t size,
+                            Arena* arena,
+                            Args&&... args) {
+    return Unframe(
+        [codec](auto&&... decode_args)
+            -> decltype(codec->DecodeMessage(
+                std::forward<decltype(decode_args)>(decode_args)...)) {
+          return codec->DecodeMessage(
+              std::forward<decltype(decode_args)>(decode_args)...);
+        },
+        data, size, arena, std::forward<Args>(args)...);
+  }
+
+ private:
+  CompressedMessageCodec() = delete;
+
+  // Frames what |encode| writes into a scratch vector. Codecs whose
+  // encoding cannot fail return nothing.
+  template <typename Encode>
+  static bool Frame(Encode encode,
+                    std::vector<uint8_t>* encoded,
+                    size_t threshold) {
+    thread_local std::vector<uint8_t> payload;
+    if constexpr (std::is_void_v<decltype(encode(&payload))>) {
+      encode(&payload);
+    } else if (!encode(&payload)) {
+      return false;
+    }
+    EncodeFrame(payload.data(), payload.size(), encoded, threshold);
+    return true;
+  }
+
+  // Calls |decode| on the payload of |frame|, passing |arena| on if it
+  // takes one after the payload.
+  template <typename Decode, typename... Args>
+  static auto Unframe(Decode decode,
+                      const uint8_t* frame,
+                      size_t size,
+                      Arena* arena,
+                      Args&&... args) {
+    ByteSpan payload;
+    bool ok = OpenFrame(frame, size, arena, &payload);
+    if constexpr (std::is_invocable_v<Decode, const uint8_t*, size_t, Arena*,
+                                      Args...>) {
+      if (!ok) {
+        return std::invoke_result_t<Decode, const uint8_t*, size_t, Arena*,
+                                    Args...>{};
+      }
+      return decode(payload.data, payload.size, arena,
+                    std::forward<Args>(args)...);
+    } else {
+      if (!ok) {
+        return std::invoke_result_t<Decode, const uint8_t*, size_t,
+                                    Args...>{};
+      }
+      return decode(payload.data, payload.size, std::forward<Args>(args)...);
+    }
+  }
+};
+
+}  // namespace platzi
+
+#endif  // NATIVE_CODEC_COMPRESSED_CODEC_H_
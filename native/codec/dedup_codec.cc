@@ -0,0 +1,446 @@
+#include "codec/dedup_codec.h"
+
+#include <cstring>
+#include <functional>
+#include <string_view>
+#include <utility>
+
+namespace platzi {
+
+namespace {
+
+constexpr uint64_t kGolden = 0x9E3779B97F4A7C15ull;
+
+// The splitmix64 finalizer: every input bit affects every output bit, so
+// hashes folded in one after another depend on their order.
+inline uint64_t Mix(uint64_t value) {
+  value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+  value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+  return value ^ (value >> 31);
+}
+
+inline uint64_t HashBytes(const void* data, size_t size) {
+  return std::hash<std::string_view>()(
+      std::string_view(static_cast<const char*>(data), size));
+}
+
+inline uint64_t Seed(const Value& value, uint64_t payload) {
+  return Mix(static_cast<uint64_t>(value.type) * kGolden ^ payload);
+}
+
+inline uint64_t BitsOf(double value) {
+  uint64_t bits;
+  std::memcpy(&bits, &value, 8);
+  return bits;
+}
+
+// Number of elements of a list or map, keys and values counting
+// separately; 0 for anything else.
+inline size_t SlotsOf(const Value& value) {
+  switch (value.type) {
+    case ValueType::kList:
+      return value.list.size;
+    case ValueType::kMap:
+      return 2 * value.map.size;
+    default:
+      return 0;
+  }
+}
+
+// Values that |DedupWriter::WriteShared| gets to see.
+inline bool IsShareable(const Value& value) {
+  switch (value.type) {
+    case ValueType::kString:
+    case ValueType::kTypedData:
+    case ValueType::kList:
+    case ValueType::kMap:
+      return true;
+    default:
+      return false;
+  }
+}
+
+inline const Value& ElementAt(const Value& container, size_t slot) {
+  if (container.type == ValueType::kList) {
+    return container.list[slot];
+  }
+  const MapEntry& entry = container.map[slot / 2];
+  return slot % 2 == 0 ? entry.key : entry.value;
+}
+
+// Whether |a| and |b| encode the same, with |pending| as scratch space.
+// Scalars compare bit for bit, so that 0.0 and -0.0 stay apart and NaN
+// equals itself.
+bool Equal(const Value& a,
+           const Value& b,
+           std::vector<std::pair<const Value*, const Value*>>* pending) {
+  pending->assign(1, {&a, &b});
+  while (!pending->empty()) {
+    const Value* x = pending->back().first;
+    const Value* y = pending->back().second;
+    pending->pop_back();
+    if (x == y) {
+      continue;
+    }
+    if (x->type != y->type) {
+      return false;
+    }
+    switch (x->type) {
+      case ValueType::kNull:
+        break;
+      case ValueType::kBool:
+        if (x->boolean != y->boolean) {
+          return false;
+        }
+        break;
+      case ValueType::kInt32:
+        if (x->int32 != y->int32) {
+          return false;
+        }
+        break;
+      case ValueType::kInt64:
+        if (x->int64 != y->int64) {
+          return false;
+        }
+        break;
+      case ValueType::kFloat64:
+        if (BitsOf(x->float64) != BitsOf(y->float64)) {
+          return false;
+        }
+        break;
+      case ValueType::kString:
+        if (x->string != y->string) {
+          return false;
+        }
+        break;
+      case ValueType::kTypedData: {
+        const TypedDataView& p = x->typed_data;
+        const TypedDataView& q = y->typed_data;
+        if (p.type != q.type || p.element_count != q.element_count ||
+            p.element_size != q.element_size ||
+            (p.bytes != q.bytes && p.byte_size() > 0 &&
+             std::memcmp(p.bytes, q.bytes, p.byte_size()) != 0)) {
+          return false;
+        }
+        break;
+      }
+      case ValueType::kList:
+      case ValueType::kMap: {
+        size_t slots = SlotsOf(*x);
+        if (slots != SlotsOf(*y)) {
+          return false;
+        }
+        for (size_t i = 0; i < slots; i++) {
+          pending->emplace_back(&ElementAt(*x, i), &ElementAt(*y, i));
+        }
+        break;
+      }
+      case ValueType::kTensor:
+        if (x->tensor != y->tensor) {
+          return false;
+        }
+        break;
+      case ValueType::kExtension:
+        if (x->extension.type_id != y->extension.type_id ||
+            x->extension.object != y->extension.object) {
+          return false;
+        }
+        break;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+DedupPlanner::DedupPlanner() = default;
+
+DedupPlanner::~DedupPlanner() = default;
+
+DedupPlanner::Node DedupPlanner::LeafNodeOf(const Value& value) {
+  switch (value.type) {
+    case ValueType::kNull:
+      return {Seed(value, 0), 1, 0};
+    case ValueType::kBool:
+      return {Seed(value, value.boolean), 1, 0};
+    case ValueType::kInt32:
+      return {Seed(value, static_cast<uint32_t>(value.int32)), 5, 0};
+    case ValueType::kInt64:
+      return {Seed(value, static_cast<uint64_t>(value.int64)), 9, 0};
+    case ValueType::kFloat64:
+      return {Seed(value, BitsOf(value.float64)), 9, 0};
+    case ValueType::kString: {
+      size_t length = value.string.size();
+      return {Seed(value, HashBytes(value.string.data(), length)),
+              1 + EncodedSizeOfSize(static_cast<uint32_t>(length)) + length,
+              0};
+    }
+    case ValueType::kTypedData: {
+      const TypedDataView& data = value.typed_data;
+      uint64_t hash = HashBytes(data.bytes, data.byte_size()) ^
+                      (static_cast<uint64_t>(data.type) << 32);
+      return {Seed(value, hash),
+              1 + EncodedSizeOfSize(data.element_count) + data.byte_size(),
+              0};
+    }
+    case ValueType::kTensor:
+      // Tensors are never shared, so the same view is all that is equal.
+      return {Seed(value, reinterpret_cast<uintptr_t>(value.tensor)), 1, 0};
+    case ValueType::kExtension:
+      return {Seed(value, Mix(reinterpret_cast<uintptr_t>(
+                                  value.extension.type_id)) ^
+                              reinterpret_cast<uintptr_t>(
+                                  value.extension.object)),
+              1, 0};
+    case ValueType::kList:
+    case ValueType::kMap:
+      break;
+  }
+  return {0, 0, 0};
+}
+
+void DedupPlanner::HashNodes(const Value& value) {
+  nodes_.clear();
+  stack_.clear();
+  // Adds |element| to |nodes_| if it belongs there, and starts on it if it
+  // is a non-empty list or map; otherwise returns false with its node in
+  // |*done|. Containers get their nodes once their elements are done.
+  auto open = [this](const Value& element, Node* done) {
+    uint32_t index = static_cast<uint32_t>(nodes_.size());
+    if (element.type != ValueType::kList && element.type != ValueType::kMap) {
+      *done = LeafNodeOf(element);
+      if (IsShareable(element)) {
+        done->end = index + 1;
+        nodes_.push_back(*done);
+      }
+      return false;
+    }
+    size_t slots = SlotsOf(element);
+    uint32_t size = static_cast<uint32_t>(
+        element.type == ValueType::kList ? slots : slots / 2);
+    Node node = {Seed(element, size), 1 + EncodedSizeOfSize(size), index + 1};
+    nodes_.push_back(node);
+    if (slots == 0) {
+      *done = node;
+      return false;
+    }
+    stack_.push_back({&element, 0, slots, index, node, kNoGroup});
+    return true;
+  };
+  auto fold = [](Node* parent, const Node& child) {
+    parent->hash = Mix(parent->hash ^ child.hash);
+    parent->size += child.size;
+  };
+  Node done;
+  if (!open(value, &done)) {
+    return;
+  }
+  while (!stack_.empty()) {
+    Open& top = stack_.back();
+    if (top.index < top.slots) {
+      const Value& element = ElementAt(*top.value, top.index++);
+      if (!open(element, &done)) {
+        fold(&stack_.back().folded, done);
+      }
+      continue;
+    }
+    done = top.folded;
+    done.end = static_cast<uint32_t>(nodes_.size());
+    nodes_[top.node] = done;
+    stack_.pop_back();
+    if (!stack_.empty()) {
+      fold(&stack_.back().folded, done);
+    }
+  }
+}
+
+uint32_t DedupPlanner::GroupOf(const Value& value,
+                               uint64_t hash,
+                               bool* added) {
+  size_t mask = table_.size() - 1;
+  size_t slot = hash & mask;
+  for (; table_[slot] != kNoGroup; slot = (slot + 1) & mask) {
+    uint32_t group = table_[slot];
+    if (groups_[group].hash == hash &&
+        Equal(*groups_[group].first, value, &pending_)) {
+      *added = false;
+      return group;
+    }
+  }
+  uint32_t group = static_cast<uint32_t>(groups_.size());
+  table_[slot] = group;
+  groups_.push_back({hash, &value, 1, 0});
+  *added = true;
+  return group;
+}
+
+void DedupPlanner::Plan(const Value& value) {
+  groups_.clear();
+  visits_.clear();
+  ended_.clear();
+  next_visit_ = 0;
+  HashNodes(value);
+  // At most one group per node, and at most half full.
+  size_t capacity = 16;
+  while (capacity < 2 * nodes_.size()) {
+    capacity *= 2;
+  }
+  table_.assign(capacity, kNoGroup);
+
+  // Visits what |WriteValue| will, in the same order, skipping over the
+  // elements of repeats. Groups are listed as their first values end, which
+  // is when the reader numbers them.
+  stack_.clear();
+  uint32_t index = 0;
+  const Value* current = &value;
+  while (true) {
+    uint32_t group = kNoGroup;
+    bool descend = true;
+    if (IsShareable(*current)) {
+      const Node& node = nodes_[index++];
+      uint32_t visit = kNoGroup;
+      if (node.size >= kMinSharedSize) {
+        bool added;
+        group = GroupOf(*current, node.hash, &added);
+        visit = group << 1 | (added ? 1 : 0);
+        if (!added) {
+          groups_[group].count++;
+          group = kNoGroup;
+          descend = false;
+          index = node.end;
+        }
+      }
+      visits_.push_back(visit);
+    }
+    size_t slots = descend ? SlotsOf(*current) : 0;
+    if (slots > 0) {
+      stack_.push_back({current, 0, slots, 0, Node(), group});
+    } else if (group != kNoGroup) {
+      ended_.push_back(group);
+    }
+    while (!stack_.empty() && stack_.back().index == stack_.back().slots) {
+      if (stack_.back().group != kNoGroup) {
+        ended_.push_back(stack_.back().group);
+      }
+      stack_.pop_back();
+    }
+    if (stack_.empty()) {
+      break;
+    }
+    Open& top = stack_.back();
+    current = &ElementAt(*top.value, top.index++);
+  }
+
+  uint32_t next_id = 0;
+  for (uint32_t group : ended_) {
+    if (groups_[group].count > 1) {
+      groups_[group].id = next_id++;
+    }
+  }
+}
+
+DedupPlanner::Action DedupPlanner::Next(uint32_t* id) {
+  if (next_visit_ == visits_.size()) {
+    return Action::kWrite;
+  }
+  uint32_t visit = visits_[next_visit_++];
+  if (visit == kNoGroup || groups_[visit >> 1].count < 2) {
+    return Action::kWrite;
+  }
+  if ((visit & 1) != 0) {
+    return Action::kDefine;
+  }
+  *id = groups_[visit >> 1].id;
+  return Action::kRefer;
+}
+
+DedupWriter::DedupWriter(std::vector<uint8_t>* data, DedupPlanner* planner)
+    : StandardWriter(data),
+      planner_(planner != nullptr ? planner : &own_planner_) {}
+
+DedupWriter::DedupWriter(uint8_t* buffer,
+                         size_t capacity,
+                         DedupPlanner* planner)
+    : StandardWriter(buffer, capacity),
+      planner_(planner != nullptr ? planner : &own_planner_) {}
+
+DedupWriter::~DedupWriter() = default;
+
+bool DedupWriter::WriteShared(const Value& /*value*/, bool /*is_map_key*/) {
+  uint32_t id;
+  switch (planner_->Next(&id)) {
+    case DedupPlanner::Action::kWrite:
+      return false;
+    case DedupPlanner::Action::kDefine:
+      WriteByte(static_cast<uint8_t>(SharedField::kDefinition));
+      return false;
+    case DedupPlanner::Action::kRefer:
+      WriteByte(static_cast<uint8_t>(SharedField::kReference));
+      WriteVarint(id);
+      return true;
+  }
+  return false;
+}
+
+DedupReader::DedupReader(const uint8_t* data, size_t size)
+    : StandardReader(data, size) {}
+
+DedupReader::~DedupReader() = default;
+
+bool DedupReader::ReadValueOfType(uint8_t type, StandardToken* token) {
+  switch (static_cast<SharedField>(type)) {
+    case SharedField::kDefinition: {
+      uint8_t shared_type;
+      if (!ReadByte(&shared_type) ||
+          shared_type == static_cast<uint8_t>(SharedField::kDefinition) ||
+          shared_type == static_cast<uint8_t>(SharedField::kReference) ||
+          !ReadValueOfType(shared_type, token)) {
+        return false;
+      }
+      token->share = true;
+      return true;
+    }
+    case SharedField::kReference: {
+      uint32_t id;
+      if (!ReadVarint(&id) || id >= shared_.size()) {
+        return false;
+      }
+      token->type = StandardField::kNil;
+      token->shared = shared_[id];
+      return true;
+    }
+  }
+  return StandardReader::ReadValueOfType(type, token);
+}
+
+void DedupReader::ShareValue(const Value* value) {
+  shared_.push_back(value);
+}
+
+bool DedupMessageCodec::EncodeMessage(const Value& value,
+                                      std::vector<uint8_t>* encoded) {
+  // Not reserved up front like the standard codec does: repeats can make
+  // the encoding a fraction of |EncodedSizeOf|.
+  encoded->clear();
+  // Kept, like the scratch space of other codecs, so that encoding does
+  // not allocate once it has seen a message as large.
+  thread_local DedupPlanner planner;
+  DedupWriter writer(encoded, &planner);
+  writer.Plan(value);
+  writer.WriteValue(value);
+  return writer.ok();
+}
+
+const Value* DedupMessageCodec::DecodeMessage(const uint8_t* data,
+                                              size_t size,
+                                              Arena* arena,
+                                              DecodeMode mode) {
+  DedupReader reader(data, size);
+  const Value* value = DecodeValue(&reader, arena, mode);
+  if (value == nullptr || reader.HasMore()) {
+    return nullptr;
+  }
+  return value;
+}
+
+}  // namespace platzi
@@ -0,0 +1,184 @@
+#ifndef NATIVE_CODEC_DEDUP_CODEC_H_
+#define NATIVE_CODEC_DEDUP_CODEC_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "codec/arena.h"
+#include "codec/standard_reader.h"
+#include "codec/standard_writer.h"
+#include "codec/value.h"
+#include "codec/value_decoder.h"
+
+namespace platzi {
+
+// Type bytes of shared values.
+enum class SharedField : uint8_t {
+  // A value that later ones refer back to: the tag, then the value.
+  kDefinition = 66,
+  // A value equal to one defined earlier: its ID as a varint. IDs number
+  // definitions in the order their values end, elements included, so a
+  // value can never refer to itself or to anything it is part of.
+  kReference = 67,
+};
+
+// Strings, typed data, lists and maps encoding to fewer bytes than this are
+// always written in full; a reference would save too little.
+constexpr size_t kMinSharedSize = 8;
+
+// Finds the strings, typed data lists, lists and maps that appear more than
+// once in a message, for |DedupWriter|. Everything it works with lives in
+// flat vectors indexed in encoding order, which it keeps from one message
+// to the next, so that planning a message no larger than earlier ones does
+// not allocate.
+class DedupPlanner {
+ public:
+  DedupPlanner();
+  ~DedupPlanner();
+
+  DedupPlanner(const DedupPlanner&) = delete;
+  DedupPlanner& operator=(const DedupPlanner&) = delete;
+
+  // Plans |value|, forgetting the previous plan.
+  void Plan(const Value& value);
+
+  // What to write for a value that appears more than once.
+  enum class Action { kWrite, kDefine, kRefer };
+
+  // Returns what to do for the next string, typed data list, list or map
+  // that |StandardWriter::WriteValue| visits, and for |kRefer| the ID to
+  // refer to.
+  Action Next(uint32_t* id);
+
+ private:
+  // The content hash and approximate encoded size, without padding, of a
+  // value, and for the strings, typed data lists, lists and maps in
+  // |nodes_| the index past everything they contain.
+  struct Node {
+    uint64_t hash;
+    size_t size;
+    uint32_t end;
+  };
+
+  // Equal values, in the order they are first written.
+  struct Group {
+    uint64_t hash;
+    const Value* first;
+    uint32_t count;
+    uint32_t id;
+  };
+
+  // A list or map being walked.
+  struct Open {
+    const Value* value;
+    size_t index;
+    size_t slots;
+    // The entry of |value| in |nodes_|.
+    uint32_t node;
+    // While hashing, the hash and size of the elements so far; while
+    // planning, the group of |value| if it is the first of one.
+    Node folded;
+    uint32_t group;
+  };
+
+  static constexpr uint32_t kNoGroup = UINT32_MAX;
+
+  // Returns the node of |value|, which must not be a list or map.
+  static Node LeafNodeOf(const Value& value);
+
+  // Fills |nodes_| for |value| and everything it contains.
+  void HashNodes(const Value& value);
+
+  // Returns the group of values equal to |value|, whose hash is |hash|,
+  // adding one if there is none, and whether it was added.
+  uint32_t GroupOf(const Value& value, uint64_t hash, bool* added);
+
+  // The strings, typed data lists, lists and maps of the message in
+  // encoding order, repeats included.
+  std::vector<Node> nodes_;
+  std::vector<Group> groups_;
+  // An open-addressed table of |groups_| by hash; a power of two in size.
+  std::vector<uint32_t> table_;
+  // For every value |Next| is asked about, in order: kNoGroup if it is
+  // never shared, or its group, shifted left by one, with the low bit set
+  // on the first of the group.
+  std::vector<uint32_t> visits_;
+  size_t next_visit_ = 0;
+  // Scratch space.
+  std::vector<Open> stack_;
+  std::vector<uint32_t> ended_;
+  std::vector<std::pair<const Value*, const Value*>> pending_;
+};
+
+// A standard writer that writes each string, typed data list, list or map
+// that appears more than once in a message in full only the first time, and
+// as a reference to that first time after. Equal values are found by
+// content, so copies are shared as well as values reached twice.
+//
+// |Plan| must be called with each value before |WriteValue|.
+class DedupWriter : public StandardWriter {
+ public:
+  // Plans with |planner|, which must outlive the writer, if given.
+  explicit DedupWriter(std::vector<uint8_t>* data,
+                       DedupPlanner* planner = nullptr);
+  DedupWriter(uint8_t* buffer,
+              size_t capacity,
+              DedupPlanner* planner = nullptr);
+  ~DedupWriter() override;
+
+  // Finds the values that |WriteValue| will write by reference when passed
+  // |value| next.
+  void Plan(const Value& value) { planner_->Plan(value); }
+
+ protected:
+  bool WriteShared(const Value& value, bool is_map_key) override;
+
+ private:
+  DedupPlanner own_planner_;
+  DedupPlanner* planner_;
+};
+
+// A standard reader that resolves references to shared values. They come
+// out as tokens whose |shared| is the value decoded the first time, so
+// every reference to a value decodes to the same storage.
+class DedupReader : public StandardReader {
+ public:
+  DedupReader(const uint8_t* data, size_t size);
+  ~DedupReader() override;
+
+  bool ReadValueOfType(uint8_t type, StandardToken* token) override;
+  void ShareValue(const Value* value) override;
+
+ private:
+  std::vector<const Value*> shared_;
+};
+
+// A variant of |StandardMessageCodec| that sends repeated sub-values, such
+// as the same place description in every element of a list, once per
+// message. A message without repeats encodes exactly as with the standard
+// codec.
+//
+// Decoded trees share the storage of repeated values, which is why decoded
+// values are immutable: a change to one place would show in all of them.
+//
+// The Dart end of the channel needs a matching MessageCodec.
+class DedupMessageCodec {
+ public:
+  // Replaces the contents of |encoded| with the encoding of |value|.
+  // Returns false if it holds an extension value.
+  static bool EncodeMessage(const Value& value, std::vector<uint8_t>* encoded);
+
+  static const Value* DecodeMessage(const uint8_t* data,
+                                    size_t size,
+                                    Arena* arena,
+                                    DecodeMode mode = DecodeMode::kBorrow);
+
+ private:
+  DedupMessageCodec() = delete;
+};
+
+}  // namespace platzi
+
+#endif  // NATIVE_CODEC_DEDUP_CODEC_H_
@@ -0,0 +1,239 @@
+#include "codec/delta_varint.h"
+
+#include <cstring>
+
+namespace platzi {
+
+namespace {
+
+constexpr uint64_t kContinuationMask64 = 0x8080808080808080ull;
+// Continuation bits of four two-byte varints.
+constexpr uint64_t kTwoByteContinuations = 0x0080008000800080ull;
+
+inline uint64_t LoadElement(const uint8_t* values, size_t index) {
+  uint64_t value;
+  std::memcpy(&value, values + index * 8, 8);
+  return value;
+}
+
+inline uint64_t ZigZag(uint64_t delta) {
+  return (delta << 1) ^
+         static_cast<uint64_t>(static_cast<int64_t>(delta) >> 63);
+}
+
+inline uint64_t UnZigZag(uint64_t value) {
+  return (value >> 1) ^ (0 - (value & 1));
+}
+
+inline size_t VarintLength(uint64_t value) {
+  // 1 + floor(log2(value)) / 7, with 0 taking a byte like 1 does.
+  return (64 - __builtin_clzll(value | 1) + 6) / 7;
+}
+
+// Stores the zigzag differences of the eight elements at |values|, the
+// first from |previous|, in |zigzags| and returns them ORed together. The
+// differences are independent of each other and vectorize.
+inline uint64_t ZigZagGroup(const uint8_t* values,
+                            uint64_t previous,
+                            uint64_t zigzags[8]) {
+  uint64_t combined = 0;
+  for (size_t j = 0; j < 8; j++) {
+    uint64_t before = j == 0 ? previous : LoadElement(values, j - 1);
+    zigzags[j] = ZigZag(LoadElement(values, j) - before);
+    combined |= zigzags[j];
+  }
+  return combined;
+}
+
+// Varints of up to eight bytes, which hold 56 bits, are read and written a
+// word at a time: the 7-bit groups are spread to or gathered from the low
+// bits of each byte in three shift-and-mask steps, instead of a loop with a
+// branch per byte.
+constexpr uint64_t kMaxWordVarint = uint64_t{1} << 56;
+
+inline uint64_t SpreadGroups(uint64_t value) {
+  value = (value & 0x000000000FFFFFFFull) |
+          ((value & 0x00FFFFFFF0000000ull) << 4);
+  value = (value & 0x00003FFF00003FFFull) |
+          ((value & 0x0FFFC0000FFFC000ull) << 2);
+  return (value & 0x007F007F007F007Full) |
+         ((value & 0x3F803F803F803F80ull) << 1);
+}
+
+inline uint64_t GatherGroups(uint64_t word) {
+  word &= ~kContinuationMask64;
+  word = (word & 0x007F007F007F007Full) |
+         ((word & 0x7F007F007F007F00ull) >> 1);
+  word = (word & 0x00003FFF00003FFFull) |
+         ((word & 0x3FFF00003FFF0000ull) >> 2);
+  return (word & 0x000000000FFFFFFFull) |
+         ((word & 0x0FFFFFFF00000000ull) >> 4);
+}
+
+// Writes the varint of |value| at |out|, which has |size| bytes left, and
+// returns its length.
+inline size_t WriteVarint(uint64_t value, uint8_t* out, size_t size) {
+  if (value < kMaxWordVarint && size >= 8) {
+    size_t length = VarintLength(value);
+    uint64_t word = SpreadGroups(value) |
+                    (kContinuationMask64 & ((uint64_t{1} << (8 * length - 8)) -
+                                            1));
+    std::memcpy(out, &word, 8);
+    return length;
+  }
+  size_t length = 0;
+  while (value >= 0x80) {
+    out[length++] = static_cast<uint8_t>(value) | 0x80;
+    value >>= 7;
+  }
+  out[length++] = static_cast<uint8_t>(value);
+  return length;
+}
+
+// Reads the varint at |data|, which has |size| bytes left. Returns its
+// length, or 0 if it is truncated or longer than a 64-bit value allows.
+inline size_t ReadVarint(const uint8_t* data, size_t size, uint64_t* value) {
+  if (size >= 8) {
+    uint64_t word;
+    std::memcpy(&word, data, 8);
+    uint64_t ends = ~word & kContinuationMask64;
+    if (ends != 0) {
+      size_t length = __builtin_ctzll(ends) / 8 + 1;
+      *value = GatherGroups(word & (~uint64_t{0} >> (64 - 8 * length)));
+      return length;
+    }
+  }
+  uint64_t result = 0;
+  size_t limit = size < kMaxVarint64Length ? size : kMaxVarint64Length;
+  for (size_t i = 0; i < limit; i++) {
+    uint8_t byte = data[i];
+    result |= static_cast<uint64_t>(byte & 0x7F) << (7 * i);
+    if (byte < 0x80) {
+      // The tenth byte holds only the top bit.
+      if (i == kMaxVarint64Length - 1 && byte > 1) {
+        return 0;
+      }
+      *value = result;
+      return i + 1;
+    }
+  }
+  return 0;
+}
+
+}  // namespace
+
+size_t PackedSizeOfInt64Deltas(const uint8_t* values, size_t count) {
+  size_t size = 0;
+  uint64_t previous = 0;
+  size_t i = 0;
+  for (; count - i >= 8; i += 8) {
+    uint64_t zigzags[8];
+    uint64_t combined = ZigZagGroup(values + i * 8, previous, zigzags);
+    previous = LoadElement(values, i + 7);
+    if (combined < 0x80) {
+      size += 8;
+    } else if (combined < 0x4000) {
+      size += 16;
+    } else {
+      for (size_t j = 0; j < 8; j++) {
+        size += VarintLength(zigzags[j]);
+      }
+    }
+  }
+  for (; i < count; i++) {
+    uint64_t value = LoadElement(values, i);
+    size += VarintLength(ZigZag(value - previous));
+    previous = value;
+  }
+  return size;
+}
+
+void PackInt64Deltas(const uint8_t* values,
+                     size_t count,
+                     uint8_t* out,
+                     size_t size) {
+  size_t length = 0;
+  uint64_t previous = 0;
+  size_t i = 0;
+  // When the eight differences of a group all fit one or two bytes, which
+  // is the common case for the lists this is meant for, they go out without
+  // a loop per varint.
+  for (; count - i >= 8; i += 8) {
+    uint64_t zigzags[8];
+    uint64_t combined = ZigZagGroup(values + i * 8, previous, zigzags);
+    previous = LoadElement(values, i + 7);
+    if (combined < 0x80) {
+      for (size_t j = 0; j < 8; j++) {
+        out[length + j] = static_cast<uint8_t>(zigzags[j]);
+      }
+      length += 8;
+      continue;
+    }
+    if (combined < 0x4000) {
+      for (size_t j = 0; j < 8; j++) {
+        out[length + 2 * j] = static_cast<uint8_t>(zigzags[j]) | 0x80;
+        out[length + 2 * j + 1] = static_cast<uint8_t>(zigzags[j] >> 7);
+      }
+      length += 16;
+      continue;
+    }
+    for (size_t j = 0; j < 8; j++) {
+      length += WriteVarint(zigzags[j], out + length, size - length);
+    }
+  }
+  for (; i < count; i++) {
+    uint64_t value = LoadElement(values, i);
+    length += WriteVarint(ZigZag(value - previous), out + length,
+                          size - length);
+    previous = value;
+  }
+}
+
+bool UnpackInt64Deltas(const uint8_t* packed,
+                       size_t size,
+                       size_t count,
+                       int64_t* out) {
+  uint64_t previous = 0;
+  size_t position = 0;
+  size_t i = 0;
+  while (i < count) {
+    // A word of eight single-byte or four two-byte varints, told apart by
+    // its continuation bits, unpacks without looking for the end of each.
+    if (count - i >= 8 && size - position >= 8) {
+      uint64_t word;
+      std::memcpy(&word, packed + position, 8);
+      uint64_t continuations = word & kContinuationMask64;
+      if (continuations == 0) {
+        for (size_t j = 0; j < 8; j++) {
+          previous += UnZigZag((word >> (8 * j)) & 0xFF);
+          out[i + j] = static_cast<int64_t>(previous);
+        }
+        i += 8;
+        position += 8;
+        continue;
+      }
+      if (continuations == kTwoByteContinuations) {
+        word = (word & 0x007F007F007F007Full) |
+               ((word & 0x7F007F007F007F00ull) >> 1);
+        for (size_t j = 0; j < 4; j++) {
+          previous += UnZigZag((word >> (16 * j)) & 0xFFFF);
+          out[i + j] = static_cast<int64_t>(previous);
+        }
+        i += 4;
+        position += 8;
+        continue;
+      }
+    }
+    uint64_t zigzag;
+    size_t length = ReadVarint(packed + position, size - position, &zigzag);
+    if (length == 0) {
+      return false;
+    }
+    previous += UnZigZag(zigzag);
+    out[i++] = static_cast<int64_t>(previous);
+    position += length;
+  }
+  return position == size;
+}
+
+}  // namespace platzi
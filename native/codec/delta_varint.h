@@ -0,0 +1,42 @@
+#ifndef NATIVE_CODEC_DELTA_VARINT_H_
+#define NATIVE_CODEC_DELTA_VARINT_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace platzi {
+
+// Packing of the Int64DeltaData list of the standard encoding: each element
+// is sent as its difference from the previous one (the first from zero),
+// zigzag encoded so that small negative differences stay small, as an LEB128
+// varint. Timestamps, sequence numbers and offsets mostly advance by a few
+// units and pack into a byte or two per element instead of eight.
+//
+// Differences wrap around like unsigned arithmetic, so every list packs and
+// unpacks to itself, monotonic or not; a list that jumps around just packs
+// no smaller than it started.
+
+// The longest varint of a 64-bit value.
+constexpr size_t kMaxVarint64Length = 10;
+
+// Returns the number of bytes |PackInt64Deltas| writes for the |count|
+// native-order int64 elements at |values|, which need not be aligned.
+size_t PackedSizeOfInt64Deltas(const uint8_t* values, size_t count);
+
+// Packs the |count| elements at |values| into the |size| bytes at |out|,
+// where |size| is what |PackedSizeOfInt64Deltas| returned for them.
+void PackInt64Deltas(const uint8_t* values,
+                     size_t count,
+                     uint8_t* out,
+                     size_t size);
+
+// Unpacks the |size| bytes at |packed| into the |count| elements at |out|.
+// Returns false unless they are exactly |count| well-formed varints.
+bool UnpackInt64Deltas(const uint8_t* packed,
+                       size_t size,
+                       size_t count,
+                       int64_t* out);
+
+}  // namespace platzi
+
+#endif  // NATIVE_CODEC_DELTA_VARINT_H_
@@ -0,0 +1,121 @@
+#include "codec/extension_registry.h"
+
+namespace platzi {
+
+ExtensionRegistry::ExtensionRegistry() {
+  codes_.fill(0);
+}
+
+ExtensionRegistry::~ExtensionRegistry() = default;
+
+size_t ExtensionRegistry::SlotOf(const void* type_id) {
+  // Fibonacci hashing: the top byte of the product depends on every bit of
+  // the address.
+  uint64_t hash = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(type_id)) *
+                  0x9E3779B97F4A7C15ull;
+  return static_cast<size_t>(hash >> 56) % kTypeSlots;
+}
+
+bool ExtensionRegistry::Register(uint8_t code,
+                                 const void* type_id,
+                                 ExtensionEncoder encode,
+                                 ExtensionDecoder decode) {
+  if (!IsExtensionType(code) || type_id == nullptr ||
+      types_[code].type_id != nullptr) {
+    return false;
+  }
+  size_t slot = SlotOf(type_id);
+  while (codes_[slot] != 0) {
+    if (types_[codes_[slot]].type_id == type_id) {
+      return false;
+    }
+    slot = (slot + 1) % kTypeSlots;
+  }
+  codes_[slot] = code;
+  types_[code] = Entry{type_id, encode, decode};
+  size_++;
+  return true;
+}
+
+bool ExtensionRegistry::Encode(const ExtensionValue& value,
+                               StandardWriter* writer) const {
+  uint8_t code = 0;
+  for (size_t slot = SlotOf(value.type_id); codes_[slot] != 0;
+       slot = (slot + 1) % kTypeSlots) {
+    if (types_[codes_[slot]].type_id == value.type_id) {
+      code = codes_[slot];
+      break;
+    }
+  }
+  if (code == 0) {
+    return false;
+  }
+  // The payload needs its own writer, both because its size goes first and
+  // because its alignment is relative to its own start. The buffer is taken
+  // from the thread for the duration, so nested extension values get a
+  // fresh one.
+  thread_local std::vector<uint8_t> scratch;
+  std::vector<uint8_t> payload;
+  payload.swap(scratch);
+  payload.clear();
+  StandardWriter payload_writer(&payload);
+  payload_writer.set_extensions(this);
+  types_[code].encode(value.object, &payload_writer);
+  bool ok = payload_writer.ok();
+  if (ok) {
+    writer->WriteByte(code);
+    writer->WriteSize(static_cast<uint32_t>(payload.size()));
+    writer->WriteBytes(payload.data(), payload.size());
+  }
+  scratch.swap(payload);
+  return ok;
+}
+
+bool ExtensionRegistry::Decode(uint8_t code,
+                               const ByteSpan& payload,
+                               Arena* arena,
+                               DecodeMode mode,
+                               Value* value) const {
+  const Entry& entry = types_[code];
+  if (entry.decode == nullptr) {
+    return false;
+  }
+  StandardReader reader(payload.data, payload.size);
+  reader.set_extensions(this);
+  const void* object = entry.decode(&reader, arena, mode);
+  if (object == nullptr || reader.HasMore()) {
+    return false;
+  }
+  *value = Value::Extension(entry.type_id, object);
+  return true;
+}
+
+ExtensionMessageCodec::ExtensionMessageCodec(
+    const ExtensionRegistry* registry)
+    : registry_(registry) {}
+
+bool ExtensionMessageCodec::EncodeMessage(
+    const Value& value,
+    std::vector<uint8_t>* encoded) const {
+  encoded->clear();
+  encoded->reserve(EncodedSizeOf(value));
+  StandardWriter writer(encoded);
+  writer.set_extensions(registry_);
+  writer.WriteValue(value);
+  return writer.ok();
+}
+
+const Value* ExtensionMessageCodec::DecodeMessage(const uint8_t* data,
+                                                  size_t size,
+                                                  Arena* arena,
+                                                  DecodeMode mode) const {
+  StandardReader reader(data, size);
+  reader.set_extensions(registry_);
+  const Value* value = DecodeValue(&reader, arena, mode);
+  if (value == nullptr || reader.HasMore()) {
+    return nullptr;
+  }
+  return value;
+}
+
+}  // namespace platzi
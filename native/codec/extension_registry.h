@@ -0,0 +1,125 @@
+#ifndef NATIVE_CODEC_EXTENSION_REGISTRY_H_
+#define NATIVE_CODEC_EXTENSION_REGISTRY_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "codec/arena.h"
+#include "codec/standard_field.h"
+#include "codec/standard_reader.h"
+#include "codec/standard_writer.h"
+#include "codec/value.h"
+#include "codec/value_decoder.h"
+
+namespace platzi {
+
+// Writes the payload of the extension value |object| with |writer|, whose
+// alignment is relative to the start of the payload. Nested extension
+// values can be written with it.
+using ExtensionEncoder = void (*)(const void* object, StandardWriter* writer);
+
+// Reads an object of an extension type into |arena| with |reader|, which
+// spans exactly its payload, and returns it; returns nullptr if the payload
+// is malformed or not read to the end. In |DecodeMode::kBorrow| the object
+// may point into the payload.
+using ExtensionDecoder = const void* (*)(StandardReader* reader,
+                                         Arena* arena,
+                                         DecodeMode mode);
+
+// The extension types of a channel: the replacement for subclassing
+// FlutterStandardReaderWriter, FlutterStandardReader and
+// FlutterStandardWriter, where every custom type adds a check to a chain
+// of readValueOfType: and writeValue: overrides.
+//
+// Each type maps a type code from |kFirstExtensionType| on to functions
+// that encode and decode its payloads. Reading dispatches through a flat
+// table indexed by type byte, and writing through a hash of type IDs, so
+// neither depends on how many types are registered. Both ends of a channel
+// must register the same codes.
+//
+// Registration is not thread-safe; register every type before the registry
+// is first used.
+class ExtensionRegistry {
+ public:
+  ExtensionRegistry();
+  ~ExtensionRegistry();
+
+  ExtensionRegistry(const ExtensionRegistry&) = delete;
+  ExtensionRegistry& operator=(const ExtensionRegistry&) = delete;
+
+  // Registers the type |type_id| (see |ExtensionTypeId|) under |code|.
+  // Returns false if |code| is not an extension type code, or either is
+  // already registered.
+  bool Register(uint8_t code,
+                const void* type_id,
+                ExtensionEncoder encode,
+                ExtensionDecoder decode);
+
+  template <typename T>
+  bool Register(uint8_t code,
+                ExtensionEncoder encode,
+                ExtensionDecoder decode) {
+    return Register(code, ExtensionTypeId<T>(), encode, decode);
+  }
+
+  size_t size() const { return size_; }
+
+  // Writes the type byte, payload size and payload of |value|. Returns
+  // false, writing nothing, if its type is not registered.
+  bool Encode(const ExtensionValue& value, StandardWriter* writer) const;
+
+  // Decodes the payload of the extension type |code| into |value|. Returns
+  // false if the type is not registered or the payload is malformed.
+  bool Decode(uint8_t code,
+              const ByteSpan& payload,
+              Arena* arena,
+              DecodeMode mode,
+              Value* value) const;
+
+ private:
+  struct Entry {
+    const void* type_id = nullptr;
+    ExtensionEncoder encode = nullptr;
+    ExtensionDecoder decode = nullptr;
+  };
+
+  // Twice as many slots as there are extension type codes, so that the
+  // type ID hash stays at most half full.
+  static constexpr size_t kTypeSlots = 256;
+
+  static size_t SlotOf(const void* type_id);
+
+  // Indexed by type code; empty below |kFirstExtensionType|.
+  std::array<Entry, 256> types_;
+  // Open addressing over type IDs: the code of each registered type, 0 for
+  // empty slots.
+  std::array<uint8_t, kTypeSlots> codes_;
+  size_t size_ = 0;
+};
+
+// A variant of |StandardMessageCodec| for a channel with extension types,
+// the counterpart of a FlutterStandardMessageCodec made with a custom
+// FlutterStandardReaderWriter.
+class ExtensionMessageCodec {
+ public:
+  // |registry| must outlive the codec.
+  explicit ExtensionMessageCodec(const ExtensionRegistry* registry);
+
+  // Replaces the contents of |encoded| with the encoding of |value|.
+  // Returns false if it holds a value of an unregistered type.
+  bool EncodeMessage(const Value& value, std::vector<uint8_t>* encoded) const;
+
+  const Value* DecodeMessage(const uint8_t* data,
+                             size_t size,
+                             Arena* arena,
+                             DecodeMode mode = DecodeMode::kBorrow) const;
+
+ private:
+  const ExtensionRegistry* registry_;
+};
+
+}  // namespace platzi
+
+#endif  // NATIVE_CODEC_EXTENSION_REGISTRY_H_
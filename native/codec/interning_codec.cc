@@ -0,0 +1,187 @@
+#include "codec/interning_codec.h"
+
+#include <random>
+
+namespace platzi {
+
+namespace {
+
+// Bits of the flags byte that starts every message.
+constexpr uint8_t kResetFlag = 1;
+
+// Epochs of different incarnations of an encoder should differ, or a peer
+// that missed the reset could take one table for the other.
+uint32_t RandomEpoch() {
+  std::random_device device;
+  return static_cast<uint32_t>(device());
+}
+
+}  // namespace
+
+InterningEncoderTable::InterningEncoderTable(const InterningOptions& options)
+    : options_(options), epoch_(RandomEpoch()) {}
+
+InterningEncoderTable::~InterningEncoderTable() = default;
+
+void InterningEncoderTable::Reset() {
+  ids_.clear();
+  strings_.Reset();
+  epoch_++;
+  reset_pending_ = true;
+}
+
+bool InterningEncoderTable::Find(std::string_view string,
+                                 bool is_map_key,
+                                 uint32_t* id) {
+  if ((!is_map_key && !options_.intern_values) ||
+      string.size() > options_.max_length) {
+    *id = kNotInterned;
+    return false;
+  }
+  auto it = ids_.find(string);
+  if (it != ids_.end()) {
+    *id = it->second;
+    return true;
+  }
+  if (ids_.size() >= options_.max_entries) {
+    *id = kNotInterned;
+    return false;
+  }
+  *id = static_cast<uint32_t>(ids_.size());
+  ids_.emplace(strings_.CopyString(string), *id);
+  return false;
+}
+
+InterningDecoderTable::InterningDecoderTable(const InterningOptions& options)
+    : options_(options) {}
+
+InterningDecoderTable::~InterningDecoderTable() = default;
+
+void InterningDecoderTable::Reset(uint32_t epoch) {
+  strings_.clear();
+  storage_.Reset();
+  epoch_ = epoch;
+  in_sync_ = true;
+}
+
+bool InterningDecoderTable::Define(uint32_t id,
+                                   std::string_view string,
+                                   std::string_view* stored) {
+  if (id != strings_.size() || id >= options_.max_entries ||
+      string.size() > options_.max_length) {
+    return false;
+  }
+  *stored = storage_.CopyString(string);
+  strings_.push_back(*stored);
+  return true;
+}
+
+bool InterningDecoderTable::Lookup(uint32_t id,
+                                   std::string_view* string) const {
+  if (id >= strings_.size()) {
+    return false;
+  }
+  *string = strings_[id];
+  return true;
+}
+
+InterningWriter::InterningWriter(std::vector<uint8_t>* data,
+                                 InterningEncoderTable* table)
+    : StandardWriter(data), table_(table) {}
+
+InterningWriter::~InterningWriter() = default;
+
+void InterningWriter::WriteString(std::string_view value, bool is_map_key) {
+  uint32_t id;
+  if (table_->Find(value, is_map_key, &id)) {
+    WriteByte(static_cast<uint8_t>(InternedField::kReference));
+    WriteVarint(id);
+    return;
+  }
+  if (id == InterningEncoderTable::kNotInterned) {
+    StandardWriter::WriteString(value, is_map_key);
+    return;
+  }
+  WriteByte(static_cast<uint8_t>(InternedField::kDefinition));
+  WriteVarint(id);
+  WriteUTF8(value);
+}
+
+InterningReader::InterningReader(const uint8_t* data,
+                                 size_t size,
+                                 InterningDecoderTable* table)
+    : StandardReader(data, size), table_(table) {}
+
+InterningReader::~InterningReader() = default;
+
+bool InterningReader::ReadValueOfType(uint8_t type, StandardToken* token) {
+  uint32_t id;
+  switch (static_cast<InternedField>(type)) {
+    case InternedField::kDefinition: {
+      std::string_view string;
+      if (!ReadVarint(&id) || !ReadUTF8(&string) ||
+          !table_->Define(id, string, &token->string)) {
+        return false;
+      }
+      token->type = StandardField::kString;
+      return true;
+    }
+    case InternedField::kReference:
+      if (!ReadVarint(&id) || !table_->Lookup(id, &token->string)) {
+        return false;
+      }
+      token->type = StandardField::kString;
+      return true;
+  }
+  return StandardReader::ReadValueOfType(type, token);
+}
+
+InterningMessageCodec::InterningMessageCodec(const InterningOptions& options)
+    : encoder_table_(options), decoder_table_(options) {}
+
+InterningMessageCodec::~InterningMessageCodec() = default;
+
+bool InterningMessageCodec::EncodeMessage(const Value& value,
+                                          std::vector<uint8_t>* encoded) {
+  encoded->clear();
+  InterningWriter writer(encoded, &encoder_table_);
+  writer.WriteByte(encoder_table_.reset_pending() ? kResetFlag : 0);
+  writer.WriteScalar(encoder_table_.epoch());
+  encoder_table_.clear_reset_pending();
+  writer.WriteValue(value);
+  if (!writer.ok()) {
+    encoder_table_.Reset();
+    return false;
+  }
+  return true;
+}
+
+const Value* InterningMessageCodec::DecodeMessage(const uint8_t* data,
+                                                  size_t size,
+                                                  Arena* arena,
+                                                  DecodeMode mode) {
+  InterningReader reader(data, size, &decoder_table_);
+  uint8_t flags;
+  uint32_t epoch;
+  if (!reader.ReadByte(&flags) ||
+      !reader.ReadBytes(&epoch, sizeof(epoch))) {
+    decoder_table_.MarkOutOfSync();
+    return nullptr;
+  }
+  if ((flags & kResetFlag) != 0) {
+    decoder_table_.Reset(epoch);
+  } else if (!decoder_table_.in_sync() || epoch != decoder_table_.epoch()) {
+    decoder_table_.MarkOutOfSync();
+    return nullptr;
+  }
+  // A message that fails halfway may have defined some of its strings but
+  // not others, which the peer cannot know.
+  const Value* value = DecodeValue(&reader, arena, mode);
+  if (value == nullptr || reader.HasMore()) {
+    decoder_table_.MarkOutOfSync();
+    return nullptr;
+  }
+  return value;
+}
+
+}  // namespace platzi
@@ -0,0 +1,201 @@
+#ifndef NATIVE_CODEC_INTERNING_CODEC_H_
+#define NATIVE_CODEC_INTERNING_CODEC_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "codec/arena.h"
+#include "codec/standard_reader.h"
+#include "codec/standard_writer.h"
+#include "codec/value.h"
+#include "codec/value_decoder.h"
+
+namespace platzi {
+
+// Type bytes of interned strings. Both decode to plain strings.
+enum class InternedField : uint8_t {
+  // A string entering the table: its ID as a varint, then the string as
+  // |StandardWriter::WriteUTF8| writes it. IDs are handed out in order, so
+  // the ID is redundant unless a message went missing, which it detects.
+  kDefinition = 64,
+  // A string already in the table: its ID as a varint.
+  kReference = 65,
+};
+
+// Limits on what enters a string table. Both ends of a channel must use the
+// same limits; a decoder rejects definitions beyond them.
+struct InterningOptions {
+  // Strings longer than this are always written out in full.
+  size_t max_length = 64;
+  // Once the table holds this many strings, new ones are written in full.
+  uint32_t max_entries = 1024;
+  // Map keys are always interned. String values only are if this is set,
+  // which pays off for enum-like values but fills the table with unique
+  // ones otherwise.
+  bool intern_values = false;
+};
+
+// The sending half of a string table: the strings a peer has been sent and
+// the IDs they were given.
+class InterningEncoderTable {
+ public:
+  explicit InterningEncoderTable(const InterningOptions& options = {});
+  ~InterningEncoderTable();
+
+  InterningEncoderTable(const InterningEncoderTable&) = delete;
+  InterningEncoderTable& operator=(const InterningEncoderTable&) = delete;
+
+  const InterningOptions& options() const { return options_; }
+  size_t size() const { return ids_.size(); }
+
+  // Identifies this incarnation of the table; changes on every reset.
+  uint32_t epoch() const { return epoch_; }
+
+  // Whether the next message must tell the peer to start over.
+  bool reset_pending() const { return reset_pending_; }
+  void clear_reset_pending() { reset_pending_ = false; }
+
+  // Forgets every string and starts a new epoch.
+  void Reset();
+
+  static constexpr uint32_t kNotInterned = UINT32_MAX;
+
+  // Returns the ID of |string| in |id| and true if the peer already knows
+  // it. Otherwise adds it if it qualifies, storing its new ID in |id| or
+  // |kNotInterned| if it does not.
+  bool Find(std::string_view string, bool is_map_key, uint32_t* id);
+
+ private:
+  InterningOptions options_;
+  uint32_t epoch_;
+  bool reset_pending_ = true;
+  Arena strings_;
+  std::unordered_map<std::string_view, uint32_t> ids_;
+};
+
+// The receiving half of a string table.
+//
+// A table is in sync once a message has reset it. It falls out of sync when
+// a message refers to a string it has not seen, belongs to another epoch or
+// fails to decode for any other reason; it then rejects every message until
+// the peer resets its encoder.
+class InterningDecoderTable {
+ public:
+  explicit InterningDecoderTable(const InterningOptions& options = {});
+  ~InterningDecoderTable();
+
+  InterningDecoderTable(const InterningDecoderTable&) = delete;
+  InterningDecoderTable& operator=(const InterningDecoderTable&) = delete;
+
+  const InterningOptions& options() const { return options_; }
+  size_t size() const { return strings_.size(); }
+  bool in_sync() const { return in_sync_; }
+  uint32_t epoch() const { return epoch_; }
+
+  // Forgets every string and adopts |epoch|.
+  void Reset(uint32_t epoch);
+  void MarkOutOfSync() { in_sync_ = false; }
+
+  // Adds the string with the given |id|, which must be the next one, and
+  // returns its copy in the table.
+  bool Define(uint32_t id, std::string_view string, std::string_view* stored);
+  bool Lookup(uint32_t id, std::string_view* string) const;
+
+ private:
+  InterningOptions options_;
+  uint32_t epoch_ = 0;
+  bool in_sync_ = false;
+  Arena storage_;
+  std::vector<std::string_view> strings_;
+};
+
+// A standard writer that replaces strings by references into |table|.
+class InterningWriter : public StandardWriter {
+ public:
+  InterningWriter(std::vector<uint8_t>* data, InterningEncoderTable* table);
+  ~InterningWriter() override;
+
+ protected:
+  void WriteString(std::string_view value, bool is_map_key) override;
+
+ private:
+  InterningEncoderTable* table_;
+};
+
+// A standard reader that resolves interned strings through |table|. They
+// come out as |StandardField::kString| tokens pointing into the table.
+class InterningReader : public StandardReader {
+ public:
+  InterningReader(const uint8_t* data,
+                  size_t size,
+                  InterningDecoderTable* table);
+  ~InterningReader() override;
+
+  bool ReadValueOfType(uint8_t type, StandardToken* token) override;
+
+ private:
+  InterningDecoderTable* table_;
+};
+
+// A variant of |StandardMessageCodec| for one channel that sends each map
+// key (and optionally each short string value) in full only the first time,
+// and as a varint ID into a table both ends keep from then on.
+//
+// Every message starts with a flags byte and the 32-bit epoch of the
+// sender's table; the rest is the standard encoding with interned strings.
+// The reset protocol:
+//
+//  * A new encoder picks a random epoch and flags its first message as a
+//    reset, so a sender that restarts resets its peer's table.
+//  * |ResetEncoder| does the same on demand, with the next epoch.
+//  * A decoder that is out of sync, because it restarted or missed a
+//    message (Flutter drops messages sent while no handler is set), fails
+//    every message and reports |needs_peer_reset|. Its owner must then ask
+//    the peer, for instance with a method call on a control channel, to
+//    reset its encoder.
+//
+// The Dart end of the channel needs a matching MessageCodec.
+class InterningMessageCodec {
+ public:
+  explicit InterningMessageCodec(const InterningOptions& options = {});
+  ~InterningMessageCodec();
+
+  InterningMessageCodec(const InterningMessageCodec&) = delete;
+  InterningMessageCodec& operator=(const InterningMessageCodec&) = delete;
+
+  // Replaces the contents of |encoded| with the encoding of |value|.
+  // Returns false if it holds an extension value; the strings it defined
+  // are then forgotten by resetting the table, as the message is not sent.
+  bool EncodeMessage(const Value& value, std::vector<uint8_t>* encoded);
+
+  // Decodes a message from the peer. Returns nullptr if it is malformed or
+  // the table is out of sync.
+  //
+  // Interned strings point into the table rather than the message, even in
+  // |DecodeMode::kBorrow|, and stay valid until a message resetting the table
+  // is decoded.
+  const Value* DecodeMessage(const uint8_t* data,
+                             size_t size,
+                             Arena* arena,
+                             DecodeMode mode = DecodeMode::kBorrow);
+
+  // Starts a new table for outgoing messages; the next one resets the peer.
+  void ResetEncoder() { encoder_table_.Reset(); }
+
+  // True if incoming messages cannot be decoded until the peer resets.
+  bool needs_peer_reset() const { return !decoder_table_.in_sync(); }
+
+  const InterningEncoderTable& encoder_table() const { return encoder_table_; }
+  const InterningDecoderTable& decoder_table() const { return decoder_table_; }
+
+ private:
+  InterningEncoderTable encoder_table_;
+  InterningDecoderTable decoder_table_;
+};
+
+}  // namespace platzi
+
+#endif  // NATIVE_CODEC_INTERNING_CODEC_H_
@@ -0,0 +1,29 @@
+#include "codec/json_message_codec.h"
+
+#include "codec/json_reader.h"
+#include "codec/json_writer.h"
+
+namespace platzi {
+
+bool JsonMessageCodec::EncodeMessage(const Value& message,
+                                     std::vector<uint8_t>* encoded) {
+  encoded->clear();
+  if (message.is_null()) {
+    return true;
+  }
+  JsonWriter writer(encoded);
+  return writer.WriteValue(message);
+}
+
+const Value* JsonMessageCodec::DecodeMessage(const uint8_t* data,
+                                             size_t size,
+                                             Arena* arena,
+                                             DecodeMode mode) {
+  if (size == 0) {
+    return arena->New<Value>();
+  }
+  thread_local JsonReader reader;
+  return reader.Decode(data, size, arena, mode);
+}
+
+}  // namespace platzi
@@ -0,0 +1,37 @@
+#ifndef NATIVE_CODEC_JSON_MESSAGE_CODEC_H_
+#define NATIVE_CODEC_JSON_MESSAGE_CODEC_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "codec/arena.h"
+#include "codec/value.h"
+#include "codec/value_decoder.h"
+
+namespace platzi {
+
+// The counterpart of FlutterJSONMessageCodec: messages are UTF-8 encoded
+// JSON. Any value may be the top-level one. A null message encodes to no
+// bytes at all, and no bytes decode to null.
+class JsonMessageCodec {
+ public:
+  // Replaces the contents of |encoded| with the encoding of |message|.
+  // Returns false if |message| holds values JSON cannot represent.
+  static bool EncodeMessage(const Value& message,
+                            std::vector<uint8_t>* encoded);
+
+  // Decodes with a |JsonReader| kept per thread. Returns nullptr if the
+  // message is malformed.
+  static const Value* DecodeMessage(const uint8_t* data,
+                                    size_t size,
+                                    Arena* arena,
+                                    DecodeMode mode = DecodeMode::kBorrow);
+
+ private:
+  JsonMessageCodec() = delete;
+};
+
+}  // namespace platzi
+
+#endif  // NATIVE_CODEC_JSON_MESSAGE_CODEC_H_
@@ -0,0 +1,75 @@
+#include "codec/json_method_codec.h"
+
+#include "codec/json_message_codec.h"
+
+namespace platzi {
+
+bool JsonMethodCodec::EncodeMethodCall(const MethodCall& call,
+                                       std::vector<uint8_t>* encoded) {
+  MapEntry entries[2];
+  entries[0].key = Value::String("method");
+  entries[0].value = Value::String(call.method);
+  entries[1].key = Value::String("args");
+  entries[1].value = call.arguments;
+  return JsonMessageCodec::EncodeMessage(Value::Map(entries, 2), encoded);
+}
+
+bool JsonMethodCodec::DecodeMethodCall(const uint8_t* data,
+                                       size_t size,
+                                       Arena* arena,
+                                       MethodCall* call,
+                                       DecodeMode mode) {
+  const Value* message =
+      JsonMessageCodec::DecodeMessage(data, size, arena, mode);
+  if (message == nullptr) {
+    return false;
+  }
+  const Value* method = message->Find("method");
+  if (method == nullptr || method->type != ValueType::kString) {
+    return false;
+  }
+  const Value* arguments = message->Find("args");
+  call->method = method->string;
+  call->arguments = arguments != nullptr ? *arguments : Value::Null();
+  return true;
+}
+
+bool JsonMethodCodec::EncodeSuccessEnvelope(const Value& result,
+                                            std::vector<uint8_t>* encoded) {
+  return JsonMessageCodec::EncodeMessage(Value::List(&result, 1), encoded);
+}
+
+bool JsonMethodCodec::EncodeErrorEnvelope(const MethodError& error,
+                                          std::vector<uint8_t>* encoded) {
+  Value items[3] = {Value::String(error.code), error.message, error.details};
+  return JsonMessageCodec::EncodeMessage(Value::List(items, 3), encoded);
+}
+
+bool JsonMethodCodec::DecodeEnvelope(const uint8_t* data,
+                                     size_t size,
+                                     Arena* arena,
+                                     Envelope* envelope,
+                                     DecodeMode mode) {
+  const Value* message =
+      JsonMessageCodec::DecodeMessage(data, size, arena, mode);
+  if (message == nullptr || message->type != ValueType::kList) {
+    return false;
+  }
+  const Span<Value>& items = message->list;
+  if (items.size == 1) {
+    envelope->is_error = false;
+    envelope->result = items[0];
+    return true;
+  }
+  if (items.size != 3 || items[0].type != ValueType::kString ||
+      !(items[1].is_null() || items[1].type == ValueType::kString)) {
+    return false;
+  }
+  envelope->is_error = true;
+  envelope->error.code = items[0].string;
+  envelope->error.message = items[1];
+  envelope->error.details = items[2];
+  return true;
+}
+
+}  // namespace platzi
@@ -0,0 +1,47 @@
+#ifndef NATIVE_CODEC_JSON_METHOD_CODEC_H_
+#define NATIVE_CODEC_JSON_METHOD_CODEC_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "codec/arena.h"
+#include "codec/method_call.h"
+#include "codec/value.h"
+#include "codec/value_decoder.h"
+
+namespace platzi {
+
+// The counterpart of FlutterJSONMethodCodec. Method calls are encoded as
+// {"method": name, "args": arguments}, successful results as [result] and
+// errors as [code, message, details].
+//
+// Encoding fails for values |JsonMessageCodec| cannot encode; decoding fails
+// for malformed JSON and for JSON of the wrong shape.
+class JsonMethodCodec {
+ public:
+  static bool EncodeMethodCall(const MethodCall& call,
+                               std::vector<uint8_t>* encoded);
+  static bool DecodeMethodCall(const uint8_t* data,
+                               size_t size,
+                               Arena* arena,
+                               MethodCall* call,
+                               DecodeMode mode = DecodeMode::kBorrow);
+
+  static bool EncodeSuccessEnvelope(const Value& result,
+                                    std::vector<uint8_t>* encoded);
+  static bool EncodeErrorEnvelope(const MethodError& error,
+                                  std::vector<uint8_t>* encoded);
+  static bool DecodeEnvelope(const uint8_t* data,
+                             size_t size,
+                             Arena* arena,
+                             Envelope* envelope,
+                             DecodeMode mode = DecodeMode::kBorrow);
+
+ private:
+  JsonMethodCodec() = delete;
+};
+
+}  // namespace platzi
+
+#endif  // NATIVE_CODEC_JSON_METHOD_CODEC_H_
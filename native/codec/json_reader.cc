@@ -0,0 +1,812 @@
+#include "codec/json_reader.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <limits>
+#include <string_view>
+
+#include "codec/json_string.h"
+#include "codec/utf8.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PLATZI_JSON_X86 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define PLATZI_JSON_NEON 1
+#endif
+
+namespace platzi {
+
+namespace {
+
+constexpr uint8_t kWhitespace = 1 << 0;
+constexpr uint8_t kOperator = 1 << 1;
+constexpr uint8_t kQuote = 1 << 2;
+constexpr uint8_t kBackslash = 1 << 3;
+
+struct ByteClasses {
+  uint8_t classes[256] = {};
+
+  constexpr ByteClasses() {
+    classes[' '] = classes['\t'] = classes['\n'] = classes['\r'] =
+        kWhitespace;
+    classes['{'] = classes['}'] = classes['['] = classes[']'] =
+        classes[':'] = classes[','] = kOperator;
+    classes['"'] = kQuote;
+    classes['\\'] = kBackslash;
+  }
+};
+
+constexpr ByteClasses kClasses;
+
+// True for bytes that continue a number or literal.
+inline bool IsScalarByte(uint8_t byte) {
+  return (kClasses.classes[byte] & (kWhitespace | kOperator | kQuote)) == 0;
+}
+
+// Maps with more entries than this check for duplicate keys with a hash
+// table.
+constexpr size_t kLinearKeySearchMax = 16;
+
+// FNV-1a, which is quick for the short keys of JSON objects.
+inline size_t HashKey(std::string_view key) {
+  uint64_t hash = 14695981039346656037ull;
+  for (char c : key) {
+    hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+  }
+  return static_cast<size_t>(hash ^ (hash >> 32));
+}
+
+// A cheap one-bit hash of a map key. Keys with different signatures differ.
+inline uint64_t KeySignature(std::string_view key) {
+  size_t hash = key.size();
+  if (!key.empty()) {
+    hash = hash * 31 + static_cast<uint8_t>(key.front()) * 7 +
+           static_cast<uint8_t>(key.back());
+  }
+  return 1ull << (hash % 64);
+}
+
+inline bool IsDigit(uint8_t byte) {
+  return byte >= '0' && byte <= '9';
+}
+
+// One bit per byte of a 64-byte block, lowest bit first.
+struct BlockMasks {
+  uint64_t quote;
+  uint64_t backslash;
+  uint64_t op;
+  uint64_t whitespace;
+};
+
+// Bit i of the result is the parity of bits 0..i of |bits|.
+inline uint64_t PrefixXor(uint64_t bits) {
+  bits ^= bits << 1;
+  bits ^= bits << 2;
+  bits ^= bits << 4;
+  bits ^= bits << 8;
+  bits ^= bits << 16;
+  bits ^= bits << 32;
+  return bits;
+}
+
+// Turns the character masks of consecutive blocks into structural positions:
+// operators and opening quotes outside strings, and the first byte of every
+// run of other non-whitespace bytes (numbers, literals and garbage) outside
+// strings. Closing quotes are not indexed; the second pass finds them while
+// reading the string.
+class StructuralScanner {
+ public:
+  uint32_t* Scan(const BlockMasks& masks, size_t base, uint32_t* out) {
+    uint64_t quotes = masks.quote & ~Escaped(masks.backslash);
+    // From each opening quote up to, not including, its closing quote.
+    uint64_t in_string = PrefixXor(quotes) ^ in_string_;
+    in_string_ = static_cast<uint64_t>(static_cast<int64_t>(in_string) >> 63);
+    uint64_t outside = ~(in_string | quotes);
+    uint64_t op = masks.op & outside;
+    uint64_t scalar = outside & ~masks.whitespace & ~op;
+    uint64_t scalar_starts = scalar & ~((scalar << 1) | scalar_carry_);
+    scalar_carry_ = scalar >> 63;
+
+    uint64_t structurals = op | (quotes & in_string) | scalar_starts;
+    while (structurals != 0) {
+      *out++ = static_cast<uint32_t>(base + __builtin_ctzll(structurals));
+      structurals &= structurals - 1;
+    }
+    return out;
+  }
+
+  // True if the bytes scanned so far end inside a string.
+  bool in_string() const { return in_string_ != 0; }
+
+ private:
+  // Returns the bytes preceded by an escaping backslash. Backslashes are
+  // rare enough outside binary-ish payloads that walking them one by one
+  // beats the carry-propagating bit tricks.
+  uint64_t Escaped(uint64_t backslash) {
+    uint64_t escaped = escape_carry_;
+    escape_carry_ = 0;
+    uint64_t escapes = backslash & ~escaped;
+    while (escapes != 0) {
+      int bit = __builtin_ctzll(escapes);
+      if (bit == 63) {
+        escape_carry_ = 1;
+        break;
+      }
+      escaped |= 2ull << bit;
+      escapes &= ~(3ull << bit);
+    }
+    return escaped;
+  }
+
+  uint64_t in_string_ = 0;
+  uint64_t escape_carry_ = 0;
+  uint64_t scalar_carry_ = 0;
+};
+
+// Returns the 64-byte block at |offset|, padding a short last block with
+// whitespace in |padded|.
+inline const uint8_t* BlockAt(const uint8_t* data,
+                              size_t size,
+                              size_t offset,
+                              uint8_t* padded) {
+  if (size - offset >= 64) {
+    return data + offset;
+  }
+  std::memset(padded, ' ', 64);
+  std::memcpy(padded, data + offset, size - offset);
+  return padded;
+}
+
+#if defined(PLATZI_JSON_X86)
+
+// Adds the classes of the 16 bytes at |data| to |masks|, at bit |kShift|.
+// The shift is a template argument so that it compiles to an immediate.
+template <int kShift>
+inline void ClassifySse2Lane(const uint8_t* data, BlockMasks* masks) {
+  __m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+  // '[' and ']' differ from '{' and '}' only in bit 5.
+  __m128i folded = _mm_or_si128(input, _mm_set1_epi8(0x20));
+  __m128i op = _mm_or_si128(
+      _mm_or_si128(_mm_cmpeq_epi8(folded, _mm_set1_epi8('{')),
+                   _mm_cmpeq_epi8(folded, _mm_set1_epi8('}'))),
+      _mm_or_si128(_mm_cmpeq_epi8(input, _mm_set1_epi8(':')),
+                   _mm_cmpeq_epi8(input, _mm_set1_epi8(','))));
+  __m128i whitespace = _mm_or_si128(
+      _mm_or_si128(_mm_cmpeq_epi8(input, _mm_set1_epi8(' ')),
+                   _mm_cmpeq_epi8(input, _mm_set1_epi8('\t'))),
+      _mm_or_si128(_mm_cmpeq_epi8(input, _mm_set1_epi8('\n')),
+                   _mm_cmpeq_epi8(input, _mm_set1_epi8('\r'))));
+  auto mask = [](__m128i matches) {
+    return static_cast<uint64_t>(
+               static_cast<uint32_t>(_mm_movemask_epi8(matches)))
+           << kShift;
+  };
+  masks->quote |= mask(_mm_cmpeq_epi8(input, _mm_set1_epi8('"')));
+  masks->backslash |= mask(_mm_cmpeq_epi8(input, _mm_set1_epi8('\\')));
+  masks->op |= mask(op);
+  masks->whitespace |= mask(whitespace);
+}
+
+inline void ClassifySse2(const uint8_t* block, BlockMasks* masks) {
+  *masks = BlockMasks();
+  ClassifySse2Lane<0>(block, masks);
+  ClassifySse2Lane<16>(block + 16, masks);
+  ClassifySse2Lane<32>(block + 32, masks);
+  ClassifySse2Lane<48>(block + 48, masks);
+}
+
+uint32_t* IndexSse2(const uint8_t* data, size_t size, uint32_t* out) {
+  StructuralScanner scanner;
+  uint8_t padded[64];
+  for (size_t offset = 0; offset < size; offset += 64) {
+    BlockMasks masks;
+    ClassifySse2(BlockAt(data, size, offset, padded), &masks);
+    out = scanner.Scan(masks, offset, out);
+  }
+  return scanner.in_string() ? nullptr : out;
+}
+
+template <int kShift>
+__attribute__((target("avx2"))) inline void ClassifyAvx2Lane(
+    const uint8_t* data,
+    BlockMasks* masks) {
+  __m256i input = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+  __m256i folded = _mm256_or_si256(input, _mm256_set1_epi8(0x20));
+  __m256i op = _mm256_or_si256(
+      _mm256_or_si256(_mm256_cmpeq_epi8(folded, _mm256_set1_epi8('{')),
+                      _mm256_cmpeq_epi8(folded, _mm256_set1_epi8('}'))),
+      _mm256_or_si256(_mm256_cmpeq_epi8(input, _mm256_set1_epi8(':')),
+                      _mm256_cmpeq_epi8(input, _mm256_set1_epi8(','))));
+  __m256i whitespace = _mm256_or_si256(
+      _mm256_or_si256(_mm256_cmpeq_epi8(input, _mm256_set1_epi8(' ')),
+                      _mm256_cmpeq_epi8(input, _mm256_set1_epi8('\t'))),
+      _mm256_or_si256(_mm256_cmpeq_epi8(input, _mm256_set1_epi8('\n')),
+                      _mm256_cmpeq_epi8(input, _mm256_set1_epi8('\r'))));
+  masks->quote |= static_cast<uint64_t>(static_cast<uint32_t>(
+                      _mm256_movemask_epi8(_mm256_cmpeq_epi8(
+                          input, _mm256_set1_epi8('"')))))
+                  << kShift;
+  masks->backslash |= static_cast<uint64_t>(static_cast<uint32_t>(
+                          _mm256_movemask_epi8(_mm256_cmpeq_epi8(
+                              input, _mm256_set1_epi8('\\')))))
+                      << kShift;
+  masks->op |=
+      static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(op)))
+      << kShift;
+  masks->whitespace |= static_cast<uint64_t>(static_cast<uint32_t>(
+                           _mm256_movemask_epi8(whitespace)))
+                       << kShift;
+}
+
+__attribute__((target("avx2"))) inline void ClassifyAvx2(const uint8_t* block,
+                                                         BlockMasks* masks) {
+  *masks = BlockMasks();
+  ClassifyAvx2Lane<0>(block, masks);
+  ClassifyAvx2Lane<32>(block + 32, masks);
+}
+
+__attribute__((target("avx2"))) uint32_t* IndexAvx2(const uint8_t* data,
+                                                    size_t size,
+                                                    uint32_t* out) {
+  StructuralScanner scanner;
+  uint8_t padded[64];
+  for (size_t offset = 0; offset < size; offset += 64) {
+    BlockMasks masks;
+    ClassifyAvx2(BlockAt(data, size, offset, padded), &masks);
+    out = scanner.Scan(masks, offset, out);
+  }
+  return scanner.in_string() ? nullptr : out;
+}
+
+#elif defined(PLATZI_JSON_NEON)
+
+// Packs four vectors of 0x00/0xFF lanes into one bit per lane.
+inline uint64_t Mask64(uint8x16_t a, uint8x16_t b, uint8x16_t c, uint8x16_t d) {
+  const uint8x16_t weights = {1, 2, 4, 8, 16, 32, 64, 128,
+                              1, 2, 4, 8, 16, 32, 64, 128};
+  uint8x16_t ab = vpaddq_u8(vandq_u8(a, weights), vandq_u8(b, weights));
+  uint8x16_t cd = vpaddq_u8(vandq_u8(c, weights), vandq_u8(d, weights));
+  uint8x16_t abcd = vpaddq_u8(ab, cd);
+  abcd = vpaddq_u8(abcd, abcd);
+  return vgetq_lane_u64(vreinterpretq_u64_u8(abcd), 0);
+}
+
+inline void ClassifyNeon(const uint8_t* block, BlockMasks* masks) {
+  uint8x16_t quote[4];
+  uint8x16_t backslash[4];
+  uint8x16_t op[4];
+  uint8x16_t whitespace[4];
+  for (int lane = 0; lane < 4; lane++) {
+    uint8x16_t input = vld1q_u8(block + 16 * lane);
+    uint8x16_t folded = vorrq_u8(input, vdupq_n_u8(0x20));
+    quote[lane] = vceqq_u8(input, vdupq_n_u8('"'));
+    backslash[lane] = vceqq_u8(input, vdupq_n_u8('\\'));
+    op[lane] = vorrq_u8(vorrq_u8(vceqq_u8(folded, vdupq_n_u8('{')),
+                                 vceqq_u8(folded, vdupq_n_u8('}'))),
+                        vorrq_u8(vceqq_u8(input, vdupq_n_u8(':')),
+                                 vceqq_u8(input, vdupq_n_u8(','))));
+    whitespace[lane] = vorrq_u8(vorrq_u8(vceqq_u8(input, vdupq_n_u8(' ')),
+                                         vceqq_u8(input, vdupq_n_u8('\t'))),
+                                vorrq_u8(vceqq_u8(input, vdupq_n_u8('\n')),
+                                         vceqq_u8(input, vdupq_n_u8('\r'))));
+  }
+  masks->quote = Mask64(quote[0], quote[1], quote[2], quote[3]);
+  masks->backslash =
+      Mask64(backslash[0], backslash[1], backslash[2], backslash[3]);
+  masks->op = Mask64(op[0], op[1], op[2], op[3]);
+  masks->whitespace =
+      Mask64(whitespace[0], whitespace[1], whitespace[2], whitespace[3]);
+}
+
+uint32_t* IndexNeon(const uint8_t* data, size_t size, uint32_t* out) {
+  StructuralScanner scanner;
+  uint8_t padded[64];
+  for (size_t offset = 0; offset < size; offset += 64) {
+    BlockMasks masks;
+    ClassifyNeon(BlockAt(data, size, offset, padded), &masks);
+    out = scanner.Scan(masks, offset, out);
+  }
+  return scanner.in_string() ? nullptr : out;
+}
+
+#else
+
+inline void ClassifyScalar(const uint8_t* block, BlockMasks* masks) {
+  *masks = BlockMasks();
+  for (int i = 0; i < 64; i++) {
+    uint8_t classes = kClasses.classes[block[i]];
+    uint64_t bit = 1ull << i;
+    masks->quote |= (classes & kQuote) != 0 ? bit : 0;
+    masks->backslash |= (classes & kBackslash) != 0 ? bit : 0;
+    masks->op |= (classes & kOperator) != 0 ? bit : 0;
+    masks->whitespace |= (classes & kWhitespace) != 0 ? bit : 0;
+  }
+}
+
+uint32_t* IndexScalar(const uint8_t* data, size_t size, uint32_t* out) {
+  StructuralScanner scanner;
+  uint8_t padded[64];
+  for (size_t offset = 0; offset < size; offset += 64) {
+    BlockMasks masks;
+    ClassifyScalar(BlockAt(data, size, offset, padded), &masks);
+    out = scanner.Scan(masks, offset, out);
+  }
+  return scanner.in_string() ? nullptr : out;
+}
+
+#endif
+
+// Stores the structural positions of |data| at |out| and returns their end,
+// or nullptr if |data| ends inside a string.
+using IndexFunction = uint32_t* (*)(const uint8_t*, size_t, uint32_t*);
+
+IndexFunction ResolveIndex() {
+#if defined(PLATZI_JSON_X86)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return IndexAvx2;
+  }
+  return IndexSse2;
+#elif defined(PLATZI_JSON_NEON)
+  return IndexNeon;
+#else
+  return IndexScalar;
+#endif
+}
+
+// Returns true if the well-formed number in [start, end) is below one in
+// magnitude, judging by its digits and exponent.
+bool IsTiny(const uint8_t* start, const uint8_t* end) {
+  const uint8_t* p = start;
+  if (*p == '-') {
+    p++;
+  }
+  // The power of ten of the first significant digit.
+  int64_t order = -1;
+  if (*p == '0') {
+    p++;
+    if (p != end && *p == '.') {
+      for (p++; p != end && *p == '0'; p++) {
+        order--;
+      }
+    }
+  } else {
+    for (; p != end && IsDigit(*p); p++) {
+      order++;
+    }
+  }
+  while (p != end && *p != 'e' && *p != 'E') {
+    p++;
+  }
+  if (p != end) {
+    p++;
+    bool negative = *p == '-';
+    if (*p == '-' || *p == '+') {
+      p++;
+    }
+    int64_t exponent = 0;
+    for (; p != end; p++) {
+      exponent = std::min<int64_t>(exponent * 10 + (*p - '0'), 1 << 30);
+    }
+    order += negative ? -exponent : exponent;
+  }
+  return order < 0;
+}
+
+inline int HexDigit(uint8_t byte) {
+  if (IsDigit(byte)) {
+    return byte - '0';
+  }
+  byte |= 0x20;
+  return byte >= 'a' && byte <= 'f' ? byte - 'a' + 10 : -1;
+}
+
+// Reads the four hex digits of a \u escape at |data|.
+inline bool ReadHex4(const uint8_t* data,
+                     const uint8_t* end,
+                     uint32_t* code_unit) {
+  if (end - data < 4) {
+    return false;
+  }
+  uint32_t value = 0;
+  for (int i = 0; i < 4; i++) {
+    int digit = HexDigit(data[i]);
+    if (digit < 0) {
+      return false;
+    }
+    value = (value << 4) | static_cast<uint32_t>(digit);
+  }
+  *code_unit = value;
+  return true;
+}
+
+void AppendUtf8(uint32_t code_point, std::string* out) {
+  if (code_point < 0x80) {
+    out->push_back(static_cast<char>(code_point));
+  } else if (code_point < 0x800) {
+    out->push_back(static_cast<char>(0xC0 | (code_point >> 6)));
+    out->push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+  } else if (code_point < 0x10000) {
+    out->push_back(static_cast<char>(0xE0 | (code_point >> 12)));
+    out->push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+    out->push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+  } else {
+    out->push_back(static_cast<char>(0xF0 | (code_point >> 18)));
+    out->push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3F)));
+    out->push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+    out->push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+  }
+}
+
+// Decodes the escape sequence after the backslash at |*data| and advances
+// past it. Unpaired surrogates become U+FFFD, as they do on their way from
+// an NSString into UTF-8.
+bool Unescape(const uint8_t** data, const uint8_t* end, std::string* out) {
+  const uint8_t* p = *data + 1;
+  if (p == end) {
+    return false;
+  }
+  switch (*p) {
+    case '"':
+    case '\\':
+    case '/':
+      out->push_back(static_cast<char>(*p));
+      break;
+    case 'b':
+      out->push_back('\b');
+      break;
+    case 'f':
+      out->push_back('\f');
+      break;
+    case 'n':
+      out->push_back('\n');
+      break;
+    case 'r':
+      out->push_back('\r');
+      break;
+    case 't':
+      out->push_back('\t');
+      break;
+    case 'u': {
+      uint32_t code_point;
+      if (!ReadHex4(p + 1, end, &code_point)) {
+        return false;
+      }
+      p += 4;
+      if (code_point >= 0xD800 && code_point <= 0xDBFF) {
+        uint32_t low;
+        if (end - p >= 7 && p[1] == '\\' && p[2] == 'u' &&
+            ReadHex4(p + 3, end, &low) && low >= 0xDC00 && low <= 0xDFFF) {
+          code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+          p += 6;
+        } else {
+          code_point = 0xFFFD;
+        }
+      } else if (code_point >= 0xDC00 && code_point <= 0xDFFF) {
+        code_point = 0xFFFD;
+      }
+      AppendUtf8(code_point, out);
+      break;
+    }
+    default:
+      return false;
+  }
+  *data = p + 1;
+  return true;
+}
+
+}  // namespace
+
+JsonReader::JsonReader() = default;
+
+JsonReader::~JsonReader() = default;
+
+const Value* JsonReader::Decode(const uint8_t* data,
+                                size_t size,
+                                Arena* arena,
+                                DecodeMode mode) {
+  if (size == 0 || size > std::numeric_limits<uint32_t>::max() ||
+      !ValidateUtf8(data, size)) {
+    return nullptr;
+  }
+  data_ = data;
+  size_ = size;
+  arena_ = arena;
+  mode_ = mode;
+
+  // Every structural position is a distinct byte of the input.
+  if (index_.size() < size) {
+    index_.resize(size);
+  }
+  static const IndexFunction index_structurals = ResolveIndex();
+  const uint32_t* index_end = index_structurals(data, size, index_.data());
+  if (index_end == nullptr) {
+    return nullptr;
+  }
+
+  enum class Expect {
+    kValue,
+    kValueOrListEnd,
+    kKey,
+    kKeyOrMapEnd,
+    kColon,
+    kCommaOrEnd,
+  };
+  values_.clear();
+  open_.clear();
+  Expect expect = Expect::kValue;
+  for (const uint32_t* it = index_.data(); it != index_end; ++it) {
+    size_t position = *it;
+    uint8_t byte = data[position];
+    switch (expect) {
+      case Expect::kValueOrListEnd:
+        if (byte == ']') {
+          CloseContainer();
+          expect = Expect::kCommaOrEnd;
+          break;
+        }
+        [[fallthrough]];
+      case Expect::kValue: {
+        if (byte == '[' || byte == '{') {
+          open_.push_back({byte == '{', values_.size()});
+          expect = byte == '{' ? Expect::kKeyOrMapEnd
+                               : Expect::kValueOrListEnd;
+          break;
+        }
+        Value value;
+        if (!(byte == '"' ? ReadString(position, &value)
+                          : ReadScalar(position, &value))) {
+          return nullptr;
+        }
+        values_.push_back(value);
+        expect = Expect::kCommaOrEnd;
+        break;
+      }
+      case Expect::kKeyOrMapEnd:
+        if (byte == '}') {
+          CloseContainer();
+          expect = Expect::kCommaOrEnd;
+          break;
+        }
+        [[fallthrough]];
+      case Expect::kKey: {
+        Value key;
+        if (byte != '"' || !ReadString(position, &key)) {
+          return nullptr;
+        }
+        values_.push_back(key);
+        expect = Expect::kColon;
+        break;
+      }
+      case Expect::kColon:
+        if (byte != ':') {
+          return nullptr;
+        }
+        expect = Expect::kValue;
+        break;
+      case Expect::kCommaOrEnd: {
+        if (open_.empty()) {
+          // Something follows the top-level value.
+          return nullptr;
+        }
+        bool is_map = open_.back().is_map;
+        if (byte == ',') {
+          expect = is_map ? Expect::kKey : Expect::kValue;
+        } else if (byte == (is_map ? '}' : ']')) {
+          CloseContainer();
+        } else {
+          return nullptr;
+        }
+        break;
+      }
+    }
+  }
+  if (expect != Expect::kCommaOrEnd || !open_.empty()) {
+    return nullptr;
+  }
+  return arena->New<Value>(values_.front());
+}
+
+bool JsonReader::ReadString(size_t position, Value* value) {
+  const uint8_t* begin = data_ + position + 1;
+  const uint8_t* end = data_ + size_;
+  const uint8_t* p = FindJsonStringSpecial(begin, end);
+  if (p != end && *p == '"') {
+    std::string_view string(reinterpret_cast<const char*>(begin), p - begin);
+    *value = Value::String(mode_ == DecodeMode::kCopy
+                               ? arena_->CopyString(string)
+                               : string);
+    return true;
+  }
+  unescaped_.assign(begin, p);
+  while (p != end && *p == '\\') {
+    if (!Unescape(&p, end, &unescaped_)) {
+      return false;
+    }
+    const uint8_t* run = p;
+    p = FindJsonStringSpecial(run, end);
+    unescaped_.append(run, p);
+  }
+  if (p == end || *p != '"') {
+    // Unterminated, or a raw control character.
+    return false;
+  }
+  *value = Value::String(arena_->CopyString(unescaped_));
+  return true;
+}
+
+bool JsonReader::ReadScalar(size_t position, Value* value) {
+  const uint8_t* start = data_ + position;
+  const uint8_t* end = data_ + size_;
+  const uint8_t* p = start;
+
+  auto literal = [&](const char* text, size_t length) {
+    if (static_cast<size_t>(end - p) < length ||
+        std::memcmp(p, text, length) != 0) {
+      return false;
+    }
+    p += length;
+    return p == end || !IsScalarByte(*p);
+  };
+  switch (*p) {
+    case 't':
+      *value = Value::Bool(true);
+      return literal("true", 4);
+    case 'f':
+      *value = Value::Bool(false);
+      return literal("false", 5);
+    case 'n':
+      *value = Value::Null();
+      return literal("null", 4);
+    default:
+      break;
+  }
+
+  bool negative = *p == '-';
+  if (negative) {
+    p++;
+  }
+  if (p == end || !IsDigit(*p)) {
+    return false;
+  }
+  uint64_t magnitude = 0;
+  int digits = 0;
+  if (*p == '0') {
+    p++;
+  } else {
+    for (; p != end && IsDigit(*p); p++, digits++) {
+      // Nineteen digits always fit.
+      if (digits < 19) {
+        magnitude = magnitude * 10 + (*p - '0');
+      }
+    }
+  }
+  bool is_integer = true;
+  if (p != end && *p == '.') {
+    is_integer = false;
+    p++;
+    if (p == end || !IsDigit(*p)) {
+      return false;
+    }
+    while (p != end && IsDigit(*p)) {
+      p++;
+    }
+  }
+  if (p != end && (*p == 'e' || *p == 'E')) {
+    is_integer = false;
+    p++;
+    if (p != end && (*p == '+' || *p == '-')) {
+      p++;
+    }
+    if (p == end || !IsDigit(*p)) {
+      return false;
+    }
+    while (p != end && IsDigit(*p)) {
+      p++;
+    }
+  }
+  if (p != end && IsScalarByte(*p)) {
+    return false;
+  }
+
+  constexpr uint64_t kInt64Max = std::numeric_limits<int64_t>::max();
+  if (is_integer && digits <= 19 &&
+      magnitude <= (negative ? kInt64Max + 1 : kInt64Max)) {
+    int64_t integer = negative ? static_cast<int64_t>(0 - magnitude)
+                               : static_cast<int64_t>(magnitude);
+    if (integer >= std::numeric_limits<int32_t>::min() &&
+        integer <= std::numeric_limits<int32_t>::max()) {
+      *value = Value::Int32(static_cast<int32_t>(integer));
+    } else {
+      *value = Value::Int64(integer);
+    }
+    return true;
+  }
+  double number;
+  auto result = std::from_chars(reinterpret_cast<const char*>(start),
+                                reinterpret_cast<const char*>(p), number);
+  if (result.ec == std::errc::result_out_of_range && IsTiny(start, p)) {
+    // Underflow rounds to zero rather than failing, as with strtod.
+    number = negative ? -0.0 : 0.0;
+  } else if (result.ec != std::errc()) {
+    return false;
+  }
+  *value = Value::Float64(number);
+  return true;
+}
+
+void JsonReader::CloseContainer() {
+  Container container = open_.back();
+  open_.pop_back();
+  const Value* elements = values_.data() + container.first;
+  size_t count = values_.size() - container.first;
+  Value result;
+  if (!container.is_map) {
+    Value* items = count == 0 ? nullptr : static_cast<Value*>(arena_->Allocate(
+                                              sizeof(Value) * count,
+                                              alignof(Value)));
+    std::copy(elements, elements + count, items);
+    result = Value::List(items, count);
+  } else {
+    size_t pairs = count / 2;
+    MapEntry* entries =
+        pairs == 0 ? nullptr
+                   : static_cast<MapEntry*>(arena_->Allocate(
+                         sizeof(MapEntry) * pairs, alignof(MapEntry)));
+    // Later duplicates replace the value of the first entry with their key.
+    // Small maps are searched linearly, but only for keys whose signature
+    // bit is already taken; large ones go through an open-addressed table
+    // of entry indices plus one, at most half full.
+    size_t size = 0;
+    uint64_t signatures = 0;
+    size_t mask = 0;
+    if (pairs > kLinearKeySearchMax) {
+      size_t capacity = 64;
+      while (capacity < 2 * pairs) {
+        capacity *= 2;
+      }
+      key_slots_.assign(capacity, 0);
+      mask = capacity - 1;
+    }
+    for (size_t i = 0; i < pairs; i++) {
+      const Value& key = elements[2 * i];
+      size_t j = 0;
+      if (pairs <= kLinearKeySearchMax) {
+        uint64_t signature = KeySignature(key.string);
+        if ((signatures & signature) == 0) {
+          signatures |= signature;
+          j = size;
+        }
+        while (j < size && entries[j].key.string != key.string) {
+          j++;
+        }
+      } else {
+        for (size_t k = HashKey(key.string) & mask;; k = (k + 1) & mask) {
+          uint32_t& slot = key_slots_[k];
+          if (slot == 0) {
+            slot = static_cast<uint32_t>(size + 1);
+            j = size;
+            break;
+          }
+          if (entries[slot - 1].key.string == key.string) {
+            j = slot - 1;
+            break;
+          }
+        }
+      }
+      if (j == size) {
+        entries[size].key = key;
+        size++;
+      }
+      entries[j].value = elements[2 * i + 1];
+    }
+    result = Value::Map(entries, size);
+  }
+  values_.resize(container.first);
+  values_.push_back(result);
+}
+
+}  // namespace platzi
@@ -0,0 +1,77 @@
+#ifndef NATIVE_CODEC_JSON_READER_H_
+#define NATIVE_CODEC_JSON_READER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "codec/arena.h"
+#include "codec/value.h"
+#include "codec/value_decoder.h"
+
+namespace platzi {
+
+// A JSON decoder producing the same trees as the NSJSONSerialization parsing
+// behind FlutterJSONMessageCodec: integers become Int32 or Int64 values when
+// they fit and Float64 values otherwise, and the last of several entries with
+// the same key wins. Any value is accepted at the top level.
+//
+// Decoding takes two passes. The first validates UTF-8 and indexes every
+// structural character, string and scalar, 64 bytes at a time with SSE2 or
+// AVX2 (picked at run time) or NEON. The second walks the index and builds
+// the tree in an arena; it only touches the bytes of scalars and strings.
+//
+// A reader keeps its scratch buffers between messages, so reusing one avoids
+// allocating anything outside the arena.
+class JsonReader {
+ public:
+  JsonReader();
+  ~JsonReader();
+
+  JsonReader(const JsonReader&) = delete;
+  JsonReader& operator=(const JsonReader&) = delete;
+
+  // Decodes |data|, which must hold exactly one JSON value surrounded by
+  // optional whitespace. Returns nullptr if it is malformed or larger than
+  // 4 GB.
+  const Value* Decode(const uint8_t* data,
+                      size_t size,
+                      Arena* arena,
+                      DecodeMode mode = DecodeMode::kBorrow);
+
+ private:
+  // A list or map whose elements are still being decoded. Its elements (keys
+  // and values alternating, for maps) sit on |values_| from |first| on.
+  struct Container {
+    bool is_map;
+    size_t first;
+  };
+
+  // Decodes the string whose opening quote is at |position|.
+  bool ReadString(size_t position, Value* value);
+
+  // Decodes the number, true, false or null starting at |position|.
+  bool ReadScalar(size_t position, Value* value);
+
+  // Replaces the elements of the innermost container by the container.
+  void CloseContainer();
+
+  const uint8_t* data_ = nullptr;
+  size_t size_ = 0;
+  Arena* arena_ = nullptr;
+  DecodeMode mode_ = DecodeMode::kBorrow;
+
+  // Positions found by the first pass.
+  std::vector<uint32_t> index_;
+  std::vector<Value> values_;
+  std::vector<Container> open_;
+  std::string unescaped_;
+  // An open-addressed table of the entries of the map being closed, by
+  // key, holding entry indices plus one; only used for large maps.
+  std::vector<uint32_t> key_slots_;
+};
+
+}  // namespace platzi
+
+#endif  // NATIVE_CODEC_JSON_READER_H_
@@ -0,0 +1,59 @@
+#ifndef NATIVE_CODEC_JSON_STRING_H_
+#define NATIVE_CODEC_JSON_STRING_H_
+
+#include <cstdint>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace platzi {
+
+// Returns true for the bytes a JSON string cannot hold unescaped.
+inline bool IsJsonStringSpecial(uint8_t byte) {
+  return byte < 0x20 || byte == '"' || byte == '\\';
+}
+
+// Returns the first quote, backslash or control character in [data, end), or
+// |end|. Shared by the reader, which looks for the end of a string or its
+// next escape, and the writer, which copies the runs in between as is.
+inline const uint8_t* FindJsonStringSpecial(const uint8_t* data,
+                                            const uint8_t* end) {
+#if defined(__SSE2__)
+  while (end - data >= 16) {
+    __m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+    __m128i special = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(input, _mm_set1_epi8('"')),
+                     _mm_cmpeq_epi8(input, _mm_set1_epi8('\\'))),
+        _mm_cmpeq_epi8(_mm_max_epu8(input, _mm_set1_epi8(0x1F)),
+                       _mm_set1_epi8(0x1F)));
+    unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(special));
+    if (mask != 0) {
+      return data + __builtin_ctz(mask);
+    }
+    data += 16;
+  }
+#elif defined(__aarch64__)
+  while (end - data >= 16) {
+    uint8x16_t input = vld1q_u8(data);
+    uint8x16_t special =
+        vorrq_u8(vorrq_u8(vceqq_u8(input, vdupq_n_u8('"')),
+                          vceqq_u8(input, vdupq_n_u8('\\'))),
+                 vcltq_u8(input, vdupq_n_u8(0x20)));
+    if (vmaxvq_u8(special) != 0) {
+      break;
+    }
+    data += 16;
+  }
+#endif
+  while (data != end && !IsJsonStringSpecial(*data)) {
+    data++;
+  }
+  return data;
+}
+
+}  // namespace platzi
+
+#endif  // NATIVE_CODEC_JSON_STRING_H_
@@ -0,0 +1,288 @@
+#include "codec/json_writer.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+#include "codec/json_string.h"
+
+namespace platzi {
+
+namespace {
+
+constexpr char kHexDigits[] = "0123456789abcdef";
+
+// "00" to "99", for formatting integers two digits at a time.
+struct DigitPairs {
+  char digits[200] = {};
+
+  constexpr DigitPairs() {
+    for (int i = 0; i < 100; i++) {
+      digits[2 * i] = static_cast<char>('0' + i / 10);
+      digits[2 * i + 1] = static_cast<char>('0' + i % 10);
+    }
+  }
+};
+
+constexpr DigitPairs kDigitPairs;
+
+// The letter after the backslash for control characters with a short escape,
+// or 'u' for those written as \u00XX.
+constexpr char kControlEscapes[32] = {
+    'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u',  //
+    'b', 't', 'n', 'u', 'f', 'r', 'u', 'u',  //
+    'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u',  //
+    'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u',  //
+};
+
+// Bytes of the longest shortest-roundtrip double, -2.2250738585072014e-308,
+// with room to spare.
+constexpr size_t kMaxDoubleLength = 32;
+
+// Integral doubles up to 2^53 in magnitude, where every integer is
+// representable, print through the integer path.
+constexpr double kMaxExactInteger = 9007199254740992.0;
+
+// Bytes of the longest int64, -9223372036854775808.
+constexpr size_t kMaxIntegerLength = 20;
+
+// A list or map whose elements are still being written.
+struct Frame {
+  const Value* items;
+  const MapEntry* entries;
+  size_t index;
+  size_t size;
+};
+
+inline int DigitCount(uint64_t value) {
+  int count = 1;
+  for (uint64_t bound = 10; count < 20 && value >= bound; bound *= 10) {
+    count++;
+  }
+  return count;
+}
+
+// Writes the decimal digits of |value| at |out| and returns their end.
+inline uint8_t* FormatUnsigned(uint64_t value, uint8_t* out) {
+  uint8_t* end = out + DigitCount(value);
+  uint8_t* p = end;
+  while (value >= 100) {
+    p -= 2;
+    std::memcpy(p, kDigitPairs.digits + (value % 100) * 2, 2);
+    value /= 100;
+  }
+  if (value >= 10) {
+    p -= 2;
+    std::memcpy(p, kDigitPairs.digits + value * 2, 2);
+  } else {
+    *--p = static_cast<uint8_t>('0' + value);
+  }
+  return end;
+}
+
+// How many bytes |Grow| extends the vector by at least.
+constexpr size_t kGrowthStep = 256;
+
+}  // namespace
+
+JsonWriter::JsonWriter(std::vector<uint8_t>* data) : data_(data) {}
+
+JsonWriter::~JsonWriter() = default;
+
+bool JsonWriter::WriteValue(const Value& value) {
+  cursor_ = data_->data() + data_->size();
+  end_ = cursor_;
+  bool ok = WriteTree(value);
+  data_->resize(cursor_ - data_->data());
+  return ok;
+}
+
+void JsonWriter::Grow(size_t size) {
+  // Extends the vector only a little past what is needed, as everything
+  // it is extended by is zero-filled first. Its capacity still grows
+  // geometrically.
+  size_t used = cursor_ - data_->data();
+  data_->resize(used + std::max(size, kGrowthStep));
+  cursor_ = data_->data() + used;
+  end_ = data_->data() + data_->size();
+}
+
+bool JsonWriter::WriteTree(const Value& value) {
+  std::vector<Frame> stack;
+  const Value* current = &value;
+  while (true) {
+    if (current->type == ValueType::kList && !current->list.empty()) {
+      Put('[');
+      stack.push_back({current->list.data, nullptr, 1, current->list.size});
+      current = &current->list[0];
+      continue;
+    }
+    if (current->type == ValueType::kMap && !current->map.empty()) {
+      Put('{');
+      const MapEntry& entry = current->map[0];
+      if (!WriteKey(entry.key)) {
+        return false;
+      }
+      stack.push_back({nullptr, current->map.data, 1, current->map.size});
+      current = &entry.value;
+      continue;
+    }
+    if (!WriteLeaf(*current)) {
+      return false;
+    }
+    // Move on to the next element, closing every container that is done.
+    current = nullptr;
+    while (current == nullptr && !stack.empty()) {
+      Frame& frame = stack.back();
+      if (frame.index == frame.size) {
+        Put(frame.items != nullptr ? ']' : '}');
+        stack.pop_back();
+        continue;
+      }
+      Put(',');
+      if (frame.items != nullptr) {
+        current = &frame.items[frame.index++];
+      } else {
+        const MapEntry& entry = frame.entries[frame.index++];
+        if (!WriteKey(entry.key)) {
+          return false;
+        }
+        current = &entry.value;
+      }
+    }
+    if (current == nullptr) {
+      return true;
+    }
+  }
+}
+
+bool JsonWriter::WriteLeaf(const Value& value) {
+  auto literal = [this](const char* text, size_t length) {
+    Ensure(length);
+    std::memcpy(cursor_, text, length);
+    cursor_ += length;
+  };
+  switch (value.type) {
+    case ValueType::kNull:
+      literal("null", 4);
+      return true;
+    case ValueType::kBool:
+      if (value.boolean) {
+        literal("true", 4);
+      } else {
+        literal("false", 5);
+      }
+      return true;
+    case ValueType::kInt32:
+      WriteInteger(value.int32);
+      return true;
+    case ValueType::kInt64:
+      WriteInteger(value.int64);
+      return true;
+    case ValueType::kFloat64:
+      if (!std::isfinite(value.float64)) {
+        return false;
+      }
+      WriteDouble(value.float64);
+      return true;
+    case ValueType::kString:
+      WriteString(value.string);
+      return true;
+    case ValueType::kList:
+      literal("[]", 2);
+      return true;
+    case ValueType::kMap:
+      literal("{}", 2);
+      return true;
+    case ValueType::kTypedData:
+    case ValueType::kTensor:
+    case ValueType::kExtension:
+      return false;
+  }
+  return false;
+}
+
+void JsonWriter::WriteInteger(int64_t value) {
+  Ensure(kMaxIntegerLength);
+  uint64_t magnitude = static_cast<uint64_t>(value);
+  if (value < 0) {
+    *cursor_++ = '-';
+    magnitude = 0 - magnitude;
+  }
+  cursor_ = FormatUnsigned(magnitude, cursor_);
+}
+
+void JsonWriter::WriteDouble(double value) {
+  // Integral values, such as logical pixel coordinates, print like integers
+  // and without a fraction, as they do with NSJSONSerialization.
+  // Negative zero keeps a fraction so that it reads back as a double.
+  if (value == 0 && std::signbit(value)) {
+    Ensure(4);
+    std::memcpy(cursor_, "-0.0", 4);
+    cursor_ += 4;
+    return;
+  }
+  if (value >= -kMaxExactInteger && value <= kMaxExactInteger &&
+      value == std::trunc(value)) {
+    WriteInteger(static_cast<int64_t>(value));
+    return;
+  }
+  // std::to_chars without a precision produces the shortest digits that
+  // read back exactly; libstdc++ and libc++ implement it with Ryu. The
+  // general format picks fixed or exponent notation for those digits like
+  // %g, so large values never print every digit of their binary expansion.
+  Ensure(kMaxDoubleLength);
+  std::to_chars_result result = std::to_chars(
+      reinterpret_cast<char*>(cursor_), reinterpret_cast<char*>(end_), value,
+      std::chars_format::general);
+  cursor_ = reinterpret_cast<uint8_t*>(result.ptr);
+}
+
+void JsonWriter::WriteString(std::string_view value) {
+  const uint8_t* p = reinterpret_cast<const uint8_t*>(value.data());
+  const uint8_t* end = p + value.size();
+  // Room for the quotes and every byte unescaped; each escape then asks for
+  // its extra bytes.
+  Ensure(value.size() + 2);
+  *cursor_++ = '"';
+  while (true) {
+    const uint8_t* run_end = FindJsonStringSpecial(p, end);
+    size_t run = run_end - p;
+    if (run != 0) {
+      std::memcpy(cursor_, p, run);
+      cursor_ += run;
+    }
+    p = run_end;
+    if (p == end) {
+      break;
+    }
+    Ensure(6 + (end - p));
+    uint8_t byte = *p++;
+    *cursor_++ = '\\';
+    if (byte >= 0x20) {
+      *cursor_++ = byte;
+      continue;
+    }
+    char escape = kControlEscapes[byte];
+    *cursor_++ = static_cast<uint8_t>(escape);
+    if (escape == 'u') {
+      *cursor_++ = '0';
+      *cursor_++ = '0';
+      *cursor_++ = static_cast<uint8_t>(kHexDigits[byte >> 4]);
+      *cursor_++ = static_cast<uint8_t>(kHexDigits[byte & 0xF]);
+    }
+  }
+  *cursor_++ = '"';
+}
+
+bool JsonWriter::WriteKey(const Value& key) {
+  if (key.type != ValueType::kString) {
+    return false;
+  }
+  WriteString(key.string);
+  Put(':');
+  return true;
+}
+
+}  // namespace platzi
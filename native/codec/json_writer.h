@@ -0,0 +1,67 @@
+#ifndef NATIVE_CODEC_JSON_WRITER_H_
+#define NATIVE_CODEC_JSON_WRITER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "codec/value.h"
+
+namespace platzi {
+
+// Writes |Value| trees as compact JSON, the counterpart of the
+// NSJSONSerialization encoding behind FlutterJSONMessageCodec.
+//
+// Output goes straight into the vector through a cursor; the vector is
+// extended a few hundred bytes at a time, so that little more than what is
+// written gets zero-filled, and trimmed to the written size before
+// |WriteValue| returns. Doubles use the shortest representation that reads
+// back exactly, integers are formatted two digits at a time from a table,
+// and strings are copied in runs of bytes that need no escaping, found 16
+// at a time.
+class JsonWriter {
+ public:
+  // Appends to |data|.
+  explicit JsonWriter(std::vector<uint8_t>* data);
+  ~JsonWriter();
+
+  JsonWriter(const JsonWriter&) = delete;
+  JsonWriter& operator=(const JsonWriter&) = delete;
+
+  // Writes |value| and everything it contains. Returns false, leaving
+  // partial output, for values JSON cannot represent: typed data, NaN and
+  // infinities, and map keys that are not strings.
+  bool WriteValue(const Value& value);
+
+ private:
+  bool WriteTree(const Value& value);
+
+  // Writes anything but a non-empty list or map.
+  bool WriteLeaf(const Value& value);
+  void WriteString(std::string_view value);
+  bool WriteKey(const Value& key);
+  void WriteInteger(int64_t value);
+  void WriteDouble(double value);
+
+  // Makes room for |size| more bytes at the cursor.
+  void Ensure(size_t size) {
+    if (static_cast<size_t>(end_ - cursor_) < size) {
+      Grow(size);
+    }
+  }
+  void Grow(size_t size);
+
+  void Put(char c) {
+    Ensure(1);
+    *cursor_++ = static_cast<uint8_t>(c);
+  }
+
+  std::vector<uint8_t>* data_;
+  uint8_t* cursor_ = nullptr;
+  uint8_t* end_ = nullptr;
+};
+
+}  // namespace platzi
+
+#endif  // NATIVE_CODEC_JSON_WRITER_H_
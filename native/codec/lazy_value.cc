@@ -0,0 +1,197 @@
+#include "codec/lazy_value.h"
+
+namespace platzi {
+
+namespace {
+
+// FNV-1a, which is quick for the short keys of argument maps.
+inline size_t HashKey(std::string_view key) {
+  uint64_t hash = 14695981039346656037ull;
+  for (char c : key) {
+    hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+  }
+  return static_cast<size_t>(hash ^ (hash >> 32));
+}
+
+}  // namespace
+
+LazyValue LazyValue::At(size_t index) const {
+  if (!is_list() || index >= token_.count) {
+    return LazyValue();
+  }
+  return message_->ValueAt(message_->PositionOf(*this, index));
+}
+
+LazyValue LazyValue::KeyAt(size_t index) const {
+  if (!is_map() || index >= token_.count) {
+    return LazyValue();
+  }
+  return message_->ValueAt(message_->PositionOf(*this, 2 * index));
+}
+
+LazyValue LazyValue::ValueAt(size_t index) const {
+  if (!is_map() || index >= token_.count) {
+    return LazyValue();
+  }
+  return message_->ValueAt(message_->PositionOf(*this, 2 * index + 1));
+}
+
+LazyValue LazyValue::Find(std::string_view key) const {
+  if (!is_map()) {
+    return LazyValue();
+  }
+  size_t entry = message_->EntryOf(*this, key);
+  if (entry == SIZE_MAX) {
+    return LazyValue();
+  }
+  return message_->ValueAt(message_->PositionOf(*this, 2 * entry + 1));
+}
+
+const Value* LazyValue::Decode(Arena* arena, DecodeMode mode) const {
+  if (!valid()) {
+    return nullptr;
+  }
+  StandardReader reader(message_->data_, message_->size_);
+  if (!reader.Seek(position_)) {
+    return nullptr;
+  }
+  return DecodeValue(&reader, arena, mode);
+}
+
+LazyMessage::LazyMessage(const uint8_t* data, size_t size)
+    : data_(data), size_(size) {}
+
+LazyMessage::~LazyMessage() = default;
+
+LazyValue LazyMessage::ValueAt(size_t position) {
+  StandardReader reader(data_, size_);
+  LazyValue value;
+  if (position == SIZE_MAX || !reader.Seek(position) ||
+      !reader.ReadValue(&value.token_)) {
+    return LazyValue();
+  }
+  value.message_ = this;
+  value.position_ = position;
+  value.elements_ = reader.position();
+  return value;
+}
+
+LazyMessage::ContainerIndex* LazyMessage::IndexOf(const LazyValue& container) {
+  auto inserted = indexes_.try_emplace(container.elements_);
+  ContainerIndex* index = &inserted.first->second;
+  if (!inserted.second) {
+    return index->failed ? nullptr : index;
+  }
+  // Every element takes at least a byte, which bounds the storage a corrupt
+  // count can make us allocate.
+  bool is_map = container.type() == StandardField::kMap;
+  size_t slots =
+      static_cast<size_t>(container.token_.count) * (is_map ? 2 : 1);
+  if (slots > size_ - container.elements_) {
+    index->failed = true;
+    return nullptr;
+  }
+  index->positions.push_back(container.elements_);
+  if (is_map) {
+    index->keys.reserve(container.token_.count);
+    size_t capacity = 8;
+    while (capacity < 2 * static_cast<size_t>(container.token_.count)) {
+      capacity *= 2;
+    }
+    index->slots.assign(capacity, 0);
+  }
+  return index;
+}
+
+bool LazyMessage::ScanNext(const LazyValue& container,
+                           ContainerIndex* index,
+                           StandardReader* reader) {
+  size_t slot = index->positions.size() - 1;
+  size_t position = index->positions.back();
+  reader->Seek(position);
+  if (container.type() == StandardField::kMap && slot % 2 == 0) {
+    StandardToken key;
+    if (!reader->ReadValue(&key)) {
+      return false;
+    }
+    if (key.type == StandardField::kString) {
+      index->keys.push_back(key.string);
+      size_t mask = index->slots.size() - 1;
+      for (size_t i = HashKey(key.string) & mask;; i = (i + 1) & mask) {
+        uint32_t& entry = index->slots[i];
+        if (entry == 0) {
+          entry = static_cast<uint32_t>(slot / 2 + 1);
+          break;
+        }
+        if (index->keys[entry - 1] == key.string) {
+          break;
+        }
+      }
+    } else {
+      index->keys.emplace_back();
+    }
+    // Keys are almost always scalars or strings, which are now behind the
+    // reader; anything else is skipped over from the start.
+    if (key.type == StandardField::kList || key.type == StandardField::kMap) {
+      reader->Seek(position);
+      if (!reader->SkipValue()) {
+        return false;
+      }
+    }
+  } else if (!reader->SkipValue()) {
+    return false;
+  }
+  index->positions.push_back(reader->position());
+  return true;
+}
+
+size_t LazyMessage::PositionOf(const LazyValue& container, size_t slot) {
+  ContainerIndex* index = IndexOf(container);
+  if (index == nullptr) {
+    return SIZE_MAX;
+  }
+  StandardReader reader(data_, size_);
+  while (index->positions.size() <= slot) {
+    if (!ScanNext(container, index, &reader)) {
+      index->failed = true;
+      return SIZE_MAX;
+    }
+  }
+  return index->positions[slot];
+}
+
+size_t LazyMessage::EntryOf(const LazyValue& container, std::string_view key) {
+  ContainerIndex* index = IndexOf(container);
+  if (index == nullptr) {
+    return SIZE_MAX;
+  }
+  size_t mask = index->slots.size() - 1;
+  for (size_t i = HashKey(key) & mask;; i = (i + 1) & mask) {
+    uint32_t entry = index->slots[i];
+    if (entry == 0) {
+      break;
+    }
+    if (index->keys[entry - 1] == key) {
+      return entry - 1;
+    }
+  }
+  // Not among the keys scanned so far: scan on until it turns up. Keys are
+  // scanned at even slots, and every earlier occurrence would have been
+  // found above.
+  size_t slots = 2 * static_cast<size_t>(container.token_.count);
+  StandardReader reader(data_, size_);
+  while (index->positions.size() - 1 < slots) {
+    bool at_key = (index->positions.size() - 1) % 2 == 0;
+    if (!ScanNext(container, index, &reader)) {
+      index->failed = true;
+      return SIZE_MAX;
+    }
+    const std::string_view& scanned = index->keys.back();
+    if (at_key && scanned.data() != nullptr && scanned == key) {
+      return index->keys.size() - 1;
+    }
+  }
+  return SIZE_MAX;
+}
+
+}  // namespace platzi
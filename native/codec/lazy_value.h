@@ -0,0 +1,135 @@
+#ifndef NATIVE_CODEC_LAZY_VALUE_H_
+#define NATIVE_CODEC_LAZY_VALUE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "codec/arena.h"
+#include "codec/standard_field.h"
+#include "codec/standard_reader.h"
+#include "codec/value.h"
+#include "codec/value_decoder.h"
+
+namespace platzi {
+
+class LazyMessage;
+
+// A value inside a message of the standard encoding that has not been
+// decoded. Only its type byte and payload (for lists and maps, the element
+// count) are read; elements are reached through |At|, |KeyAt|, |ValueAt|
+// and |Find|, which read no more than they must.
+//
+// A value is a small handle into its |LazyMessage|, which must outlive it.
+// Looking up something that is missing or malformed yields an invalid value,
+// and every lookup on an invalid value does too, so lookups can be chained
+// and checked once at the end.
+class LazyValue {
+ public:
+  LazyValue() = default;
+
+  bool valid() const { return message_ != nullptr; }
+  StandardField type() const { return token_.type; }
+  bool is_list() const { return valid() && type() == StandardField::kList; }
+  bool is_map() const { return valid() && type() == StandardField::kMap; }
+
+  // The type and payload of the value, as |StandardReader::ReadValue| reads
+  // them.
+  const StandardToken& token() const { return token_; }
+
+  // Elements of a list or entries of a map; 0 for anything else.
+  size_t size() const { return is_list() || is_map() ? token_.count : 0; }
+
+  // The element at |index| of a list.
+  LazyValue At(size_t index) const;
+
+  // The key and value of the entry at |index| of a map.
+  LazyValue KeyAt(size_t index) const;
+  LazyValue ValueAt(size_t index) const;
+
+  // The value of the first entry of a map whose key is the string |key|.
+  LazyValue Find(std::string_view key) const;
+
+  // Decodes the value and everything it contains into |arena|. Returns
+  // nullptr if it is invalid or malformed.
+  const Value* Decode(Arena* arena,
+                      DecodeMode mode = DecodeMode::kBorrow) const;
+
+ private:
+  friend class LazyMessage;
+
+  LazyMessage* message_ = nullptr;
+  // Position of the type byte in the message.
+  size_t position_ = 0;
+  // Position of the first element of a list or map.
+  size_t elements_ = 0;
+  StandardToken token_;
+};
+
+// Random access to a message of the standard encoding without decoding all
+// of it, for handlers that read a few fields out of large arguments.
+//
+// Lookups in a list or map build its index as they go: the first skips over
+// elements, recording where each starts and, for maps, hashing string keys,
+// until it reaches what it looks for. Later lookups of what has been passed
+// take O(1) and resume the scan otherwise, so every element is skipped over
+// at most once. Containers never looked into are skipped over whole and never
+// indexed.
+//
+// The message buffer must outlive the view; strings and typed data point
+// into it.
+class LazyMessage {
+ public:
+  LazyMessage(const uint8_t* data, size_t size);
+  ~LazyMessage();
+
+  LazyMessage(const LazyMessage&) = delete;
+  LazyMessage& operator=(const LazyMessage&) = delete;
+
+  // The top-level value, or an invalid value if its header is malformed.
+  LazyValue root() { return ValueAt(0); }
+
+ private:
+  friend class LazyValue;
+
+  struct ContainerIndex {
+    bool failed = false;
+    // Positions of the elements scanned so far, and of the next one; keys
+    // and values alternate for maps.
+    std::vector<size_t> positions;
+    // String keys of the entries scanned so far; other keys are empty.
+    std::vector<std::string_view> keys;
+    // Open addressing over |keys|: entry + 1 for each string key, first
+    // entry wins, 0 for empty slots. Sized for every entry up front.
+    std::vector<uint32_t> slots;
+  };
+
+  // Reads the value whose type byte is at |position|.
+  LazyValue ValueAt(size_t position);
+
+  // Returns the position of element |slot| of |container| (keys and values
+  // counting separately for maps), or SIZE_MAX if it is malformed.
+  size_t PositionOf(const LazyValue& container, size_t slot);
+
+  // Returns the entry of |container| whose key is the string |key|, or
+  // SIZE_MAX if there is none.
+  size_t EntryOf(const LazyValue& container, std::string_view key);
+
+  ContainerIndex* IndexOf(const LazyValue& container);
+
+  // Scans the next element of |container| into |index| with |reader|.
+  bool ScanNext(const LazyValue& container,
+                ContainerIndex* index,
+                StandardReader* reader);
+
+  const uint8_t* data_;
+  size_t size_;
+  // Keyed by the position of the container's first element.
+  std::unordered_map<size_t, ContainerIndex> indexes_;
+};
+
+}  // namespace platzi
+
+#endif  // NATIVE_CODEC_LAZY_VALUE_H_
@@ -0,0 +1,244 @@
+#include "codec/lz_block.h"
+
+#include <cstring>
+
+namespace platzi {
+
+namespace {
+
+constexpr size_t kMinMatch = 4;
+
+// The last five bytes of a block are always literals, and the last match
+// starts at least twelve bytes before the end, as the LZ4 format requires
+// so that decoders can copy in whole words.
+constexpr size_t kLastLiterals = 5;
+constexpr size_t kMatchStartLimit = 12;
+
+constexpr size_t kMaxOffset = 65535;
+
+constexpr int kHashBits = 12;
+constexpr size_t kHashSize = size_t{1} << kHashBits;
+
+// Every 2^kSkipShift failed match attempts in a row, the compressor moves
+// one byte further per attempt.
+constexpr unsigned kSkipShift = 6;
+
+inline uint32_t Load32(const uint8_t* p) {
+  uint32_t value;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+inline uint64_t Load64(const uint8_t* p) {
+  uint64_t value;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+inline uint32_t Hash(uint32_t sequence) {
+  return (sequence * 2654435761u) >> (32 - kHashBits);
+}
+
+// Returns how many bytes from |a| on equal those from |b|, stopping at
+// |a_limit|.
+inline size_t MatchLength(const uint8_t* a,
+                          const uint8_t* b,
+                          const uint8_t* a_limit) {
+  const uint8_t* start = a;
+  while (a_limit - a >= 8) {
+    uint64_t difference = Load64(a) ^ Load64(b);
+    if (difference != 0) {
+      return (a - start) + (__builtin_ctzll(difference) >> 3);
+    }
+    a += 8;
+    b += 8;
+  }
+  while (a < a_limit && *a == *b) {
+    a++;
+    b++;
+  }
+  return a - start;
+}
+
+// Writes the part of a length that does not fit its token nibble.
+inline uint8_t* WriteLengthTail(size_t length, uint8_t* out) {
+  while (length >= 255) {
+    *out++ = 255;
+    length -= 255;
+  }
+  *out++ = static_cast<uint8_t>(length);
+  return out;
+}
+
+inline uint8_t* WriteLiterals(const uint8_t* literals,
+                              size_t count,
+                              uint8_t* token,
+                              uint8_t* out) {
+  if (count >= 15) {
+    *token = 15 << 4;
+    out = WriteLengthTail(count - 15, out);
+  } else {
+    *token = static_cast<uint8_t>(count << 4);
+  }
+  if (count > 0) {
+    std::memcpy(out, literals, count);
+  }
+  return out + count;
+}
+
+// Reads the part of a length that did not fit its token nibble.
+inline bool ReadLengthTail(const uint8_t** in,
+                           const uint8_t* in_end,
+                           size_t* length) {
+  uint8_t byte;
+  do {
+    if (*in == in_end) {
+      return false;
+    }
+    byte = *(*in)++;
+    *length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+}  // namespace
+
+size_t LzCompress(const uint8_t* data, size_t size, uint8_t* out) {
+  const uint8_t* const end = data + size;
+  const uint8_t* anchor = data;
+  uint8_t* op = out;
+  if (size > kMatchStartLimit) {
+    const uint8_t* const match_start_end = end - kMatchStartLimit;
+    const uint8_t* const match_end = end - kLastLiterals;
+    uint32_t table[kHashSize] = {};
+    const uint8_t* ip = data + 1;
+    while (ip < match_start_end) {
+      // Look for a match, moving faster the longer none turns up.
+      const uint8_t* match = nullptr;
+      unsigned attempts = 1u << kSkipShift;
+      while (ip < match_start_end) {
+        uint32_t hash = Hash(Load32(ip));
+        const uint8_t* candidate = data + table[hash];
+        table[hash] = static_cast<uint32_t>(ip - data);
+        if (static_cast<size_t>(ip - candidate) <= kMaxOffset &&
+            Load32(candidate) == Load32(ip)) {
+          match = candidate;
+          break;
+        }
+        ip += attempts++ >> kSkipShift;
+      }
+      if (match == nullptr) {
+        break;
+      }
+      // The match may reach back into the pending literals.
+      while (ip > anchor && match > data && ip[-1] == match[-1]) {
+        ip--;
+        match--;
+      }
+      size_t length =
+          kMinMatch + MatchLength(ip + kMinMatch, match + kMinMatch, match_end);
+
+      uint8_t* token = op++;
+      op = WriteLiterals(anchor, ip - anchor, token, op);
+      uint16_t offset = static_cast<uint16_t>(ip - match);
+      *op++ = static_cast<uint8_t>(offset);
+      *op++ = static_cast<uint8_t>(offset >> 8);
+      if (length - kMinMatch >= 15) {
+        *token |= 15;
+        op = WriteLengthTail(length - kMinMatch - 15, op);
+      } else {
+        *token |= static_cast<uint8_t>(length - kMinMatch);
+      }
+
+      ip += length;
+      anchor = ip;
+      // Remember a position inside the match so that runs of repeated
+      // records find each other.
+      if (ip < match_start_end) {
+        table[Hash(Load32(ip - 2))] = static_cast<uint32_t>(ip - 2 - data);
+      }
+    }
+  }
+  uint8_t* token = op++;
+  op = WriteLiterals(anchor, end - anchor, token, op);
+  return op - out;
+}
+
+bool LzDecompress(const uint8_t* data,
+                  size_t size,
+                  uint8_t* out,
+                  size_t capacity,
+                  size_t* decompressed_size) {
+  const uint8_t* ip = data;
+  const uint8_t* const in_end = data + size;
+  uint8_t* op = out;
+  uint8_t* const out_end = out + capacity;
+  while (true) {
+    if (ip == in_end) {
+      return false;
+    }
+    uint8_t token = *ip++;
+
+    size_t literals = token >> 4;
+    if (literals == 15 && !ReadLengthTail(&ip, in_end, &literals)) {
+      return false;
+    }
+    if (literals > static_cast<size_t>(in_end - ip) ||
+        literals > static_cast<size_t>(out_end - op)) {
+      return false;
+    }
+    // Short runs, the common case, move as one 16-byte copy when both
+    // buffers have room for it.
+    if (literals <= 16 && in_end - ip >= 16 && out_end - op >= 16) {
+      std::memcpy(op, ip, 16);
+    } else if (literals > 0) {
+      std::memcpy(op, ip, literals);
+    }
+    ip += literals;
+    op += literals;
+    // The last sequence has no match.
+    if (ip == in_end) {
+      break;
+    }
+
+    if (in_end - ip < 2) {
+      return false;
+    }
+    size_t offset = ip[0] | (ip[1] << 8);
+    ip += 2;
+    if (offset == 0 || offset > static_cast<size_t>(op - out)) {
+      return false;
+    }
+    size_t length = token & 15;
+    if (length == 15 && !ReadLengthTail(&ip, in_end, &length)) {
+      return false;
+    }
+    length += kMinMatch;
+    size_t room = out_end - op;
+    if (length > room) {
+      return false;
+    }
+    const uint8_t* match = op - offset;
+    // Copies in chunks may run past the match, into bytes later sequences
+    // overwrite; an offset of at least the chunk size keeps every chunk from
+    // reading bytes it writes.
+    if (offset >= 16 && room - length >= 16) {
+      for (size_t copied = 0; copied < length; copied += 16) {
+        std::memcpy(op + copied, match + copied, 16);
+      }
+    } else if (offset >= 8 && room - length >= 8) {
+      for (size_t copied = 0; copied < length; copied += 8) {
+        std::memcpy(op + copied, match + copied, 8);
+      }
+    } else {
+      for (size_t i = 0; i < length; i++) {
+        op[i] = match[i];
+      }
+    }
+    op += length;
+  }
+  *decompressed_size = op - out;
+  return true;
+}
+
+}  // namespace platzi
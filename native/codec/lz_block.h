@@ -0,0 +1,41 @@
+#ifndef NATIVE_CODEC_LZ_BLOCK_H_
+#define NATIVE_CODEC_LZ_BLOCK_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace platzi {
+
+// A dependency-free LZ77 compressor producing the LZ4 block format: runs of
+// literals alternating with matches of at least four bytes at most 64 KB
+// back, each introduced by a token byte of two length nibbles.
+//
+// Compression is greedy with a single hash table of 4096 recent positions
+// and skips ahead faster through data that does not compress. Decompression
+// checks every length and offset against both buffers, so corrupt or
+// hostile input cannot make it read or write out of bounds.
+
+// Returns the largest compressed size of |size| bytes; incompressible input
+// grows by about 0.4%.
+inline size_t LzCompressBound(size_t size) {
+  return size + size / 255 + 16;
+}
+
+// Compresses the |size| bytes at |data| into |out|, which must have room for
+// |LzCompressBound(size)| bytes, and returns the compressed size. |size|
+// must be below 4 GB.
+size_t LzCompress(const uint8_t* data, size_t size, uint8_t* out);
+
+// Decompresses the |size| bytes at |data| into the |capacity| bytes at
+// |out| and stores the decompressed size in |decompressed_size|. Returns
+// false if the block is malformed or does not fit. Bytes of |out| past the
+// decompressed size may be overwritten, as copies run in 16-byte chunks.
+bool LzDecompress(const uint8_t* data,
+                  size_t size,
+                  uint8_t* out,
+                  size_t capacity,
+                  size_t* decompressed_size);
+
+}  // namespace platzi
+
+#endif  // NATIVE_CODEC_LZ_BLOCK_H_
@@ -0,0 +1,42 @@
+#ifndef NATIVE_CODEC_MAPPED_FILE_H_
+#define NATIVE_CODEC_MAPPED_FILE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "codec/typed_data.h"
+
+namespace platzi {
+
+// A read-only memory mapping of a whole file, for decoding file-backed
+// messages in place with |StandardReader|.
+class MappedFile {
+ public:
+  MappedFile();
+  ~MappedFile();
+
+  MappedFile(MappedFile&& other);
+  MappedFile& operator=(MappedFile&& other);
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  // Maps |path|. Returns false, leaving this object empty, on failure.
+  bool Open(const std::string& path);
+  void Close();
+
+  bool is_open() const { return open_; }
+  const uint8_t* data() const { return data_; }
+  size_t size() const { return size_; }
+  ByteSpan bytes() const { return ByteSpan{data_, size_}; }
+
+ private:
+  const uint8_t* data_ = nullptr;
+  size_t size_ = 0;
+  bool open_ = false;
+};
+
+}  // namespace platzi
+
+#endif  // NATIVE_CODEC_MAPPED_FILE_H_
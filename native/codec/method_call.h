@@ -0,0 +1,34 @@
+#ifndef NATIVE_CODEC_METHOD_CALL_H_
+#define NATIVE_CODEC_METHOD_CALL_H_
+
+#include <string_view>
+
+#include "codec/value.h"
+
+namespace platzi {
+
+// The counterpart of FlutterMethodCall. Decoded calls borrow from the message
+// buffer or an arena, like |Value|.
+struct MethodCall {
+  std::string_view method;
+  Value arguments;
+};
+
+// The counterpart of FlutterError.
+struct MethodError {
+  std::string_view code;
+  // A string, or null if the error has no message.
+  Value message;
+  Value details;
+};
+
+// A decoded result envelope: a result, or an error if |is_error| is set.
+struct Envelope {
+  bool is_error = false;
+  Value result;
+  MethodError error;
+};
+
+}  // namespace platzi
+
+#endif  // NATIVE_CODEC_METHOD_CALL_H_
@@ -0,0 +1,474 @@
+#ifndef NATIVE_CODEC_SCHEMA_H_
+#define NATIVE_CODEC_SCHEMA_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "codec/delta_varint.h"
+#include "codec/standard_field.h"
+#include "codec/standard_reader.h"
+#include "codec/standard_writer.h"
+#include "codec/typed_data.h"
+
+// Encoders and decoders specialized at compile time for fixed-shape
+// messages.
+//
+// A described struct is encoded as a standard-codec map from field names to
+// field values, byte for byte what FlutterStandardWriter produces for the
+// equivalent NSDictionary, so the Dart side sees a plain Map<String, dynamic>.
+// The field types are known statically: there is no per-value type dispatch
+// and no intermediate dictionary on either side.
+//
+// Describe a struct at namespace scope with PLATZI_SCHEMA:
+//
+//   struct Place {
+//     std::string name;
+//     int32_t stars = 0;
+//     std::vector<Review> reviews;
+//   };
+//   PLATZI_SCHEMA(Place,
+//                 PLATZI_FIELD(Place, name),
+//                 PLATZI_FIELD(Place, stars),
+//                 PLATZI_FIELD(Place, reviews));
+//
+// Supported field types are bool, int32_t, int64_t, double, std::string,
+// std::string_view (decoded as a view into the message), TypedDataView,
+// std::optional<T> (null when empty), std::vector<T> (a list, or for
+// int64_t also an Int64List) and other described structs. Decoding
+// tolerates fields in any order, skips unknown keys and leaves absent
+// fields untouched; it is fastest when keys arrive in declaration order, as
+// they do from the encoder.
+
+namespace platzi {
+
+// Specialized by PLATZI_SCHEMA with a tuple of |Field|s named kFields.
+template <typename T>
+struct Schema;
+
+template <typename Class, typename Member>
+struct Field {
+  using Type = Member;
+
+  const char* name;
+  size_t name_size;
+  Member Class::*member;
+};
+
+template <typename Class, typename Member, size_t N>
+constexpr Field<Class, Member> MakeField(const char (&name)[N],
+                                         Member Class::*member) {
+  static_assert(N - 1 < 254, "Field names must fit a one byte size");
+  return Field<Class, Member>{name, N - 1, member};
+}
+
+#define PLATZI_FIELD(Type, member) ::platzi::MakeField(#member, &Type::member)
+
+#define PLATZI_SCHEMA(Type, ...)                                   \
+  template <>                                                      \
+  struct platzi::Schema<Type> {                                    \
+    static constexpr auto kFields = std::make_tuple(__VA_ARGS__);  \
+  }
+
+template <typename T, typename = void>
+struct HasSchema : std::false_type {};
+
+template <typename T>
+struct HasSchema<T, std::void_t<decltype(Schema<T>::kFields)>>
+    : std::true_type {};
+
+// Encodes and decodes one field type. Specializations follow.
+template <typename T, typename = void>
+struct FieldCodec;
+
+namespace internal {
+
+inline void WriteType(StandardWriter* writer, StandardField type) {
+  writer->WriteByte(static_cast<uint8_t>(type));
+}
+
+inline bool ReadType(StandardReader* reader, StandardField* type) {
+  uint8_t byte;
+  if (!reader->ReadByte(&byte)) {
+    return false;
+  }
+  *type = static_cast<StandardField>(byte);
+  return true;
+}
+
+// Reads an integer written as Int32 or Int64, as Dart chooses by magnitude.
+inline bool ReadInteger(StandardReader* reader,
+                        StandardField type,
+                        int64_t* value) {
+  if (type == StandardField::kInt32) {
+    int32_t value32;
+    if (!reader->ReadBytes(&value32, sizeof(value32))) {
+      return false;
+    }
+    *value = value32;
+    return true;
+  }
+  if (type == StandardField::kInt64) {
+    return reader->ReadBytes(value, sizeof(*value));
+  }
+  return false;
+}
+
+}  // namespace internal
+
+template <>
+struct FieldCodec<bool> {
+  static void Encode(bool value, StandardWriter* writer) {
+    internal::WriteType(writer,
+                        value ? StandardField::kTrue : StandardField::kFalse);
+  }
+  static bool Decode(StandardReader* reader, bool* value) {
+    StandardField type;
+    if (!internal::ReadType(reader, &type)) {
+      return false;
+    }
+    if (type != StandardField::kTrue && type != StandardField::kFalse) {
+      return false;
+    }
+    *value = type == StandardField::kTrue;
+    return true;
+  }
+};
+
+template <>
+struct FieldCodec<int32_t> {
+  static void Encode(int32_t value, StandardWriter* writer) {
+    internal::WriteType(writer, StandardField::kInt32);
+    writer->WriteScalar(value);
+  }
+  static bool Decode(StandardReader* reader, int32_t* value) {
+    StandardField type;
+    int64_t value64;
+    if (!internal::ReadType(reader, &type) ||
+        !internal::ReadInteger(reader, type, &value64) ||
+        value64 < std::numeric_limits<int32_t>::min() ||
+        value64 > std::numeric_limits<int32_t>::max()) {
+      return false;
+    }
+    *value = static_cast<int32_t>(value64);
+    return true;
+  }
+};
+
+template <>
+struct FieldCodec<int64_t> {
+  // Like FlutterStandardWriter, keeps the width of the declared type.
+  static void Encode(int64_t value, StandardWriter* writer) {
+    internal::WriteType(writer, StandardField::kInt64);
+    writer->WriteScalar(value);
+  }
+  static bool Decode(StandardReader* reader, int64_t* value) {
+    StandardField type;
+    return internal::ReadType(reader, &type) &&
+           internal::ReadInteger(reader, type, value);
+  }
+};
+
+template <>
+struct FieldCodec<double> {
+  static void Encode(double value, StandardWriter* writer) {
+    internal::WriteType(writer, StandardField::kFloat64);
+    writer->WriteAlignment(8);
+    writer->WriteScalar(value);
+  }
+  static bool Decode(StandardReader* reader, double* value) {
+    StandardField type;
+    if (!internal::ReadType(reader, &type)) {
+      return false;
+    }
+    if (type == StandardField::kFloat64) {
+      return reader->ReadAlignment(8) &&
+             reader->ReadBytes(value, sizeof(*value));
+    }
+    int64_t integer;
+    if (!internal::ReadInteger(reader, type, &integer)) {
+      return false;
+    }
+    *value = static_cast<double>(integer);
+    return true;
+  }
+};
+
+template <>
+struct FieldCodec<std::string_view> {
+  static void Encode(std::string_view value, StandardWriter* writer) {
+    internal::WriteType(writer, StandardField::kString);
+    writer->WriteUTF8(value);
+  }
+  static bool Decode(StandardReader* reader, std::string_view* value) {
+    StandardField type;
+    return internal::ReadType(reader, &type) &&
+           type == StandardField::kString && reader->ReadUTF8(value);
+  }
+};
+
+template <>
+struct FieldCodec<std::string> {
+  static void Encode(const std::string& value, StandardWriter* writer) {
+    FieldCodec<std::string_view>::Encode(value, writer);
+  }
+  static bool Decode(StandardReader* reader, std::string* value) {
+    std::string_view view;
+    if (!FieldCodec<std::string_view>::Decode(reader, &view)) {
+      return false;
+    }
+    value->assign(view.data(), view.size());
+    return true;
+  }
+};
+
+// Int64DeltaData views are written packed, as StandardWriter does. They do
+// not decode back into a view, which would have nothing to point its
+// unpacked elements at; decode them into a std::vector<int64_t> instead.
+template <>
+struct FieldCodec<TypedDataView> {
+  static void Encode(const TypedDataView& value, StandardWriter* writer) {
+    internal::WriteType(writer, value.type);
+    if (value.type == StandardField::kInt64DeltaData) {
+      writer->WriteInt64Deltas(value);
+    } else {
+      writer->WriteTypedData(value);
+    }
+  }
+  static bool Decode(StandardReader* reader, TypedDataView* value) {
+    StandardToken token;
+    if (!reader->ReadValue(&token) || !IsTypedDataField(token.type)) {
+      return false;
+    }
+    *value = token.typed_data;
+    return true;
+  }
+};
+
+template <typename T>
+struct FieldCodec<std::optional<T>> {
+  static void Encode(const std::optional<T>& value, StandardWriter* writer) {
+    if (value) {
+      FieldCodec<T>::Encode(*value, writer);
+    } else {
+      internal::WriteType(writer, StandardField::kNil);
+    }
+  }
+  static bool Decode(StandardReader* reader, std::optional<T>* value) {
+    if (reader->HasMore() &&
+        reader->data()[reader->position()] ==
+            static_cast<uint8_t>(StandardField::kNil)) {
+      value->reset();
+      uint8_t nil;
+      return reader->ReadByte(&nil);
+    }
+    T decoded{};
+    if (!FieldCodec<T>::Decode(reader, &decoded)) {
+      return false;
+    }
+    *value = std::move(decoded);
+    return true;
+  }
+};
+
+namespace internal {
+
+template <typename T>
+struct ListCodec {
+  static void Encode(const std::vector<T>& value, StandardWriter* writer) {
+    internal::WriteType(writer, StandardField::kList);
+    writer->WriteSize(static_cast<uint32_t>(value.size()));
+    for (const T& item : value) {
+      FieldCodec<T>::Encode(item, writer);
+    }
+  }
+  static bool Decode(StandardReader* reader, std::vector<T>* value) {
+    StandardField type;
+    uint32_t count;
+    if (!internal::ReadType(reader, &type) || type != StandardField::kList ||
+        !reader->ReadSize(&count) ||
+        count > reader->size() - reader->position()) {
+      return false;
+    }
+    // Decoded aside, so that a malformed list leaves |value| untouched.
+    // Elements go through a local, as std::vector<bool> hands out proxies
+    // rather than references.
+    std::vector<T> decoded;
+    decoded.reserve(count);
+    for (uint32_t i = 0; i < count; i++) {
+      T item{};
+      if (!FieldCodec<T>::Decode(reader, &item)) {
+        return false;
+      }
+      decoded.push_back(std::move(item));
+    }
+    value->swap(decoded);
+    return true;
+  }
+};
+
+}  // namespace internal
+
+template <typename T>
+struct FieldCodec<std::vector<T>> : internal::ListCodec<T> {};
+
+// Also decodes Int64Data and Int64DeltaData lists, which Dart sends for an
+// Int64List, and which |FieldCodec<TypedDataView>| encodes.
+template <>
+struct FieldCodec<std::vector<int64_t>> : internal::ListCodec<int64_t> {
+  static bool Decode(StandardReader* reader, std::vector<int64_t>* value) {
+    if (!reader->HasMore()) {
+      return false;
+    }
+    auto type =
+        static_cast<StandardField>(reader->data()[reader->position()]);
+    if (type != StandardField::kInt64Data &&
+        type != StandardField::kInt64DeltaData) {
+      return ListCodec::Decode(reader, value);
+    }
+    StandardToken token;
+    if (!reader->ReadValue(&token)) {
+      return false;
+    }
+    std::vector<int64_t> decoded;
+    if (type == StandardField::kInt64Data) {
+      decoded.resize(token.typed_data.element_count);
+      token.typed_data.CopyTo(decoded.data());
+    } else {
+      decoded.resize(token.count);
+      if (!UnpackInt64Deltas(token.payload.data, token.payload.size,
+                             token.count, decoded.data())) {
+        return false;
+      }
+    }
+    value->swap(decoded);
+    return true;
+  }
+};
+
+// Described structs: a map keyed by field name.
+template <typename T>
+struct FieldCodec<T, std::enable_if_t<HasSchema<T>::value>> {
+  static constexpr size_t kFieldCount =
+      std::tuple_size<decltype(Schema<T>::kFields)>::value;
+
+  static void Encode(const T& value, StandardWriter* writer) {
+    internal::WriteType(writer, StandardField::kMap);
+    writer->WriteSize(static_cast<uint32_t>(kFieldCount));
+    std::apply(
+        [&](const auto&... fields) {
+          (EncodeField(fields, value, writer), ...);
+        },
+        Schema<T>::kFields);
+  }
+
+  static bool Decode(StandardReader* reader, T* value) {
+    StandardField type;
+    uint32_t count;
+    if (!internal::ReadType(reader, &type) || type != StandardField::kMap ||
+        !reader->ReadSize(&count)) {
+      return false;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+      std::string_view key;
+      if (!internal::ReadType(reader, &type) ||
+          type != StandardField::kString || !reader->ReadUTF8(&key)) {
+        return false;
+      }
+      size_t index = FindField(key, i);
+      bool ok = index < kFieldCount ? DecodeField(reader, index, value)
+                                    : reader->SkipValue();
+      if (!ok) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+ private:
+  template <typename F>
+  static void EncodeField(const F& field,
+                          const T& value,
+                          StandardWriter* writer) {
+    internal::WriteType(writer, StandardField::kString);
+    writer->WriteByte(static_cast<uint8_t>(field.name_size));
+    writer->WriteBytes(field.name, field.name_size);
+    FieldCodec<typename F::Type>::Encode(value.*field.member, writer);
+  }
+
+  template <size_t... I>
+  static bool NameMatches(std::string_view key,
+                          size_t index,
+                          std::index_sequence<I...>) {
+    bool matches = false;
+    ((I == index ? (matches = key == std::string_view(
+                                          std::get<I>(Schema<T>::kFields).name,
+                                          std::get<I>(Schema<T>::kFields)
+                                              .name_size))
+                 : false),
+     ...);
+    return matches;
+  }
+
+  // Returns the index of the field named |key|, or kFieldCount. The field
+  // at |expected| is tried first.
+  static size_t FindField(std::string_view key, size_t expected) {
+    using Indices = std::make_index_sequence<kFieldCount>;
+    if (expected < kFieldCount && NameMatches(key, expected, Indices())) {
+      return expected;
+    }
+    for (size_t index = 0; index < kFieldCount; index++) {
+      if (NameMatches(key, index, Indices())) {
+        return index;
+      }
+    }
+    return kFieldCount;
+  }
+
+  template <size_t I>
+  static bool DecodeFieldAt(StandardReader* reader, T* value) {
+    const auto& field = std::get<I>(Schema<T>::kFields);
+    using Type = typename std::decay_t<decltype(field)>::Type;
+    return FieldCodec<Type>::Decode(reader, &(value->*field.member));
+  }
+
+  template <size_t... I>
+  static bool DecodeField(StandardReader* reader,
+                          size_t index,
+                          T* value,
+                          std::index_sequence<I...>) {
+    using Decoder = bool (*)(StandardReader*, T*);
+    static constexpr Decoder kDecoders[] = {&DecodeFieldAt<I>...};
+    return kDecoders[index](reader, value);
+  }
+
+  static bool DecodeField(StandardReader* reader, size_t index, T* value) {
+    return DecodeField(reader, index, value,
+                       std::make_index_sequence<kFieldCount>());
+  }
+};
+
+// Appends the encoding of |value| to |encoded|.
+template <typename T>
+void EncodeSchemaMessage(const T& value, std::vector<uint8_t>* encoded) {
+  StandardWriter writer(encoded);
+  FieldCodec<T>::Encode(value, &writer);
+}
+
+// Decodes a message that holds exactly one |T|.
+template <typename T>
+bool DecodeSchemaMessage(const uint8_t* data, size_t size, T* value) {
+  StandardReader reader(data, size);
+  return FieldCodec<T>::Decode(&reader, value) && !reader.HasMore();
+}
+
+}  // namespace platzi
+
+#endif  // NATIVE_CODEC_SCHEMA_H_
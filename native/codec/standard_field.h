@@ -0,0 +1,99 @@
+#ifndef NATIVE_CODEC_STANDARD_FIELD_H_
+#define NATIVE_CODEC_STANDARD_FIELD_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace platzi {
+
+// Type bytes of the Flutter standard binary encoding, as written by
+// FlutterStandardWriter and read by FlutterStandardReader.
+//
+// Values are preceded by one of these bytes. Sizes (string lengths, element
+// counts) use the variable-length encoding of |StandardReader::ReadSize|, and
+// multi-byte scalars use the platform's native (little) endianness.
+enum class StandardField : uint8_t {
+  kNil = 0,
+  kTrue = 1,
+  kFalse = 2,
+  kInt32 = 3,
+  kInt64 = 4,
+  kIntHex = 5,
+  kFloat64 = 6,
+  kString = 7,
+  kUInt8Data = 8,
+  kInt32Data = 9,
+  kInt64Data = 10,
+  kFloat64Data = 11,
+  kList = 12,
+  kMap = 13,
+  // Typed data lists beyond those of FlutterStandardDataType. Float32Data
+  // has the value Flutter's own codecs later adopted for Float32List; the
+  // Dart side needs a StandardMessageCodec subclass that reads Int16Data and
+  // UInt16Data into Int16List and Uint16List.
+  kFloat32Data = 14,
+  kInt16Data = 15,
+  kUInt16Data = 16,
+  // An Int64 list sent as the differences between consecutive elements
+  // (the first from zero), zigzag encoded as varints: the element count and
+  // the byte length of the varints as sizes, then the varints, unaligned.
+  // In memory it is an Int64 list like any other; a |TypedDataView| of this
+  // type asks the writer to pack it.
+  kInt64DeltaData = 17,
+  // An n-dimensional array of typed data elements (see tensor.h): the type
+  // byte of its elements' typed data list, the rank as one byte, padding to
+  // a multiple of 4, the dimensions as rank native uint32s, padding to the
+  // element size, then the elements, contiguous in row-major order.
+  kTensor = 18,
+};
+
+// Type bytes from here on belong to extension types, whose codes an
+// |ExtensionRegistry| assigns: the type byte, the payload size as a size,
+// then the payload, which the registered decoder interprets. Lower type
+// bytes are reserved for the standard fields.
+constexpr uint8_t kFirstExtensionType = 128;
+
+inline bool IsExtensionType(uint8_t type) {
+  return type >= kFirstExtensionType;
+}
+
+// Returns true if |field| is one of the typed data lists stored as an array
+// of fixed-size elements; |kInt64DeltaData| is not.
+inline bool IsTypedDataField(StandardField field) {
+  switch (field) {
+    case StandardField::kUInt8Data:
+    case StandardField::kInt32Data:
+    case StandardField::kInt64Data:
+    case StandardField::kFloat64Data:
+    case StandardField::kFloat32Data:
+    case StandardField::kInt16Data:
+    case StandardField::kUInt16Data:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Returns the size in bytes of one element of a typed data list, or 0 if
+// |field| is not a typed data list.
+inline uint8_t TypedDataElementSize(StandardField field) {
+  switch (field) {
+    case StandardField::kUInt8Data:
+      return 1;
+    case StandardField::kInt16Data:
+    case StandardField::kUInt16Data:
+      return 2;
+    case StandardField::kInt32Data:
+    case StandardField::kFloat32Data:
+      return 4;
+    case StandardField::kInt64Data:
+    case StandardField::kFloat64Data:
+      return 8;
+    default:
+      return 0;
+  }
+}
+
+}  // namespace platzi
+
+#endif  // NATIVE_CODEC_STANDARD_FIELD_H_
@@ -0,0 +1,33 @@
+#include "codec/standard_message_codec.h"
+
+#include "codec/standard_writer.h"
+
+namespace platzi {
+
+bool StandardMessageCodec::EncodeMessage(const Value& value,
+                                         std::vector<uint8_t>* encoded) {
+  encoded->clear();
+  encoded->reserve(EncodedSizeOf(value));
+  StandardWriter writer(encoded);
+  writer.WriteValue(value);
+  return writer.ok();
+}
+
+bool StandardMessageCodec::EncodeMessage(const Value& value,
+                                         uint8_t* buffer,
+                                         size_t capacity,
+                                         size_t* size) {
+  // Extension values are refused before anything is written: their
+  // payloads are not part of the size, and this codec has no registry to
+  // write them with anyway.
+  bool holds_extension;
+  *size = EncodedSizeOf(value, 0, &holds_extension);
+  if (holds_extension || *size > capacity) {
+    return false;
+  }
+  StandardWriter writer(buffer, capacity);
+  writer.WriteValue(value);
+  return writer.ok();
+}
+
+}  // namespace platzi
@@ -0,0 +1,49 @@
+#ifndef NATIVE_CODEC_STANDARD_MESSAGE_CODEC_H_
+#define NATIVE_CODEC_STANDARD_MESSAGE_CODEC_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "codec/arena.h"
+#include "codec/value.h"
+#include "codec/value_decoder.h"
+
+namespace platzi {
+
+// The counterpart of FlutterStandardMessageCodec for |Value| trees.
+//
+// Encoding first computes the exact encoded size with |EncodedSizeOf| and
+// then writes in one pass, so a message costs a single allocation (or none,
+// with a caller-supplied buffer) instead of repeated growth and copying.
+// Both passes keep the lists and maps they are in on the stack, which
+// takes no allocation either unless they nest more than 32 deep.
+class StandardMessageCodec {
+ public:
+  // Replaces the contents of |encoded| with the encoding of |value|.
+  // Returns false if it holds an extension value, which needs an
+  // |ExtensionMessageCodec|.
+  static bool EncodeMessage(const Value& value, std::vector<uint8_t>* encoded);
+
+  // Encodes |value| into |buffer|. Stores the encoded size in |size| and
+  // returns false, writing nothing, if it exceeds |capacity| or holds an
+  // extension value (whose size is then only a lower bound).
+  static bool EncodeMessage(const Value& value,
+                            uint8_t* buffer,
+                            size_t capacity,
+                            size_t* size);
+
+  static const Value* DecodeMessage(const uint8_t* data,
+                                    size_t size,
+                                    Arena* arena,
+                                    DecodeMode mode = DecodeMode::kBorrow) {
+    return platzi::DecodeMessage(data, size, arena, mode);
+  }
+
+ private:
+  StandardMessageCodec() = delete;
+};
+
+}  // namespace platzi
+
+#endif  // NATIVE_CODEC_STANDARD_MESSAGE_CODEC_H_
@@ -0,0 +1,295 @@
+#include "codec/standard_method_codec.h"
+
+#include "codec/standard_reader.h"
+#include "codec/standard_writer.h"
+
+namespace platzi {
+
+namespace {
+
+constexpr uint8_t kSuccessEnvelope = 0;
+constexpr uint8_t kErrorEnvelope = 1;
+constexpr uint8_t kBatch = 2;
+
+// Every call and envelope takes at least two bytes, which bounds the storage
+// a corrupt batch size can make us allocate.
+constexpr size_t kMinElementSize = 2;
+
+// Returns the number of bytes |WriteCall| produces at |offset|.
+size_t EncodedSizeOfCall(const MethodCall& call, size_t offset) {
+  size_t end = offset + EncodedSizeOf(Value::String(call.method), offset);
+  end += EncodedSizeOf(call.arguments, end);
+  return end - offset;
+}
+
+void WriteCall(const MethodCall& call, StandardWriter* writer) {
+  writer->WriteValue(Value::String(call.method));
+  writer->WriteValue(call.arguments);
+}
+
+bool ReadCall(StandardReader* reader,
+              Arena* arena,
+              DecodeMode mode,
+              MethodCall* call) {
+  const Value* method = DecodeValue(reader, arena, mode);
+  if (method == nullptr || method->type != ValueType::kString) {
+    return false;
+  }
+  const Value* arguments = DecodeValue(reader, arena, mode);
+  if (arguments == nullptr) {
+    return false;
+  }
+  call->method = method->string;
+  call->arguments = *arguments;
+  return true;
+}
+
+// Returns the number of bytes |WriteEnvelope| produces at |offset|.
+size_t EncodedSizeOfEnvelope(const Envelope& envelope, size_t offset) {
+  size_t end = offset + 1;
+  if (!envelope.is_error) {
+    end += EncodedSizeOf(envelope.result, end);
+    return end - offset;
+  }
+  end += EncodedSizeOf(Value::String(envelope.error.code), end);
+  end += EncodedSizeOf(envelope.error.message, end);
+  end += EncodedSizeOf(envelope.error.details, end);
+  return end - offset;
+}
+
+void WriteEnvelope(const Envelope& envelope, StandardWriter* writer) {
+  if (!envelope.is_error) {
+    writer->WriteByte(kSuccessEnvelope);
+    writer->WriteValue(envelope.result);
+    return;
+  }
+  writer->WriteByte(kErrorEnvelope);
+  writer->WriteValue(Value::String(envelope.error.code));
+  writer->WriteValue(envelope.error.message);
+  writer->WriteValue(envelope.error.details);
+}
+
+// Writes a batch of envelopes, or the single envelope at |envelopes| if
+// |batch| is false. Returns false if a value cannot be encoded.
+bool EncodeEnvelopes(const Envelope* envelopes,
+                     size_t count,
+                     bool batch,
+                     std::vector<uint8_t>* encoded) {
+  size_t size =
+      batch ? 1 + EncodedSizeOfSize(static_cast<uint32_t>(count)) : 0;
+  for (size_t i = 0; i < count; i++) {
+    size += EncodedSizeOfEnvelope(envelopes[i], size);
+  }
+  encoded->clear();
+  encoded->reserve(size);
+  StandardWriter writer(encoded);
+  if (batch) {
+    writer.WriteByte(kBatch);
+    writer.WriteSize(static_cast<uint32_t>(count));
+  }
+  for (size_t i = 0; i < count; i++) {
+    WriteEnvelope(envelopes[i], &writer);
+  }
+  return writer.ok();
+}
+
+bool ReadEnvelope(StandardReader* reader,
+                  Arena* arena,
+                  DecodeMode mode,
+                  Envelope* envelope) {
+  uint8_t flag;
+  if (!reader->ReadByte(&flag)) {
+    return false;
+  }
+  if (flag == kSuccessEnvelope) {
+    const Value* result = DecodeValue(reader, arena, mode);
+    if (result == nullptr) {
+      return false;
+    }
+    envelope->is_error = false;
+    envelope->result = *result;
+    return true;
+  }
+  if (flag != kErrorEnvelope) {
+    return false;
+  }
+  const Value* code = DecodeValue(reader, arena, mode);
+  if (code == nullptr || code->type != ValueType::kString) {
+    return false;
+  }
+  const Value* message = DecodeValue(reader, arena, mode);
+  if (message == nullptr ||
+      !(message->is_null() || message->type == ValueType::kString)) {
+    return false;
+  }
+  const Value* details = DecodeValue(reader, arena, mode);
+  if (details == nullptr) {
+    return false;
+  }
+  envelope->is_error = true;
+  envelope->error.code = code->string;
+  envelope->error.message = *message;
+  envelope->error.details = *details;
+  return true;
+}
+
+// Reads the batch byte and size, and allocates the elements.
+template <typename T>
+bool ReadBatchHeader(StandardReader* reader,
+                     Arena* arena,
+                     T** elements,
+                     uint32_t* count) {
+  uint8_t flag;
+  if (!reader->ReadByte(&flag) || flag != kBatch || !reader->ReadSize(count) ||
+      *count > (reader->size() - reader->position()) / kMinElementSize) {
+    return false;
+  }
+  *elements = arena->NewArray<T>(*count);
+  return true;
+}
+
+}  // namespace
+
+MethodCallHandler::~MethodCallHandler() = default;
+
+bool StandardMethodCodec::EncodeMethodCall(const MethodCall& call,
+                                           std::vector<uint8_t>* encoded) {
+  encoded->clear();
+  encoded->reserve(EncodedSizeOfCall(call, 0));
+  StandardWriter writer(encoded);
+  WriteCall(call, &writer);
+  return writer.ok();
+}
+
+bool StandardMethodCodec::DecodeMethodCall(const uint8_t* data,
+                                           size_t size,
+                                           Arena* arena,
+                                           MethodCall* call,
+                                           DecodeMode mode) {
+  StandardReader reader(data, size);
+  return ReadCall(&reader, arena, mode, call) && !reader.HasMore();
+}
+
+bool StandardMethodCodec::EncodeSuccessEnvelope(
+    const Value& result,
+    std::vector<uint8_t>* encoded) {
+  Envelope envelope;
+  envelope.result = result;
+  return EncodeEnvelopes(&envelope, 1, false, encoded);
+}
+
+bool StandardMethodCodec::EncodeErrorEnvelope(const MethodError& error,
+                                              std::vector<uint8_t>* encoded) {
+  Envelope envelope;
+  envelope.is_error = true;
+  envelope.error = error;
+  return EncodeEnvelopes(&envelope, 1, false, encoded);
+}
+
+bool StandardMethodCodec::DecodeEnvelope(const uint8_t* data,
+                                         size_t size,
+                                         Arena* arena,
+                                         Envelope* envelope,
+                                         DecodeMode mode) {
+  StandardReader reader(data, size);
+  return ReadEnvelope(&reader, arena, mode, envelope) && !reader.HasMore();
+}
+
+bool StandardMethodCodec::EncodeMethodCallBatch(
+    const MethodCall* calls,
+    size_t count,
+    std::vector<uint8_t>* encoded) {
+  size_t size = 1 + EncodedSizeOfSize(static_cast<uint32_t>(count));
+  for (size_t i = 0; i < count; i++) {
+    size += EncodedSizeOfCall(calls[i], size);
+  }
+  encoded->clear();
+  encoded->reserve(size);
+  StandardWriter writer(encoded);
+  writer.WriteByte(kBatch);
+  writer.WriteSize(static_cast<uint32_t>(count));
+  for (size_t i = 0; i < count; i++) {
+    WriteCall(calls[i], &writer);
+  }
+  return writer.ok();
+}
+
+bool StandardMethodCodec::DecodeMethodCallBatch(const uint8_t* data,
+                                                size_t size,
+                                                Arena* arena,
+                                                Span<MethodCall>* calls,
+                                                DecodeMode mode) {
+  StandardReader reader(data, size);
+  MethodCall* items;
+  uint32_t count;
+  if (!ReadBatchHeader(&reader, arena, &items, &count)) {
+    return false;
+  }
+  for (uint32_t i = 0; i < count; i++) {
+    if (!ReadCall(&reader, arena, mode, &items[i])) {
+      return false;
+    }
+  }
+  calls->data = items;
+  calls->size = count;
+  return !reader.HasMore();
+}
+
+bool StandardMethodCodec::EncodeEnvelopeBatch(const Envelope* envelopes,
+                                              size_t count,
+                                              std::vector<uint8_t>* encoded) {
+  return EncodeEnvelopes(envelopes, count, true, encoded);
+}
+
+bool StandardMethodCodec::DecodeEnvelopeBatch(const uint8_t* data,
+                                              size_t size,
+                                              Arena* arena,
+                                              Span<Envelope>* envelopes,
+                                              DecodeMode mode) {
+  StandardReader reader(data, size);
+  Envelope* items;
+  uint32_t count;
+  if (!ReadBatchHeader(&reader, arena, &items, &count)) {
+    return false;
+  }
+  for (uint32_t i = 0; i < count; i++) {
+    if (!ReadEnvelope(&reader, arena, mode, &items[i])) {
+      return false;
+    }
+  }
+  envelopes->data = items;
+  envelopes->size = count;
+  return !reader.HasMore();
+}
+
+bool StandardMethodCodec::IsBatch(const uint8_t* data, size_t size) {
+  return size > 0 && data[0] == kBatch;
+}
+
+bool StandardMethodCodec::DispatchMethodCalls(const uint8_t* data,
+                                              size_t size,
+                                              Arena* arena,
+                                              MethodCallHandler* handler,
+                                              std::vector<uint8_t>* reply,
+                                              DecodeMode mode) {
+  if (!IsBatch(data, size)) {
+    MethodCall call;
+    if (!DecodeMethodCall(data, size, arena, &call, mode)) {
+      return false;
+    }
+    Envelope envelope;
+    handler->HandleMethodCall(call, &envelope);
+    return EncodeEnvelopes(&envelope, 1, false, reply);
+  }
+  Span<MethodCall> calls;
+  if (!DecodeMethodCallBatch(data, size, arena, &calls, mode)) {
+    return false;
+  }
+  Envelope* envelopes = arena->NewArray<Envelope>(calls.size);
+  for (size_t i = 0; i < calls.size; i++) {
+    handler->HandleMethodCall(calls[i], &envelopes[i]);
+  }
+  return EncodeEnvelopeBatch(envelopes, calls.size, reply);
+}
+
+}  // namespace platzi
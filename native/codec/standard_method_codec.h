@@ -0,0 +1,99 @@
+#ifndef NATIVE_CODEC_STANDARD_METHOD_CODEC_H_
+#define NATIVE_CODEC_STANDARD_METHOD_CODEC_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "codec/arena.h"
+#include "codec/method_call.h"
+#include "codec/value.h"
+#include "codec/value_decoder.h"
+
+namespace platzi {
+
+// Handles the method calls of |StandardMethodCodec::DispatchMethodCalls|.
+class MethodCallHandler {
+ public:
+  virtual ~MethodCallHandler();
+
+  // Handles |call| and stores its result or error in |reply|, which starts
+  // out as a null result. Values stored in |reply| must stay valid until
+  // the dispatch returns.
+  virtual void HandleMethodCall(const MethodCall& call, Envelope* reply) = 0;
+};
+
+// The counterpart of FlutterStandardMethodCodec. A method call is its name
+// followed by its arguments, each in the standard encoding. A result
+// envelope is a 0 byte followed by the result; an error envelope is a 1 byte
+// followed by the code, message and details.
+//
+// Batches carry several calls, or their replies, in one message, so a burst
+// of calls costs one dispatch and one reply. A batch is a 2 byte, the number
+// of elements as a size, and the elements: calls as above, or envelopes each
+// with its own 0 or 1 byte. The Dart end needs a MethodCodec that knows the
+// batch byte.
+//
+// Encoders return false if a value is an extension value, which the
+// standard encoding has no type for.
+class StandardMethodCodec {
+ public:
+  static bool EncodeMethodCall(const MethodCall& call,
+                               std::vector<uint8_t>* encoded);
+  static bool DecodeMethodCall(const uint8_t* data,
+                               size_t size,
+                               Arena* arena,
+                               MethodCall* call,
+                               DecodeMode mode = DecodeMode::kBorrow);
+
+  static bool EncodeSuccessEnvelope(const Value& result,
+                                    std::vector<uint8_t>* encoded);
+  static bool EncodeErrorEnvelope(const MethodError& error,
+                                  std::vector<uint8_t>* encoded);
+  static bool DecodeEnvelope(const uint8_t* data,
+                             size_t size,
+                             Arena* arena,
+                             Envelope* envelope,
+                             DecodeMode mode = DecodeMode::kBorrow);
+
+  static bool EncodeMethodCallBatch(const MethodCall* calls,
+                                    size_t count,
+                                    std::vector<uint8_t>* encoded);
+  // Decodes the calls of a batch into an array allocated in |arena|.
+  static bool DecodeMethodCallBatch(const uint8_t* data,
+                                    size_t size,
+                                    Arena* arena,
+                                    Span<MethodCall>* calls,
+                                    DecodeMode mode = DecodeMode::kBorrow);
+
+  static bool EncodeEnvelopeBatch(const Envelope* envelopes,
+                                  size_t count,
+                                  std::vector<uint8_t>* encoded);
+  // Decodes the envelopes of a batch into an array allocated in |arena|.
+  static bool DecodeEnvelopeBatch(const uint8_t* data,
+                                  size_t size,
+                                  Arena* arena,
+                                  Span<Envelope>* envelopes,
+                                  DecodeMode mode = DecodeMode::kBorrow);
+
+  // Whether |data| holds a batch rather than a single call or envelope.
+  static bool IsBatch(const uint8_t* data, size_t size);
+
+  // Decodes a method call or a batch of them, hands each call to |handler|
+  // in order and replaces the contents of |reply| with the matching
+  // envelope or batch of envelopes. Returns false, leaving |reply| alone,
+  // if the message is malformed, and false if a reply cannot be encoded.
+  static bool DispatchMethodCalls(const uint8_t* data,
+                                  size_t size,
+                                  Arena* arena,
+                                  MethodCallHandler* handler,
+                                  std::vector<uint8_t>* reply,
+                                  DecodeMode mode = DecodeMode::kBorrow);
+
+ private:
+  StandardMethodCodec() = delete;
+};
+
+}  // namespace platzi
+
+#endif  // NATIVE_CODEC_STANDARD_METHOD_CODEC_H_
@@ -0,0 +1,287 @@
+#include "codec/standard_reader.h"
+
+#include <cstring>
+
+#include "codec/delta_varint.h"
+#include "codec/tensor.h"
+#include "codec/utf8.h"
+
+namespace platzi {
+
+StandardReader::StandardReader(const uint8_t* data, size_t size)
+    : data_(data), size_(size) {}
+
+StandardReader::~StandardReader() = default;
+
+bool StandardReader::Seek(size_t position) {
+  if (position > size_) {
+    return false;
+  }
+  position_ = position;
+  return true;
+}
+
+bool StandardReader::ReadByte(uint8_t* value) {
+  if (position_ >= size_) {
+    return false;
+  }
+  *value = data_[position_++];
+  return true;
+}
+
+bool StandardReader::ReadBytes(void* destination, size_t length) {
+  if (size_ - position_ < length) {
+    return false;
+  }
+  std::memcpy(destination, data_ + position_, length);
+  position_ += length;
+  return true;
+}
+
+bool StandardReader::ReadData(size_t length, ByteSpan* value) {
+  if (size_ - position_ < length) {
+    return false;
+  }
+  value->data = data_ + position_;
+  value->size = length;
+  position_ += length;
+  return true;
+}
+
+template <typename T>
+bool StandardReader::ReadScalar(T* value) {
+  return ReadBytes(value, sizeof(T));
+}
+
+bool StandardReader::ReadSize(uint32_t* value) {
+  uint8_t byte;
+  if (!ReadByte(&byte)) {
+    return false;
+  }
+  if (byte < 254) {
+    *value = byte;
+    return true;
+  }
+  if (byte == 254) {
+    uint16_t value16;
+    if (!ReadScalar(&value16)) {
+      return false;
+    }
+    *value = value16;
+    return true;
+  }
+  return ReadScalar(value);
+}
+
+bool StandardReader::ReadAlignment(uint8_t alignment) {
+  size_t mod = position_ % alignment;
+  if (mod == 0) {
+    return true;
+  }
+  size_t padding = alignment - mod;
+  if (size_ - position_ < padding) {
+    return false;
+  }
+  position_ += padding;
+  return true;
+}
+
+bool StandardReader::ReadVarint(uint32_t* value) {
+  uint32_t result = 0;
+  for (int shift = 0; shift < 35; shift += 7) {
+    uint8_t byte;
+    if (!ReadByte(&byte)) {
+      return false;
+    }
+    if (shift == 28 && byte > 0x0F) {
+      return false;
+    }
+    result |= static_cast<uint32_t>(byte & 0x7F) << shift;
+    if (byte < 0x80) {
+      *value = result;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool StandardReader::ReadUTF8(std::string_view* value) {
+  uint32_t length;
+  ByteSpan bytes;
+  if (!ReadSize(&length) || !ReadData(length, &bytes)) {
+    return false;
+  }
+  if (validate_utf8_ && !ValidateUtf8(bytes.data, bytes.size)) {
+    return false;
+  }
+  *value = std::string_view(reinterpret_cast<const char*>(bytes.data),
+                            bytes.size);
+  return true;
+}
+
+bool StandardReader::ReadUTF16(std::u16string* value) {
+  uint32_t length;
+  ByteSpan bytes;
+  if (!ReadSize(&length) || !ReadData(length, &bytes)) {
+    return false;
+  }
+  return Utf8ToUtf16(bytes.data, bytes.size, value);
+}
+
+bool StandardReader::ReadValue(StandardToken* token) {
+  uint8_t type;
+  if (!ReadByte(&type)) {
+    return false;
+  }
+  token->shared = nullptr;
+  token->share = false;
+  return ReadValueOfType(type, token);
+}
+
+bool StandardReader::ReadTypedData(StandardField type, StandardToken* token) {
+  uint32_t count;
+  if (!ReadSize(&count)) {
+    return false;
+  }
+  uint8_t element_size = TypedDataElementSize(type);
+  if (!ReadAlignment(element_size)) {
+    return false;
+  }
+  size_t length = static_cast<size_t>(count) * element_size;
+  ByteSpan bytes;
+  if (!ReadData(length, &bytes)) {
+    return false;
+  }
+  token->typed_data.type = type;
+  token->typed_data.bytes = bytes.data;
+  token->typed_data.element_count = count;
+  token->typed_data.element_size = element_size;
+  token->count = count;
+  return true;
+}
+
+bool StandardReader::ReadInt64Deltas(StandardToken* token) {
+  uint32_t count;
+  uint32_t length;
+  if (!ReadSize(&count) || !ReadSize(&length)) {
+    return false;
+  }
+  // Every varint takes one to ten bytes.
+  if (length < count || length > static_cast<uint64_t>(count) *
+                                     kMaxVarint64Length) {
+    return false;
+  }
+  token->count = count;
+  return ReadData(length, &token->payload);
+}
+
+bool StandardReader::ReadTensor(StandardToken* token) {
+  uint8_t dtype;
+  uint8_t rank;
+  if (!ReadByte(&dtype) || !ReadByte(&rank) ||
+      !IsTypedDataField(static_cast<StandardField>(dtype)) ||
+      rank > kMaxTensorRank || !ReadAlignment(4) ||
+      !ReadData(static_cast<size_t>(rank) * 4, &token->payload)) {
+    return false;
+  }
+  StandardField type = static_cast<StandardField>(dtype);
+  uint8_t element_size = TypedDataElementSize(type);
+  if (!ReadAlignment(element_size)) {
+    return false;
+  }
+  uint32_t shape[kMaxTensorRank];
+  std::memcpy(shape, token->payload.data, token->payload.size);
+  // A tensor with any dimension of zero has no elements, however large the
+  // others are. Otherwise the product is checked against what is left of
+  // the message as it grows, so that it cannot overflow.
+  uint64_t count = 1;
+  for (uint8_t i = 0; i < rank; i++) {
+    if (shape[i] == 0) {
+      count = 0;
+    }
+  }
+  size_t available = (size_ - position_) / element_size;
+  for (uint8_t i = 0; i < rank && count != 0; i++) {
+    count *= shape[i];
+    if (count > available) {
+      return false;
+    }
+  }
+  ByteSpan bytes;
+  if (count > UINT32_MAX || !ReadData(count * element_size, &bytes)) {
+    return false;
+  }
+  token->typed_data.type = type;
+  token->typed_data.bytes = bytes.data;
+  token->typed_data.element_count = static_cast<uint32_t>(count);
+  token->typed_data.element_size = element_size;
+  token->count = rank;
+  return true;
+}
+
+bool StandardReader::ReadValueOfType(uint8_t type, StandardToken* token) {
+  StandardField field = static_cast<StandardField>(type);
+  token->type = field;
+  switch (field) {
+    case StandardField::kNil:
+      return true;
+    case StandardField::kTrue:
+      token->boolean = true;
+      return true;
+    case StandardField::kFalse:
+      token->boolean = false;
+      return true;
+    case StandardField::kInt32:
+      return ReadScalar(&token->int32);
+    case StandardField::kInt64:
+      return ReadScalar(&token->int64);
+    case StandardField::kFloat64:
+      return ReadAlignment(8) && ReadScalar(&token->float64);
+    case StandardField::kIntHex:
+    case StandardField::kString:
+      return ReadUTF8(&token->string);
+    case StandardField::kUInt8Data:
+    case StandardField::kInt32Data:
+    case StandardField::kInt64Data:
+    case StandardField::kFloat64Data:
+    case StandardField::kFloat32Data:
+    case StandardField::kInt16Data:
+    case StandardField::kUInt16Data:
+      return ReadTypedData(field, token);
+    case StandardField::kInt64DeltaData:
+      return ReadInt64Deltas(token);
+    case StandardField::kTensor:
+      return ReadTensor(token);
+    case StandardField::kList:
+    case StandardField::kMap:
+      return ReadSize(&token->count);
+  }
+  // Extension payloads are only interpreted once decoded, so they can be
+  // skipped over without knowing their types.
+  if (IsExtensionType(type)) {
+    return ReadSize(&token->count) && ReadData(token->count, &token->payload);
+  }
+  return false;
+}
+
+void StandardReader::ShareValue(const Value* /*value*/) {}
+
+bool StandardReader::SkipValue() {
+  // Iterative so that deeply nested messages cannot exhaust the stack.
+  uint64_t remaining = 1;
+  StandardToken token;
+  while (remaining > 0) {
+    if (!ReadValue(&token)) {
+      return false;
+    }
+    remaining--;
+    if (token.type == StandardField::kList) {
+      remaining += token.count;
+    } else if (token.type == StandardField::kMap) {
+      remaining += 2ull * token.count;
+    }
+  }
+  return true;
+}
+
+}  // namespace platzi
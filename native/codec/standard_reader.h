@@ -0,0 +1,142 @@
+#ifndef NATIVE_CODEC_STANDARD_READER_H_
+#define NATIVE_CODEC_STANDARD_READER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "codec/standard_field.h"
+#include "codec/typed_data.h"
+
+namespace platzi {
+
+class ExtensionRegistry;
+struct Value;
+
+// One decoded value of the standard encoding, without its children.
+//
+// Strings and typed data point into the message buffer and stay valid for as
+// long as that buffer does. For lists and maps only the element count is
+// decoded; the elements (keys and values alternating, for maps) follow in the
+// stream and are read with further calls to |StandardReader::ReadValue|.
+struct StandardToken {
+  StandardField type = StandardField::kNil;
+  union {
+    bool boolean;
+    int32_t int32;
+    int64_t int64;
+    double float64;
+    // Number of elements of a list, or of entries of a map; rank of a
+    // tensor.
+    uint32_t count;
+  };
+  // UTF-8 bytes of a string, or hex digits of an IntHex.
+  std::string_view string;
+  // Elements of a typed data list, or of a tensor as a flat list.
+  TypedDataView typed_data;
+  // Varints of an Int64DeltaData list, which unpack to |count| elements
+  // with |UnpackInt64Deltas|, the payload of an extension type, or the
+  // |count| native uint32 dimensions of a tensor.
+  ByteSpan payload;
+  // Set by readers of encodings that share values between places in a
+  // message (see dedup_codec.h). |shared| is an earlier value, complete
+  // with its elements, that the token stands for. |share| asks
+  // |DecodeValue| to pass the value decoded from the token to
+  // |StandardReader::ShareValue| once its elements are complete.
+  const Value* shared = nullptr;
+  bool share = false;
+
+  StandardToken() : int64(0) {}
+};
+
+// A reader of the Flutter standard binary encoding over a borrowed byte range.
+//
+// This is the zero-copy counterpart of FlutterStandardReader: nothing is
+// copied or allocated while decoding. The reader never takes ownership of
+// |data|, which must outlive the reader and every view handed out by it.
+//
+// All read methods return false if the message is truncated or malformed;
+// the position of the reader is unspecified afterwards.
+class StandardReader {
+ public:
+  StandardReader(const uint8_t* data, size_t size);
+  virtual ~StandardReader();
+
+  StandardReader(const StandardReader&) = delete;
+  StandardReader& operator=(const StandardReader&) = delete;
+
+  bool HasMore() const { return position_ < size_; }
+  size_t position() const { return position_; }
+  size_t size() const { return size_; }
+  const uint8_t* data() const { return data_; }
+
+  // Whether |ReadUTF8| rejects strings that are not valid UTF-8. Off by
+  // default: the Dart side of a channel only ever writes valid UTF-8, so
+  // validation is only worth its cost for messages from untrusted peers.
+  bool validate_utf8() const { return validate_utf8_; }
+  void set_validate_utf8(bool validate) { validate_utf8_ = validate; }
+
+  // The extension types |DecodeValue| decodes values of, if any. The
+  // registry must outlive the reader.
+  const ExtensionRegistry* extensions() const { return extensions_; }
+  void set_extensions(const ExtensionRegistry* extensions) {
+    extensions_ = extensions;
+  }
+
+  // Moves the reader to |position|, which must be within the message.
+  bool Seek(size_t position);
+
+  bool ReadByte(uint8_t* value);
+
+  // Copies |length| bytes into |destination|.
+  bool ReadBytes(void* destination, size_t length);
+
+  // Returns a view of the next |length| bytes without copying them.
+  bool ReadData(size_t length, ByteSpan* value);
+
+  bool ReadSize(uint32_t* value);
+  bool ReadVarint(uint32_t* value);
+  bool ReadAlignment(uint8_t alignment);
+
+  // Returns a view of a size-prefixed UTF-8 string.
+  bool ReadUTF8(std::string_view* value);
+
+  // Reads a size-prefixed UTF-8 string transcoded to UTF-16, the
+  // representation used by NSString. Always validates.
+  bool ReadUTF16(std::u16string* value);
+
+  // Reads the type byte and payload of the next value into |token|.
+  bool ReadValue(StandardToken* token);
+
+  // Reads the payload of a value whose type byte has already been consumed.
+  //
+  // The encoding is extensible via subclasses overriding this method for
+  // type bytes the standard encoding does not use. Extension types, from
+  // |kFirstExtensionType| on, are read as a size-prefixed payload.
+  virtual bool ReadValueOfType(uint8_t type, StandardToken* token);
+
+  // Skips the next value, including all elements of lists and maps.
+  bool SkipValue();
+
+  // Receives each complete value decoded from a token with |share| set.
+  virtual void ShareValue(const Value* value);
+
+ private:
+  template <typename T>
+  bool ReadScalar(T* value);
+
+  bool ReadTypedData(StandardField type, StandardToken* token);
+  bool ReadInt64Deltas(StandardToken* token);
+  bool ReadTensor(StandardToken* token);
+
+  const uint8_t* data_;
+  size_t size_;
+  size_t position_ = 0;
+  bool validate_utf8_ = false;
+  const ExtensionRegistry* extensions_ = nullptr;
+};
+
+}  // namespace platzi
+
+#endif  // NATIVE_CODEC_STANDARD_READER_H_
@@ -0,0 +1,352 @@
+#include "codec/standard_writer.h"
+
+#include "codec/delta_varint.h"
+#include "codec/extension_registry.h"
+#include "codec/tensor.h"
+#include "codec/utf8.h"
+
+namespace platzi {
+
+namespace {
+
+constexpr uint8_t kPadding[8] = {};
+
+// A list or map whose elements are still being visited.
+struct Frame {
+  const Value* items;
+  const MapEntry* entries;
+  size_t index;
+  size_t slots;
+
+  const Value& NextSlot() {
+    size_t slot = index++;
+    if (items != nullptr) {
+      return items[slot];
+    }
+    const MapEntry& entry = entries[slot / 2];
+    return slot % 2 == 0 ? entry.key : entry.value;
+  }
+};
+
+// The open lists and maps of a visit. The first |kInlineFrames| live in
+// the object itself, on the caller's stack, and only deeper trees spill to
+// the heap, so that encoding a message of ordinary depth does not allocate.
+class FrameStack {
+ public:
+  bool empty() const { return size_ == 0; }
+  Frame& back() {
+    return size_ <= kInlineFrames ? inline_[size_ - 1] : spilled_.back();
+  }
+
+  void push_back(const Frame& frame) {
+    if (size_ < kInlineFrames) {
+      inline_[size_] = frame;
+    } else {
+      spilled_.push_back(frame);
+    }
+    size_++;
+  }
+
+  void pop_back() {
+    if (size_ > kInlineFrames) {
+      spilled_.pop_back();
+    }
+    size_--;
+  }
+
+ private:
+  static constexpr size_t kInlineFrames = 32;
+
+  Frame inline_[kInlineFrames];
+  size_t size_ = 0;
+  std::vector<Frame> spilled_;
+};
+
+// Calls |visit| for |value| and everything it contains in encoding order:
+// map keys before their values. The second argument of |visit| tells map keys
+// apart; what it returns is whether to visit the elements of a list or map.
+// Iterative, like DecodeValue, so deep trees cannot exhaust the stack.
+template <typename Visitor>
+void VisitInEncodingOrder(const Value& value, Visitor visit) {
+  FrameStack stack;
+  const Value* current = &value;
+  bool is_map_key = false;
+  while (true) {
+    bool descend = visit(*current, is_map_key);
+    if (descend && current->type == ValueType::kList &&
+        !current->list.empty()) {
+      stack.push_back({current->list.data, nullptr, 0, current->list.size});
+    } else if (descend && current->type == ValueType::kMap &&
+               !current->map.empty()) {
+      stack.push_back({nullptr, current->map.data, 0, 2 * current->map.size});
+    }
+    while (!stack.empty() && stack.back().index == stack.back().slots) {
+      stack.pop_back();
+    }
+    if (stack.empty()) {
+      return;
+    }
+    Frame& frame = stack.back();
+    is_map_key = frame.entries != nullptr && frame.index % 2 == 0;
+    current = &frame.NextSlot();
+  }
+}
+
+// Values that |StandardWriter::WriteShared| gets to see.
+inline bool IsShareable(const Value& value) {
+  switch (value.type) {
+    case ValueType::kString:
+    case ValueType::kTypedData:
+    case ValueType::kList:
+    case ValueType::kMap:
+      return true;
+    default:
+      return false;
+  }
+}
+
+inline size_t Padding(size_t offset, size_t alignment) {
+  return (alignment - offset % alignment) % alignment;
+}
+
+}  // namespace
+
+StandardWriter::StandardWriter(std::vector<uint8_t>* data) : vector_(data) {}
+
+StandardWriter::StandardWriter(uint8_t* buffer, size_t capacity)
+    : begin_(buffer), cursor_(buffer), end_(buffer + capacity) {}
+
+StandardWriter::~StandardWriter() = default;
+
+uint8_t* StandardWriter::Extend(size_t length) {
+  if (vector_ != nullptr) {
+    size_t start = vector_->size();
+    vector_->resize(start + length);
+    return vector_->data() + start;
+  }
+  if (static_cast<size_t>(end_ - cursor_) < length) {
+    Overflow();
+    return nullptr;
+  }
+  uint8_t* start = cursor_;
+  cursor_ += length;
+  return start;
+}
+
+void StandardWriter::Overflow() {
+  // Stay full so that later, smaller writes cannot leave gaps.
+  end_ = cursor_;
+  ok_ = false;
+}
+
+void StandardWriter::WriteSize(uint32_t size) {
+  if (size < 254) {
+    WriteByte(static_cast<uint8_t>(size));
+  } else if (size <= 0xFFFF) {
+    WriteByte(254);
+    WriteScalar(static_cast<uint16_t>(size));
+  } else {
+    WriteByte(255);
+    WriteScalar(size);
+  }
+}
+
+void StandardWriter::WriteVarint(uint32_t value) {
+  while (value >= 0x80) {
+    WriteByte(static_cast<uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  WriteByte(static_cast<uint8_t>(value));
+}
+
+void StandardWriter::WriteAlignment(uint8_t alignment) {
+  WriteBytes(kPadding, Padding(size(), alignment));
+}
+
+void StandardWriter::WriteUTF8(std::string_view value) {
+  WriteSize(static_cast<uint32_t>(value.size()));
+  WriteBytes(value.data(), value.size());
+}
+
+void StandardWriter::WriteUTF8(std::u16string_view value) {
+  size_t length = Utf8LengthOfUtf16(value.data(), value.size());
+  WriteSize(static_cast<uint32_t>(length));
+  if (uint8_t* out = Extend(length)) {
+    Utf16ToUtf8(value.data(), value.size(), out);
+  }
+}
+
+void StandardWriter::WriteTypedData(const TypedDataView& value,
+                                    ByteOrder source_order) {
+  WriteSize(value.element_count);
+  WriteAlignment(value.element_size);
+  if (value.element_size == 1 || !NeedsByteSwap(source_order)) {
+    WriteBytes(value.bytes, value.byte_size());
+  } else if (uint8_t* out = Extend(value.byte_size())) {
+    CopyElements(value.bytes, value.element_count, value.element_size,
+                 source_order, out);
+  }
+}
+
+void StandardWriter::WriteInt64Deltas(const TypedDataView& value) {
+  size_t size = PackedSizeOfInt64Deltas(value.bytes, value.element_count);
+  WriteSize(value.element_count);
+  WriteSize(static_cast<uint32_t>(size));
+  if (uint8_t* out = Extend(size)) {
+    PackInt64Deltas(value.bytes, value.element_count, out, size);
+  }
+}
+
+void StandardWriter::WriteTensor(const TensorView& value) {
+  WriteByte(static_cast<uint8_t>(value.dtype));
+  WriteByte(value.rank);
+  WriteAlignment(4);
+  WriteBytes(value.shape, static_cast<size_t>(value.rank) * 4);
+  WriteAlignment(value.element_size);
+  if (value.IsContiguous()) {
+    WriteBytes(value.data, value.byte_size());
+  } else if (uint8_t* out = Extend(value.byte_size())) {
+    value.CopyContiguous(out);
+  }
+}
+
+void StandardWriter::WriteString(std::string_view value,
+                                 bool /*is_map_key*/) {
+  WriteByte(static_cast<uint8_t>(StandardField::kString));
+  WriteUTF8(value);
+}
+
+bool StandardWriter::WriteShared(const Value& /*value*/,
+                                 bool /*is_map_key*/) {
+  return false;
+}
+
+void StandardWriter::WriteValueHeader(const Value& value, bool is_map_key) {
+  switch (value.type) {
+    case ValueType::kNull:
+      WriteByte(static_cast<uint8_t>(StandardField::kNil));
+      return;
+    case ValueType::kBool:
+      WriteByte(static_cast<uint8_t>(value.boolean ? StandardField::kTrue
+                                                   : StandardField::kFalse));
+      return;
+    case ValueType::kInt32:
+      WriteByte(static_cast<uint8_t>(StandardField::kInt32));
+      WriteScalar(value.int32);
+      return;
+    case ValueType::kInt64:
+      WriteByte(static_cast<uint8_t>(StandardField::kInt64));
+      WriteScalar(value.int64);
+      return;
+    case ValueType::kFloat64:
+      WriteByte(static_cast<uint8_t>(StandardField::kFloat64));
+      WriteAlignment(8);
+      WriteScalar(value.float64);
+      return;
+    case ValueType::kString:
+      WriteString(value.string, is_map_key);
+      return;
+    case ValueType::kTypedData:
+      WriteByte(static_cast<uint8_t>(value.typed_data.type));
+      if (value.typed_data.type == StandardField::kInt64DeltaData) {
+        WriteInt64Deltas(value.typed_data);
+      } else {
+        WriteTypedData(value.typed_data);
+      }
+      return;
+    case ValueType::kList:
+      WriteByte(static_cast<uint8_t>(StandardField::kList));
+      WriteSize(static_cast<uint32_t>(value.list.size));
+      return;
+    case ValueType::kMap:
+      WriteByte(static_cast<uint8_t>(StandardField::kMap));
+      WriteSize(static_cast<uint32_t>(value.map.size));
+      return;
+    case ValueType::kTensor:
+      WriteByte(static_cast<uint8_t>(StandardField::kTensor));
+      WriteTensor(*value.tensor);
+      return;
+    case ValueType::kExtension:
+      if (extensions_ == nullptr ||
+          !extensions_->Encode(value.extension, this)) {
+        ok_ = false;
+      }
+      return;
+  }
+}
+
+void StandardWriter::WriteValue(const Value& value) {
+  VisitInEncodingOrder(value, [this](const Value& node, bool is_map_key) {
+    if (IsShareable(node) && WriteShared(node, is_map_key)) {
+      return false;
+    }
+    WriteValueHeader(node, is_map_key);
+    return true;
+  });
+}
+
+size_t EncodedSizeOf(const Value& value, size_t offset) {
+  bool holds_extension;
+  return EncodedSizeOf(value, offset, &holds_extension);
+}
+
+size_t EncodedSizeOf(const Value& value,
+                     size_t offset,
+                     bool* holds_extension) {
+  size_t end = offset;
+  *holds_extension = false;
+  VisitInEncodingOrder(value, [&end, holds_extension](const Value& node,
+                                                      bool) {
+    end++;  // The type byte.
+    switch (node.type) {
+      case ValueType::kNull:
+      case ValueType::kBool:
+        break;
+      case ValueType::kInt32:
+        end += 4;
+        break;
+      case ValueType::kInt64:
+        end += 8;
+        break;
+      case ValueType::kFloat64:
+        end += Padding(end, 8) + 8;
+        break;
+      case ValueType::kString:
+        end += EncodedSizeOfSize(static_cast<uint32_t>(node.string.size())) +
+               node.string.size();
+        break;
+      case ValueType::kTypedData: {
+        const TypedDataView& data = node.typed_data;
+        end += EncodedSizeOfSize(data.element_count);
+        if (data.type == StandardField::kInt64DeltaData) {
+          size_t packed = PackedSizeOfInt64Deltas(data.bytes,
+                                                  data.element_count);
+          end += EncodedSizeOfSize(static_cast<uint32_t>(packed)) + packed;
+          break;
+        }
+        end += Padding(end, data.element_size) + data.byte_size();
+        break;
+      }
+      case ValueType::kList:
+        end += EncodedSizeOfSize(static_cast<uint32_t>(node.list.size));
+        break;
+      case ValueType::kMap:
+        end += EncodedSizeOfSize(static_cast<uint32_t>(node.map.size));
+        break;
+      case ValueType::kTensor: {
+        const TensorView& tensor = *node.tensor;
+        end += 2;
+        end += Padding(end, 4) + static_cast<size_t>(tensor.rank) * 4;
+        end += Padding(end, tensor.element_size) + tensor.byte_size();
+        break;
+      }
+      case ValueType::kExtension:
+        *holds_extension = true;
+        break;
+    }
+    return true;
+  });
+  return end - offset;
+}
+
+}  // namespace platzi
@@ -0,0 +1,176 @@
+#ifndef NATIVE_CODEC_STANDARD_WRITER_H_
+#define NATIVE_CODEC_STANDARD_WRITER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+#include "codec/standard_field.h"
+#include "codec/typed_data.h"
+#include "codec/value.h"
+
+namespace platzi {
+
+class ExtensionRegistry;
+struct TensorView;
+
+// A writer of the Flutter standard binary encoding, the counterpart of
+// FlutterStandardWriter.
+//
+// A writer either appends to a growable vector or fills a caller-supplied
+// buffer of fixed capacity. In the latter case writes past the end are
+// dropped and |ok| turns false. Alignment is relative to the start of the
+// vector or buffer, which is the start of the message.
+class StandardWriter {
+ public:
+  // Appends to |data|.
+  explicit StandardWriter(std::vector<uint8_t>* data);
+
+  // Writes into the |capacity| bytes at |buffer|.
+  StandardWriter(uint8_t* buffer, size_t capacity);
+
+  virtual ~StandardWriter();
+
+  StandardWriter(const StandardWriter&) = delete;
+  StandardWriter& operator=(const StandardWriter&) = delete;
+
+  // Bytes written so far, counting from the start of the message.
+  size_t size() const {
+    return vector_ != nullptr ? vector_->size()
+                              : static_cast<size_t>(cursor_ - begin_);
+  }
+
+  // False if a fixed-capacity writer ran out of room, or a value of an
+  // extension type could not be written.
+  bool ok() const { return ok_; }
+
+  // The extension types |WriteValue| writes values of, if any. The registry
+  // must outlive the writer.
+  const ExtensionRegistry* extensions() const { return extensions_; }
+  void set_extensions(const ExtensionRegistry* extensions) {
+    extensions_ = extensions;
+  }
+
+  // Makes room for |size| more bytes at once, so a growable writer
+  // reallocates at most once for them.
+  void Reserve(size_t size) {
+    if (vector_ != nullptr) {
+      vector_->reserve(vector_->size() + size);
+    }
+  }
+
+  void WriteByte(uint8_t value) {
+    if (vector_ != nullptr) {
+      vector_->push_back(value);
+    } else if (cursor_ != end_) {
+      *cursor_++ = value;
+    } else {
+      Overflow();
+    }
+  }
+
+  void WriteBytes(const void* bytes, size_t length) {
+    const uint8_t* begin = static_cast<const uint8_t*>(bytes);
+    if (vector_ != nullptr) {
+      vector_->insert(vector_->end(), begin, begin + length);
+    } else if (static_cast<size_t>(end_ - cursor_) >= length) {
+      if (length > 0) {
+        std::memcpy(cursor_, begin, length);
+        cursor_ += length;
+      }
+    } else {
+      Overflow();
+    }
+  }
+
+  template <typename T>
+  void WriteScalar(T value) {
+    WriteBytes(&value, sizeof(T));
+  }
+
+  void WriteSize(uint32_t size);
+
+  // Writes |value| as an LEB128 varint, which extensions of the encoding use
+  // for table IDs.
+  void WriteVarint(uint32_t value);
+  void WriteAlignment(uint8_t alignment);
+
+  // Writes a size-prefixed UTF-8 string.
+  void WriteUTF8(std::string_view value);
+
+  // Writes a UTF-16 string, such as the contents of an NSString, as a
+  // size-prefixed UTF-8 string.
+  void WriteUTF8(std::u16string_view value);
+
+  // Writes the element count, padding and elements of a typed data list,
+  // without the type byte. Elements stored in |source_order| are converted
+  // to the host's order on the way in.
+  void WriteTypedData(const TypedDataView& value,
+                      ByteOrder source_order = ByteOrder::kNative);
+
+  // Writes the element count, packed size and varints of an Int64DeltaData
+  // list holding the native-order int64 elements of |value|, without the
+  // type byte.
+  void WriteInt64Deltas(const TypedDataView& value);
+
+  // Writes the element type, rank, dimensions and elements of a tensor,
+  // without the type byte. Strided elements are gathered into row-major
+  // order on the way in.
+  void WriteTensor(const TensorView& value);
+
+  // Writes |value| and everything it contains, type bytes included.
+  void WriteValue(const Value& value);
+
+ protected:
+  // Writes a string value or map key, type byte included.
+  //
+  // The encoding of strings is extensible via subclasses overriding this
+  // method, the counterpart of |StandardReader::ReadValueOfType|.
+  virtual void WriteString(std::string_view value, bool is_map_key);
+
+  // Lets subclasses write a string, typed data list, list or map some other
+  // way than in full, such as a reference to an equal one written before.
+  // Returns true if |value| has been written, elements included. Returning
+  // false after writing a prefix, such as a tag, is fine. Writes nothing by
+  // default.
+  virtual bool WriteShared(const Value& value, bool is_map_key);
+
+ private:
+  // Writes |value| itself; lists and maps only get their type and size.
+  void WriteValueHeader(const Value& value, bool is_map_key);
+
+  // Appends |length| bytes for the caller to fill in and returns them, or
+  // nullptr if a fixed-capacity writer cannot fit them.
+  uint8_t* Extend(size_t length);
+
+  void Overflow();
+
+  std::vector<uint8_t>* vector_ = nullptr;
+  uint8_t* begin_ = nullptr;
+  uint8_t* cursor_ = nullptr;
+  uint8_t* end_ = nullptr;
+  bool ok_ = true;
+  const ExtensionRegistry* extensions_ = nullptr;
+};
+
+// Returns the number of bytes |StandardWriter::WriteValue| produces for
+// |value| when the writer has already written |offset| bytes. The offset
+// matters because of alignment padding. Values of extension types count
+// only their type byte, as their payloads are up to their encoders, so the
+// result is a lower bound for trees that hold any.
+size_t EncodedSizeOf(const Value& value, size_t offset = 0);
+
+// As above, and also stores in |holds_extension| whether |value| holds an
+// extension value, in which case the size is not exact.
+size_t EncodedSizeOf(const Value& value, size_t offset, bool* holds_extension);
+
+// Returns the number of bytes |StandardWriter::WriteSize| uses for |size|.
+inline size_t EncodedSizeOfSize(uint32_t size) {
+  return size < 254 ? 1 : size <= 0xFFFF ? 3 : 5;
+}
+
+}  // namespace platzi
+
+#endif  // NATIVE_CODEC_STANDARD_WRITER_H_
@@ -0,0 +1,291 @@
+#include "codec/streaming_reader.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "codec/delta_varint.h"
+
+namespace platzi {
+
+StreamingHandler::~StreamingHandler() = default;
+
+StreamingReader::StreamingReader(StreamingHandler* handler)
+    : handler_(handler) {}
+
+StreamingReader::~StreamingReader() = default;
+
+void StreamingReader::Reset() {
+  state_ = State::kType;
+  offset_ = 0;
+  buffered_ = 0;
+  needed_ = 0;
+  payload_remaining_ = 0;
+  open_.clear();
+}
+
+bool StreamingReader::AtValueBoundary() const {
+  return state_ == State::kType && open_.empty();
+}
+
+bool StreamingReader::Feed(const uint8_t* data, size_t size) {
+  size_t i = 0;
+  while (i < size) {
+    switch (state_) {
+      case State::kFailed:
+        return false;
+      case State::kType: {
+        uint8_t type = data[i++];
+        offset_++;
+        if (!BeginValue(type)) {
+          state_ = State::kFailed;
+        }
+        break;
+      }
+      case State::kSize:
+      case State::kAlignment:
+      case State::kScalar:
+      case State::kShape: {
+        size_t count = std::min(needed_ - buffered_, size - i);
+        uint8_t* buffer = state_ == State::kShape
+                              ? reinterpret_cast<uint8_t*>(shape_)
+                              : buffer_;
+        std::memcpy(buffer + buffered_, data + i, count);
+        buffered_ += count;
+        i += count;
+        offset_ += count;
+        if (buffered_ == needed_ && !OnFieldComplete()) {
+          state_ = State::kFailed;
+        }
+        break;
+      }
+      case State::kPayload: {
+        size_t count = static_cast<size_t>(
+            std::min<uint64_t>(payload_remaining_, size - i));
+        payload_remaining_ -= count;
+        handler_->OnBytes(data + i, count, payload_remaining_ == 0);
+        i += count;
+        offset_ += count;
+        if (payload_remaining_ == 0) {
+          state_ = State::kType;
+          CompleteValue();
+        }
+        break;
+      }
+    }
+  }
+  return state_ != State::kFailed;
+}
+
+bool StreamingReader::BeginValue(uint8_t type) {
+  token_ = StandardToken();
+  token_.type = static_cast<StandardField>(type);
+  switch (token_.type) {
+    case StandardField::kNil:
+      handler_->OnValue(token_);
+      CompleteValue();
+      return true;
+    case StandardField::kTrue:
+    case StandardField::kFalse:
+      token_.boolean = token_.type == StandardField::kTrue;
+      handler_->OnValue(token_);
+      CompleteValue();
+      return true;
+    case StandardField::kInt32:
+      Expect(State::kScalar, 4);
+      return true;
+    case StandardField::kInt64:
+      Expect(State::kScalar, 8);
+      return true;
+    case StandardField::kFloat64:
+      Expect(State::kAlignment, (8 - offset_ % 8) % 8);
+      return buffered_ < needed_ || OnFieldComplete();
+    case StandardField::kIntHex:
+    case StandardField::kString:
+    case StandardField::kList:
+    case StandardField::kMap:
+      element_size_ = 1;
+      Expect(State::kSize, 1);
+      return true;
+    case StandardField::kInt64DeltaData:
+      element_size_ = 1;
+      delta_count_read_ = false;
+      Expect(State::kSize, 1);
+      return true;
+    case StandardField::kTensor:
+      // The element type and rank.
+      shape_read_ = false;
+      Expect(State::kScalar, 2);
+      return true;
+    default:
+      if (IsExtensionType(type)) {
+        element_size_ = 1;
+        Expect(State::kSize, 1);
+        return true;
+      }
+      if (!IsTypedDataField(token_.type)) {
+        return false;
+      }
+      element_size_ = TypedDataElementSize(token_.type);
+      Expect(State::kSize, 1);
+      return true;
+  }
+}
+
+void StreamingReader::Expect(State state, size_t count) {
+  state_ = state;
+  buffered_ = 0;
+  needed_ = count;
+}
+
+bool StreamingReader::OnFieldComplete() {
+  switch (state_) {
+    case State::kSize: {
+      if (buffered_ == 1 && buffer_[0] >= 254) {
+        needed_ = buffer_[0] == 254 ? 3 : 5;
+        return true;
+      }
+      uint32_t size;
+      if (buffered_ == 1) {
+        size = buffer_[0];
+      } else if (buffered_ == 3) {
+        uint16_t size16;
+        std::memcpy(&size16, buffer_ + 1, 2);
+        size = size16;
+      } else {
+        std::memcpy(&size, buffer_ + 1, 4);
+      }
+      if (token_.type == StandardField::kInt64DeltaData) {
+        if (!delta_count_read_) {
+          token_.count = size;
+          delta_count_read_ = true;
+          Expect(State::kSize, 1);
+          return true;
+        }
+        // Every varint takes one to ten bytes.
+        if (size < token_.count ||
+            size > static_cast<uint64_t>(token_.count) * kMaxVarint64Length) {
+          return false;
+        }
+        token_.payload.size = size;
+        handler_->OnValue(token_);
+        payload_remaining_ = size;
+        Expect(State::kAlignment, 0);
+        return OnFieldComplete();
+      }
+      token_.count = size;
+      if (token_.type == StandardField::kList ||
+          token_.type == StandardField::kMap) {
+        handler_->OnValue(token_);
+        uint64_t values = token_.type == StandardField::kMap ? 2ull * size
+                                                             : size;
+        state_ = State::kType;
+        if (values == 0) {
+          handler_->OnContainerEnd();
+          CompleteValue();
+        } else {
+          open_.push_back(values);
+        }
+        return true;
+      }
+      if (IsTypedDataField(token_.type)) {
+        token_.typed_data.type = token_.type;
+        token_.typed_data.bytes = nullptr;
+        token_.typed_data.element_count = size;
+        token_.typed_data.element_size = element_size_;
+      }
+      handler_->OnValue(token_);
+      payload_remaining_ = static_cast<uint64_t>(size) * element_size_;
+      Expect(State::kAlignment, (element_size_ - offset_ % element_size_) %
+                                    element_size_);
+      return buffered_ < needed_ || OnFieldComplete();
+    }
+    case State::kAlignment:
+      if (token_.type == StandardField::kFloat64) {
+        Expect(State::kScalar, 8);
+        return true;
+      }
+      if (token_.type == StandardField::kTensor && !shape_read_) {
+        Expect(State::kShape, static_cast<size_t>(token_.count) * 4);
+        return buffered_ < needed_ || OnFieldComplete();
+      }
+      state_ = State::kPayload;
+      if (payload_remaining_ == 0) {
+        handler_->OnBytes(nullptr, 0, true);
+        state_ = State::kType;
+        CompleteValue();
+      }
+      return true;
+    case State::kShape:
+      return BeginTensorElements();
+    case State::kScalar:
+      if (token_.type == StandardField::kTensor) {
+        StandardField dtype = static_cast<StandardField>(buffer_[0]);
+        if (!IsTypedDataField(dtype) || buffer_[1] > kMaxTensorRank) {
+          return false;
+        }
+        element_size_ = TypedDataElementSize(dtype);
+        token_.typed_data.type = dtype;
+        token_.count = buffer_[1];
+        Expect(State::kAlignment, (4 - offset_ % 4) % 4);
+        return buffered_ < needed_ || OnFieldComplete();
+      }
+      switch (token_.type) {
+        case StandardField::kInt32:
+          std::memcpy(&token_.int32, buffer_, 4);
+          break;
+        case StandardField::kInt64:
+          std::memcpy(&token_.int64, buffer_, 8);
+          break;
+        default:
+          std::memcpy(&token_.float64, buffer_, 8);
+          break;
+      }
+      handler_->OnValue(token_);
+      state_ = State::kType;
+      CompleteValue();
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool StreamingReader::BeginTensorElements() {
+  uint8_t rank = static_cast<uint8_t>(token_.count);
+  // As in |StandardReader|, a dimension of zero leaves no elements however
+  // large the others are, and the count must fit a typed data list.
+  uint64_t count = 1;
+  for (uint8_t i = 0; i < rank; i++) {
+    if (shape_[i] == 0) {
+      count = 0;
+    }
+  }
+  for (uint8_t i = 0; i < rank && count != 0; i++) {
+    count *= shape_[i];
+    if (count > UINT32_MAX) {
+      return false;
+    }
+  }
+  shape_read_ = true;
+  token_.typed_data.bytes = nullptr;
+  token_.typed_data.element_count = static_cast<uint32_t>(count);
+  token_.typed_data.element_size = element_size_;
+  token_.payload = ByteSpan{reinterpret_cast<const uint8_t*>(shape_),
+                            static_cast<size_t>(rank) * 4};
+  handler_->OnValue(token_);
+  payload_remaining_ = count * element_size_;
+  Expect(State::kAlignment,
+         (element_size_ - offset_ % element_size_) % element_size_);
+  return buffered_ < needed_ || OnFieldComplete();
+}
+
+void StreamingReader::CompleteValue() {
+  while (!open_.empty()) {
+    if (--open_.back() > 0) {
+      return;
+    }
+    open_.pop_back();
+    handler_->OnContainerEnd();
+  }
+}
+
+}  // namespace platzi
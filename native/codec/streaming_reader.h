@@ -0,0 +1,127 @@
+#ifndef NATIVE_CODEC_STREAMING_READER_H_
+#define NATIVE_CODEC_STREAMING_READER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "codec/standard_reader.h"
+#include "codec/tensor.h"
+
+namespace platzi {
+
+// Receives the values of a message decoded by |StreamingReader|, in message
+// order, as soon as each is complete.
+class StreamingHandler {
+ public:
+  virtual ~StreamingHandler();
+
+  // A complete value. For lists and maps this announces |token.count|
+  // elements (entries, for maps), which follow as further calls and are
+  // closed by |OnContainerEnd|. For strings, IntHex and typed data only the
+  // type and |token.count| (bytes or elements) are set; the payload follows
+  // through |OnBytes|. For Int64DeltaData lists the payload is the packed
+  // varints, whose length is |token.payload.size|; |UnpackInt64Deltas| turns
+  // them into |token.count| elements. For tensors |token.count| is the rank,
+  // |token.payload| the dimensions, valid only during the call, and
+  // |token.typed_data| the element type and count; the elements follow as
+  // the payload. For extension types the payload is |token.count| bytes for
+  // the registered decoder.
+  virtual void OnValue(const StandardToken& token) = 0;
+
+  // The next |size| bytes of the payload announced by the last |OnValue|.
+  // |last| is set on the final piece; an empty payload gets one empty,
+  // last piece. |bytes| is only valid during the call.
+  virtual void OnBytes(const uint8_t* bytes, size_t size, bool last) = 0;
+
+  // The innermost open list or map is complete.
+  virtual void OnContainerEnd() = 0;
+};
+
+// An incremental decoder of the standard encoding for messages that arrive
+// in chunks of arbitrary size, such as reads from a file or fragments from
+// a transport.
+//
+// Unlike |StandardReader| it never needs the whole message: between chunks
+// it keeps only the bytes of an unfinished size or scalar (at most eight),
+// the dimensions of a tensor (at most |kMaxTensorRank|) and one counter per
+// open list or map. Strings, typed data and the elements of tensors are
+// passed on in pieces as their bytes arrive, so peak memory does not depend
+// on the size of the payloads.
+class StreamingReader {
+ public:
+  explicit StreamingReader(StreamingHandler* handler);
+  ~StreamingReader();
+
+  StreamingReader(const StreamingReader&) = delete;
+  StreamingReader& operator=(const StreamingReader&) = delete;
+
+  // Decodes |size| more bytes of the message. Returns false once the message
+  // is found to be malformed; every later call fails too.
+  bool Feed(const uint8_t* data, size_t size);
+
+  // Returns true if the bytes fed so far end on a top-level value boundary,
+  // meaning the message is complete if no more bytes follow.
+  bool AtValueBoundary() const;
+
+  bool failed() const { return state_ == State::kFailed; }
+
+  // Total bytes fed; alignment is relative to the first of them.
+  uint64_t offset() const { return offset_; }
+
+  // Prepares for a new message.
+  void Reset();
+
+ private:
+  enum class State {
+    kType,
+    kSize,
+    kAlignment,
+    kScalar,
+    kShape,
+    kPayload,
+    kFailed,
+  };
+
+  // Reacts to a type byte.
+  bool BeginValue(uint8_t type);
+
+  // Reacts to a complete size, scalar, tensor shape or padding.
+  bool OnFieldComplete();
+
+  // Announces the tensor whose shape is in |shape_|, and expects its
+  // elements.
+  bool BeginTensorElements();
+
+  // Requests |count| bytes into |buffer_|, or |shape_| for |kShape|,
+  // before calling OnFieldComplete.
+  void Expect(State state, size_t count);
+
+  // Records the completion of a value in the open containers.
+  void CompleteValue();
+
+  StreamingHandler* handler_;
+  State state_ = State::kType;
+  uint64_t offset_ = 0;
+
+  StandardToken token_;
+  // Bytes per element of the current string (1) or typed data list.
+  uint8_t element_size_ = 0;
+  // Set once the element count of an Int64DeltaData list, the first of its
+  // two sizes, has been read.
+  bool delta_count_read_ = false;
+  // Set once the dimensions of a tensor have been read.
+  bool shape_read_ = false;
+  uint8_t buffer_[8];
+  uint32_t shape_[kMaxTensorRank];
+  size_t buffered_ = 0;
+  size_t needed_ = 0;
+  uint64_t payload_remaining_ = 0;
+
+  // Values still to come in each open list or map, innermost last.
+  std::vector<uint64_t> open_;
+};
+
+}  // namespace platzi
+
+#endif  // NATIVE_CODEC_STREAMING_READER_H_
@@ -0,0 +1,34 @@
+#include "codec/string_codec.h"
+
+#include "codec/utf8.h"
+
+namespace platzi {
+
+void StringCodec::EncodeMessage(std::u16string_view message,
+                                std::vector<uint8_t>* encoded) {
+  encoded->resize(Utf8LengthOfUtf16(message.data(), message.size()));
+  Utf16ToUtf8(message.data(), message.size(), encoded->data());
+}
+
+bool StringCodec::DecodeMessage(const uint8_t* data,
+                                size_t size,
+                                std::u16string* message) {
+  return Utf8ToUtf16(data, size, message);
+}
+
+void StringCodec::EncodeMessage(std::string_view message,
+                                std::vector<uint8_t>* encoded) {
+  encoded->assign(message.begin(), message.end());
+}
+
+bool StringCodec::DecodeMessage(const uint8_t* data,
+                                size_t size,
+                                std::string_view* message) {
+  if (!ValidateUtf8(data, size)) {
+    return false;
+  }
+  *message = std::string_view(reinterpret_cast<const char*>(data), size);
+  return true;
+}
+
+}  // namespace platzi
@@ -0,0 +1,37 @@
+#ifndef NATIVE_CODEC_STRING_CODEC_H_
+#define NATIVE_CODEC_STRING_CODEC_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace platzi {
+
+// The counterpart of FlutterStringCodec: messages are UTF-8 encoded strings.
+//
+// The UTF-16 overloads match NSString and go through the vectorized
+// transcoders in utf8.h. The UTF-8 overloads only validate.
+class StringCodec {
+ public:
+  static void EncodeMessage(std::u16string_view message,
+                            std::vector<uint8_t>* encoded);
+  static bool DecodeMessage(const uint8_t* data,
+                            size_t size,
+                            std::u16string* message);
+
+  static void EncodeMessage(std::string_view message,
+                            std::vector<uint8_t>* encoded);
+  // Returns a view of |data| if it is valid UTF-8.
+  static bool DecodeMessage(const uint8_t* data,
+                            size_t size,
+                            std::string_view* message);
+
+ private:
+  StringCodec() = delete;
+};
+
+}  // namespace platzi
+
+#endif  // NATIVE_CODEC_STRING_CODEC_H_
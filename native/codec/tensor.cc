@@ -0,0 +1,80 @@
+#include "codec/tensor.h"
+
+namespace platzi {
+
+bool TensorView::IsContiguous() const {
+  if (strides == nullptr) {
+    return true;
+  }
+  int64_t expected = element_size;
+  for (int i = rank - 1; i >= 0; i--) {
+    // Dimensions of one element can have any stride.
+    if (shape[i] != 1 && strides[i] != expected) {
+      return false;
+    }
+    expected *= shape[i];
+  }
+  return true;
+}
+
+int64_t TensorView::OffsetOf(const uint32_t* index) const {
+  int64_t offset = 0;
+  int64_t stride = element_size;
+  for (int i = rank - 1; i >= 0; i--) {
+    offset += static_cast<int64_t>(index[i]) *
+              (strides != nullptr ? strides[i] : stride);
+    stride *= shape[i];
+  }
+  return offset;
+}
+
+void TensorView::CopyContiguous(uint8_t* destination) const {
+  size_t count = element_count();
+  if (count == 0) {
+    return;
+  }
+  if (IsContiguous()) {
+    std::memcpy(destination, data, count * element_size);
+    return;
+  }
+  // The innermost dimensions laid out contiguously, such as the columns and
+  // channels of a crop, are copied as one run, and the outer ones walked
+  // like an odometer. If not even the innermost is, its elements are copied
+  // one at a time.
+  int outer = rank;
+  int64_t run = element_size;
+  while (outer > 0 && (shape[outer - 1] == 1 || strides[outer - 1] == run)) {
+    outer--;
+    run *= shape[outer];
+  }
+  size_t pieces = 1;
+  size_t piece_size = static_cast<size_t>(run);
+  int64_t piece_stride = 0;
+  if (outer == rank) {
+    outer--;
+    pieces = shape[outer];
+    piece_size = element_size;
+    piece_stride = strides[outer];
+  }
+  uint32_t index[kMaxTensorRank] = {};
+  const uint8_t* source = data;
+  while (true) {
+    for (size_t i = 0; i < pieces; i++) {
+      std::memcpy(destination,
+                  source + static_cast<int64_t>(i) * piece_stride, piece_size);
+      destination += piece_size;
+    }
+    int dimension = outer - 1;
+    while (dimension >= 0 && ++index[dimension] == shape[dimension]) {
+      source -= static_cast<int64_t>(shape[dimension] - 1) * strides[dimension];
+      index[dimension] = 0;
+      dimension--;
+    }
+    if (dimension < 0) {
+      return;
+    }
+    source += strides[dimension];
+  }
+}
+
+}  // namespace platzi
@@ -0,0 +1,96 @@
+#ifndef NATIVE_CODEC_TENSOR_H_
+#define NATIVE_CODEC_TENSOR_H_
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "codec/standard_field.h"
+#include "codec/typed_data.h"
+
+namespace platzi {
+
+// The most dimensions a tensor may have, as in NumPy.
+constexpr uint8_t kMaxTensorRank = 32;
+
+// A borrowed view of an n-dimensional array of typed data elements, such as
+// an image patch, a matrix or the input and output buffers of an on-device
+// model, with its shape, so that it needs no flattening or side-channel
+// dimensions.
+//
+// Elements may be laid out with arbitrary strides, for instance to send a
+// crop or a transposition of a larger tensor without copying it first. The
+// standard encoding always sends them contiguous in row-major order, which
+// is how decoded tensors come out: as views of the message buffer, without
+// a copy.
+struct TensorView {
+  // The element type: a fixed-size typed data list field.
+  StandardField dtype = StandardField::kFloat32Data;
+  uint8_t element_size = 4;
+  uint8_t rank = 0;
+  const uint8_t* data = nullptr;
+  // |rank| dimensions, outermost first.
+  const uint32_t* shape = nullptr;
+  // Distance in bytes between consecutive elements along each dimension, or
+  // nullptr for row-major contiguous elements.
+  const int64_t* strides = nullptr;
+
+  // Returns a view of the row-major contiguous elements at |data|.
+  template <typename T>
+  static TensorView Of(const T* data, const uint32_t* shape, uint8_t rank) {
+    TensorView view;
+    view.dtype = TypedDataFieldOf<T>::kField;
+    view.element_size = sizeof(T);
+    view.rank = rank;
+    view.data = reinterpret_cast<const uint8_t*>(data);
+    view.shape = shape;
+    return view;
+  }
+
+  size_t element_count() const {
+    size_t count = 1;
+    for (uint8_t i = 0; i < rank; i++) {
+      count *= shape[i];
+    }
+    return count;
+  }
+
+  size_t byte_size() const { return element_count() * element_size; }
+
+  // Whether the elements are row-major and contiguous, whatever |strides|
+  // says.
+  bool IsContiguous() const;
+
+  // Returns the byte offset of the element at |index|, which has |rank|
+  // coordinates.
+  int64_t OffsetOf(const uint32_t* index) const;
+
+  // Loads the element at |index| as a |T|, regardless of alignment.
+  template <typename T>
+  T Get(const uint32_t* index) const {
+    assert(sizeof(T) == element_size);
+    T value;
+    std::memcpy(&value, data + OffsetOf(index), sizeof(T));
+    return value;
+  }
+
+  // Returns the elements of a contiguous tensor as a flat list.
+  TypedDataView Flat() const {
+    assert(IsContiguous());
+    TypedDataView view;
+    view.type = dtype;
+    view.bytes = data;
+    view.element_count = static_cast<uint32_t>(element_count());
+    view.element_size = element_size;
+    return view;
+  }
+
+  // Copies the elements in row-major order to the |byte_size| bytes at
+  // |destination|.
+  void CopyContiguous(uint8_t* destination) const;
+};
+
+}  // namespace platzi
+
+#endif  // NATIVE_CODEC_TENSOR_H_
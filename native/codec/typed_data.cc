@@ -0,0 +1,176 @@
+#include "codec/typed_data.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PLATZI_TYPED_DATA_X86 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define PLATZI_TYPED_DATA_NEON 1
+#endif
+
+namespace platzi {
+
+namespace {
+
+void SwapElementsScalar(const uint8_t* source,
+                        size_t count,
+                        uint8_t element_size,
+                        uint8_t* destination) {
+  for (size_t i = 0; i < count; i++) {
+    switch (element_size) {
+      case 2: {
+        uint16_t value;
+        std::memcpy(&value, source + i * 2, 2);
+        value = __builtin_bswap16(value);
+        std::memcpy(destination + i * 2, &value, 2);
+        break;
+      }
+      case 4: {
+        uint32_t value;
+        std::memcpy(&value, source + i * 4, 4);
+        value = __builtin_bswap32(value);
+        std::memcpy(destination + i * 4, &value, 4);
+        break;
+      }
+      case 8: {
+        uint64_t value;
+        std::memcpy(&value, source + i * 8, 8);
+        value = __builtin_bswap64(value);
+        std::memcpy(destination + i * 8, &value, 8);
+        break;
+      }
+    }
+  }
+}
+
+#if defined(PLATZI_TYPED_DATA_X86) || defined(PLATZI_TYPED_DATA_NEON)
+
+// Byte shuffles reversing every 2, 4 and 8 byte element of a 16-byte block.
+alignas(16) constexpr uint8_t kSwap16[16] = {1, 0, 3,  2,  5,  4,  7,  6,
+                                             9, 8, 11, 10, 13, 12, 15, 14};
+alignas(16) constexpr uint8_t kSwap32[16] = {3,  2,  1,  0,  7,  6,  5,  4,
+                                             11, 10, 9, 8, 15, 14, 13, 12};
+alignas(16) constexpr uint8_t kSwap64[16] = {7,  6,  5,  4,  3,  2,  1, 0,
+                                             15, 14, 13, 12, 11, 10, 9, 8};
+
+const uint8_t* SwapShuffle(uint8_t element_size) {
+  return element_size == 2 ? kSwap16 : element_size == 4 ? kSwap32 : kSwap64;
+}
+
+#endif
+
+#if defined(PLATZI_TYPED_DATA_X86)
+
+__attribute__((target("ssse3"))) void SwapElementsSsse3(
+    const uint8_t* source,
+    size_t count,
+    uint8_t element_size,
+    uint8_t* destination) {
+  const __m128i shuffle = _mm_load_si128(
+      reinterpret_cast<const __m128i*>(SwapShuffle(element_size)));
+  size_t size = count * element_size;
+  size_t i = 0;
+  for (; size - i >= 16; i += 16) {
+    __m128i block =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i),
+                     _mm_shuffle_epi8(block, shuffle));
+  }
+  SwapElementsScalar(source + i, (size - i) / element_size, element_size,
+                     destination + i);
+}
+
+__attribute__((target("avx2"))) void SwapElementsAvx2(const uint8_t* source,
+                                                      size_t count,
+                                                      uint8_t element_size,
+                                                      uint8_t* destination) {
+  const __m256i shuffle = _mm256_broadcastsi128_si256(_mm_load_si128(
+      reinterpret_cast<const __m128i*>(SwapShuffle(element_size))));
+  size_t size = count * element_size;
+  size_t i = 0;
+  for (; size - i >= 64; i += 64) {
+    __m256i low =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i));
+    __m256i high =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i + 32));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i),
+                        _mm256_shuffle_epi8(low, shuffle));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i + 32),
+                        _mm256_shuffle_epi8(high, shuffle));
+  }
+  for (; size - i >= 32; i += 32) {
+    __m256i block =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i),
+                        _mm256_shuffle_epi8(block, shuffle));
+  }
+  SwapElementsScalar(source + i, (size - i) / element_size, element_size,
+                     destination + i);
+}
+
+#elif defined(PLATZI_TYPED_DATA_NEON)
+
+void SwapElementsNeon(const uint8_t* source,
+                      size_t count,
+                      uint8_t element_size,
+                      uint8_t* destination) {
+  size_t size = count * element_size;
+  size_t i = 0;
+  for (; size - i >= 16; i += 16) {
+    uint8x16_t block = vld1q_u8(source + i);
+    switch (element_size) {
+      case 2:
+        block = vrev16q_u8(block);
+        break;
+      case 4:
+        block = vrev32q_u8(block);
+        break;
+      default:
+        block = vrev64q_u8(block);
+        break;
+    }
+    vst1q_u8(destination + i, block);
+  }
+  SwapElementsScalar(source + i, (size - i) / element_size, element_size,
+                     destination + i);
+}
+
+#endif
+
+using SwapFunction = void (*)(const uint8_t*, size_t, uint8_t, uint8_t*);
+
+SwapFunction ResolveSwap() {
+#if defined(PLATZI_TYPED_DATA_X86)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return SwapElementsAvx2;
+  }
+  if (__builtin_cpu_supports("ssse3")) {
+    return SwapElementsSsse3;
+  }
+  return SwapElementsScalar;
+#elif defined(PLATZI_TYPED_DATA_NEON)
+  return SwapElementsNeon;
+#else
+  return SwapElementsScalar;
+#endif
+}
+
+}  // namespace
+
+void CopyElements(const uint8_t* source,
+                  size_t count,
+                  uint8_t element_size,
+                  ByteOrder order,
+                  uint8_t* destination) {
+  if (element_size == 1 || !NeedsByteSwap(order)) {
+    if (count > 0) {
+      std::memcpy(destination, source, count * element_size);
+    }
+    return;
+  }
+  static const SwapFunction swap = ResolveSwap();
+  swap(source, count, element_size, destination);
+}
+
+}  // namespace platzi
@@ -0,0 +1,150 @@
+#ifndef NATIVE_CODEC_TYPED_DATA_H_
+#define NATIVE_CODEC_TYPED_DATA_H_
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "codec/standard_field.h"
+
+namespace platzi {
+
+// Byte order of typed data elements outside a message. The standard encoding
+// itself always uses the host's order.
+enum class ByteOrder {
+  kNative,
+  kLittleEndian,
+  kBigEndian,
+};
+
+// Returns true if data in |order| must be byte swapped on this host.
+constexpr bool NeedsByteSwap(ByteOrder order) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  return order == ByteOrder::kLittleEndian;
+#else
+  return order == ByteOrder::kBigEndian;
+#endif
+}
+
+// Copies |count| elements of |element_size| bytes from |source| to
+// |destination|, reversing the bytes of each element if |order| differs from
+// the host's. Byte swapping is vectorized (SSSE3/AVX2 or NEON).
+void CopyElements(const uint8_t* source,
+                  size_t count,
+                  uint8_t element_size,
+                  ByteOrder order,
+                  uint8_t* destination);
+
+// A borrowed, read-only range of bytes. Does not own the memory it points to.
+struct ByteSpan {
+  const uint8_t* data = nullptr;
+  size_t size = 0;
+
+  bool empty() const { return size == 0; }
+  const uint8_t* begin() const { return data; }
+  const uint8_t* end() const { return data + size; }
+};
+
+// A borrowed, read-only array of |T|. The pointer is always suitably aligned
+// for |T|.
+template <typename T>
+struct Span {
+  const T* data = nullptr;
+  size_t size = 0;
+
+  bool empty() const { return size == 0; }
+  const T& operator[](size_t index) const { return data[index]; }
+  const T* begin() const { return data; }
+  const T* end() const { return data + size; }
+};
+
+// Maps an element type to its typed data list.
+template <typename T>
+struct TypedDataFieldOf;
+template <>
+struct TypedDataFieldOf<uint8_t> {
+  static constexpr StandardField kField = StandardField::kUInt8Data;
+};
+template <>
+struct TypedDataFieldOf<int16_t> {
+  static constexpr StandardField kField = StandardField::kInt16Data;
+};
+template <>
+struct TypedDataFieldOf<uint16_t> {
+  static constexpr StandardField kField = StandardField::kUInt16Data;
+};
+template <>
+struct TypedDataFieldOf<int32_t> {
+  static constexpr StandardField kField = StandardField::kInt32Data;
+};
+template <>
+struct TypedDataFieldOf<int64_t> {
+  static constexpr StandardField kField = StandardField::kInt64Data;
+};
+template <>
+struct TypedDataFieldOf<float> {
+  static constexpr StandardField kField = StandardField::kFloat32Data;
+};
+template <>
+struct TypedDataFieldOf<double> {
+  static constexpr StandardField kField = StandardField::kFloat64Data;
+};
+
+// A borrowed view of a typed data list, the counterpart of
+// FlutterStandardTypedData without the copy into an NSData.
+//
+// The standard encoding aligns element storage relative to the start of the
+// message, so elements are naturally aligned in memory only when the message
+// buffer itself is. |Get| works in either case; |As| requires |IsAligned|.
+struct TypedDataView {
+  StandardField type = StandardField::kUInt8Data;
+  const uint8_t* bytes = nullptr;
+  uint32_t element_count = 0;
+  uint8_t element_size = 1;
+
+  // Returns a view of |count| elements at |data|.
+  template <typename T>
+  static TypedDataView Of(const T* data, size_t count) {
+    TypedDataView view;
+    view.type = TypedDataFieldOf<T>::kField;
+    view.bytes = reinterpret_cast<const uint8_t*>(data);
+    view.element_count = static_cast<uint32_t>(count);
+    view.element_size = sizeof(T);
+    return view;
+  }
+
+  size_t byte_size() const {
+    return static_cast<size_t>(element_count) * element_size;
+  }
+
+  bool IsAligned() const {
+    return reinterpret_cast<uintptr_t>(bytes) % element_size == 0;
+  }
+
+  // Loads element |index| as a |T|, regardless of alignment.
+  template <typename T>
+  T Get(size_t index) const {
+    assert(sizeof(T) == element_size && index < element_count);
+    T value;
+    std::memcpy(&value, bytes + index * sizeof(T), sizeof(T));
+    return value;
+  }
+
+  // Returns the elements as a typed span over the message buffer.
+  template <typename T>
+  Span<T> As() const {
+    assert(sizeof(T) == element_size && IsAligned());
+    return Span<T>{reinterpret_cast<const T*>(bytes), element_count};
+  }
+
+  // Copies all elements to |destination| in byte order |order|.
+  void CopyTo(void* destination, ByteOrder order = ByteOrder::kNative) const {
+    CopyElements(bytes, element_count, element_size, order,
+                 static_cast<uint8_t*>(destination));
+  }
+};
+
+}  // namespace platzi
+
+#endif  // NATIVE_CODEC_TYPED_DATA_H_
@@ -0,0 +1,1128 @@
+#include "codec/utf8.h"
+
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PLATZI_UTF8_X86 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define PLATZI_UTF8_NEON 1
+#endif
+
+namespace platzi {
+
+namespace {
+
+constexpr uint64_t kAsciiMask64 = 0x8080808080808080ull;
+
+// Decodes the sequence at |data|, which has |size| > 0 bytes left. Returns
+// its length, or 0 if it is not well-formed.
+inline size_t DecodeCodePoint(const uint8_t* data,
+                              size_t size,
+                              uint32_t* code_point) {
+  uint8_t lead = data[0];
+  if (lead < 0x80) {
+    *code_point = lead;
+    return 1;
+  }
+  size_t length;
+  uint32_t value;
+  uint32_t min;
+  if (lead >= 0xC2 && lead <= 0xDF) {
+    length = 2;
+    value = lead & 0x1F;
+    min = 0x80;
+  } else if ((lead & 0xF0) == 0xE0) {
+    length = 3;
+    value = lead & 0x0F;
+    min = 0x800;
+  } else if (lead >= 0xF0 && lead <= 0xF4) {
+    length = 4;
+    value = lead & 0x07;
+    min = 0x10000;
+  } else {
+    return 0;
+  }
+  if (size < length) {
+    return 0;
+  }
+  for (size_t i = 1; i < length; i++) {
+    uint8_t byte = data[i];
+    if ((byte & 0xC0) != 0x80) {
+      return 0;
+    }
+    value = (value << 6) | (byte & 0x3F);
+  }
+  if (value < min || value > 0x10FFFF ||
+      (value >= 0xD800 && value <= 0xDFFF)) {
+    return 0;
+  }
+  *code_point = value;
+  return length;
+}
+
+bool ValidateUtf8Scalar(const uint8_t* data, size_t size) {
+  size_t i = 0;
+  while (i < size) {
+    if (size - i >= 8) {
+      uint64_t word;
+      std::memcpy(&word, data + i, 8);
+      if ((word & kAsciiMask64) == 0) {
+        i += 8;
+        continue;
+      }
+    }
+    uint32_t code_point;
+    size_t length = DecodeCodePoint(data + i, size - i, &code_point);
+    if (length == 0) {
+      return false;
+    }
+    i += length;
+  }
+  return true;
+}
+
+// Writes the code point starting at |data|, which must be well-formed, and
+// returns the number of bytes consumed.
+inline size_t TranscodeValidCodePoint(const uint8_t* data,
+                                      char16_t* out,
+                                      size_t* out_index) {
+  uint8_t lead = data[0];
+  if (lead < 0x80) {
+    out[(*out_index)++] = lead;
+    return 1;
+  }
+  if (lead < 0xE0) {
+    out[(*out_index)++] =
+        static_cast<char16_t>(((lead & 0x1F) << 6) | (data[1] & 0x3F));
+    return 2;
+  }
+  if (lead < 0xF0) {
+    out[(*out_index)++] = static_cast<char16_t>(
+        ((lead & 0x0F) << 12) | ((data[1] & 0x3F) << 6) | (data[2] & 0x3F));
+    return 3;
+  }
+  uint32_t code_point = ((lead & 0x07) << 18) | ((data[1] & 0x3F) << 12) |
+                        ((data[2] & 0x3F) << 6) | (data[3] & 0x3F);
+  code_point -= 0x10000;
+  out[(*out_index)++] = static_cast<char16_t>(0xD800 + (code_point >> 10));
+  out[(*out_index)++] = static_cast<char16_t>(0xDC00 + (code_point & 0x3FF));
+  return 4;
+}
+
+// Lookup tables of the vectorized validator. Every byte pair (previous byte,
+// current byte) is classified by three 16-entry tables indexed by the high
+// nibble of the previous byte, its low nibble and the high nibble of the
+// current byte; a pair is an error if the three entries share a bit. Bits
+// flag one class of error each. Continuations required by three and four byte
+// sequences are checked separately, see "Validating UTF-8 In Less Than One
+// Instruction Per Byte" (Keiser and Lemire, 2021).
+#if defined(PLATZI_UTF8_X86) || defined(PLATZI_UTF8_NEON)
+
+constexpr uint8_t kTooShort = 1 << 0;
+constexpr uint8_t kTooLong = 1 << 1;
+constexpr uint8_t kOverlong3 = 1 << 2;
+constexpr uint8_t kTooLarge = 1 << 3;
+constexpr uint8_t kSurrogate = 1 << 4;
+constexpr uint8_t kOverlong2 = 1 << 5;
+constexpr uint8_t kTooLarge1000 = 1 << 6;
+constexpr uint8_t kOverlong4 = 1 << 6;
+constexpr uint8_t kTwoConts = 1 << 7;
+constexpr uint8_t kCarry = kTooShort | kTooLong | kTwoConts;
+
+alignas(16) constexpr uint8_t kByte1High[16] = {
+    kTooLong,
+    kTooLong,
+    kTooLong,
+    kTooLong,
+    kTooLong,
+    kTooLong,
+    kTooLong,
+    kTooLong,
+    kTwoConts,
+    kTwoConts,
+    kTwoConts,
+    kTwoConts,
+    kTooShort | kOverlong2,
+    kTooShort,
+    kTooShort | kOverlong3 | kSurrogate,
+    kTooShort | kTooLarge | kTooLarge1000 | kOverlong4,
+};
+
+alignas(16) constexpr uint8_t kByte1Low[16] = {
+    kCarry | kOverlong3 | kOverlong2 | kOverlong4,
+    kCarry | kOverlong2,
+    kCarry,
+    kCarry,
+    kCarry | kTooLarge,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000 | kSurrogate,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+};
+
+alignas(16) constexpr uint8_t kByte2High[16] = {
+    kTooShort,
+    kTooShort,
+    kTooShort,
+    kTooShort,
+    kTooShort,
+    kTooShort,
+    kTooShort,
+    kTooShort,
+    kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge1000 | kOverlong4,
+    kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge,
+    kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+    kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+    kTooShort,
+    kTooShort,
+    kTooShort,
+    kTooShort,
+};
+
+// Subtracted (saturating) from the last bytes of a block: anything left
+// means the block ends inside a multi-byte sequence.
+alignas(32) constexpr uint8_t kIncompleteMax[32] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xEF, 0xDF, 0xBF,
+};
+
+#endif  // PLATZI_UTF8_X86 || PLATZI_UTF8_NEON
+
+#if defined(PLATZI_UTF8_X86)
+
+struct Ssse3State {
+  __m128i error;
+  __m128i prev_input;
+  __m128i prev_incomplete;
+};
+
+__attribute__((target("ssse3"))) inline void CheckBlockSsse3(
+    __m128i input,
+    Ssse3State* state) {
+  if (_mm_movemask_epi8(input) == 0) {
+    state->error = _mm_or_si128(state->error, state->prev_incomplete);
+  } else {
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    __m128i prev1 = _mm_alignr_epi8(input, state->prev_input, 15);
+    __m128i byte_1_high = _mm_shuffle_epi8(
+        _mm_load_si128(reinterpret_cast<const __m128i*>(kByte1High)),
+        _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble));
+    __m128i byte_1_low = _mm_shuffle_epi8(
+        _mm_load_si128(reinterpret_cast<const __m128i*>(kByte1Low)),
+        _mm_and_si128(prev1, nibble));
+    __m128i byte_2_high = _mm_shuffle_epi8(
+        _mm_load_si128(reinterpret_cast<const __m128i*>(kByte2High)),
+        _mm_and_si128(_mm_srli_epi16(input, 4), nibble));
+    __m128i special =
+        _mm_and_si128(_mm_and_si128(byte_1_high, byte_1_low), byte_2_high);
+
+    __m128i prev2 = _mm_alignr_epi8(input, state->prev_input, 14);
+    __m128i prev3 = _mm_alignr_epi8(input, state->prev_input, 13);
+    __m128i third = _mm_subs_epu8(prev2, _mm_set1_epi8(0xE0 - 0x80));
+    __m128i fourth =
+        _mm_subs_epu8(prev3, _mm_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+    __m128i must_be_continuation =
+        _mm_and_si128(_mm_or_si128(third, fourth),
+                      _mm_set1_epi8(static_cast<char>(0x80)));
+
+    state->error = _mm_or_si128(state->error,
+                                _mm_xor_si128(must_be_continuation, special));
+    state->prev_incomplete = _mm_subs_epu8(
+        input,
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(kIncompleteMax + 16)));
+  }
+  state->prev_input = input;
+}
+
+__attribute__((target("ssse3"))) bool ValidateUtf8Ssse3(const uint8_t* data,
+                                                        size_t size) {
+  Ssse3State state;
+  state.error = _mm_setzero_si128();
+  state.prev_input = _mm_setzero_si128();
+  state.prev_incomplete = _mm_setzero_si128();
+  size_t i = 0;
+  for (; size - i >= 16; i += 16) {
+    CheckBlockSsse3(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)), &state);
+  }
+  if (i < size) {
+    alignas(16) uint8_t tail[16] = {};
+    std::memcpy(tail, data + i, size - i);
+    CheckBlockSsse3(_mm_load_si128(reinterpret_cast<const __m128i*>(tail)),
+                    &state);
+  }
+  __m128i error = _mm_or_si128(state.error, state.prev_incomplete);
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) ==
+         0xFFFF;
+}
+
+struct Avx2State {
+  __m256i error;
+  __m256i prev_input;
+  __m256i prev_incomplete;
+};
+
+__attribute__((target("avx2"))) inline __m256i Avx2Table(
+    const uint8_t* table) {
+  return _mm256_broadcastsi128_si256(
+      _mm_load_si128(reinterpret_cast<const __m128i*>(table)));
+}
+
+__attribute__((target("avx2"))) inline void CheckBlockAvx2(__m256i input,
+                                                          Avx2State* state) {
+  if (_mm256_movemask_epi8(input) == 0) {
+    state->error = _mm256_or_si256(state->error, state->prev_incomplete);
+  } else {
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    // The upper half of the previous block followed by the lower half of
+    // this one, for byte shifts across the 128-bit lanes.
+    __m256i straddle =
+        _mm256_permute2x128_si256(state->prev_input, input, 0x21);
+    __m256i prev1 = _mm256_alignr_epi8(input, straddle, 15);
+    __m256i byte_1_high = _mm256_shuffle_epi8(
+        Avx2Table(kByte1High),
+        _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble));
+    __m256i byte_1_low = _mm256_shuffle_epi8(Avx2Table(kByte1Low),
+                                             _mm256_and_si256(prev1, nibble));
+    __m256i byte_2_high = _mm256_shuffle_epi8(
+        Avx2Table(kByte2High),
+        _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble));
+    __m256i special = _mm256_and_si256(
+        _mm256_and_si256(byte_1_high, byte_1_low), byte_2_high);
+
+    __m256i prev2 = _mm256_alignr_epi8(input, straddle, 14);
+    __m256i prev3 = _mm256_alignr_epi8(input, straddle, 13);
+    __m256i third = _mm256_subs_epu8(prev2, _mm256_set1_epi8(0xE0 - 0x80));
+    __m256i fourth = _mm256_subs_epu8(
+        prev3, _mm256_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+    __m256i must_be_continuation =
+        _mm256_and_si256(_mm256_or_si256(third, fourth),
+                         _mm256_set1_epi8(static_cast<char>(0x80)));
+
+    state->error = _mm256_or_si256(
+        state->error, _mm256_xor_si256(must_be_continuation, special));
+    state->prev_incomplete = _mm256_subs_epu8(
+        input,
+        _mm256_load_si256(reinterpret_cast<const __m256i*>(kIncompleteMax)));
+  }
+  state->prev_input = input;
+}
+
+__attribute__((target("avx2"))) bool ValidateUtf8Avx2(const uint8_t* data,
+                                                      size_t size) {
+  Avx2State state;
+  state.error = _mm256_setzero_si256();
+  state.prev_input = _mm256_setzero_si256();
+  state.prev_incomplete = _mm256_setzero_si256();
+  size_t i = 0;
+  for (; size - i >= 32; i += 32) {
+    CheckBlockAvx2(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)),
+        &state);
+  }
+  if (i < size) {
+    alignas(32) uint8_t tail[32] = {};
+    std::memcpy(tail, data + i, size - i);
+    CheckBlockAvx2(_mm256_load_si256(reinterpret_cast<const __m256i*>(tail)),
+                   &state);
+  }
+  __m256i error = _mm256_or_si256(state.error, state.prev_incomplete);
+  return _mm256_testz_si256(error, error) != 0;
+}
+
+#elif defined(PLATZI_UTF8_NEON)
+
+struct NeonState {
+  uint8x16_t error;
+  uint8x16_t prev_input;
+  uint8x16_t prev_incomplete;
+};
+
+inline void CheckBlockNeon(uint8x16_t input, NeonState* state) {
+  if (vmaxvq_u8(input) < 0x80) {
+    state->error = vorrq_u8(state->error, state->prev_incomplete);
+  } else {
+    uint8x16_t prev1 = vextq_u8(state->prev_input, input, 15);
+    uint8x16_t byte_1_high =
+        vqtbl1q_u8(vld1q_u8(kByte1High), vshrq_n_u8(prev1, 4));
+    uint8x16_t byte_1_low =
+        vqtbl1q_u8(vld1q_u8(kByte1Low), vandq_u8(prev1, vdupq_n_u8(0x0F)));
+    uint8x16_t byte_2_high =
+        vqtbl1q_u8(vld1q_u8(kByte2High), vshrq_n_u8(input, 4));
+    uint8x16_t special =
+        vandq_u8(vandq_u8(byte_1_high, byte_1_low), byte_2_high);
+
+    uint8x16_t prev2 = vextq_u8(state->prev_input, input, 14);
+    uint8x16_t prev3 = vextq_u8(state->prev_input, input, 13);
+    uint8x16_t third = vqsubq_u8(prev2, vdupq_n_u8(0xE0 - 0x80));
+    uint8x16_t fourth = vqsubq_u8(prev3, vdupq_n_u8(0xF0 - 0x80));
+    uint8x16_t must_be_continuation =
+        vandq_u8(vorrq_u8(third, fourth), vdupq_n_u8(0x80));
+
+    state->error =
+        vorrq_u8(state->error, veorq_u8(must_be_continuation, special));
+    state->prev_incomplete = vqsubq_u8(input, vld1q_u8(kIncompleteMax + 16));
+  }
+  state->prev_input = input;
+}
+
+bool ValidateUtf8Neon(const uint8_t* data, size_t size) {
+  NeonState state;
+  state.error = vdupq_n_u8(0);
+  state.prev_input = vdupq_n_u8(0);
+  state.prev_incomplete = vdupq_n_u8(0);
+  size_t i = 0;
+  for (; size - i >= 16; i += 16) {
+    CheckBlockNeon(vld1q_u8(data + i), &state);
+  }
+  if (i < size) {
+    uint8_t tail[16] = {};
+    std::memcpy(tail, data + i, size - i);
+    CheckBlockNeon(vld1q_u8(tail), &state);
+  }
+  return vmaxvq_u8(vorrq_u8(state.error, state.prev_incomplete)) == 0;
+}
+
+#endif
+
+using ValidateFunction = bool (*)(const uint8_t*, size_t);
+
+ValidateFunction ResolveValidate() {
+#if defined(PLATZI_UTF8_X86)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return ValidateUtf8Avx2;
+  }
+  if (__builtin_cpu_supports("ssse3")) {
+    return ValidateUtf8Ssse3;
+  }
+  return ValidateUtf8Scalar;
+#elif defined(PLATZI_UTF8_NEON)
+  return ValidateUtf8Neon;
+#else
+  return ValidateUtf8Scalar;
+#endif
+}
+
+// Widens the ASCII prefix of the 16 bytes at |data| into |out| and returns
+// its length. Always stores 16 code units; callers guarantee the room.
+inline size_t WidenAsciiBlock(const uint8_t* data, char16_t* out) {
+#if defined(__SSE2__)
+  __m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+  __m128i zero = _mm_setzero_si128();
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(out),
+                   _mm_unpacklo_epi8(input, zero));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 8),
+                   _mm_unpackhi_epi8(input, zero));
+  unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(input));
+  return mask == 0 ? 16 : __builtin_ctz(mask);
+#elif defined(PLATZI_UTF8_NEON)
+  uint8x16_t input = vld1q_u8(data);
+  vst1q_u16(reinterpret_cast<uint16_t*>(out), vmovl_u8(vget_low_u8(input)));
+  vst1q_u16(reinterpret_cast<uint16_t*>(out + 8), vmovl_high_u8(input));
+  if (vmaxvq_u8(input) < 0x80) {
+    return 16;
+  }
+  size_t length = 0;
+  while (data[length] < 0x80) {
+    length++;
+  }
+  return length;
+#else
+  size_t length = 0;
+  while (length < 16 && data[length] < 0x80) {
+    out[length] = data[length];
+    length++;
+  }
+  return length;
+#endif
+}
+
+// Returns the length of the ASCII prefix of the 8 code units at |data|,
+// narrowing it into |out|. Always stores 8 bytes; callers guarantee the room.
+inline size_t NarrowAsciiBlock(const char16_t* data, uint8_t* out) {
+#if defined(__SSE2__)
+  __m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+  _mm_storel_epi64(reinterpret_cast<__m128i*>(out),
+                   _mm_packus_epi16(input, input));
+  __m128i non_ascii = _mm_cmpeq_epi16(
+      _mm_and_si128(input, _mm_set1_epi16(static_cast<short>(0xFF80))),
+      _mm_setzero_si128());
+  unsigned mask = ~static_cast<unsigned>(_mm_movemask_epi8(non_ascii)) & 0xFFFF;
+  return mask == 0 ? 8 : __builtin_ctz(mask) / 2;
+#elif defined(PLATZI_UTF8_NEON)
+  uint16x8_t input = vld1q_u16(reinterpret_cast<const uint16_t*>(data));
+  vst1_u8(out, vqmovn_u16(input));
+  if (vmaxvq_u16(input) < 0x80) {
+    return 8;
+  }
+  size_t length = 0;
+  while (data[length] < 0x80) {
+    length++;
+  }
+  return length;
+#else
+  size_t length = 0;
+  while (length < 8 && data[length] < 0x80) {
+    out[length] = static_cast<uint8_t>(data[length]);
+    length++;
+  }
+  return length;
+#endif
+}
+
+inline bool IsHighSurrogate(char16_t unit) {
+  return unit >= 0xD800 && unit <= 0xDBFF;
+}
+
+inline bool IsLowSurrogate(char16_t unit) {
+  return unit >= 0xDC00 && unit <= 0xDFFF;
+}
+
+// Transcodes valid UTF-8 from |data| + |i| on, writing from |out| + |o|,
+// and returns the number of code units written in all. The portable loop,
+// and the tail of the vectorized ones.
+size_t TranscodeUtf8Portable(const uint8_t* data,
+                             size_t size,
+                             size_t i,
+                             char16_t* out,
+                             size_t o) {
+  while (size - i >= 16) {
+    size_t ascii = WidenAsciiBlock(data + i, out + o);
+    i += ascii;
+    o += ascii;
+    if (ascii < 16) {
+      i += TranscodeValidCodePoint(data + i, out, &o);
+    }
+  }
+  while (i < size) {
+    i += TranscodeValidCodePoint(data + i, out, &o);
+  }
+  return o;
+}
+
+// Writes the code point of the unit, or surrogate pair, at |data| + |*i|.
+inline void TranscodeUnit(const char16_t* data,
+                          size_t size,
+                          size_t* i,
+                          uint8_t* out,
+                          size_t* o) {
+  uint32_t code_point = data[(*i)++];
+  if (code_point < 0x80) {
+    out[(*o)++] = static_cast<uint8_t>(code_point);
+    return;
+  }
+  if (code_point < 0x800) {
+    out[(*o)++] = static_cast<uint8_t>(0xC0 | (code_point >> 6));
+    out[(*o)++] = static_cast<uint8_t>(0x80 | (code_point & 0x3F));
+    return;
+  }
+  if (IsHighSurrogate(static_cast<char16_t>(code_point)) && *i < size &&
+      IsLowSurrogate(data[*i])) {
+    code_point =
+        0x10000 + ((code_point - 0xD800) << 10) + (data[(*i)++] - 0xDC00);
+    out[(*o)++] = static_cast<uint8_t>(0xF0 | (code_point >> 18));
+    out[(*o)++] = static_cast<uint8_t>(0x80 | ((code_point >> 12) & 0x3F));
+    out[(*o)++] = static_cast<uint8_t>(0x80 | ((code_point >> 6) & 0x3F));
+    out[(*o)++] = static_cast<uint8_t>(0x80 | (code_point & 0x3F));
+    return;
+  }
+  if (code_point >= 0xD800 && code_point <= 0xDFFF) {
+    code_point = 0xFFFD;
+  }
+  out[(*o)++] = static_cast<uint8_t>(0xE0 | (code_point >> 12));
+  out[(*o)++] = static_cast<uint8_t>(0x80 | ((code_point >> 6) & 0x3F));
+  out[(*o)++] = static_cast<uint8_t>(0x80 | (code_point & 0x3F));
+}
+
+// As |TranscodeUtf8Portable|, the other way around, in bytes.
+size_t TranscodeUtf16Portable(const char16_t* data,
+                              size_t size,
+                              size_t i,
+                              uint8_t* out,
+                              size_t o) {
+  while (i < size) {
+    // Every unit produces at least one byte, so there is room for the eight
+    // byte store whenever eight units remain.
+    if (size - i >= 8) {
+      size_t ascii = NarrowAsciiBlock(data + i, out + o);
+      i += ascii;
+      o += ascii;
+      if (ascii == 8) {
+        continue;
+      }
+    }
+    TranscodeUnit(data, size, &i, out, &o);
+  }
+  return o;
+}
+
+// Shuffle tables of the vectorized transcoders, which handle code points of
+// up to three UTF-8 bytes, that is the whole BMP but surrogates. Code points
+// beyond it, four UTF-8 bytes or a surrogate pair, go through the portable
+// code one at a time.
+#if defined(PLATZI_UTF8_X86) || defined(PLATZI_UTF8_NEON)
+
+// How to transcode the complete code points of up to three bytes among the
+// first 8 bytes of a window, given which of its bytes 1 to 8 start a code
+// point (byte 0 does). |tail| gathers the last byte of each code point and,
+// above it, the byte before, if any; |lead| the leading byte of three-byte
+// ones. One code point per 16-bit lane; 0x80 selects a zero.
+struct Utf8ToUtf16Step {
+  uint8_t tail[16] = {};
+  uint8_t lead[16] = {};
+  // Code units written and bytes consumed, 0 if the window starts with a
+  // four-byte sequence.
+  uint8_t units = 0;
+  uint8_t bytes = 0;
+};
+
+constexpr std::array<Utf8ToUtf16Step, 256> MakeUtf8ToUtf16Steps() {
+  std::array<Utf8ToUtf16Step, 256> steps;
+  for (size_t starts = 0; starts < 256; starts++) {
+    Utf8ToUtf16Step& step = steps[starts];
+    for (size_t j = 0; j < 16; j++) {
+      step.tail[j] = 0x80;
+      step.lead[j] = 0x80;
+    }
+    size_t start = 0;
+    for (size_t next = 1; next <= 8; next++) {
+      if ((starts >> (next - 1) & 1) == 0) {
+        continue;
+      }
+      size_t length = next - start;
+      if (length > 3) {
+        break;
+      }
+      size_t lane = 2 * step.units;
+      step.tail[lane] = static_cast<uint8_t>(next - 1);
+      if (length >= 2) {
+        step.tail[lane + 1] = static_cast<uint8_t>(next - 2);
+      }
+      if (length == 3) {
+        step.lead[lane] = static_cast<uint8_t>(start);
+      }
+      step.units++;
+      start = next;
+    }
+    step.bytes = static_cast<uint8_t>(start);
+  }
+  return steps;
+}
+
+constexpr std::array<Utf8ToUtf16Step, 256> kUtf8ToUtf16Steps =
+    MakeUtf8ToUtf16Steps();
+
+// How to pack the UTF-8 of code units spelled out in the low bytes of their
+// lanes, lead byte first, given which need more than one byte.
+struct Utf16ToUtf8Step {
+  uint8_t shuffle[16] = {};
+  uint8_t bytes = 0;
+};
+
+// With 8 lanes, bit k tells whether unit k is at least 0x80. With 4 lanes,
+// bits 0 to 3 do, and bits 4 to 7 whether it is at least 0x800.
+constexpr std::array<Utf16ToUtf8Step, 256> MakeUtf16ToUtf8Steps(
+    size_t lanes) {
+  std::array<Utf16ToUtf8Step, 256> steps;
+  for (size_t lengths = 0; lengths < 256; lengths++) {
+    Utf16ToUtf8Step& step = steps[lengths];
+    for (size_t j = 0; j < 16; j++) {
+      step.shuffle[j] = 0x80;
+    }
+    for (size_t lane = 0; lane < lanes; lane++) {
+      size_t length = 1 + (lengths >> lane & 1);
+      if (lanes == 4) {
+        length += lengths >> (lane + 4) & 1;
+      }
+      for (size_t j = 0; j < length; j++) {
+        step.shuffle[step.bytes++] =
+            static_cast<uint8_t>(16 / lanes * lane + j);
+      }
+    }
+  }
+  return steps;
+}
+
+constexpr std::array<Utf16ToUtf8Step, 256> kUtf16ToUtf8TwoByteSteps =
+    MakeUtf16ToUtf8Steps(8);
+constexpr std::array<Utf16ToUtf8Step, 256> kUtf16ToUtf8ThreeByteSteps =
+    MakeUtf16ToUtf8Steps(4);
+
+#endif  // PLATZI_UTF8_X86 || PLATZI_UTF8_NEON
+
+#if defined(PLATZI_UTF8_X86)
+
+// Transcodes code points of up to three bytes from |data|, a code point
+// boundary with 64 bytes readable, a table step of up to 8 bytes at a time
+// until past byte 48 or before a four-byte code point. Stores up to 56 code
+// units at |out|; callers guarantee room for 64. Adds the bytes consumed to
+// |*i| and the code units written to |*o|.
+//
+// The start of every code point in the block is found up front, so each
+// step waits only on the table lookup of the one before.
+__attribute__((target("ssse3"))) inline void TranscodeUtf8BlockSsse3(
+    const uint8_t* data,
+    char16_t* out,
+    size_t* i,
+    size_t* o) {
+  uint64_t starts = 0;
+  for (size_t k = 0; k < 64; k += 16) {
+    // Continuation bytes, 0x80 to 0xBF, are the signed bytes below -64.
+    __m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + k));
+    unsigned continuations = static_cast<unsigned>(
+        _mm_movemask_epi8(_mm_cmplt_epi8(input, _mm_set1_epi8(-64))));
+    starts |= static_cast<uint64_t>(~continuations & 0xFFFF) << k;
+  }
+  size_t offset = 0;
+  size_t written = 0;
+  while (offset < 48) {
+    const Utf8ToUtf16Step& step =
+        kUtf8ToUtf16Steps[(starts >> (offset + 1)) & 0xFF];
+    if (step.bytes == 0) {
+      break;
+    }
+    __m128i input =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + offset));
+    __m128i tail = _mm_shuffle_epi8(
+        input, _mm_loadu_si128(reinterpret_cast<const __m128i*>(step.tail)));
+    __m128i lead = _mm_shuffle_epi8(
+        input, _mm_loadu_si128(reinterpret_cast<const __m128i*>(step.lead)));
+    __m128i multi_byte = _mm_or_si128(
+        _mm_or_si128(_mm_and_si128(tail, _mm_set1_epi16(0x3F)),
+                     _mm_and_si128(_mm_srli_epi16(tail, 2),
+                                   _mm_set1_epi16(0x0FC0))),
+        _mm_slli_epi16(lead, 12));
+    // ASCII lanes hold their byte alone; the last byte of a longer code
+    // point is a continuation byte.
+    __m128i ascii = _mm_cmpeq_epi16(_mm_and_si128(tail, _mm_set1_epi16(0x80)),
+                                    _mm_setzero_si128());
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + written),
+                     _mm_or_si128(_mm_and_si128(ascii, tail),
+                                  _mm_andnot_si128(ascii, multi_byte)));
+    offset += step.bytes;
+    written += step.units;
+  }
+  *i += offset;
+  *o += written;
+}
+
+__attribute__((target("ssse3"))) size_t TranscodeUtf8Ssse3(
+    const uint8_t* data,
+    size_t size,
+    char16_t* out) {
+  size_t i = 0;
+  size_t o = 0;
+  while (size - i >= 64) {
+    size_t ascii = WidenAsciiBlock(data + i, out + o);
+    i += ascii;
+    o += ascii;
+    if (ascii == 16) {
+      continue;
+    }
+    // A lone code point amid ASCII, as in most Latin-script text, is
+    // cheaper to decode on its own than with a block.
+    if (ascii == 0) {
+      size_t start = i;
+      TranscodeUtf8BlockSsse3(data + i, out + o, &i, &o);
+      if (i != start) {
+        continue;
+      }
+    }
+    i += TranscodeValidCodePoint(data + i, out, &o);
+  }
+  return TranscodeUtf8Portable(data, size, i, out, o);
+}
+
+// Transcodes the 8 code units at |data| if all are below 0x800, storing 16
+// bytes at |out|, and adds how many are UTF-8 to |*o|. Returns false,
+// storing nothing, otherwise.
+__attribute__((target("ssse3"))) inline bool TranscodeUtf16TwoByteSsse3(
+    const char16_t* data,
+    uint8_t* out,
+    size_t* o) {
+  __m128i units = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+  __m128i below_800 = _mm_cmpeq_epi16(
+      _mm_and_si128(units, _mm_set1_epi16(static_cast<short>(0xF800))),
+      _mm_setzero_si128());
+  if (_mm_movemask_epi8(below_800) != 0xFFFF) {
+    return false;
+  }
+  __m128i ascii = _mm_cmpeq_epi16(
+      _mm_and_si128(units, _mm_set1_epi16(static_cast<short>(0xFF80))),
+      _mm_setzero_si128());
+  __m128i as_two = _mm_or_si128(
+      _mm_or_si128(_mm_srli_epi16(units, 6), _mm_set1_epi16(0xC0)),
+      _mm_slli_epi16(_mm_or_si128(_mm_and_si128(units, _mm_set1_epi16(0x3F)),
+                                  _mm_set1_epi16(0x80)),
+                     8));
+  __m128i spelled = _mm_or_si128(_mm_and_si128(ascii, units),
+                                 _mm_andnot_si128(ascii, as_two));
+  const Utf16ToUtf8Step& step = kUtf16ToUtf8TwoByteSteps
+      [~_mm_movemask_epi8(_mm_packs_epi16(ascii, ascii)) & 0xFF];
+  __m128i shuffle =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(step.shuffle));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(out),
+                   _mm_shuffle_epi8(spelled, shuffle));
+  *o += step.bytes;
+  return true;
+}
+
+// Transcodes the 4 code units at |data| if none is a surrogate, storing 16
+// bytes at |out|, and adds how many are UTF-8 to |*o|. Returns false,
+// storing nothing, otherwise.
+__attribute__((target("ssse3"))) inline bool TranscodeUtf16ThreeByteSsse3(
+    const char16_t* data,
+    uint8_t* out,
+    size_t* o) {
+  __m128i units = _mm_unpacklo_epi16(
+      _mm_loadl_epi64(reinterpret_cast<const __m128i*>(data)),
+      _mm_setzero_si128());
+  __m128i surrogates =
+      _mm_cmpeq_epi32(_mm_and_si128(units, _mm_set1_epi32(0xF800)),
+                      _mm_set1_epi32(0xD800));
+  if (_mm_movemask_epi8(surrogates) != 0) {
+    return false;
+  }
+  __m128i two_bytes = _mm_cmpgt_epi32(units, _mm_set1_epi32(0x7F));
+  __m128i three_bytes = _mm_cmpgt_epi32(units, _mm_set1_epi32(0x7FF));
+  __m128i low = _mm_or_si128(_mm_and_si128(units, _mm_set1_epi32(0x3F)),
+                             _mm_set1_epi32(0x80));
+  __m128i middle =
+      _mm_or_si128(_mm_and_si128(_mm_srli_epi32(units, 6),
+                                 _mm_set1_epi32(0x3F)),
+                   _mm_set1_epi32(0x80));
+  __m128i as_two = _mm_or_si128(
+      _mm_or_si128(_mm_srli_epi32(units, 6), _mm_set1_epi32(0xC0)),
+      _mm_slli_epi32(low, 8));
+  __m128i as_three = _mm_or_si128(
+      _mm_or_si128(_mm_srli_epi32(units, 12), _mm_set1_epi32(0xE0)),
+      _mm_or_si128(_mm_slli_epi32(middle, 8), _mm_slli_epi32(low, 16)));
+  __m128i spelled = _mm_or_si128(
+      _mm_andnot_si128(two_bytes, units),
+      _mm_or_si128(_mm_and_si128(_mm_andnot_si128(three_bytes, two_bytes),
+                                 as_two),
+                   _mm_and_si128(three_bytes, as_three)));
+  const Utf16ToUtf8Step& step = kUtf16ToUtf8ThreeByteSteps
+      [_mm_movemask_ps(_mm_castsi128_ps(two_bytes)) |
+       _mm_movemask_ps(_mm_castsi128_ps(three_bytes)) << 4];
+  __m128i shuffle =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(step.shuffle));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(out),
+                   _mm_shuffle_epi8(spelled, shuffle));
+  *o += step.bytes;
+  return true;
+}
+
+__attribute__((target("ssse3"))) size_t TranscodeUtf16Ssse3(
+    const char16_t* data,
+    size_t size,
+    uint8_t* out) {
+  size_t i = 0;
+  size_t o = 0;
+  // With 20 units left there is room for 16 bytes past the UTF-8 of any 4.
+  while (size - i >= 20) {
+    size_t ascii = NarrowAsciiBlock(data + i, out + o);
+    i += ascii;
+    o += ascii;
+    if (ascii == 8 || size - i < 20) {
+      continue;
+    }
+    if (data[i] < 0xD800 || data[i] > 0xDFFF) {
+      if (TranscodeUtf16TwoByteSsse3(data + i, out + o, &o)) {
+        i += 8;
+        continue;
+      }
+      if (TranscodeUtf16ThreeByteSsse3(data + i, out + o, &o)) {
+        i += 4;
+        if (TranscodeUtf16ThreeByteSsse3(data + i, out + o, &o)) {
+          i += 4;
+        }
+        continue;
+      }
+    }
+    // A surrogate, here or among the next 4 units.
+    TranscodeUnit(data, size, &i, out, &o);
+  }
+  return TranscodeUtf16Portable(data, size, i, out, o);
+}
+
+#elif defined(PLATZI_UTF8_NEON)
+
+// See |TranscodeUtf8BlockSsse3|.
+inline void TranscodeUtf8BlockNeon(const uint8_t* data,
+                                   char16_t* out,
+                                   size_t* i,
+                                   size_t* o) {
+  static const uint8_t kBits[16] = {1, 2, 4, 8, 16, 32, 64, 128,
+                                    1, 2, 4, 8, 16, 32, 64, 128};
+  uint64_t starts = 0;
+  for (size_t k = 0; k < 64; k += 16) {
+    uint8x16_t continuations = vandq_u8(
+        vcltq_s8(vreinterpretq_s8_u8(vld1q_u8(data + k)), vdupq_n_s8(-64)),
+        vld1q_u8(kBits));
+    unsigned mask = vaddv_u8(vget_low_u8(continuations)) |
+                    static_cast<unsigned>(vaddv_u8(vget_high_u8(continuations)))
+                        << 8;
+    starts |= static_cast<uint64_t>(~mask & 0xFFFF) << k;
+  }
+  size_t offset = 0;
+  size_t written = 0;
+  while (offset < 48) {
+    const Utf8ToUtf16Step& step =
+        kUtf8ToUtf16Steps[(starts >> (offset + 1)) & 0xFF];
+    if (step.bytes == 0) {
+      break;
+    }
+    // Indices of 16 and above select a zero.
+    uint8x16_t input = vld1q_u8(data + offset);
+    uint16x8_t tail =
+        vreinterpretq_u16_u8(vqtbl1q_u8(input, vld1q_u8(step.tail)));
+    uint16x8_t lead =
+        vreinterpretq_u16_u8(vqtbl1q_u8(input, vld1q_u8(step.lead)));
+    uint16x8_t multi_byte = vorrq_u16(
+        vorrq_u16(vandq_u16(tail, vdupq_n_u16(0x3F)),
+                  vandq_u16(vshrq_n_u16(tail, 2), vdupq_n_u16(0x0FC0))),
+        vshlq_n_u16(lead, 12));
+    uint16x8_t ascii = vcltq_u16(tail, vdupq_n_u16(0x80));
+    vst1q_u16(reinterpret_cast<uint16_t*>(out + written),
+              vbslq_u16(ascii, tail, multi_byte));
+    offset += step.bytes;
+    written += step.units;
+  }
+  *i += offset;
+  *o += written;
+}
+
+size_t TranscodeUtf8Neon(const uint8_t* data, size_t size, char16_t* out) {
+  size_t i = 0;
+  size_t o = 0;
+  while (size - i >= 64) {
+    size_t ascii = WidenAsciiBlock(data + i, out + o);
+    i += ascii;
+    o += ascii;
+    if (ascii == 16) {
+      continue;
+    }
+    if (ascii == 0) {
+      size_t start = i;
+      TranscodeUtf8BlockNeon(data + i, out + o, &i, &o);
+      if (i != start) {
+        continue;
+      }
+    }
+    i += TranscodeValidCodePoint(data + i, out, &o);
+  }
+  return TranscodeUtf8Portable(data, size, i, out, o);
+}
+
+// See |TranscodeUtf16TwoByteSsse3|.
+inline bool TranscodeUtf16TwoByteNeon(const char16_t* data,
+                                      uint8_t* out,
+                                      size_t* o) {
+  static const uint16_t kBits[8] = {1, 2, 4, 8, 16, 32, 64, 128};
+  uint16x8_t units = vld1q_u16(reinterpret_cast<const uint16_t*>(data));
+  if (vmaxvq_u16(units) >= 0x800) {
+    return false;
+  }
+  uint16x8_t ascii = vcltq_u16(units, vdupq_n_u16(0x80));
+  uint16x8_t as_two = vorrq_u16(
+      vorrq_u16(vshrq_n_u16(units, 6), vdupq_n_u16(0xC0)),
+      vshlq_n_u16(vorrq_u16(vandq_u16(units, vdupq_n_u16(0x3F)),
+                            vdupq_n_u16(0x80)),
+                  8));
+  uint16x8_t spelled = vbslq_u16(ascii, units, as_two);
+  const Utf16ToUtf8Step& step = kUtf16ToUtf8TwoByteSteps
+      [vaddvq_u16(vandq_u16(vmvnq_u16(ascii), vld1q_u16(kBits)))];
+  vst1q_u8(out, vqtbl1q_u8(vreinterpretq_u8_u16(spelled),
+                           vld1q_u8(step.shuffle)));
+  *o += step.bytes;
+  return true;
+}
+
+// See |TranscodeUtf16ThreeByteSsse3|.
+inline bool TranscodeUtf16ThreeByteNeon(const char16_t* data,
+                                        uint8_t* out,
+                                        size_t* o) {
+  static const uint32_t kBits[4] = {1, 2, 4, 8};
+  uint32x4_t units =
+      vmovl_u16(vld1_u16(reinterpret_cast<const uint16_t*>(data)));
+  if (vmaxvq_u32(vceqq_u32(vandq_u32(units, vdupq_n_u32(0xF800)),
+                           vdupq_n_u32(0xD800))) != 0) {
+    return false;
+  }
+  uint32x4_t two_bytes = vcgtq_u32(units, vdupq_n_u32(0x7F));
+  uint32x4_t three_bytes = vcgtq_u32(units, vdupq_n_u32(0x7FF));
+  uint32x4_t low =
+      vorrq_u32(vandq_u32(units, vdupq_n_u32(0x3F)), vdupq_n_u32(0x80));
+  uint32x4_t middle = vorrq_u32(
+      vandq_u32(vshrq_n_u32(units, 6), vdupq_n_u32(0x3F)), vdupq_n_u32(0x80));
+  uint32x4_t as_two =
+      vorrq_u32(vorrq_u32(vshrq_n_u32(units, 6), vdupq_n_u32(0xC0)),
+                vshlq_n_u32(low, 8));
+  uint32x4_t as_three = vorrq_u32(
+      vorrq_u32(vshrq_n_u32(units, 12), vdupq_n_u32(0xE0)),
+      vorrq_u32(vshlq_n_u32(middle, 8), vshlq_n_u32(low, 16)));
+  uint32x4_t spelled =
+      vbslq_u32(three_bytes, as_three, vbslq_u32(two_bytes, as_two, units));
+  uint32x4_t bits = vld1q_u32(kBits);
+  const Utf16ToUtf8Step& step = kUtf16ToUtf8ThreeByteSteps
+      [vaddvq_u32(vandq_u32(two_bytes, bits)) |
+       vaddvq_u32(vandq_u32(three_bytes, bits)) << 4];
+  vst1q_u8(out, vqtbl1q_u8(vreinterpretq_u8_u32(spelled),
+                           vld1q_u8(step.shuffle)));
+  *o += step.bytes;
+  return true;
+}
+
+size_t TranscodeUtf16Neon(const char16_t* data, size_t size, uint8_t* out) {
+  size_t i = 0;
+  size_t o = 0;
+  // With 20 units left there is room for 16 bytes past the UTF-8 of any 4.
+  while (size - i >= 20) {
+    size_t ascii = NarrowAsciiBlock(data + i, out + o);
+    i += ascii;
+    o += ascii;
+    if (ascii == 8 || size - i < 20) {
+      continue;
+    }
+    if (data[i] < 0xD800 || data[i] > 0xDFFF) {
+      if (TranscodeUtf16TwoByteNeon(data + i, out + o, &o)) {
+        i += 8;
+        continue;
+      }
+      if (TranscodeUtf16ThreeByteNeon(data + i, out + o, &o)) {
+        i += 4;
+        if (TranscodeUtf16ThreeByteNeon(data + i, out + o, &o)) {
+          i += 4;
+        }
+        continue;
+      }
+    }
+    // A surrogate, here or among the next 4 units.
+    TranscodeUnit(data, size, &i, out, &o);
+  }
+  return TranscodeUtf16Portable(data, size, i, out, o);
+}
+
+#endif
+
+using Utf8ToUtf16Function = size_t (*)(const uint8_t*, size_t, char16_t*);
+using Utf16ToUtf8Function = size_t (*)(const char16_t*, size_t, uint8_t*);
+
+size_t TranscodeUtf8(const uint8_t* data, size_t size, char16_t* out) {
+  return TranscodeUtf8Portable(data, size, 0, out, 0);
+}
+
+size_t TranscodeUtf16(const char16_t* data, size_t size, uint8_t* out) {
+  return TranscodeUtf16Portable(data, size, 0, out, 0);
+}
+
+Utf8ToUtf16Function ResolveUtf8ToUtf16() {
+#if defined(PLATZI_UTF8_X86)
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("ssse3") ? TranscodeUtf8Ssse3
+                                         : TranscodeUtf8;
+#elif defined(PLATZI_UTF8_NEON)
+  return TranscodeUtf8Neon;
+#else
+  return TranscodeUtf8;
+#endif
+}
+
+Utf16ToUtf8Function ResolveUtf16ToUtf8() {
+#if defined(PLATZI_UTF8_X86)
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("ssse3") ? TranscodeUtf16Ssse3
+                                         : TranscodeUtf16;
+#elif defined(PLATZI_UTF8_NEON)
+  return TranscodeUtf16Neon;
+#else
+  return TranscodeUtf16;
+#endif
+}
+
+}  // namespace
+
+bool ValidateUtf8(const uint8_t* data, size_t size) {
+  if (size < 16) {
+    return ValidateUtf8Scalar(data, size);
+  }
+  static const ValidateFunction validate = ResolveValidate();
+  return validate(data, size);
+}
+
+bool Utf8ToUtf16(const uint8_t* data,
+                 size_t size,
+                 char16_t* out,
+                 size_t* out_size) {
+  if (!ValidateUtf8(data, size)) {
+    return false;
+  }
+  // A valid sequence of n bytes never produces more than n code units, so
+  // the output index trails the input index and the 16-unit stores of the
+  // vectorized paths stay within the |size| units the caller provided.
+  if (size < 16) {
+    *out_size = TranscodeUtf8(data, size, out);
+    return true;
+  }
+  static const Utf8ToUtf16Function transcode = ResolveUtf8ToUtf16();
+  *out_size = transcode(data, size, out);
+  return true;
+}
+
+bool Utf8ToUtf16(const uint8_t* data, size_t size, std::u16string* out) {
+  out->resize(size);
+  size_t length;
+  if (!Utf8ToUtf16(data, size, &(*out)[0], &length)) {
+    out->clear();
+    return false;
+  }
+  out->resize(length);
+  return true;
+}
+
+size_t Utf8LengthOfUtf16(const char16_t* data, size_t size) {
+  size_t length = 0;
+  size_t i = 0;
+  while (i < size) {
+    char16_t unit = data[i];
+    if (unit < 0x80) {
+      length++;
+      i++;
+    } else if (unit < 0x800) {
+      length += 2;
+      i++;
+    } else if (IsHighSurrogate(unit) && i + 1 < size &&
+               IsLowSurrogate(data[i + 1])) {
+      length += 4;
+      i += 2;
+    } else {
+      // Includes unpaired surrogates, which become U+FFFD.
+      length += 3;
+      i++;
+    }
+  }
+  return length;
+}
+
+size_t Utf16ToUtf8(const char16_t* data, size_t size, uint8_t* out) {
+  if (size < 16) {
+    return TranscodeUtf16(data, size, out);
+  }
+  static const Utf16ToUtf8Function transcode = ResolveUtf16ToUtf8();
+  return transcode(data, size, out);
+}
+
+}  // namespace platzi
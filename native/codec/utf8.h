@@ -0,0 +1,45 @@
+#ifndef NATIVE_CODEC_UTF8_H_
+#define NATIVE_CODEC_UTF8_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace platzi {
+
+// UTF-8 validation and UTF-8/UTF-16 transcoding for the string paths of the
+// codecs. The kernels pick SSSE3 or AVX2 on x86 (at run time) and NEON on
+// ARM64, and fall back to a portable implementation elsewhere. Validation
+// handles 16 or 32 bytes at a time whatever the text. Transcoding handles
+// runs of ASCII 8 or 16 code units at a time, and code points of two and
+// three UTF-8 bytes, which cover the BMP, with table-driven shuffles of up
+// to 8 at a time. Code points of four bytes, surrogate pairs in UTF-16 such
+// as most emoji, go one at a time, as do the lone non-ASCII characters of
+// mostly ASCII UTF-8, for which that is cheaper.
+
+// Returns true if |data| is well-formed UTF-8: no overlong encodings,
+// surrogates, code points above U+10FFFF or truncated sequences.
+bool ValidateUtf8(const uint8_t* data, size_t size);
+
+// Transcodes |size| bytes of UTF-8 into |out|, which must have room for
+// |size| code units. Returns false without a meaningful |out| if |data| is
+// not valid UTF-8; otherwise stores the number of code units written.
+bool Utf8ToUtf16(const uint8_t* data,
+                 size_t size,
+                 char16_t* out,
+                 size_t* out_size);
+
+// Convenience wrapper of the above that replaces the contents of |out|.
+bool Utf8ToUtf16(const uint8_t* data, size_t size, std::u16string* out);
+
+// Returns the number of UTF-8 bytes |Utf16ToUtf8| produces for |data|.
+size_t Utf8LengthOfUtf16(const char16_t* data, size_t size);
+
+// Transcodes |size| UTF-16 code units into |out|, which must have room for
+// |Utf8LengthOfUtf16| bytes, and returns the number of bytes written.
+// Unpaired surrogates become U+FFFD, as with Dart's utf8.encode.
+size_t Utf16ToUtf8(const char16_t* data, size_t size, uint8_t* out);
+
+}  // namespace platzi
+
+#endif  // NATIVE_CODEC_UTF8_H_
@@ -0,0 +1,182 @@
+#ifndef NATIVE_CODEC_VALUE_H_
+#define NATIVE_CODEC_VALUE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "codec/typed_data.h"
+
+namespace platzi {
+
+enum class ValueType : uint8_t {
+  kNull,
+  kBool,
+  kInt32,
+  kInt64,
+  kFloat64,
+  kString,
+  kTypedData,
+  kList,
+  kMap,
+  kExtension,
+  kTensor,
+};
+
+struct MapEntry;
+struct TensorView;
+
+// Returns an identifier unique to the C++ type |T|, which an
+// |ExtensionRegistry| maps to the type code of its extension type.
+template <typename T>
+const void* ExtensionTypeId() {
+  static const char id = 0;
+  return &id;
+}
+
+// A value of an extension type: an object of a type that an
+// |ExtensionRegistry| knows how to encode, the counterpart of the custom
+// objects a FlutterStandardWriter subclass writes.
+struct ExtensionValue {
+  const void* type_id;
+  const void* object;
+};
+
+// A decoded message value: the C++ counterpart of the NSNull, NSNumber,
+// NSString, FlutterStandardTypedData, NSArray and NSDictionary trees built by
+// FlutterStandardReader, plus tensors and objects of registered extension
+// types.
+//
+// Values are plain data. A tree is allocated in an |Arena| (see
+// value_decoder.h) and lives until the arena is reset; strings and typed data
+// may also point into the message buffer.
+struct Value {
+  ValueType type;
+  union {
+    bool boolean;
+    int32_t int32;
+    int64_t int64;
+    double float64;
+    std::string_view string;
+    TypedDataView typed_data;
+    Span<Value> list;
+    Span<MapEntry> map;
+    ExtensionValue extension;
+    const TensorView* tensor;
+  };
+
+  Value() : type(ValueType::kNull), int64(0) {}
+
+  static Value Null() { return Value(); }
+  static Value Bool(bool value);
+  static Value Int32(int32_t value);
+  static Value Int64(int64_t value);
+  static Value Float64(double value);
+  static Value String(std::string_view value);
+  static Value TypedData(const TypedDataView& value);
+  static Value List(const Value* items, size_t size);
+  static Value Map(const MapEntry* entries, size_t size);
+  static Value Extension(const void* type_id, const void* object);
+  static Value Tensor(const TensorView* value);
+  template <typename T>
+  static Value Extension(const T* object) {
+    return Extension(ExtensionTypeId<T>(), object);
+  }
+
+  bool is_null() const { return type == ValueType::kNull; }
+
+  // Returns the value of the first map entry whose key is the string |key|,
+  // or nullptr. Lookup is linear, like the maps it decodes from.
+  const Value* Find(std::string_view key) const;
+};
+
+struct MapEntry {
+  Value key;
+  Value value;
+};
+
+inline Value Value::Bool(bool value) {
+  Value result;
+  result.type = ValueType::kBool;
+  result.boolean = value;
+  return result;
+}
+
+inline Value Value::Int32(int32_t value) {
+  Value result;
+  result.type = ValueType::kInt32;
+  result.int32 = value;
+  return result;
+}
+
+inline Value Value::Int64(int64_t value) {
+  Value result;
+  result.type = ValueType::kInt64;
+  result.int64 = value;
+  return result;
+}
+
+inline Value Value::Float64(double value) {
+  Value result;
+  result.type = ValueType::kFloat64;
+  result.float64 = value;
+  return result;
+}
+
+inline Value Value::String(std::string_view value) {
+  Value result;
+  result.type = ValueType::kString;
+  result.string = value;
+  return result;
+}
+
+inline Value Value::TypedData(const TypedDataView& value) {
+  Value result;
+  result.type = ValueType::kTypedData;
+  result.typed_data = value;
+  return result;
+}
+
+inline Value Value::List(const Value* items, size_t size) {
+  Value result;
+  result.type = ValueType::kList;
+  result.list = Span<Value>{items, size};
+  return result;
+}
+
+inline Value Value::Map(const MapEntry* entries, size_t size) {
+  Value result;
+  result.type = ValueType::kMap;
+  result.map = Span<MapEntry>{entries, size};
+  return result;
+}
+
+inline Value Value::Extension(const void* type_id, const void* object) {
+  Value result;
+  result.type = ValueType::kExtension;
+  result.extension = ExtensionValue{type_id, object};
+  return result;
+}
+
+inline Value Value::Tensor(const TensorView* value) {
+  Value result;
+  result.type = ValueType::kTensor;
+  result.tensor = value;
+  return result;
+}
+
+inline const Value* Value::Find(std::string_view key) const {
+  if (type != ValueType::kMap) {
+    return nullptr;
+  }
+  for (const MapEntry& entry : map) {
+    if (entry.key.type == ValueType::kString && entry.key.string == key) {
+      return &entry.value;
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace platzi
+
+#endif  // NATIVE_CODEC_VALUE_H_
@@ -0,0 +1,179 @@
+#include "codec/value_decoder.h"
+
+#include <vector>
+
+#include "codec/delta_varint.h"
+#include "codec/extension_registry.h"
+#include "codec/tensor.h"
+
+namespace platzi {
+
+namespace {
+
+// A list or map whose elements are still being decoded.
+struct Frame {
+  Value* items;
+  MapEntry* entries;
+  size_t index;
+  size_t slots;
+  // The list or map itself, and whether it goes to |ShareValue| once
+  // complete.
+  const Value* value;
+  bool share;
+
+  Value* NextSlot() {
+    size_t slot = index++;
+    if (items != nullptr) {
+      return &items[slot];
+    }
+    MapEntry& entry = entries[slot / 2];
+    return slot % 2 == 0 ? &entry.key : &entry.value;
+  }
+};
+
+// Fills |value| from |token|. Lists and maps get their element storage but
+// not their elements. Returns false if the token is malformed.
+bool ConvertToken(const StandardToken& token,
+                  const ExtensionRegistry* extensions,
+                  Arena* arena,
+                  DecodeMode mode,
+                  Value* value) {
+  switch (token.type) {
+    case StandardField::kNil:
+      *value = Value::Null();
+      return true;
+    case StandardField::kTrue:
+    case StandardField::kFalse:
+      *value = Value::Bool(token.boolean);
+      return true;
+    case StandardField::kInt32:
+      *value = Value::Int32(token.int32);
+      return true;
+    case StandardField::kInt64:
+      *value = Value::Int64(token.int64);
+      return true;
+    case StandardField::kFloat64:
+      *value = Value::Float64(token.float64);
+      return true;
+    case StandardField::kIntHex:
+    case StandardField::kString:
+      *value = Value::String(mode == DecodeMode::kCopy
+                                 ? arena->CopyString(token.string)
+                                 : token.string);
+      return true;
+    case StandardField::kList:
+      *value = Value::List(arena->NewArray<Value>(token.count), token.count);
+      return true;
+    case StandardField::kMap:
+      *value = Value::Map(arena->NewArray<MapEntry>(token.count), token.count);
+      return true;
+    case StandardField::kInt64DeltaData: {
+      // Unpacked into the arena whatever the mode, as the message holds no
+      // elements to borrow.
+      int64_t* elements = static_cast<int64_t*>(
+          arena->Allocate(static_cast<size_t>(token.count) * 8, 8));
+      if (!UnpackInt64Deltas(token.payload.data, token.payload.size,
+                             token.count, elements)) {
+        return false;
+      }
+      TypedDataView typed_data = TypedDataView::Of(elements, token.count);
+      typed_data.type = StandardField::kInt64DeltaData;
+      *value = Value::TypedData(typed_data);
+      return true;
+    }
+    case StandardField::kTensor: {
+      // The dimensions are copied, as they need not be aligned in memory;
+      // the elements are borrowed like those of a typed data list.
+      TensorView* tensor = arena->New<TensorView>();
+      tensor->dtype = token.typed_data.type;
+      tensor->element_size = token.typed_data.element_size;
+      tensor->rank = static_cast<uint8_t>(token.count);
+      tensor->shape = reinterpret_cast<const uint32_t*>(
+          arena->CopyBytes(token.payload.data, token.payload.size, 4));
+      tensor->data = mode == DecodeMode::kCopy
+                         ? arena->CopyBytes(token.typed_data.bytes,
+                                            token.typed_data.byte_size(),
+                                            token.typed_data.element_size)
+                         : token.typed_data.bytes;
+      *value = Value::Tensor(tensor);
+      return true;
+    }
+    default: {
+      uint8_t type = static_cast<uint8_t>(token.type);
+      if (IsExtensionType(type)) {
+        return extensions != nullptr &&
+               extensions->Decode(type, token.payload, arena, mode, value);
+      }
+      TypedDataView typed_data = token.typed_data;
+      if (mode == DecodeMode::kCopy) {
+        typed_data.bytes =
+            arena->CopyBytes(typed_data.bytes, typed_data.byte_size(),
+                             typed_data.element_size);
+      }
+      *value = Value::TypedData(typed_data);
+      return true;
+    }
+  }
+}
+
+}  // namespace
+
+const Value* DecodeValue(StandardReader* reader,
+                         Arena* arena,
+                         DecodeMode mode) {
+  Value* root = arena->New<Value>();
+  std::vector<Frame> stack;
+  Value* slot = root;
+  StandardToken token;
+  while (true) {
+    if (!reader->ReadValue(&token)) {
+      return nullptr;
+    }
+    // Every element takes at least a byte, which bounds the storage a
+    // corrupt count can make us allocate.
+    size_t remaining = reader->size() - reader->position();
+    if ((token.type == StandardField::kList && token.count > remaining) ||
+        (token.type == StandardField::kMap && token.count > remaining / 2)) {
+      return nullptr;
+    }
+    if (token.shared != nullptr) {
+      // Complete with its elements already.
+      *slot = *token.shared;
+    } else if (!ConvertToken(token, reader->extensions(), arena, mode,
+                             slot)) {
+      return nullptr;
+    } else if (slot->type == ValueType::kList && !slot->list.empty()) {
+      stack.push_back({const_cast<Value*>(slot->list.data), nullptr, 0,
+                       slot->list.size, slot, token.share});
+    } else if (slot->type == ValueType::kMap && !slot->map.empty()) {
+      stack.push_back({nullptr, const_cast<MapEntry*>(slot->map.data), 0,
+                       2 * slot->map.size, slot, token.share});
+    } else if (token.share) {
+      reader->ShareValue(slot);
+    }
+    while (!stack.empty() && stack.back().index == stack.back().slots) {
+      if (stack.back().share) {
+        reader->ShareValue(stack.back().value);
+      }
+      stack.pop_back();
+    }
+    if (stack.empty()) {
+      return root;
+    }
+    slot = stack.back().NextSlot();
+  }
+}
+
+const Value* DecodeMessage(const uint8_t* data,
+                           size_t size,
+                           Arena* arena,
+                           DecodeMode mode) {
+  StandardReader reader(data, size);
+  const Value* value = DecodeValue(&reader, arena, mode);
+  if (value == nullptr || reader.HasMore()) {
+    return nullptr;
+  }
+  return value;
+}
+
+}  // namespace platzi
@@ -0,0 +1,40 @@
+#ifndef NATIVE_CODEC_VALUE_DECODER_H_
+#define NATIVE_CODEC_VALUE_DECODER_H_
+
+#include "codec/arena.h"
+#include "codec/standard_reader.h"
+#include "codec/value.h"
+
+namespace platzi {
+
+enum class DecodeMode {
+  // Strings and typed data point into the message buffer, which must outlive
+  // the decoded tree.
+  kBorrow,
+  // Strings and typed data are copied into the arena, so the message buffer
+  // can be released once decoding returns. Typed data copies are aligned to
+  // their element size.
+  kCopy,
+};
+
+// Decodes the next value of |reader| into a tree allocated in |arena|: the
+// counterpart of FlutterStandardReader's readValue with one bump allocation
+// per node instead of one heap object. Returns nullptr if the message is
+// malformed; the arena may then hold a partial tree until it is reset.
+//
+// Nesting depth is bounded only by the message size; decoding does not
+// recurse. Values of extension types are decoded by the reader's
+// |extensions|, and are malformed without them.
+const Value* DecodeValue(StandardReader* reader,
+                         Arena* arena,
+                         DecodeMode mode = DecodeMode::kBorrow);
+
+// Decodes a whole message, which must hold exactly one value.
+const Value* DecodeMessage(const uint8_t* data,
+                           size_t size,
+                           Arena* arena,
+                           DecodeMode mode = DecodeMode::kBorrow);
+
+}  // namespace platzi
+
+#endif  // NATIVE_CODEC_VALUE_DECODER_H_
@@ -0,0 +1,299 @@
+#include "messenger/binary_messenger.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace platzi {
+
+namespace {
+
+// The message held in |bytes|. The data of an empty vector may be null,
+// which would make an empty message nil.
+BinaryMessage MessageOf(bool nil, const std::vector<uint8_t>& bytes) {
+  static const uint8_t kEmpty = 0;
+  if (nil) {
+    return BinaryMessage();
+  }
+  return BinaryMessage{bytes.empty() ? &kEmpty : bytes.data(), bytes.size()};
+}
+
+}  // namespace
+
+MessengerTransport::~MessengerTransport() = default;
+
+void MessengerTransport::ResumeReceiving() {}
+
+BinaryMessenger::BinaryMessenger(MessengerTransport* transport)
+    : transport_(transport) {}
+
+BinaryMessenger::~BinaryMessenger() = default;
+
+void BinaryMessenger::Send(ChannelId channel,
+                           BinaryMessage message,
+                           BinaryReply callback) {
+  uint32_t response_id = 0;
+  if (callback && pending_replies_.full()) {
+    callback(BinaryMessage());
+  } else if (callback) {
+    response_id = pending_replies_.Insert({channel, std::move(callback)});
+  }
+  transport_->SendMessage(channel, channels_.NameOf(channel), message,
+                          response_id);
+}
+
+void BinaryMessenger::SetMessageHandler(ChannelId channel,
+                                        BinaryMessageHandler handler) {
+  if (channel >= handlers_.size()) {
+    if (!handler) {
+      return;
+    }
+    handlers_.resize(channel + 1);
+  }
+  handlers_[channel] =
+      handler ? std::make_shared<BinaryMessageHandler>(std::move(handler))
+              : nullptr;
+  if (!HasHandler(channel) && lanes_ != nullptr && !lanes_->empty()) {
+    BufferQueuedMessages(channel);
+  }
+  if (HasHandler(channel) && channel < buffers_.size() &&
+      buffers_[channel] != nullptr && !buffers_[channel]->empty()) {
+    Replay(channel);
+  }
+}
+
+void BinaryMessenger::SetBufferOptions(ChannelId channel,
+                                       const ChannelBufferOptions& options) {
+  ChannelBuffer* buffer = BufferOf(channel);
+  buffer->set_options(options);
+  while (buffer->OverLimits()) {
+    DropOldest(buffer);
+  }
+  if (receiving_blocked_) {
+    receiving_blocked_ = false;
+    transport_->ResumeReceiving();
+  }
+}
+
+bool BinaryMessenger::HandleMessage(std::string_view channel,
+                                    BinaryMessage message,
+                                    uint32_t response_id) {
+  ChannelId id = default_buffer_options_.max_messages > 0
+                     ? channels_.Intern(channel)
+                     : channels_.Find(channel);
+  return HandleMessage(id, message, response_id);
+}
+
+bool BinaryMessenger::HandleMessage(ChannelId channel,
+                                    BinaryMessage message,
+                                    uint32_t response_id) {
+  // Behind buffered messages while they are replayed, so that order holds.
+  const ChannelBuffer* buffered = buffer(channel);
+  if (HasHandler(channel) && (buffered == nullptr || buffered->empty())) {
+    if (lanes_ == nullptr) {
+      Dispatch(channel, message, response_id);
+      return true;
+    }
+    ChannelPriority lane = priority(channel);
+    if (lanes_->DispatchNow(lane, message.size)) {
+      Dispatch(channel, message, response_id);
+      return true;
+    }
+    bool was_empty = lanes_->empty();
+    lanes_->Push(lane, channel, message, response_id,
+                 PriorityLanes::Clock::now());
+    if (was_empty) {
+      ScheduleDispatch();
+    }
+    return true;
+  }
+  if (channel == kNoChannel) {
+    if (response_id != 0) {
+      transport_->SendReply(response_id, BinaryMessage());
+    }
+    return true;
+  }
+  return BufferMessage(channel, message, response_id);
+}
+
+void BinaryMessenger::Dispatch(ChannelId channel,
+                               BinaryMessage message,
+                               uint32_t response_id) {
+  // A reference of its own, as the handler may replace itself, and
+  // |handlers_| may grow, while it runs.
+  std::shared_ptr<BinaryMessageHandler> handler = handlers_[channel];
+  (*handler)(message, MessageReply(this, response_id));
+}
+
+ChannelBuffer* BinaryMessenger::BufferOf(ChannelId channel) {
+  if (channel >= buffers_.size()) {
+    buffers_.resize(channel + 1);
+  }
+  if (buffers_[channel] == nullptr) {
+    buffers_[channel] =
+        std::make_unique<ChannelBuffer>(default_buffer_options_);
+  }
+  return buffers_[channel].get();
+}
+
+bool BinaryMessenger::BufferMessage(ChannelId channel,
+                                    BinaryMessage message,
+                                    uint32_t response_id) {
+  ChannelBuffer* buffer = BufferOf(channel);
+  if (!buffer->CanEverFit(message.size)) {
+    buffer->CountDropped();
+    if (response_id != 0) {
+      transport_->SendReply(response_id, BinaryMessage());
+    }
+    return true;
+  }
+  while (!buffer->Fits(message.size)) {
+    switch (buffer->options().policy) {
+      case BufferOverflowPolicy::kDropOldest:
+        DropOldest(buffer);
+        break;
+      case BufferOverflowPolicy::kDropNewest:
+        buffer->CountDropped();
+        if (response_id != 0) {
+          transport_->SendReply(response_id, BinaryMessage());
+        }
+        return true;
+      case BufferOverflowPolicy::kBlock:
+        receiving_blocked_ = true;
+        return false;
+    }
+  }
+  buffer->Push(message, response_id);
+  return true;
+}
+
+void BinaryMessenger::DropOldest(ChannelBuffer* buffer) {
+  uint32_t response_id = buffer->front().response_id;
+  buffer->PopFront();
+  buffer->CountDropped();
+  if (response_id != 0) {
+    transport_->SendReply(response_id, BinaryMessage());
+  }
+}
+
+void BinaryMessenger::BufferQueuedMessages(ChannelId channel) {
+  std::vector<PriorityLanes::Entry> queued;
+  lanes_->TakeChannel(channel, &queued);
+  if (queued.empty()) {
+    return;
+  }
+  // Anything buffered for the channel arrived after them, as messages are
+  // only buffered while it has no handler.
+  ChannelBuffer* buffer = BufferOf(channel);
+  for (size_t i = queued.size(); i-- > 0;) {
+    buffer->PushFront(queued[i].nil, queued[i].response_id, &queued[i].bytes);
+  }
+  // The transport handed them over already, so a blocking buffer keeps them
+  // over its limits; otherwise the oldest go, as in |SetBufferOptions|.
+  if (buffer->options().policy != BufferOverflowPolicy::kBlock) {
+    while (buffer->OverLimits()) {
+      DropOldest(buffer);
+    }
+  }
+}
+
+void BinaryMessenger::Replay(ChannelId channel) {
+  if (std::find(replaying_.begin(), replaying_.end(), channel) !=
+      replaying_.end()) {
+    return;
+  }
+  replaying_.push_back(channel);
+  ChannelBuffer* buffer = buffers_[channel].get();
+  while (!buffer->empty() && HasHandler(channel)) {
+    // Taken out first: the handler may buffer more on the channel.
+    bool nil = buffer->front().nil;
+    uint32_t response_id = buffer->front().response_id;
+    std::vector<uint8_t> bytes;
+    buffer->PopFront(&bytes);
+    if (receiving_blocked_) {
+      receiving_blocked_ = false;
+      transport_->ResumeReceiving();
+    }
+    Dispatch(channel, MessageOf(nil, bytes), response_id);
+  }
+  replaying_.erase(
+      std::find(replaying_.begin(), replaying_.end(), channel));
+}
+
+void BinaryMessenger::EnablePriorityLanes(
+    std::function<void()> schedule_dispatch,
+    const PriorityLaneOptions& options) {
+  if (lanes_ != nullptr) {
+    // Messages queued under the old options go first.
+    while (DispatchQueued(SIZE_MAX) > 0) {
+    }
+  }
+  lanes_ = std::make_unique<PriorityLanes>(options);
+  schedule_dispatch_ = std::move(schedule_dispatch);
+  dispatch_scheduled_ = false;
+  for (std::string_view name : {"flutter/lifecycle", "flutter/textinput",
+                                "flutter/keyevent", "flutter/navigation"}) {
+    SetChannelPriority(Channel(name), ChannelPriority::kInteractive);
+  }
+}
+
+void BinaryMessenger::SetChannelPriority(ChannelId channel,
+                                         ChannelPriority priority) {
+  if (channel >= priorities_.size()) {
+    priorities_.resize(channel + 1, ChannelPriority::kDefault);
+  }
+  priorities_[channel] = priority;
+}
+
+void BinaryMessenger::ScheduleDispatch() {
+  if (!dispatch_scheduled_ && schedule_dispatch_) {
+    dispatch_scheduled_ = true;
+    schedule_dispatch_();
+  }
+}
+
+size_t BinaryMessenger::DispatchQueued(size_t limit) {
+  if (lanes_ == nullptr) {
+    return 0;
+  }
+  dispatch_scheduled_ = false;
+  PriorityLanes::Entry entry;
+  size_t dispatched = 0;
+  // The storage of each message dispatched goes to the next one queued.
+  while (dispatched < limit &&
+         lanes_->Pop(&entry, PriorityLanes::Clock::now())) {
+    BinaryMessage message = MessageOf(entry.nil, entry.bytes);
+    const ChannelBuffer* buffered = buffer(entry.channel);
+    if (HasHandler(entry.channel) &&
+        (buffered == nullptr || buffered->empty())) {
+      Dispatch(entry.channel, message, entry.response_id);
+    } else if (!BufferMessage(entry.channel, message, entry.response_id)) {
+      // Kept behind what is buffered for the channel. The transport handed
+      // it over already, so the buffer takes it over its limits; later
+      // messages on the channel are refused.
+      BufferOf(entry.channel)->Push(message, entry.response_id);
+    }
+    entry.bytes.clear();
+    dispatched++;
+  }
+  if (!lanes_->empty()) {
+    ScheduleDispatch();
+  }
+  return dispatched;
+}
+
+void BinaryMessenger::HandleReply(uint32_t response_id, BinaryMessage reply) {
+  PendingReply pending;
+  if (pending_replies_.Take(response_id, &pending)) {
+    pending.callback(reply);
+  }
+}
+
+void BinaryMessenger::SweepOverdueReplies(std::vector<OverdueReply>* overdue) {
+  pending_replies_.Sweep([overdue](uint32_t response_id,
+                                   const PendingReply& pending,
+                                   uint32_t sweeps) {
+    overdue->push_back({response_id, pending.channel, sweeps});
+  });
+}
+
+}  // namespace platzi
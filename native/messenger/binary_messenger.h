@@ -0,0 +1,309 @@
+#ifndef NATIVE_MESSENGER_BINARY_MESSENGER_H_
+#define NATIVE_MESSENGER_BINARY_MESSENGER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "codec/typed_data.h"
+#include "messenger/channel_buffer.h"
+#include "messenger/channel_registry.h"
+#include "messenger/priority_lanes.h"
+#include "messenger/slot_map.h"
+
+namespace platzi {
+
+class BinaryMessenger;
+
+// Messages and replies are borrowed bytes, valid only for the duration of
+// the call they are passed to. A null |data| stands for a nil NSData, which
+// is not the same as an empty message.
+using BinaryMessage = ByteSpan;
+
+// The counterpart of FlutterBinaryReply for messages sent to the peer:
+// receives its reply.
+using BinaryReply = std::function<void(BinaryMessage reply)>;
+
+// Sends the reply to a message received from the peer, the counterpart of
+// the FlutterBinaryReply passed to a FlutterBinaryMessageHandler. Copyable
+// and cheap to pass around, so it can be kept to reply asynchronously, on
+// the platform thread and no more than once.
+class MessageReply {
+ public:
+  MessageReply() = default;
+  MessageReply(BinaryMessenger* messenger, uint32_t response_id)
+      : messenger_(messenger), response_id_(response_id) {}
+
+  // Whether the peer waits for a reply at all.
+  bool expected() const { return response_id_ != 0; }
+
+  // Sends |reply|, unless the peer does not expect one.
+  void Send(BinaryMessage reply) const;
+
+ private:
+  BinaryMessenger* messenger_ = nullptr;
+  uint32_t response_id_ = 0;
+};
+
+// The counterpart of FlutterBinaryMessageHandler.
+using BinaryMessageHandler =
+    std::function<void(BinaryMessage message, MessageReply reply)>;
+
+// Carries messages and replies to the peer of a |BinaryMessenger|: the
+// Dart side through the engine, or another process.
+class MessengerTransport {
+ public:
+  virtual ~MessengerTransport();
+
+  // Sends |message| on |channel|, which is named |name|. The peer must
+  // answer a nonzero |response_id| with a reply, which it hands to
+  // |BinaryMessenger::HandleReply|.
+  virtual void SendMessage(ChannelId channel,
+                           std::string_view name,
+                           BinaryMessage message,
+                           uint32_t response_id) = 0;
+
+  // Sends the reply to the message the peer sent with |response_id|.
+  virtual void SendReply(uint32_t response_id, BinaryMessage reply) = 0;
+
+  // Called once messages that |BinaryMessenger::HandleMessage| refused may
+  // be offered again. Transports whose channels never block can ignore it.
+  virtual void ResumeReceiving();
+};
+
+// A portable core of FlutterBinaryMessenger, keyed by |ChannelId|.
+//
+// Channel names are interned once, when a handler is registered or a
+// channel first used, and everything after that works on IDs: incoming
+// messages whose transport knows the ID are dispatched by indexing a flat
+// table of handlers, without hashing or comparing names. The string API of
+// FlutterBinaryMessenger is kept on top, interning the name on every call,
+// for code that does not hold on to IDs.
+//
+// Messages for channels without a handler are held in a bounded
+// |ChannelBuffer| per channel, and handed to the handler in order once one
+// is registered; see |ChannelBufferOptions| for the limits and what happens
+// beyond them. Messages dropped, or received with buffering off, get a nil
+// reply, as in FlutterEngine.
+//
+// With |EnablePriorityLanes|, incoming messages wait in a queue per
+// |ChannelPriority| instead of being dispatched as they arrive, so that
+// input and lifecycle messages overtake a backlog of bulk data; see
+// |PriorityLanes| for how the lanes share the platform thread. Messages
+// queued for a channel whose handler is unregistered move to the front of
+// its buffer, so they are still replayed in order.
+//
+// Like FlutterBinaryMessenger, a messenger belongs to the platform thread:
+// every method must be called on it, and handlers and reply callbacks run
+// on it. Handlers may register and unregister handlers, themselves
+// included, while they run.
+class BinaryMessenger {
+ public:
+  // |transport| must outlive the messenger.
+  explicit BinaryMessenger(MessengerTransport* transport);
+  ~BinaryMessenger();
+
+  BinaryMessenger(const BinaryMessenger&) = delete;
+  BinaryMessenger& operator=(const BinaryMessenger&) = delete;
+
+  const ChannelRegistry& channels() const { return channels_; }
+
+  // Returns the ID of the channel |name|, interning it if it is new.
+  ChannelId Channel(std::string_view name) { return channels_.Intern(name); }
+
+  // Sends |message| to the peer on |channel|, and |callback|, if any, its
+  // reply. If |SlotMap::kMaxEntries| replies are pending already,
+  // |callback| gets a nil reply at once and the peer is not asked for one.
+  void Send(ChannelId channel,
+            BinaryMessage message,
+            BinaryReply callback = nullptr);
+
+  // Registers |handler| for messages on |channel|, replacing any previous
+  // one, and hands it the messages buffered for the channel; an empty
+  // |handler| unregisters it.
+  void SetMessageHandler(ChannelId channel, BinaryMessageHandler handler);
+
+  // Sets the limits of the buffer of |channel|. Messages it holds over the
+  // new limits are dropped, oldest first.
+  void SetBufferOptions(ChannelId channel,
+                        const ChannelBufferOptions& options);
+
+  // The limits of buffers of channels without options of their own.
+  // Setting |max_messages| to 0 turns buffering off.
+  const ChannelBufferOptions& default_buffer_options() const {
+    return default_buffer_options_;
+  }
+  void set_default_buffer_options(const ChannelBufferOptions& options) {
+    default_buffer_options_ = options;
+  }
+
+  // The buffer of |channel|, with its counters, or nullptr if nothing was
+  // ever buffered for it.
+  const ChannelBuffer* buffer(ChannelId channel) const {
+    return channel < buffers_.size() ? buffers_[channel].get() : nullptr;
+  }
+
+  // Dispatches incoming messages through priority lanes from now on: they
+  // are copied into the lane of their channel's priority and handed to
+  // handlers by |DispatchQueued|, which |schedule_dispatch| must make the
+  // platform thread call soon. It is called when messages are queued and
+  // none were, not per message. A message that would be dispatched next
+  // anyway, as nothing of its priority or higher is queued, is dispatched
+  // at once, without a copy.
+  //
+  // The engine's lifecycle, text input, key event and navigation channels
+  // are made interactive, and the rest default to |kDefault|.
+  void EnablePriorityLanes(std::function<void()> schedule_dispatch,
+                           const PriorityLaneOptions& options = {});
+
+  // Sets the lane of |channel|'s messages received from now on. Messages
+  // already queued stay in their lane, which may let later ones overtake
+  // them, so priorities are best set before traffic starts.
+  void SetChannelPriority(ChannelId channel, ChannelPriority priority);
+
+  ChannelPriority priority(ChannelId channel) const {
+    return channel < priorities_.size() ? priorities_[channel]
+                                        : ChannelPriority::kDefault;
+  }
+
+  // The lanes, with their queueing delay counters, or nullptr if they are
+  // not enabled.
+  const PriorityLanes* lanes() const { return lanes_.get(); }
+  void ResetLaneStats() {
+    if (lanes_ != nullptr) {
+      lanes_->ResetStats();
+    }
+  }
+
+  // Dispatches up to |limit| queued messages in the lanes' order, and
+  // returns how many were dispatched. Schedules another dispatch if it
+  // stops at the limit, so that the run loop gets to poll in between.
+  size_t DispatchQueued(size_t limit = kDefaultDispatchLimit);
+
+  static constexpr size_t kDefaultDispatchLimit = 64;
+
+  // sendOnChannel:message: and sendOnChannel:message:binaryReply:.
+  void SendOnChannel(std::string_view channel,
+                     BinaryMessage message,
+                     BinaryReply callback = nullptr) {
+    Send(Channel(channel), message, std::move(callback));
+  }
+
+  // setMessageHandlerOnChannel:binaryMessageHandler:.
+  void SetMessageHandlerOnChannel(std::string_view channel,
+                                  BinaryMessageHandler handler) {
+    SetMessageHandler(Channel(channel), std::move(handler));
+  }
+
+  // Called by the transport for a message from the peer, which expects a
+  // reply if |response_id| is nonzero. Returns false if the message was
+  // refused because the channel's buffer is full and blocks; the transport
+  // must then hold it, and every later one, until |ResumeReceiving|.
+  bool HandleMessage(ChannelId channel,
+                     BinaryMessage message,
+                     uint32_t response_id);
+
+  // As above, for transports that only know the channel name. Names that
+  // were never interned are interned only if messages are buffered by
+  // default, as the channel may be about to get a handler.
+  bool HandleMessage(std::string_view channel,
+                     BinaryMessage message,
+                     uint32_t response_id);
+
+  // Called by the transport for the peer's reply to the message sent with
+  // |response_id|.
+  void HandleReply(uint32_t response_id, BinaryMessage reply);
+
+  // Sends the reply to the message the peer sent with |response_id|.
+  void SendReply(uint32_t response_id, BinaryMessage reply) {
+    transport_->SendReply(response_id, reply);
+  }
+
+  // Replies the messenger waits for from the peer.
+  size_t pending_replies() const { return pending_replies_.size(); }
+
+  // A reply the peer still owes, |sweeps| calls of |SweepOverdueReplies|
+  // after the message was sent.
+  struct OverdueReply {
+    uint32_t response_id;
+    ChannelId channel;
+    uint32_t sweeps;
+  };
+
+  // Appends to |overdue| the replies still pending since the previous
+  // call. Called at a fixed interval, it reports replies that are likely
+  // never to come, by channel, at no cost to sending.
+  void SweepOverdueReplies(std::vector<OverdueReply>* overdue);
+
+ private:
+  struct PendingReply {
+    ChannelId channel = kNoChannel;
+    BinaryReply callback;
+  };
+
+  bool HasHandler(ChannelId channel) const {
+    return channel < handlers_.size() && handlers_[channel] != nullptr;
+  }
+
+  void Dispatch(ChannelId channel, BinaryMessage message, uint32_t response_id);
+
+  // Returns the buffer of |channel|, creating it if need be.
+  ChannelBuffer* BufferOf(ChannelId channel);
+
+  // Buffers a message for |channel|; returns false if it is refused.
+  bool BufferMessage(ChannelId channel,
+                     BinaryMessage message,
+                     uint32_t response_id);
+
+  // Drops the oldest message of |buffer|.
+  void DropOldest(ChannelBuffer* buffer);
+
+  // Moves the messages queued in the lanes for |channel|, which lost its
+  // handler, to the front of its buffer, so that they are replayed first.
+  void BufferQueuedMessages(ChannelId channel);
+
+  // Hands the messages buffered for |channel| to its handler, for as long
+  // as it has one.
+  void Replay(ChannelId channel);
+
+  // Calls |schedule_dispatch_| unless a dispatch is scheduled already.
+  void ScheduleDispatch();
+
+  MessengerTransport* transport_;
+  ChannelRegistry channels_;
+
+  // Indexed by channel ID; channels past the end, and null entries, have
+  // no handler. Shared with |Dispatch|, which keeps the handler it runs
+  // alive while the handler replaces or unregisters itself.
+  std::vector<std::shared_ptr<BinaryMessageHandler>> handlers_;
+
+  // Indexed by channel ID, like |handlers_|; null until a channel first
+  // needs one.
+  std::vector<std::unique_ptr<ChannelBuffer>> buffers_;
+  ChannelBufferOptions default_buffer_options_;
+  // Channels whose buffers are being replayed.
+  std::vector<ChannelId> replaying_;
+  // Set when a message has been refused, until |ResumeReceiving|.
+  bool receiving_blocked_ = false;
+
+  SlotMap<PendingReply> pending_replies_;
+
+  // Indexed by channel ID; channels past the end are |kDefault|.
+  std::vector<ChannelPriority> priorities_;
+  std::unique_ptr<PriorityLanes> lanes_;
+  std::function<void()> schedule_dispatch_;
+  bool dispatch_scheduled_ = false;
+};
+
+inline void MessageReply::Send(BinaryMessage reply) const {
+  if (expected()) {
+    messenger_->SendReply(response_id_, reply);
+  }
+}
+
+}  // namespace platzi
+
+#endif  // NATIVE_MESSENGER_BINARY_MESSENGER_H_
@@ -0,0 +1,64 @@
+#include "messenger/channel_buffer.h"
+
+#include <utility>
+
+namespace platzi {
+
+ChannelBuffer::ChannelBuffer(const ChannelBufferOptions& options)
+    : options_(options) {}
+
+ChannelBuffer::~ChannelBuffer() = default;
+
+void ChannelBuffer::set_options(const ChannelBufferOptions& options) {
+  options_ = options;
+}
+
+void ChannelBuffer::Reserve() {
+  if (count_ < entries_.size()) {
+    return;
+  }
+  // Unwrap into a larger ring; entries move with their storage.
+  std::vector<Entry> entries(entries_.empty() ? 1 : 2 * entries_.size());
+  for (size_t i = 0; i < count_; i++) {
+    entries[i] = std::move(entries_[(head_ + i) % entries_.size()]);
+  }
+  entries_.swap(entries);
+  head_ = 0;
+}
+
+void ChannelBuffer::Push(ByteSpan message, uint32_t response_id) {
+  Reserve();
+  Entry& entry = entries_[(head_ + count_) % entries_.size()];
+  entry.nil = message.data == nullptr;
+  entry.response_id = response_id;
+  entry.bytes.assign(message.begin(), message.end());
+  count_++;
+  byte_size_ += message.size;
+}
+
+void ChannelBuffer::PushFront(bool nil,
+                              uint32_t response_id,
+                              std::vector<uint8_t>* bytes) {
+  Reserve();
+  head_ = (head_ + entries_.size() - 1) % entries_.size();
+  Entry& entry = entries_[head_];
+  entry.nil = nil;
+  entry.response_id = response_id;
+  entry.bytes.swap(*bytes);
+  bytes->clear();
+  count_++;
+  byte_size_ += entry.bytes.size();
+}
+
+void ChannelBuffer::PopFront(std::vector<uint8_t>* bytes) {
+  Entry& entry = entries_[head_];
+  byte_size_ -= entry.bytes.size();
+  if (bytes != nullptr) {
+    bytes->swap(entry.bytes);
+  }
+  entry.bytes.clear();
+  head_ = (head_ + 1) % entries_.size();
+  count_--;
+}
+
+}  // namespace platzi
@@ -0,0 +1,107 @@
+#ifndef NATIVE_MESSENGER_CHANNEL_BUFFER_H_
+#define NATIVE_MESSENGER_CHANNEL_BUFFER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "codec/typed_data.h"
+
+namespace platzi {
+
+// What happens to a message for a channel without a handler when its
+// |ChannelBuffer| is full.
+enum class BufferOverflowPolicy : uint8_t {
+  // Makes room by dropping the oldest messages.
+  kDropOldest,
+  // Drops the message.
+  kDropNewest,
+  // Refuses the message, so that the transport stops receiving until there
+  // is room and the peer's sends back up.
+  kBlock,
+};
+
+// Limits of the messages a |BinaryMessenger| holds for a channel until a
+// handler is registered. The default, like the channel buffers of the
+// Flutter framework, keeps the last message.
+struct ChannelBufferOptions {
+  size_t max_messages = 1;
+  size_t max_bytes = 64 * 1024;
+  BufferOverflowPolicy policy = BufferOverflowPolicy::kDropOldest;
+};
+
+// A bounded ring of messages with their response IDs, copied out of the
+// transport's buffers. Entries keep their storage when popped, so a buffer
+// that fills and drains repeatedly stops allocating.
+class ChannelBuffer {
+ public:
+  struct Entry {
+    bool nil = false;
+    uint32_t response_id = 0;
+    std::vector<uint8_t> bytes;
+  };
+
+  explicit ChannelBuffer(const ChannelBufferOptions& options);
+  ~ChannelBuffer();
+
+  ChannelBuffer(const ChannelBuffer&) = delete;
+  ChannelBuffer& operator=(const ChannelBuffer&) = delete;
+
+  const ChannelBufferOptions& options() const { return options_; }
+
+  // Changes the limits. Messages over them stay until popped.
+  void set_options(const ChannelBufferOptions& options);
+
+  bool empty() const { return count_ == 0; }
+  size_t size() const { return count_; }
+  size_t byte_size() const { return byte_size_; }
+
+  // Whether a message of |size| bytes fits the limits along with those
+  // buffered, and whether it would fit in an empty buffer.
+  bool Fits(size_t size) const {
+    return count_ < options_.max_messages &&
+           byte_size_ + size <= options_.max_bytes;
+  }
+  bool CanEverFit(size_t size) const {
+    return options_.max_messages > 0 && size <= options_.max_bytes;
+  }
+
+  // Whether the messages buffered exceed the limits, as they may once the
+  // limits are lowered.
+  bool OverLimits() const {
+    return count_ > options_.max_messages || byte_size_ > options_.max_bytes;
+  }
+
+  // Appends a copy of |message|, which must fit.
+  void Push(ByteSpan message, uint32_t response_id);
+
+  // Inserts a message ahead of those buffered, taking over the storage of
+  // |bytes|. Unlike |Push|, it may take the buffer over its limits.
+  void PushFront(bool nil, uint32_t response_id, std::vector<uint8_t>* bytes);
+
+  Entry& front() { return entries_[head_]; }
+
+  // Removes the oldest message, swapping its bytes into |bytes| if given.
+  void PopFront(std::vector<uint8_t>* bytes = nullptr);
+
+  // Messages dropped from the buffer, or that could never fit in it.
+  // Messages refused to block the sender are not dropped.
+  uint64_t dropped() const { return dropped_; }
+  void CountDropped() { dropped_++; }
+
+ private:
+  // Makes room for one more entry.
+  void Reserve();
+
+  ChannelBufferOptions options_;
+  // A ring of |count_| entries from |head_|; grows up to |max_messages|.
+  std::vector<Entry> entries_;
+  size_t head_ = 0;
+  size_t count_ = 0;
+  size_t byte_size_ = 0;
+  uint64_t dropped_ = 0;
+};
+
+}  // namespace platzi
+
+#endif  // NATIVE_MESSENGER_CHANNEL_BUFFER_H_
@@ -0,0 +1,82 @@
+#include "messenger/channel_registry.h"
+
+#include <cstring>
+
+namespace platzi {
+
+namespace {
+
+constexpr size_t kInitialSlots = 64;
+
+// Hashes eight bytes at a time, as channel names run to dozens of bytes.
+inline uint32_t HashName(std::string_view name) {
+  constexpr uint64_t kMultiplier = 0x9E3779B97F4A7C15ull;
+  uint64_t hash = name.size() * kMultiplier;
+  const char* data = name.data();
+  size_t size = name.size();
+  for (; size >= 8; data += 8, size -= 8) {
+    uint64_t word;
+    std::memcpy(&word, data, 8);
+    hash = (hash ^ word) * kMultiplier;
+    hash ^= hash >> 29;
+  }
+  if (size > 0) {
+    uint64_t word = 0;
+    std::memcpy(&word, data, size);
+    hash = (hash ^ word) * kMultiplier;
+    hash ^= hash >> 29;
+  }
+  return static_cast<uint32_t>(hash ^ (hash >> 32));
+}
+
+}  // namespace
+
+ChannelRegistry::ChannelRegistry() : slots_(kInitialSlots, 0) {}
+
+ChannelRegistry::~ChannelRegistry() = default;
+
+size_t ChannelRegistry::SlotOf(std::string_view name, uint32_t hash) const {
+  size_t mask = slots_.size() - 1;
+  for (size_t i = hash & mask;; i = (i + 1) & mask) {
+    uint32_t entry = slots_[i];
+    if (entry == 0 ||
+        (hashes_[entry - 1] == hash && names_[entry - 1] == name)) {
+      return i;
+    }
+  }
+}
+
+ChannelId ChannelRegistry::Find(std::string_view name) const {
+  uint32_t entry = slots_[SlotOf(name, HashName(name))];
+  return entry == 0 ? kNoChannel : entry - 1;
+}
+
+ChannelId ChannelRegistry::Intern(std::string_view name) {
+  uint32_t hash = HashName(name);
+  size_t slot = SlotOf(name, hash);
+  if (slots_[slot] != 0) {
+    return slots_[slot] - 1;
+  }
+  ChannelId channel = static_cast<ChannelId>(names_.size());
+  names_.push_back(names_arena_.CopyString(name));
+  hashes_.push_back(hash);
+  slots_[slot] = channel + 1;
+  if (2 * names_.size() > slots_.size()) {
+    Rehash(2 * slots_.size());
+  }
+  return channel;
+}
+
+void ChannelRegistry::Rehash(size_t capacity) {
+  slots_.assign(capacity, 0);
+  size_t mask = capacity - 1;
+  for (size_t channel = 0; channel < names_.size(); channel++) {
+    size_t i = hashes_[channel] & mask;
+    while (slots_[i] != 0) {
+      i = (i + 1) & mask;
+    }
+    slots_[i] = static_cast<uint32_t>(channel + 1);
+  }
+}
+
+}  // namespace platzi
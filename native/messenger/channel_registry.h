@@ -0,0 +1,67 @@
+#ifndef NATIVE_MESSENGER_CHANNEL_REGISTRY_H_
+#define NATIVE_MESSENGER_CHANNEL_REGISTRY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "codec/arena.h"
+
+namespace platzi {
+
+// A channel of a |BinaryMessenger|, numbered densely from 0 in the order
+// channel names are first interned.
+using ChannelId = uint32_t;
+
+constexpr ChannelId kNoChannel = UINT32_MAX;
+
+// Interns channel names, such as "flutter/lifecycle" or
+// "plugins.flutter.io/path_provider", into |ChannelId|s.
+//
+// A name is hashed once, when it is interned; everything that dispatches on
+// channels afterwards indexes flat arrays by ID instead of hashing and
+// comparing names, the way the NSString keys of FlutterEngine's handler
+// dictionary are on every message. IDs are never reused: a channel keeps
+// its ID for the life of the registry even once nothing handles it.
+//
+// Not thread-safe.
+class ChannelRegistry {
+ public:
+  ChannelRegistry();
+  ~ChannelRegistry();
+
+  ChannelRegistry(const ChannelRegistry&) = delete;
+  ChannelRegistry& operator=(const ChannelRegistry&) = delete;
+
+  // Returns the ID of |name|, assigning the next one if it is new.
+  ChannelId Intern(std::string_view name);
+
+  // Returns the ID of |name|, or |kNoChannel| if it was never interned.
+  ChannelId Find(std::string_view name) const;
+
+  // Returns the name of |channel|, which must have been interned. The name
+  // stays valid for the life of the registry.
+  std::string_view NameOf(ChannelId channel) const { return names_[channel]; }
+
+  // Number of channels interned, which is one more than the highest ID.
+  size_t size() const { return names_.size(); }
+
+ private:
+  // Returns the slot holding |name|, or the empty slot where it would go.
+  size_t SlotOf(std::string_view name, uint32_t hash) const;
+
+  void Rehash(size_t capacity);
+
+  // Copies of the names, indexed by ID.
+  Arena names_arena_;
+  std::vector<std::string_view> names_;
+  std::vector<uint32_t> hashes_;
+  // Open addressing over |names_|: ID + 1 for each name, 0 for empty slots.
+  // At most half full.
+  std::vector<uint32_t> slots_;
+};
+
+}  // namespace platzi
+
+#endif  // NATIVE_MESSENGER_CHANNEL_REGISTRY_H_
@@ -0,0 +1,81 @@
+#ifndef NATIVE_MESSENGER_MPSC_QUEUE_H_
+#define NATIVE_MESSENGER_MPSC_QUEUE_H_
+
+#include <atomic>
+
+namespace platzi {
+
+// A link in an |MpscQueue|, embedded in the objects queued.
+struct MpscNode {
+  std::atomic<MpscNode*> next{nullptr};
+};
+
+// An intrusive, unbounded, lock-free queue for many producer threads and
+// one consumer thread, after Dmitry Vyukov's non-intrusive MPSC node-based
+// queue.
+//
+// Pushing takes one atomic exchange and one store, whatever the contention,
+// and never allocates: nodes live in the objects queued. Popping takes
+// plain loads, plus an exchange when it takes the last node. The queue owns
+// nothing; whoever pops a node owns it again.
+//
+// The price is that a producer preempted between its two steps hides the
+// nodes pushed after its own until it resumes: |Pop| returns nullptr
+// although the queue is not empty. Consumers must be woken again by that
+// producer rather than spin, which |SendQueue| arranges.
+class MpscQueue {
+ public:
+  MpscQueue() : head_(&stub_), tail_(&stub_) {}
+
+  MpscQueue(const MpscQueue&) = delete;
+  MpscQueue& operator=(const MpscQueue&) = delete;
+
+  // Appends |node|. Any thread.
+  void Push(MpscNode* node) {
+    node->next.store(nullptr, std::memory_order_relaxed);
+    MpscNode* previous = head_.exchange(node, std::memory_order_acq_rel);
+    previous->next.store(node, std::memory_order_release);
+  }
+
+  // Removes and returns the oldest node, or nullptr if there is none or a
+  // push is in progress in front of it. Consumer thread only.
+  MpscNode* Pop() {
+    MpscNode* tail = tail_;
+    MpscNode* next = tail->next.load(std::memory_order_acquire);
+    if (tail == &stub_) {
+      if (next == nullptr) {
+        return nullptr;
+      }
+      tail_ = next;
+      tail = next;
+      next = next->next.load(std::memory_order_acquire);
+    }
+    if (next != nullptr) {
+      tail_ = next;
+      return tail;
+    }
+    if (tail != head_.load(std::memory_order_acquire)) {
+      return nullptr;
+    }
+    // |tail| is the last node. The stub goes behind it, so that it can be
+    // handed out without the queue ever becoming empty of nodes.
+    Push(&stub_);
+    next = tail->next.load(std::memory_order_acquire);
+    if (next != nullptr) {
+      tail_ = next;
+      return tail;
+    }
+    return nullptr;
+  }
+
+ private:
+  // Producers contend on |head_|; keep the consumer's |tail_| off its cache
+  // line.
+  alignas(64) std::atomic<MpscNode*> head_;
+  alignas(64) MpscNode* tail_;
+  MpscNode stub_;
+};
+
+}  // namespace platzi
+
+#endif  // NATIVE_MESSENGER_MPSC_QUEUE_H_
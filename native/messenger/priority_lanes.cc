@@ -0,0 +1,163 @@
+#include "messenger/priority_lanes.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace platzi {
+
+PriorityLanes::PriorityLanes(const PriorityLaneOptions& options) {
+  for (size_t i = 0; i < kChannelPriorityCount; i++) {
+    // A lane without credit would never be dispatched.
+    lanes_[i].quantum = std::max<size_t>(options.quantum[i], 1);
+  }
+}
+
+PriorityLanes::~PriorityLanes() = default;
+
+void PriorityLanes::ResetStats() {
+  for (Lane& lane : lanes_) {
+    lane.stats = LaneStats();
+  }
+}
+
+void PriorityLanes::Push(ChannelPriority priority,
+                         ChannelId channel,
+                         ByteSpan message,
+                         uint32_t response_id,
+                         Clock::time_point now) {
+  Lane& lane = LaneOf(priority);
+  if (lane.count == lane.entries.size()) {
+    // Unwrap into a larger ring; entries move with their storage.
+    std::vector<Entry> entries(lane.entries.empty() ? 4
+                                                    : 2 * lane.entries.size());
+    for (size_t i = 0; i < lane.count; i++) {
+      entries[i] =
+          std::move(lane.entries[(lane.head + i) % lane.entries.size()]);
+    }
+    lane.entries.swap(entries);
+    lane.head = 0;
+  }
+  if (lane.count == 0) {
+    Credit(&lane);
+  }
+  Entry& entry = lane.entries[(lane.head + lane.count) % lane.entries.size()];
+  entry.channel = channel;
+  entry.nil = message.data == nullptr;
+  entry.response_id = response_id;
+  entry.queued_at = now;
+  entry.bytes.assign(message.begin(), message.end());
+  lane.count++;
+  lane.byte_size += message.size;
+  queued_++;
+}
+
+bool PriorityLanes::DispatchNow(ChannelPriority priority, size_t size) {
+  for (size_t i = 0; i <= static_cast<size_t>(priority); i++) {
+    if (lanes_[i].count > 0) {
+      return false;
+    }
+  }
+  Lane& lane = LaneOf(priority);
+  Credit(&lane);
+  if (CostOf(size) > lane.deficit) {
+    return false;
+  }
+  lane.deficit -= CostOf(size);
+  lane.stats.dispatched++;
+  return true;
+}
+
+void PriorityLanes::TakeChannel(ChannelId channel,
+                                std::vector<Entry>* taken) {
+  size_t first = taken->size();
+  size_t lanes_taken_from = 0;
+  for (Lane& lane : lanes_) {
+    // Compacts the ring in place, keeping the order of what stays.
+    size_t ring = lane.entries.size();
+    size_t kept = 0;
+    size_t count = lane.count;
+    for (size_t i = 0; i < count; i++) {
+      Entry& entry = lane.entries[(lane.head + i) % ring];
+      if (entry.channel == channel) {
+        lane.byte_size -= entry.bytes.size();
+        lane.count--;
+        queued_--;
+        taken->push_back(std::move(entry));
+        entry.bytes = std::vector<uint8_t>();
+      } else {
+        if (kept != i) {
+          std::swap(lane.entries[(lane.head + kept) % ring], entry);
+        }
+        kept++;
+      }
+    }
+    if (kept != count) {
+      lanes_taken_from++;
+    }
+  }
+  // A channel whose priority changed may have messages in several lanes.
+  if (lanes_taken_from > 1) {
+    std::stable_sort(taken->begin() + first, taken->end(),
+                     [](const Entry& a, const Entry& b) {
+                       return a.queued_at < b.queued_at;
+                     });
+  }
+}
+
+void PriorityLanes::StartRounds() {
+  // Rounds in which nothing could be dispatched are skipped at once, which
+  // matters for messages many quanta large.
+  uint64_t rounds = UINT64_MAX;
+  for (const Lane& lane : lanes_) {
+    if (lane.count > 0) {
+      size_t need =
+          CostOf(lane.entries[lane.head].bytes.size()) - lane.deficit;
+      rounds = std::min<uint64_t>(rounds,
+                                  (need + lane.quantum - 1) / lane.quantum);
+    }
+  }
+  round_ += rounds;
+  for (Lane& lane : lanes_) {
+    if (lane.count > 0) {
+      lane.deficit += static_cast<size_t>(rounds) * lane.quantum;
+      lane.round = round_;
+    }
+  }
+}
+
+bool PriorityLanes::Pop(Entry* entry, Clock::time_point now) {
+  if (queued_ == 0) {
+    return false;
+  }
+  while (true) {
+    for (Lane& lane : lanes_) {
+      if (lane.count == 0) {
+        continue;
+      }
+      Entry& front = lane.entries[lane.head];
+      size_t cost = CostOf(front.bytes.size());
+      if (cost > lane.deficit) {
+        continue;
+      }
+      lane.deficit -= cost;
+      Clock::duration delay = now - front.queued_at;
+      lane.stats.dispatched++;
+      lane.stats.total_delay += delay;
+      lane.stats.max_delay = std::max(lane.stats.max_delay, delay);
+      entry->channel = front.channel;
+      entry->nil = front.nil;
+      entry->response_id = front.response_id;
+      entry->queued_at = front.queued_at;
+      entry->bytes.swap(front.bytes);
+      front.bytes.clear();
+      lane.byte_size -= entry->bytes.size();
+      lane.head = (lane.head + 1) % lane.entries.size();
+      lane.count--;
+      queued_--;
+      return true;
+    }
+    StartRounds();
+  }
+}
+
+}  // namespace platzi
@@ -0,0 +1,156 @@
+#ifndef NATIVE_MESSENGER_PRIORITY_LANES_H_
+#define NATIVE_MESSENGER_PRIORITY_LANES_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "codec/typed_data.h"
+#include "messenger/channel_registry.h"
+
+namespace platzi {
+
+// The lane a channel's incoming messages wait in when a |BinaryMessenger|
+// has priority lanes, highest first.
+enum class ChannelPriority : uint8_t {
+  // Input and lifecycle, such as the engine's text input, key event,
+  // lifecycle and navigation channels, which the user waits on.
+  kInteractive,
+  kDefault,
+  // Uploads, downloads and streams of data, which can wait a frame.
+  kBulk,
+};
+
+constexpr size_t kChannelPriorityCount = 3;
+
+// The shares of the platform thread the lanes get when all of them are
+// busy. Each round of the scheduler, a lane may dispatch messages worth its
+// quantum, each costing its size plus |kMessageCost|, so that small
+// messages count too.
+struct PriorityLaneOptions {
+  static constexpr size_t kMessageCost = 256;
+
+  // Indexed by |ChannelPriority|.
+  size_t quantum[kChannelPriorityCount] = {64 * 1024, 16 * 1024, 4 * 1024};
+};
+
+// Counters of a lane since it was created or last reset.
+struct LaneStats {
+  uint64_t dispatched = 0;
+  // Time messages spent queued before dispatch, in total and at most.
+  std::chrono::steady_clock::duration total_delay{0};
+  std::chrono::steady_clock::duration max_delay{0};
+};
+
+// Queues of incoming messages, one per |ChannelPriority|, and the weighted
+// scheduler that picks which is dispatched next.
+//
+// The scheduler is deficit round robin, highest lane first: a lane gains
+// its quantum of credit once per round, and the highest lane with credit
+// for its oldest message goes next. A new round starts only when no lane
+// with messages has credit left, so under load each lane gets its share
+// and no lane starves, however busy the others. A lane that was empty gets
+// its credit for the round as soon as a message arrives, and with it
+// nothing above it queued, the message skips the queue: a keystroke that
+// arrives during a flood of bulk messages is dispatched at once.
+class PriorityLanes {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  struct Entry {
+    ChannelId channel = kNoChannel;
+    bool nil = false;
+    uint32_t response_id = 0;
+    Clock::time_point queued_at;
+    std::vector<uint8_t> bytes;
+  };
+
+  explicit PriorityLanes(const PriorityLaneOptions& options);
+  ~PriorityLanes();
+
+  PriorityLanes(const PriorityLanes&) = delete;
+  PriorityLanes& operator=(const PriorityLanes&) = delete;
+
+  bool empty() const { return queued_ == 0; }
+
+  // Messages and bytes waiting in |lane|.
+  size_t size(ChannelPriority lane) const { return LaneOf(lane).count; }
+  size_t byte_size(ChannelPriority lane) const {
+    return LaneOf(lane).byte_size;
+  }
+
+  const LaneStats& stats(ChannelPriority lane) const {
+    return LaneOf(lane).stats;
+  }
+  void ResetStats();
+
+  // Appends a copy of |message| to |lane|.
+  void Push(ChannelPriority lane,
+            ChannelId channel,
+            ByteSpan message,
+            uint32_t response_id,
+            Clock::time_point now);
+
+  // Removes the message to dispatch next into |entry|, whose bytes are
+  // swapped with the queued ones so that storage is reused, and counts its
+  // delay. Returns false if every lane is empty.
+  bool Pop(Entry* entry, Clock::time_point now);
+
+  // Removes the messages queued for |channel| and appends them to |taken|
+  // in the order they were queued, for when they can no longer be
+  // dispatched as they come up.
+  void TakeChannel(ChannelId channel, std::vector<Entry>* taken);
+
+  // Whether a message of |size| bytes for |lane| may be dispatched at
+  // once, without being queued: it would be next, as its lane and those
+  // above are empty and its lane has credit, which is charged.
+  bool DispatchNow(ChannelPriority lane, size_t size);
+
+ private:
+  struct Lane {
+    // A ring of |count| entries from |head|, as in |ChannelBuffer|.
+    std::vector<Entry> entries;
+    size_t head = 0;
+    size_t count = 0;
+    size_t byte_size = 0;
+    size_t quantum = 0;
+    size_t deficit = 0;
+    // The round the lane last gained credit in. Credit left from earlier
+    // rounds is not saved up while the lane is idle.
+    uint64_t round = 0;
+    LaneStats stats;
+  };
+
+  Lane& LaneOf(ChannelPriority lane) {
+    return lanes_[static_cast<size_t>(lane)];
+  }
+  const Lane& LaneOf(ChannelPriority lane) const {
+    return lanes_[static_cast<size_t>(lane)];
+  }
+
+  static size_t CostOf(size_t size) {
+    return size + PriorityLaneOptions::kMessageCost;
+  }
+
+  // Gives an empty |lane| its credit for the current round, unless it had
+  // it already.
+  void Credit(Lane* lane) {
+    if (lane->round != round_) {
+      lane->deficit = lane->quantum;
+      lane->round = round_;
+    }
+  }
+
+  // Starts as many rounds as it takes for some lane to afford its oldest
+  // message.
+  void StartRounds();
+
+  Lane lanes_[kChannelPriorityCount];
+  uint64_t round_ = 1;
+  size_t queued_ = 0;
+};
+
+}  // namespace platzi
+
+#endif  // NATIVE_MESSENGER_PRIORITY_LANES_H_
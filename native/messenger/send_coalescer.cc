@@ -0,0 +1,148 @@
+#include "messenger/send_coalescer.h"
+
+#include <utility>
+
+#include "codec/standard_writer.h"
+
+namespace platzi {
+
+namespace {
+
+// Room left in front of the elements of a batch for the list header: the
+// type byte and the longest size.
+constexpr size_t kBatchHeaderRoom = 6;
+
+// Where held bytes start. A vector that never held any may have no
+// storage, and an empty message must not come out nil.
+const uint8_t* DataOf(const std::vector<uint8_t>& bytes) {
+  static const uint8_t kEmpty = 0;
+  return bytes.empty() ? &kEmpty : bytes.data();
+}
+
+}  // namespace
+
+SendCoalescer::SendCoalescer(
+    BinaryMessenger* messenger,
+    std::function<void(Clock::duration)> schedule_flush,
+    Clock::duration interval)
+    : messenger_(messenger),
+      schedule_flush_(std::move(schedule_flush)),
+      interval_(interval) {}
+
+SendCoalescer::~SendCoalescer() {
+  Flush();
+}
+
+void SendCoalescer::SetPolicy(ChannelId channel,
+                              CoalescePolicy policy,
+                              MessageMerger merge) {
+  if (channel >= channels_.size()) {
+    if (policy == CoalescePolicy::kNone) {
+      return;
+    }
+    channels_.resize(channel + 1);
+  }
+  Flush(channel);
+  ChannelState& state = channels_[channel];
+  state.policy = policy;
+  state.merge = std::move(merge);
+}
+
+void SendCoalescer::Send(ChannelId channel,
+                         BinaryMessage message,
+                         BinaryReply callback) {
+  messages_received_++;
+  ChannelState* state =
+      channel < channels_.size() ? &channels_[channel] : nullptr;
+  if (state == nullptr || state->policy == CoalescePolicy::kNone ||
+      callback) {
+    Flush(channel);
+    messenger_->Send(channel, message, std::move(callback));
+    messages_sent_++;
+    return;
+  }
+  if (state->held == 0) {
+    holding_.push_back(channel);
+    if (holding_.size() == 1 && schedule_flush_) {
+      schedule_flush_(interval_);
+    }
+  }
+  switch (state->policy) {
+    case CoalescePolicy::kKeepLatest:
+      state->nil = message.data == nullptr;
+      state->bytes.assign(message.begin(), message.end());
+      break;
+    case CoalescePolicy::kMerge:
+      if (state->held == 0) {
+        state->nil = message.data == nullptr;
+        state->bytes.assign(message.begin(), message.end());
+        break;
+      }
+      state->merge(BinaryMessage{state->nil ? nullptr : DataOf(state->bytes),
+                                 state->bytes.size()},
+                   message, &scratch_);
+      state->nil = false;
+      state->bytes.swap(scratch_);
+      break;
+    case CoalescePolicy::kBatch: {
+      if (state->held == 0) {
+        state->nil = false;
+        state->bytes.assign(kBatchHeaderRoom, 0);
+      }
+      StandardWriter writer(&state->bytes);
+      if (message.data == nullptr) {
+        writer.WriteByte(static_cast<uint8_t>(StandardField::kNil));
+      } else {
+        writer.WriteByte(static_cast<uint8_t>(StandardField::kUInt8Data));
+        writer.WriteTypedData(TypedDataView::Of(message.data, message.size));
+      }
+      break;
+    }
+    case CoalescePolicy::kNone:
+      break;
+  }
+  state->held++;
+}
+
+void SendCoalescer::FlushChannel(ChannelId channel, ChannelState* state) {
+  const uint8_t* data = state->nil ? nullptr : DataOf(state->bytes);
+  size_t size = state->bytes.size();
+  if (state->policy == CoalescePolicy::kBatch) {
+    // The header goes right in front of the elements, which need no
+    // alignment as Uint8Lists.
+    size_t header = 1 + EncodedSizeOfSize(state->held);
+    size_t start = kBatchHeaderRoom - header;
+    StandardWriter writer(state->bytes.data() + start, header);
+    writer.WriteByte(static_cast<uint8_t>(StandardField::kList));
+    writer.WriteSize(state->held);
+    data += start;
+    size -= start;
+  }
+  state->held = 0;
+  messenger_->Send(channel, BinaryMessage{data, size});
+  messages_sent_++;
+  state->bytes.clear();
+}
+
+void SendCoalescer::Flush(ChannelId channel) {
+  if (channel >= channels_.size() || channels_[channel].held == 0) {
+    return;
+  }
+  for (size_t i = 0; i < holding_.size(); i++) {
+    if (holding_[i] == channel) {
+      holding_.erase(holding_.begin() + i);
+      break;
+    }
+  }
+  FlushChannel(channel, &channels_[channel]);
+}
+
+void SendCoalescer::Flush() {
+  for (size_t i = 0; i < holding_.size(); i++) {
+    ChannelId channel = holding_[i];
+    FlushChannel(channel, &channels_[channel]);
+  }
+  holding_.clear();
+}
+
+}  // namespace platzi
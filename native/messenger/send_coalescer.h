@@ -0,0 +1,121 @@
+#ifndef NATIVE_MESSENGER_SEND_COALESCER_H_
+#define NATIVE_MESSENGER_SEND_COALESCER_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "messenger/binary_messenger.h"
+
+namespace platzi {
+
+// What a |SendCoalescer| does with the messages sent on a channel between
+// two flushes.
+enum class CoalescePolicy : uint8_t {
+  // Sends every message at once, as if there were no coalescer.
+  kNone,
+  // Sends only the last message, for channels whose messages are complete
+  // states, such as a location or a progress fraction.
+  kKeepLatest,
+  // Folds every message into the pending one with a |MessageMerger|.
+  kMerge,
+  // Sends all of them as one message: a standard-codec list with each
+  // message as a Uint8List, or null for nil ones. Dart handlers of the
+  // channel decode the list, then each message with the channel's codec.
+  kBatch,
+};
+
+// Replaces the contents of |merged| with the combination of the pending
+// message |pending| and the newer |message|, as a sum of counters or the
+// union of two sets of changes would be.
+using MessageMerger = std::function<void(BinaryMessage pending,
+                                         BinaryMessage message,
+                                         std::vector<uint8_t>* merged)>;
+
+// Coalesces the messages sent to the peer on high-frequency channels, so
+// that a producer sending hundreds of times between two frames costs the
+// Dart side one message per frame and channel instead of hundreds.
+//
+// Channels opt in with |SetPolicy|; the rest go straight to the messenger.
+// Held messages go out when |Flush| is called, once per vsync, or else at
+// most |interval| after the first of them: the coalescer asks for a flush
+// with |schedule_flush| whenever it starts holding messages. Channels are
+// flushed in the order they started holding messages.
+//
+// Messages that expect a reply are never coalesced; they go out right after
+// whatever their channel holds, in order. Platform thread only, like the
+// messenger, whose transport must not call back into the coalescer.
+class SendCoalescer {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  static constexpr Clock::duration kDefaultInterval =
+      std::chrono::milliseconds(16);
+
+  // |schedule_flush| must make the platform thread call |Flush| after the
+  // given delay, as dispatch_after would. It may be empty if |Flush| is
+  // called on every vsync instead. |messenger| must outlive the coalescer.
+  SendCoalescer(BinaryMessenger* messenger,
+                std::function<void(Clock::duration)> schedule_flush = nullptr,
+                Clock::duration interval = kDefaultInterval);
+
+  // Sends whatever is held.
+  ~SendCoalescer();
+
+  SendCoalescer(const SendCoalescer&) = delete;
+  SendCoalescer& operator=(const SendCoalescer&) = delete;
+
+  // Sets how messages on |channel| are coalesced. |merge| is required for
+  // |CoalescePolicy::kMerge|. Sends what the channel holds first.
+  void SetPolicy(ChannelId channel,
+                 CoalescePolicy policy,
+                 MessageMerger merge = nullptr);
+
+  // Sends |message| on |channel|, or holds it until the next flush.
+  void Send(ChannelId channel,
+            BinaryMessage message,
+            BinaryReply callback = nullptr);
+
+  // Sends what every channel holds.
+  void Flush();
+
+  // Sends what |channel| holds, if anything.
+  void Flush(ChannelId channel);
+
+  // Messages passed to |Send|, and messages the messenger sent for them.
+  uint64_t messages_received() const { return messages_received_; }
+  uint64_t messages_sent() const { return messages_sent_; }
+
+ private:
+  struct ChannelState {
+    CoalescePolicy policy = CoalescePolicy::kNone;
+    MessageMerger merge;
+    // Messages held since the last flush.
+    uint32_t held = 0;
+    // The latest or merged message, or room for the list header followed
+    // by the batch elements, encoded one after another.
+    bool nil = false;
+    std::vector<uint8_t> bytes;
+  };
+
+  // Sends what |state| of |channel| holds.
+  void FlushChannel(ChannelId channel, ChannelState* state);
+
+  BinaryMessenger* messenger_;
+  std::function<void(Clock::duration)> schedule_flush_;
+  Clock::duration interval_;
+  // Indexed by channel ID; channels past the end use |kNone|.
+  std::vector<ChannelState> channels_;
+  // Channels holding messages, in the order they started to.
+  std::vector<ChannelId> holding_;
+  // Scratch space for merges.
+  std::vector<uint8_t> scratch_;
+  uint64_t messages_received_ = 0;
+  uint64_t messages_sent_ = 0;
+};
+
+}  // namespace platzi
+
+#endif  // NATIVE_MESSENGER_SEND_COALESCER_H_
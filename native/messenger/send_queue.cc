@@ -0,0 +1,82 @@
+#include "messenger/send_queue.h"
+
+#include <cstring>
+#include <new>
+#include <utility>
+
+namespace platzi {
+
+// A queued message, with its bytes in the same allocation.
+struct SendQueue::Node : MpscNode {
+  ChannelId channel;
+  bool nil;
+  size_t size;
+  BinaryReply callback;
+
+  uint8_t* bytes() { return reinterpret_cast<uint8_t*>(this + 1); }
+
+  static Node* New(ChannelId channel,
+                   BinaryMessage message,
+                   BinaryReply callback) {
+    void* memory = ::operator new(sizeof(Node) + message.size);
+    Node* node = new (memory) Node();
+    node->channel = channel;
+    node->nil = message.data == nullptr;
+    node->size = message.size;
+    node->callback = std::move(callback);
+    if (message.size > 0) {
+      std::memcpy(node->bytes(), message.data, message.size);
+    }
+    return node;
+  }
+
+  static void Delete(Node* node) {
+    node->~Node();
+    ::operator delete(node);
+  }
+};
+
+SendQueue::SendQueue(BinaryMessenger* messenger,
+                     std::function<void()> schedule_drain)
+    : messenger_(messenger), schedule_drain_(std::move(schedule_drain)) {}
+
+SendQueue::~SendQueue() {
+  while (MpscNode* node = queue_.Pop()) {
+    Node::Delete(static_cast<Node*>(node));
+  }
+}
+
+void SendQueue::Send(ChannelId channel,
+                     BinaryMessage message,
+                     BinaryReply callback) {
+  queue_.Push(Node::New(channel, message, std::move(callback)));
+  ScheduleDrain();
+}
+
+void SendQueue::ScheduleDrain() {
+  // Pairs with the exchange in |Drain|: whichever producer sets the flag
+  // after a drain has started wakes the platform thread again, so a node
+  // that drain could not see yet is never stranded.
+  if (!drain_scheduled_.exchange(true, std::memory_order_acq_rel)) {
+    schedule_drain_();
+  }
+}
+
+size_t SendQueue::Drain(size_t limit) {
+  drain_scheduled_.exchange(false, std::memory_order_acq_rel);
+  size_t sent = 0;
+  while (sent < limit) {
+    Node* node = static_cast<Node*>(queue_.Pop());
+    if (node == nullptr) {
+      return sent;
+    }
+    BinaryMessage message{node->nil ? nullptr : node->bytes(), node->size};
+    messenger_->Send(node->channel, message, std::move(node->callback));
+    Node::Delete(node);
+    sent++;
+  }
+  ScheduleDrain();
+  return sent;
+}
+
+}  // namespace platzi
@@ -0,0 +1,73 @@
+#ifndef NATIVE_MESSENGER_SEND_QUEUE_H_
+#define NATIVE_MESSENGER_SEND_QUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include "messenger/binary_messenger.h"
+#include "messenger/mpsc_queue.h"
+
+namespace platzi {
+
+// Sends messages through a |BinaryMessenger| from any thread, such as the
+// threads of sensors and decoders, without a hop through a locked dispatch
+// queue per message.
+//
+// |Send| copies the message into a node of an |MpscQueue|, so producers
+// never block on one another or on the platform thread. The platform thread
+// sends the queued messages in batches from |Drain|, which |schedule_drain|
+// arranges for: it is called when the queue goes from drained to not, so
+// a burst of messages costs one wakeup however long it is.
+//
+// Messages from one thread are sent in the order it sent them; messages
+// from different threads interleave in some order consistent with that.
+// Reply callbacks run on the platform thread.
+class SendQueue {
+ public:
+  // |schedule_drain| is called on producer threads, and must make the
+  // platform thread call |Drain| soon, as dispatch_async to the main queue
+  // or a write to an eventfd the platform thread polls would. It may be
+  // called while a drain is pending or running, and must not call |Send|.
+  //
+  // |messenger| must outlive the queue, and the queue every producer.
+  SendQueue(BinaryMessenger* messenger, std::function<void()> schedule_drain);
+
+  // Frees the messages still queued without sending them. Platform thread.
+  ~SendQueue();
+
+  SendQueue(const SendQueue&) = delete;
+  SendQueue& operator=(const SendQueue&) = delete;
+
+  // Queues |message| for |channel|, and |callback|, if any, for its reply.
+  // Any thread. Channel IDs must be interned beforehand, on the platform
+  // thread.
+  void Send(ChannelId channel,
+            BinaryMessage message,
+            BinaryReply callback = nullptr);
+
+  // Sends up to |limit| queued messages, oldest first, and returns how many
+  // were sent. Schedules another drain if it stops at the limit, so that a
+  // flood of messages cannot hold the platform thread. Platform thread.
+  size_t Drain(size_t limit = kDefaultDrainLimit);
+
+  static constexpr size_t kDefaultDrainLimit = 1024;
+
+ private:
+  struct Node;
+
+  // Calls |schedule_drain_| unless a drain is scheduled already.
+  void ScheduleDrain();
+
+  BinaryMessenger* messenger_;
+  std::function<void()> schedule_drain_;
+  MpscQueue queue_;
+  // Set from the moment a drain is scheduled until it starts. A producer
+  // that finds it set leaves waking the platform thread to whoever set it.
+  std::atomic<bool> drain_scheduled_{false};
+};
+
+}  // namespace platzi
+
+#endif  // NATIVE_MESSENGER_SEND_QUEUE_H_
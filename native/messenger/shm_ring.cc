@@ -0,0 +1,168 @@
+#include "messenger/shm_ring.h"
+
+#include <cstring>
+#include <new>
+
+namespace platzi {
+
+namespace {
+
+enum FrameKind : uint32_t {
+  kRecordFrame = 1,
+  kWrapFrame = 2,
+};
+
+struct Frame {
+  // Including the frame itself; a multiple of 8.
+  uint32_t size;
+  uint32_t kind;
+};
+
+inline size_t RoundUp8(size_t size) {
+  return (size + 7) & ~size_t{7};
+}
+
+}  // namespace
+
+// Positions count bytes since the ring was created, so that they never
+// wrap in practice and full and empty rings differ.
+struct ShmRing::Header {
+  alignas(64) std::atomic<uint64_t> head;
+  std::atomic<uint32_t> producer_waiting;
+  alignas(64) std::atomic<uint64_t> tail;
+  std::atomic<uint32_t> consumer_waiting;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free &&
+                  std::atomic<uint32_t>::is_always_lock_free,
+              "Atomics shared between processes must be lock-free");
+
+size_t ShmRing::RegionSize(size_t capacity) {
+  return RoundUp8(sizeof(Header)) + capacity;
+}
+
+void ShmRing::Initialize(void* region) {
+  Header* header = new (region) Header();
+  // A consumer that has not polled yet is as good as asleep: the first
+  // record wakes it.
+  header->consumer_waiting.store(1, std::memory_order_relaxed);
+}
+
+ShmRing::ShmRing(void* region, size_t capacity)
+    : header_(static_cast<Header*>(region)),
+      data_(static_cast<uint8_t*>(region) + RoundUp8(sizeof(Header))),
+      capacity_(capacity) {
+  // Either side may start after the other has made progress.
+  position_ = header_->tail.load(std::memory_order_acquire);
+  next_position_ = position_;
+}
+
+bool ShmRing::HasRoom(size_t size) const {
+  size_t need = kFrameSize + RoundUp8(size);
+  // Sequentially consistent for |PrepareToWaitForRoom|.
+  uint64_t tail = header_->tail.load(std::memory_order_seq_cst);
+  size_t used = static_cast<size_t>(position_ - tail);
+  size_t offset = position_ & (capacity_ - 1);
+  size_t contiguous = capacity_ - offset;
+  size_t total = need <= contiguous ? need : contiguous + need;
+  return capacity_ - used >= total;
+}
+
+uint8_t* ShmRing::Reserve(size_t size) {
+  if (size > max_record_size()) {
+    return nullptr;
+  }
+  position_ = header_->head.load(std::memory_order_relaxed);
+  if (!HasRoom(size)) {
+    return nullptr;
+  }
+  size_t need = kFrameSize + RoundUp8(size);
+  size_t offset = position_ & (capacity_ - 1);
+  size_t contiguous = capacity_ - offset;
+  next_position_ = position_;
+  if (need > contiguous) {
+    Frame wrap = {static_cast<uint32_t>(contiguous), kWrapFrame};
+    std::memcpy(data_ + offset, &wrap, sizeof(wrap));
+    next_position_ += contiguous;
+    offset = 0;
+  }
+  Frame frame = {static_cast<uint32_t>(need), kRecordFrame};
+  std::memcpy(data_ + offset, &frame, sizeof(frame));
+  next_position_ += need;
+  return data_ + offset + kFrameSize;
+}
+
+void ShmRing::Commit() {
+  // Sequentially consistent, like the wait flags, so that a consumer
+  // announcing it waits either sees the record or is seen waiting.
+  header_->head.store(next_position_, std::memory_order_seq_cst);
+}
+
+bool ShmRing::PrepareToWaitForRoom(size_t size) {
+  position_ = header_->head.load(std::memory_order_relaxed);
+  header_->producer_waiting.store(1, std::memory_order_seq_cst);
+  if (HasRoom(size)) {
+    header_->producer_waiting.store(0, std::memory_order_relaxed);
+    return false;
+  }
+  return true;
+}
+
+bool ShmRing::TakeConsumerWaiter() {
+  return header_->consumer_waiting.load(std::memory_order_seq_cst) != 0 &&
+         header_->consumer_waiting.exchange(0, std::memory_order_seq_cst) !=
+             0;
+}
+
+const uint8_t* ShmRing::Peek(size_t* size) {
+  if (corrupt_) {
+    return nullptr;
+  }
+  uint64_t head = header_->head.load(std::memory_order_acquire);
+  next_position_ = position_;
+  while (next_position_ != head) {
+    size_t available = static_cast<size_t>(head - next_position_);
+    size_t offset = next_position_ & (capacity_ - 1);
+    Frame frame;
+    std::memcpy(&frame, data_ + offset, sizeof(frame));
+    if (frame.size < kFrameSize || frame.size % 8 != 0 ||
+        frame.size > available || frame.size > capacity_ - offset) {
+      corrupt_ = true;
+      return nullptr;
+    }
+    if (frame.kind == kWrapFrame) {
+      next_position_ += frame.size;
+      continue;
+    }
+    if (frame.kind != kRecordFrame) {
+      corrupt_ = true;
+      return nullptr;
+    }
+    *size = frame.size - kFrameSize;
+    next_position_ += frame.size;
+    return data_ + offset + kFrameSize;
+  }
+  return nullptr;
+}
+
+void ShmRing::Release() {
+  position_ = next_position_;
+  header_->tail.store(position_, std::memory_order_seq_cst);
+}
+
+bool ShmRing::PrepareToWaitForRecords() {
+  header_->consumer_waiting.store(1, std::memory_order_seq_cst);
+  if (header_->head.load(std::memory_order_seq_cst) != position_) {
+    header_->consumer_waiting.store(0, std::memory_order_relaxed);
+    return false;
+  }
+  return true;
+}
+
+bool ShmRing::TakeProducerWaiter() {
+  return header_->producer_waiting.load(std::memory_order_seq_cst) != 0 &&
+         header_->producer_waiting.exchange(0, std::memory_order_seq_cst) !=
+             0;
+}
+
+}  // namespace platzi
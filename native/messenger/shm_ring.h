@@ -0,0 +1,98 @@
+#ifndef NATIVE_MESSENGER_SHM_RING_H_
+#define NATIVE_MESSENGER_SHM_RING_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace platzi {
+
+// A single-producer single-consumer ring of variable-size records in memory
+// shared by two processes, one direction of a |ShmTransport|.
+//
+// The region starts with a header of positions and wait flags, followed by
+// |capacity| bytes of records. Every record is contiguous, so the consumer
+// reads it in place: a record that would straddle the end of the ring is
+// preceded by a marker that skips to the start. Records are 8-byte aligned
+// and at most half the capacity, which guarantees they fit once the ring
+// drains.
+//
+// Neither side trusts the other: a record header the consumer cannot make
+// sense of marks the ring corrupt rather than sending it out of bounds.
+//
+// Wakeups are left to the caller, but the ring tells it when one is due:
+// a side that finds nothing to do announces it is about to sleep with
+// |PrepareToWait...|, and the other side, after making progress, learns
+// from |Take...Waiter| whether it must wake it. A side that is busy is
+// never woken, so steady traffic costs no system calls.
+class ShmRing {
+ public:
+  // Bytes of the region for a ring of |capacity| bytes.
+  static size_t RegionSize(size_t capacity);
+
+  // Prepares a zeroed region for use. Only one side calls it, before the
+  // other maps the region.
+  static void Initialize(void* region);
+
+  // Views the ring in |region|. |capacity| must be a power of two no less
+  // than 4096, and the same on both sides.
+  ShmRing(void* region, size_t capacity);
+
+  ShmRing(const ShmRing&) = delete;
+  ShmRing& operator=(const ShmRing&) = delete;
+
+  size_t capacity() const { return capacity_; }
+
+  // The largest record |Reserve| accepts.
+  size_t max_record_size() const { return capacity_ / 2 - kFrameSize; }
+
+  // Producer: returns room for a record of |size| bytes, or nullptr if the
+  // ring lacks it for now. Nothing is visible to the consumer until
+  // |Commit|.
+  uint8_t* Reserve(size_t size);
+  void Commit();
+
+  // Producer: announces it waits for room for a record of |size| bytes.
+  // Returns false, and withdraws, if there is room already.
+  bool PrepareToWaitForRoom(size_t size);
+
+  // Producer: whether the consumer waits for records, and must be woken.
+  bool TakeConsumerWaiter();
+
+  // Consumer: returns the oldest record and its size, or nullptr if there
+  // is none or the ring is corrupt.
+  const uint8_t* Peek(size_t* size);
+
+  // Consumer: frees the record |Peek| returned.
+  void Release();
+
+  // Consumer: announces it waits for records. Returns false, and
+  // withdraws, if there are some already.
+  bool PrepareToWaitForRecords();
+
+  // Consumer: whether the producer waits for room, and must be woken.
+  bool TakeProducerWaiter();
+
+  bool corrupt() const { return corrupt_; }
+
+ private:
+  struct Header;
+
+  // Each record is preceded by its size and kind.
+  static constexpr size_t kFrameSize = 8;
+
+  bool HasRoom(size_t size) const;
+
+  Header* header_;
+  uint8_t* data_;
+  size_t capacity_;
+  // The producer's next write position and where |Commit| moves it, or the
+  // consumer's read position and where |Release| moves it.
+  uint64_t position_ = 0;
+  uint64_t next_position_ = 0;
+  bool corrupt_ = false;
+};
+
+}  // namespace platzi
+
+#endif  // NATIVE_MESSENGER_SHM_RING_H_
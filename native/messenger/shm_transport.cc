@@ -0,0 +1,439 @@
+#include "messenger/shm_transport.h"
+
+#include <fcntl.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+
+namespace platzi {
+
+namespace {
+
+enum RecordKind : uint8_t {
+  kMessageRecord = 1,
+  kReplyRecord = 2,
+};
+
+enum RecordFlags : uint8_t {
+  kNilRecord = 1 << 0,
+  // The channel name follows the header: the first message on a channel.
+  kNamedRecord = 1 << 1,
+};
+
+// Heads every record. The message follows the name, if any, at the next
+// multiple of 8, so that typed data in it is aligned in place.
+struct RecordHeader {
+  uint8_t kind;
+  uint8_t flags;
+  uint16_t name_size;
+  // The sender's ID; zero for replies.
+  uint32_t channel;
+  uint32_t response_id;
+  uint32_t message_size;
+};
+
+static_assert(sizeof(RecordHeader) == 16, "Record headers are 16 bytes");
+
+// Bounds the table of peer channels a corrupt record can make us allocate.
+constexpr uint32_t kMaxPeerChannels = 1 << 20;
+
+inline size_t RoundUp8(size_t size) {
+  return (size + 7) & ~size_t{7};
+}
+
+inline size_t RecordSize(size_t name_size, size_t message_size) {
+  return sizeof(RecordHeader) + RoundUp8(name_size) + message_size;
+}
+
+// Each ring starts on its own page.
+size_t RingOffset(size_t ring_capacity) {
+  size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+  return (ShmRing::RegionSize(ring_capacity) + page - 1) & ~(page - 1);
+}
+
+bool IsValidCapacity(size_t capacity) {
+  return capacity >= 4096 && (capacity & (capacity - 1)) == 0 &&
+         capacity <= (size_t{1} << 31);
+}
+
+void CloseFd(int* fd) {
+  if (*fd >= 0) {
+    ::close(*fd);
+    *fd = -1;
+  }
+}
+
+}  // namespace
+
+bool ShmTransport::CreateConnection(size_t ring_capacity,
+                                    ShmEndpoint* first,
+                                    ShmEndpoint* second) {
+  if (!IsValidCapacity(ring_capacity)) {
+    return false;
+  }
+  size_t size = 2 * RingOffset(ring_capacity);
+  ShmEndpoint a;
+  ShmEndpoint b;
+  a.ring_capacity = b.ring_capacity = ring_capacity;
+  b.first = false;
+  a.memory_fd = ::memfd_create("platzi-messenger", MFD_CLOEXEC);
+  a.wake_fd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  b.wake_fd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  bool ok = a.memory_fd >= 0 && a.wake_fd >= 0 && b.wake_fd >= 0 &&
+            ::ftruncate(a.memory_fd, static_cast<off_t>(size)) == 0;
+  if (ok) {
+    b.memory_fd = ::fcntl(a.memory_fd, F_DUPFD_CLOEXEC, 0);
+    a.peer_wake_fd = ::fcntl(b.wake_fd, F_DUPFD_CLOEXEC, 0);
+    b.peer_wake_fd = ::fcntl(a.wake_fd, F_DUPFD_CLOEXEC, 0);
+    ok = b.memory_fd >= 0 && a.peer_wake_fd >= 0 && b.peer_wake_fd >= 0;
+  }
+  void* mapping = MAP_FAILED;
+  if (ok) {
+    mapping = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                     a.memory_fd, 0);
+    ok = mapping != MAP_FAILED;
+  }
+  if (!ok) {
+    CloseEndpoint(&a);
+    CloseEndpoint(&b);
+    return false;
+  }
+  uint8_t* base = static_cast<uint8_t*>(mapping);
+  ShmRing::Initialize(base);
+  ShmRing::Initialize(base + RingOffset(ring_capacity));
+  ::munmap(mapping, size);
+  *first = a;
+  *second = b;
+  return true;
+}
+
+void ShmTransport::CloseEndpoint(ShmEndpoint* endpoint) {
+  CloseFd(&endpoint->memory_fd);
+  CloseFd(&endpoint->wake_fd);
+  CloseFd(&endpoint->peer_wake_fd);
+}
+
+ShmTransport::ShmTransport() = default;
+
+ShmTransport::~ShmTransport() {
+  Close();
+}
+
+bool ShmTransport::Open(ShmEndpoint* endpoint) {
+  Close();
+  size_t capacity = endpoint->ring_capacity;
+  size_t offset = RingOffset(capacity);
+  struct stat info;
+  if (!IsValidCapacity(capacity) || endpoint->memory_fd < 0 ||
+      endpoint->wake_fd < 0 || endpoint->peer_wake_fd < 0 ||
+      ::fstat(endpoint->memory_fd, &info) != 0 ||
+      static_cast<size_t>(info.st_size) < 2 * offset) {
+    CloseEndpoint(endpoint);
+    return false;
+  }
+  void* mapping = ::mmap(nullptr, 2 * offset, PROT_READ | PROT_WRITE,
+                         MAP_SHARED, endpoint->memory_fd, 0);
+  // The mapping keeps the memory alive; the descriptor is no longer needed.
+  CloseFd(&endpoint->memory_fd);
+  if (mapping == MAP_FAILED) {
+    CloseEndpoint(endpoint);
+    return false;
+  }
+  mapping_ = mapping;
+  mapping_size_ = 2 * offset;
+  wake_fd_ = endpoint->wake_fd;
+  peer_wake_fd_ = endpoint->peer_wake_fd;
+  endpoint->wake_fd = -1;
+  endpoint->peer_wake_fd = -1;
+  uint8_t* rings[2] = {static_cast<uint8_t*>(mapping),
+                       static_cast<uint8_t*>(mapping) + offset};
+  outbound_ = std::make_unique<ShmRing>(rings[endpoint->first ? 0 : 1],
+                                        capacity);
+  inbound_ = std::make_unique<ShmRing>(rings[endpoint->first ? 1 : 0],
+                                       capacity);
+  return true;
+}
+
+void ShmTransport::Close() {
+  outbound_.reset();
+  inbound_.reset();
+  if (mapping_ != nullptr) {
+    ::munmap(mapping_, mapping_size_);
+    mapping_ = nullptr;
+    mapping_size_ = 0;
+  }
+  CloseFd(&wake_fd_);
+  CloseFd(&peer_wake_fd_);
+  announced_.clear();
+  peer_channels_.clear();
+  backlog_.clear();
+  spare_records_.clear();
+  spare_bytes_ = 0;
+  writing_backlog_ = false;
+  refused_replies_.clear();
+  receiving_blocked_ = false;
+  failed_ = false;
+}
+
+size_t ShmTransport::max_message_size() const {
+  return outbound_ == nullptr
+             ? 0
+             : outbound_->max_record_size() - sizeof(RecordHeader);
+}
+
+void ShmTransport::Signal(int fd) {
+  uint64_t one = 1;
+  // Fails only if the counter would overflow, when the peer is woken
+  // anyway.
+  if (::write(fd, &one, sizeof(one)) == sizeof(one) && fd == peer_wake_fd_) {
+    wakeups_++;
+  }
+}
+
+uint8_t* ShmTransport::BeginRecord(uint8_t kind,
+                                   ChannelId channel,
+                                   std::string_view name,
+                                   BinaryMessage message,
+                                   uint32_t response_id) {
+  bool named = kind == kMessageRecord && !IsAnnounced(channel);
+  size_t name_size = named ? name.size() : 0;
+  if (outbound_ == nullptr || name_size > UINT16_MAX ||
+      message.size > max_message_size() ||
+      RecordSize(name_size, message.size) > outbound_->max_record_size()) {
+    return nullptr;
+  }
+  size_t size = RecordSize(name_size, message.size);
+  uint8_t* record = backlog_.empty() ? outbound_->Reserve(size) : nullptr;
+  writing_backlog_ = record == nullptr;
+  if (writing_backlog_) {
+    if (spare_records_.empty()) {
+      backlog_.emplace_back(size);
+    } else {
+      // Keeps its old size, so that only growth is zeroed.
+      spare_bytes_ -= spare_records_.back().capacity();
+      backlog_.push_back(std::move(spare_records_.back()));
+      spare_records_.pop_back();
+      backlog_.back().resize(size);
+    }
+    record = backlog_.back().data();
+  }
+  RecordHeader header;
+  header.kind = kind;
+  header.flags =
+      static_cast<uint8_t>((message.data == nullptr ? kNilRecord : 0) |
+                           (named ? kNamedRecord : 0));
+  header.name_size = static_cast<uint16_t>(name_size);
+  header.channel = kind == kMessageRecord ? channel : 0;
+  header.response_id = response_id;
+  header.message_size = static_cast<uint32_t>(message.size);
+  std::memcpy(record, &header, sizeof(header));
+  if (name_size > 0) {
+    std::memcpy(record + sizeof(header), name.data(), name_size);
+  }
+  if (named) {
+    if (channel >= announced_.size()) {
+      announced_.resize(channel + 1);
+    }
+    announced_[channel] = true;
+  }
+  return record + sizeof(header) + RoundUp8(name_size);
+}
+
+void ShmTransport::EndRecord() {
+  if (writing_backlog_) {
+    writing_backlog_ = false;
+    // Asks to be woken once the peer frees room, unless it has already.
+    FlushBacklog();
+    return;
+  }
+  outbound_->Commit();
+  if (outbound_->TakeConsumerWaiter()) {
+    Signal(peer_wake_fd_);
+  }
+}
+
+bool ShmTransport::SendRecord(uint8_t kind,
+                              ChannelId channel,
+                              std::string_view name,
+                              BinaryMessage message,
+                              uint32_t response_id) {
+  uint8_t* payload = BeginRecord(kind, channel, name, message, response_id);
+  if (payload == nullptr) {
+    dropped_++;
+    return false;
+  }
+  if (message.size > 0) {
+    std::memcpy(payload, message.data, message.size);
+  }
+  EndRecord();
+  return true;
+}
+
+void ShmTransport::SendMessage(ChannelId channel,
+                               std::string_view name,
+                               BinaryMessage message,
+                               uint32_t response_id) {
+  if (!SendRecord(kMessageRecord, channel, name, message, response_id) &&
+      response_id != 0 && is_open()) {
+    refused_replies_.push_back(response_id);
+    Signal(wake_fd_);
+  }
+}
+
+void ShmTransport::SendReply(uint32_t response_id, BinaryMessage reply) {
+  SendRecord(kReplyRecord, 0, std::string_view(), reply, response_id);
+}
+
+uint8_t* ShmTransport::ReserveMessage(ChannelId channel, size_t size) {
+  if (messenger_ == nullptr || size > UINT32_MAX) {
+    return nullptr;
+  }
+  // A non-null pointer, as the message is not nil.
+  static const uint8_t kNotNil = 0;
+  return BeginRecord(kMessageRecord, channel,
+                     messenger_->channels().NameOf(channel),
+                     BinaryMessage{&kNotNil, size}, 0);
+}
+
+void ShmTransport::CommitMessage() {
+  EndRecord();
+}
+
+void ShmTransport::ResumeReceiving() {
+  receiving_blocked_ = false;
+  // Comes back from the run loop rather than from within the messenger.
+  if (is_open()) {
+    Signal(wake_fd_);
+  }
+}
+
+void ShmTransport::FlushBacklog() {
+  while (!backlog_.empty()) {
+    const std::vector<uint8_t>& record = backlog_.front();
+    uint8_t* room = outbound_->Reserve(record.size());
+    if (room == nullptr) {
+      if (outbound_->PrepareToWaitForRoom(record.size())) {
+        return;
+      }
+      continue;
+    }
+    std::memcpy(room, record.data(), record.size());
+    outbound_->Commit();
+    // Spares are kept up to the size of the ring, which bounds how much
+    // the backlog usually needs at once.
+    if (spare_bytes_ + record.capacity() <= outbound_->capacity()) {
+      spare_bytes_ += record.capacity();
+      spare_records_.push_back(std::move(backlog_.front()));
+    }
+    backlog_.pop_front();
+    if (outbound_->TakeConsumerWaiter()) {
+      Signal(peer_wake_fd_);
+    }
+  }
+}
+
+bool ShmTransport::Poll(size_t limit) {
+  if (!is_open() || failed_) {
+    return false;
+  }
+  // Clears the eventfd; whatever signaled it is handled below.
+  uint64_t signals;
+  if (::read(wake_fd_, &signals, sizeof(signals)) < 0) {
+    signals = 0;
+  }
+  std::vector<uint32_t> refused;
+  refused.swap(refused_replies_);
+  for (uint32_t response_id : refused) {
+    messenger_->HandleReply(response_id, BinaryMessage());
+  }
+  FlushBacklog();
+  size_t handled = 0;
+  while (!receiving_blocked_) {
+    if (handled == limit) {
+      Signal(wake_fd_);
+      break;
+    }
+    size_t size;
+    const uint8_t* record = inbound_->Peek(&size);
+    if (record == nullptr) {
+      if (inbound_->corrupt()) {
+        failed_ = true;
+        return false;
+      }
+      if (inbound_->PrepareToWaitForRecords()) {
+        break;
+      }
+      continue;
+    }
+    if (!HandleRecord(record, size)) {
+      if (failed_) {
+        return false;
+      }
+      // Peeked again once the messenger resumes receiving.
+      receiving_blocked_ = true;
+      break;
+    }
+    // The handler is done with the bytes, which the peer may now reuse.
+    inbound_->Release();
+    handled++;
+    if (inbound_->TakeProducerWaiter()) {
+      Signal(peer_wake_fd_);
+    }
+  }
+  return true;
+}
+
+bool ShmTransport::HandleRecord(const uint8_t* record, size_t size) {
+  RecordHeader header;
+  if (size < sizeof(header)) {
+    failed_ = true;
+    return false;
+  }
+  std::memcpy(&header, record, sizeof(header));
+  size_t name_size = (header.flags & kNamedRecord) ? header.name_size : 0;
+  size_t offset = sizeof(header) + RoundUp8(name_size);
+  if (offset > size || header.message_size > size - offset) {
+    failed_ = true;
+    return false;
+  }
+  BinaryMessage message{
+      (header.flags & kNilRecord) ? nullptr : record + offset,
+      (header.flags & kNilRecord) ? 0 : header.message_size};
+  if (header.kind == kReplyRecord) {
+    messenger_->HandleReply(header.response_id, message);
+    return true;
+  }
+  if (header.kind != kMessageRecord || header.channel >= kMaxPeerChannels) {
+    failed_ = true;
+    return false;
+  }
+  if (header.channel >= peer_channels_.size()) {
+    peer_channels_.resize(header.channel + 1);
+  }
+  PeerChannel& peer = peer_channels_[header.channel];
+  if (header.flags & kNamedRecord) {
+    peer.name.assign(reinterpret_cast<const char*>(record + sizeof(header)),
+                     name_size);
+    peer.local = kNoChannel;
+    peer.announced = true;
+  }
+  if (!peer.announced) {
+    failed_ = true;
+    return false;
+  }
+  if (peer.local == kNoChannel) {
+    peer.local = messenger_->channels().Find(peer.name);
+  }
+  if (peer.local != kNoChannel) {
+    return messenger_->HandleMessage(peer.local, message, header.response_id);
+  }
+  // Not interned here yet: the messenger decides whether it should be, and
+  // the ID is looked up again for the next message.
+  return messenger_->HandleMessage(std::string_view(peer.name), message,
+                                   header.response_id);
+}
+
+}  // namespace platzi
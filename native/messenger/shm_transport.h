@@ -0,0 +1,199 @@
+#ifndef NATIVE_MESSENGER_SHM_TRANSPORT_H_
+#define NATIVE_MESSENGER_SHM_TRANSPORT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "messenger/binary_messenger.h"
+#include "messenger/shm_ring.h"
+
+namespace platzi {
+
+// The descriptors one side of a shared-memory connection needs, from
+// |ShmTransport::CreateConnection|: the memfd holding both rings, the
+// eventfd this side sleeps on, and the peer's. The two sides get distinct
+// descriptors, so each can be handed over and closed on its own.
+struct ShmEndpoint {
+  int memory_fd = -1;
+  int wake_fd = -1;
+  int peer_wake_fd = -1;
+  size_t ring_capacity = 0;
+  // Which side of the connection this is, and so which ring it writes.
+  bool first = true;
+};
+
+// A |MessengerTransport| to a |BinaryMessenger| in another process on the
+// same Linux host, through two |ShmRing|s in a memfd, one per direction.
+//
+// Messages and replies are written straight into shared memory and handed
+// to the peer's messenger in place, for the duration of its handler, with
+// no serialization beyond a 16-byte record header and no copy on the
+// receiving side. |ReserveMessage| also saves the sending side's copy of
+// large payloads, by letting them be encoded in the ring. Channel names
+// cross once, with the first message on each channel; later messages carry
+// only the sender's |ChannelId|, which the receiver maps to its own.
+//
+// A side sleeps on its eventfd, polled from its run loop, when it has
+// nothing to read, and is woken only then: a busy peer is never signaled.
+// Sending never blocks. When the peer falls behind and the ring is full,
+// records wait in a local backlog, in order, until the peer frees room
+// and wakes us; their storage is reused, so a peer that keeps falling
+// behind costs no allocations. Messages larger than |max_message_size| are
+// not sent, and get a nil reply.
+//
+// Like the messenger it serves, a transport belongs to the platform
+// thread. Noticing that the peer process is gone is left to the owner,
+// which knows how it was started.
+class ShmTransport : public MessengerTransport {
+ public:
+  static constexpr size_t kDefaultRingCapacity = size_t{4} << 20;
+  static constexpr size_t kDefaultPollLimit = 1024;
+
+  // Creates the memfd and eventfds of a connection whose rings hold
+  // |ring_capacity| bytes each, a power of two no less than 4096. The
+  // descriptors are close-on-exec: |second| suits a forked peer as it is,
+  // and a spawned one once sent over a Unix socket. Returns false on
+  // failure.
+  static bool CreateConnection(size_t ring_capacity,
+                               ShmEndpoint* first,
+                               ShmEndpoint* second);
+
+  // Closes the descriptors of an endpoint that will not be opened here.
+  static void CloseEndpoint(ShmEndpoint* endpoint);
+
+  ShmTransport();
+  ~ShmTransport() override;
+
+  ShmTransport(const ShmTransport&) = delete;
+  ShmTransport& operator=(const ShmTransport&) = delete;
+
+  // Maps the connection, taking ownership of the descriptors of |endpoint|
+  // even on failure. Returns false on failure.
+  bool Open(ShmEndpoint* endpoint);
+  void Close();
+
+  bool is_open() const { return mapping_ != nullptr; }
+
+  // The messenger that receives from the peer. Must be set before |Poll|
+  // and outlive the transport's use.
+  void set_messenger(BinaryMessenger* messenger) { messenger_ = messenger; }
+
+  // The descriptor to poll for reading; call |Poll| when it is readable.
+  int wake_fd() const { return wake_fd_; }
+
+  // Hands up to |limit| records from the peer to the messenger, and sends
+  // what the backlog holds that now fits. If it stops at the limit, the
+  // descriptor is left readable so that the run loop comes back. Returns
+  // false once the peer has written something malformed, after which
+  // nothing more is read. Must not be called from a handler.
+  bool Poll(size_t limit = kDefaultPollLimit);
+
+  // The largest message, channel name included, the rings carry.
+  size_t max_message_size() const;
+
+  // Reserves room for a |size|-byte message on |channel|, expecting no
+  // reply, for the caller to write, e.g. with a |StandardWriter| over the
+  // returned buffer, which is 8-byte aligned. Nothing else may be sent
+  // before |CommitMessage| sends it. Returns nullptr if the message is too
+  // large. The room is in the ring unless the backlog is in use, in which
+  // case the message is copied once more when it is sent; a caller that
+  // would rather wait for room can check |backlog| first.
+  uint8_t* ReserveMessage(ChannelId channel, size_t size);
+  void CommitMessage();
+
+  // MessengerTransport:
+  void SendMessage(ChannelId channel,
+                   std::string_view name,
+                   BinaryMessage message,
+                   uint32_t response_id) override;
+  void SendReply(uint32_t response_id, BinaryMessage reply) override;
+  void ResumeReceiving() override;
+
+  // Records waiting for room in the ring.
+  size_t backlog() const { return backlog_.size(); }
+  // Signals written to the peer's eventfd.
+  uint64_t wakeups() const { return wakeups_; }
+  // Messages and replies not sent because they were too large.
+  uint64_t dropped() const { return dropped_; }
+
+ private:
+  // What a peer channel ID stands for on this side.
+  struct PeerChannel {
+    std::string name;
+    ChannelId local = kNoChannel;
+    bool announced = false;
+  };
+
+  // Writes the header and channel name of a record, and returns where its
+  // message goes, in the ring or in a new backlog entry; nullptr if it is
+  // too large.
+  uint8_t* BeginRecord(uint8_t kind,
+                       ChannelId channel,
+                       std::string_view name,
+                       BinaryMessage message,
+                       uint32_t response_id);
+  void EndRecord();
+
+  // Sends a message or reply with a copy of its bytes. Returns false if it
+  // is too large.
+  bool SendRecord(uint8_t kind,
+                  ChannelId channel,
+                  std::string_view name,
+                  BinaryMessage message,
+                  uint32_t response_id);
+
+  // Whether the first message on |channel| has been written.
+  bool IsAnnounced(ChannelId channel) const {
+    return channel < announced_.size() && announced_[channel];
+  }
+
+  // Moves backlog records into the ring while they fit.
+  void FlushBacklog();
+
+  // Hands one record to the messenger. Returns false if it was refused.
+  bool HandleRecord(const uint8_t* record, size_t size);
+
+  void Signal(int fd);
+
+  BinaryMessenger* messenger_ = nullptr;
+  void* mapping_ = nullptr;
+  size_t mapping_size_ = 0;
+  int wake_fd_ = -1;
+  int peer_wake_fd_ = -1;
+  std::unique_ptr<ShmRing> outbound_;
+  std::unique_ptr<ShmRing> inbound_;
+
+  // Indexed by local channel ID.
+  std::vector<bool> announced_;
+  // Indexed by the peer's channel ID.
+  std::vector<PeerChannel> peer_channels_;
+
+  std::deque<std::vector<uint8_t>> backlog_;
+  // Storage of backlog records sent since, reused for the next ones so
+  // that a peer that keeps falling behind costs no allocations, which for
+  // large records means no fresh pages either.
+  std::vector<std::vector<uint8_t>> spare_records_;
+  size_t spare_bytes_ = 0;
+  // Whether the record being written is the newest backlog entry rather
+  // than room in the ring.
+  bool writing_backlog_ = false;
+  // Replies owed to messages that were too large to send, delivered nil on
+  // the next |Poll| rather than from within |Send|.
+  std::vector<uint32_t> refused_replies_;
+
+  // Set when the messenger refused a message, until |ResumeReceiving|.
+  bool receiving_blocked_ = false;
+  bool failed_ = false;
+
+  uint64_t wakeups_ = 0;
+  uint64_t dropped_ = 0;
+};
+
+}  // namespace platzi
+
+#endif  // NATIVE_MESSENGER_SHM_TRANSPORT_H_
@@ -0,0 +1,130 @@
+#ifndef NATIVE_MESSENGER_SLOT_MAP_H_
+#define NATIVE_MESSENGER_SLOT_MAP_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace platzi {
+
+// A table of |T| keyed by 32-bit IDs it hands out, for bookkeeping such as
+// the replies a |BinaryMessenger| waits for.
+//
+// An ID is the index of a slot in its low |kIndexBits| bits and the slot's
+// generation in the rest. Inserting takes a slot off a free list and taking
+// an entry puts it back with the next generation, both in O(1), so IDs of
+// entries taken stop matching: a late or duplicate reply finds nothing
+// rather than someone else's entry, until the generation wraps after 4095
+// reuses of the slot. Slots are never freed, so once the table has grown to
+// the most entries pending at once it no longer allocates. ID 0 is never
+// handed out.
+//
+// Entries that stay too long can be found with |Sweep|.
+template <typename T>
+class SlotMap {
+ public:
+  static constexpr uint32_t kIndexBits = 20;
+  static constexpr uint32_t kMaxEntries = 1u << kIndexBits;
+
+  SlotMap() = default;
+
+  SlotMap(const SlotMap&) = delete;
+  SlotMap& operator=(const SlotMap&) = delete;
+
+  // Entries in the table.
+  size_t size() const { return size_; }
+  bool full() const { return size_ == kMaxEntries; }
+
+  // Stores |value| and returns its ID, or 0 if the table is full.
+  uint32_t Insert(T value) {
+    uint32_t index = free_head_;
+    if (index == kNoSlot) {
+      if (slots_.size() == kMaxEntries) {
+        return 0;
+      }
+      index = static_cast<uint32_t>(slots_.size());
+      slots_.emplace_back();
+    } else {
+      free_head_ = slots_[index].next_free;
+    }
+    Slot& slot = slots_[index];
+    slot.value = std::move(value);
+    slot.used = true;
+    slot.sweep = sweep_;
+    size_++;
+    return slot.generation << kIndexBits | index;
+  }
+
+  // Returns the entry with |id|, or nullptr if there is none.
+  T* Find(uint32_t id) {
+    uint32_t index = id & (kMaxEntries - 1);
+    if (index >= slots_.size()) {
+      return nullptr;
+    }
+    Slot& slot = slots_[index];
+    if (!slot.used || slot.generation != id >> kIndexBits) {
+      return nullptr;
+    }
+    return &slot.value;
+  }
+
+  // Moves the entry with |id| into |value| and removes it. Returns false if
+  // there is none.
+  bool Take(uint32_t id, T* value) {
+    T* entry = Find(id);
+    if (entry == nullptr) {
+      return false;
+    }
+    uint32_t index = id & (kMaxEntries - 1);
+    Slot& slot = slots_[index];
+    *value = std::move(*entry);
+    *entry = T();
+    slot.used = false;
+    slot.generation = slot.generation == kMaxGeneration ? 1
+                                                        : slot.generation + 1;
+    slot.next_free = free_head_;
+    free_head_ = index;
+    size_--;
+    return true;
+  }
+
+  // Calls |visit(id, value, sweeps)| for every entry inserted before the
+  // previous call, with the number of calls it has outlived, then starts a
+  // new period. Called at a fixed interval, say every few seconds, it finds
+  // the entries older than that interval without timestamping any of them.
+  template <typename Visitor>
+  void Sweep(Visitor visit) {
+    for (size_t index = 0; index < slots_.size(); index++) {
+      const Slot& slot = slots_[index];
+      if (slot.used && slot.sweep != sweep_) {
+        visit(slot.generation << kIndexBits | static_cast<uint32_t>(index),
+              static_cast<const T&>(slot.value), sweep_ - slot.sweep);
+      }
+    }
+    sweep_++;
+  }
+
+ private:
+  static constexpr uint32_t kNoSlot = UINT32_MAX;
+  static constexpr uint32_t kMaxGeneration = (1u << (32 - kIndexBits)) - 1;
+
+  struct Slot {
+    T value{};
+    // Starts at 1, so that no ID is 0.
+    uint32_t generation = 1;
+    uint32_t next_free = kNoSlot;
+    // The |Sweep| period the entry was inserted in.
+    uint32_t sweep = 0;
+    bool used = false;
+  };
+
+  std::vector<Slot> slots_;
+  uint32_t free_head_ = kNoSlot;
+  size_t size_ = 0;
+  uint32_t sweep_ = 0;
+};
+
+}  // namespace platzi
+
+#endif  // NATIVE_MESSENGER_SLOT_MAP_H_
@@ -0,0 +1,367 @@
+#include "messenger/binary_messenger.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "tests/messenger_testing.h"
+
+namespace platzi {
+namespace {
+
+class BinaryMessengerTest : public ::testing::Test {
+ protected:
+  BinaryMessengerTest() : messenger_(&transport_) {}
+
+  RecordingTransport transport_;
+  BinaryMessenger messenger_;
+};
+
+TEST_F(BinaryMessengerTest, DispatchesByIdAndByName) {
+  std::vector<std::string> received;
+  messenger_.SetMessageHandlerOnChannel(
+      "platzi/places", [&](BinaryMessage message, MessageReply reply) {
+        received.push_back(Text(message));
+        reply.Send(Bytes("ok"));
+      });
+  ChannelId channel = messenger_.Channel("platzi/places");
+  EXPECT_EQ(channel, messenger_.channels().Find("platzi/places"));
+
+  EXPECT_TRUE(messenger_.HandleMessage(channel, Bytes("by id"), 7));
+  EXPECT_TRUE(messenger_.HandleMessage("platzi/places", BinaryMessage(), 0));
+  EXPECT_EQ(received, (std::vector<std::string>{"by id", "<nil>"}));
+  // Only the message that expected a reply got one.
+  ASSERT_EQ(transport_.replies.size(), 1u);
+  EXPECT_EQ(transport_.replies[0].first, 7u);
+  EXPECT_EQ(transport_.replies[0].second, "ok");
+}
+
+TEST_F(BinaryMessengerTest, HandsEachReplyToItsCallbackOnce) {
+  ChannelId channel = messenger_.Channel("platzi/search");
+  std::vector<std::string> replies;
+  messenger_.Send(channel, Bytes("first"),
+                  [&](BinaryMessage reply) { replies.push_back(Text(reply)); });
+  messenger_.SendOnChannel("platzi/search", Bytes("second"),
+                           [&](BinaryMessage reply) {
+                             replies.push_back("second " + Text(reply));
+                           });
+  messenger_.Send(channel, Bytes("no reply"));
+  ASSERT_EQ(transport_.sent.size(), 3u);
+  EXPECT_EQ(transport_.sent[1].name, "platzi/search");
+  EXPECT_EQ(transport_.sent[2].response_id, 0u);
+  uint32_t first = transport_.sent[0].response_id;
+  uint32_t second = transport_.sent[1].response_id;
+  ASSERT_NE(first, 0u);
+  ASSERT_NE(first, second);
+  EXPECT_EQ(messenger_.pending_replies(), 2u);
+
+  messenger_.HandleReply(second, BinaryMessage());
+  messenger_.HandleReply(first, Bytes("a"));
+  // Late, duplicate and made-up replies are ignored.
+  messenger_.HandleReply(first, Bytes("b"));
+  messenger_.HandleReply(0, Bytes("c"));
+  messenger_.HandleReply(first ^ 0x12345, Bytes("d"));
+  EXPECT_EQ(replies, (std::vector<std::string>{"second <nil>", "a"}));
+  EXPECT_EQ(messenger_.pending_replies(), 0u);
+}
+
+TEST_F(BinaryMessengerTest, RepliesNilOnChannelsNobodyHandles) {
+  ChannelBufferOptions options;
+  options.max_messages = 0;
+  messenger_.set_default_buffer_options(options);
+  EXPECT_TRUE(messenger_.HandleMessage("platzi/unknown", Bytes("x"), 3));
+  EXPECT_TRUE(messenger_.HandleMessage("platzi/unknown", Bytes("y"), 0));
+  // Without buffering, names are not interned for messages nobody handles.
+  EXPECT_EQ(messenger_.channels().size(), 0u);
+  ASSERT_EQ(transport_.replies.size(), 1u);
+  EXPECT_EQ(transport_.replies[0].first, 3u);
+  EXPECT_EQ(transport_.replies[0].second, "<nil>");
+}
+
+TEST_F(BinaryMessengerTest, LetsHandlersReplaceThemselves) {
+  ChannelId channel = messenger_.Channel("platzi/once");
+  std::string captured = "state the handler owns";
+  std::vector<std::string> received;
+  messenger_.SetMessageHandler(
+      channel, [&, captured](BinaryMessage message, MessageReply) {
+        messenger_.SetMessageHandler(channel, nullptr);
+        // Still alive after unregistering itself.
+        received.push_back(captured + ": " + Text(message));
+      });
+  messenger_.HandleMessage(channel, Bytes("first"), 0);
+  EXPECT_EQ(received,
+            std::vector<std::string>{"state the handler owns: first"});
+}
+
+// Closures capturing a single pointer are stored inline by std::function,
+// where replacing the handler would overwrite them while they run.
+TEST_F(BinaryMessengerTest, LetsSmallHandlersUnregisterThemselves) {
+  ChannelId channel = messenger_.Channel("platzi/once");
+  struct State {
+    BinaryMessenger* messenger;
+    ChannelId channel;
+    std::vector<std::string> received;
+  } state{&messenger_, channel, {}};
+  messenger_.SetMessageHandler(
+      channel, [self = &state](BinaryMessage message, MessageReply) {
+        self->messenger->SetMessageHandler(self->channel, nullptr);
+        self->received.push_back(Text(message));
+      });
+  messenger_.HandleMessage(channel, Bytes("first"), 0);
+  messenger_.HandleMessage(channel, Bytes("second"), 0);
+  EXPECT_EQ(state.received, std::vector<std::string>{"first"});
+}
+
+TEST_F(BinaryMessengerTest, LetsSmallHandlersReplaceThemselves) {
+  ChannelId channel = messenger_.Channel("platzi/relay");
+  struct State {
+    BinaryMessenger* messenger;
+    ChannelId channel;
+    std::vector<std::string> received;
+  } state{&messenger_, channel, {}};
+  // Each handler registers the next one, tagged with its generation.
+  static void (*install)(State*, int) = [](State* state, int generation) {
+    state->messenger->SetMessageHandler(
+        state->channel,
+        [state, generation](BinaryMessage message, MessageReply) {
+          install(state, generation + 1);
+          state->received.push_back(std::to_string(generation) + " " +
+                                    Text(message));
+        });
+  };
+  install(&state, 0);
+  for (const char* message : {"a", "b", "c"}) {
+    messenger_.HandleMessage(channel, Bytes(message), 0);
+  }
+  EXPECT_EQ(state.received, (std::vector<std::string>{"0 a", "1 b", "2 c"}));
+}
+
+TEST_F(BinaryMessengerTest, ReplaysBufferedMessagesInOrder) {
+  ChannelBufferOptions options;
+  options.max_messages = 10;
+  messenger_.set_default_buffer_options(options);
+  EXPECT_TRUE(messenger_.HandleMessage("platzi/late", Bytes("1"), 0));
+  EXPECT_TRUE(messenger_.HandleMessage("platzi/late", BinaryMessage(), 4));
+  EXPECT_TRUE(messenger_.HandleMessage("platzi/late", Bytes(""), 0));
+  ChannelId channel = messenger_.channels().Find("platzi/late");
+  ASSERT_NE(channel, kNoChannel);
+  ASSERT_NE(messenger_.buffer(channel), nullptr);
+  EXPECT_EQ(messenger_.buffer(channel)->size(), 3u);
+
+  // A message arriving during the replay goes behind those buffered.
+  std::vector<std::string> received;
+  messenger_.SetMessageHandler(
+      channel, [&](BinaryMessage message, MessageReply reply) {
+        received.push_back(Text(message));
+        if (received.size() == 1) {
+          messenger_.HandleMessage(channel, Bytes("3"), 0);
+        }
+        reply.Send(Bytes("ok " + Text(message)));
+      });
+  // Empty messages stay apart from nil ones.
+  EXPECT_EQ(received, (std::vector<std::string>{"1", "<nil>", "", "3"}));
+  EXPECT_TRUE(messenger_.buffer(channel)->empty());
+  ASSERT_EQ(transport_.replies.size(), 1u);
+  EXPECT_EQ(transport_.replies[0].first, 4u);
+  EXPECT_EQ(transport_.replies[0].second, "ok <nil>");
+}
+
+TEST_F(BinaryMessengerTest, DropsOldestOrNewestWithNilReplies) {
+  ChannelId oldest = messenger_.Channel("platzi/oldest");
+  ChannelId newest = messenger_.Channel("platzi/newest");
+  ChannelBufferOptions options;
+  options.max_messages = 2;
+  options.max_bytes = 8;
+  messenger_.SetBufferOptions(oldest, options);
+  options.policy = BufferOverflowPolicy::kDropNewest;
+  messenger_.SetBufferOptions(newest, options);
+  for (ChannelId channel : {oldest, newest}) {
+    messenger_.HandleMessage(channel, Bytes("a"), 1);
+    messenger_.HandleMessage(channel, Bytes("b"), 2);
+    messenger_.HandleMessage(channel, Bytes("c"), 3);
+    // Could never fit, whatever is dropped.
+    messenger_.HandleMessage(channel, Bytes("123456789"), 4);
+  }
+  std::vector<uint32_t> nil_replies;
+  for (const auto& reply : transport_.replies) {
+    EXPECT_EQ(reply.second, "<nil>");
+    nil_replies.push_back(reply.first);
+  }
+  EXPECT_EQ(nil_replies, (std::vector<uint32_t>{1, 4, 3, 4}));
+  EXPECT_EQ(messenger_.buffer(oldest)->dropped(), 2u);
+  EXPECT_EQ(messenger_.buffer(newest)->dropped(), 2u);
+
+  std::vector<std::string> received;
+  auto record = [&](BinaryMessage message, MessageReply) {
+    received.push_back(Text(message));
+  };
+  messenger_.SetMessageHandler(oldest, record);
+  messenger_.SetMessageHandler(newest, record);
+  EXPECT_EQ(received, (std::vector<std::string>{"b", "c", "a", "b"}));
+}
+
+TEST_F(BinaryMessengerTest, BlocksTheTransportUntilThereIsRoom) {
+  ChannelId channel = messenger_.Channel("platzi/blocking");
+  ChannelBufferOptions options;
+  options.max_messages = 1;
+  options.policy = BufferOverflowPolicy::kBlock;
+  messenger_.SetBufferOptions(channel, options);
+  EXPECT_TRUE(messenger_.HandleMessage(channel, Bytes("a"), 0));
+  EXPECT_FALSE(messenger_.HandleMessage(channel, Bytes("b"), 0));
+  EXPECT_EQ(transport_.resumed, 0);
+  EXPECT_EQ(messenger_.buffer(channel)->dropped(), 0u);
+
+  std::vector<std::string> received;
+  messenger_.SetMessageHandler(
+      channel, [&](BinaryMessage message, MessageReply) {
+        received.push_back(Text(message));
+      });
+  EXPECT_EQ(received, std::vector<std::string>{"a"});
+  EXPECT_EQ(transport_.resumed, 1);
+  // The transport offers the refused message again.
+  EXPECT_TRUE(messenger_.HandleMessage(channel, Bytes("b"), 0));
+  EXPECT_EQ(received, (std::vector<std::string>{"a", "b"}));
+}
+
+TEST_F(BinaryMessengerTest, DropsWhatNoLongerFitsWhenLimitsShrink) {
+  ChannelId channel = messenger_.Channel("platzi/shrinking");
+  ChannelBufferOptions options;
+  options.max_messages = 3;
+  messenger_.SetBufferOptions(channel, options);
+  for (uint32_t id = 1; id <= 3; id++) {
+    messenger_.HandleMessage(channel, Bytes(std::to_string(id)), id);
+  }
+  options.max_messages = 1;
+  messenger_.SetBufferOptions(channel, options);
+  ASSERT_EQ(transport_.replies.size(), 2u);
+  EXPECT_EQ(transport_.replies[0].first, 1u);
+  EXPECT_EQ(transport_.replies[1].first, 2u);
+  EXPECT_EQ(messenger_.buffer(channel)->size(), 1u);
+}
+
+TEST_F(BinaryMessengerTest, ReportsRepliesOverdueByChannel) {
+  ChannelId slow = messenger_.Channel("platzi/slow");
+  ChannelId fast = messenger_.Channel("platzi/fast");
+  messenger_.Send(slow, Bytes("a"), [](BinaryMessage) {});
+  messenger_.Send(fast, Bytes("b"), [](BinaryMessage) {});
+  std::vector<BinaryMessenger::OverdueReply> overdue;
+  messenger_.SweepOverdueReplies(&overdue);
+  EXPECT_TRUE(overdue.empty());
+  messenger_.HandleReply(transport_.sent[1].response_id, Bytes("done"));
+  messenger_.SweepOverdueReplies(&overdue);
+  ASSERT_EQ(overdue.size(), 1u);
+  EXPECT_EQ(overdue[0].channel, slow);
+  EXPECT_EQ(overdue[0].response_id, transport_.sent[0].response_id);
+  EXPECT_EQ(overdue[0].sweeps, 1u);
+}
+
+// Records the messages of several channels in one log, as "channel:text".
+class LaneMessengerTest : public BinaryMessengerTest {
+ protected:
+  LaneMessengerTest() {
+    messenger_.EnablePriorityLanes([this] { scheduled_++; });
+  }
+
+  BinaryMessageHandler Logger(const std::string& prefix) {
+    return [this, prefix](BinaryMessage message, MessageReply) {
+      log_.push_back(prefix + ":" + Text(message).substr(0, 1));
+    };
+  }
+
+  int scheduled_ = 0;
+  std::vector<std::string> log_;
+};
+
+TEST_F(LaneMessengerTest, LetsInteractiveMessagesOvertakeBulkOnes) {
+  ChannelId bulk = messenger_.Channel("platzi/upload");
+  messenger_.SetChannelPriority(bulk, ChannelPriority::kBulk);
+  messenger_.SetMessageHandler(bulk, Logger("bulk"));
+  ChannelId key = messenger_.Channel("flutter/keyevent");
+  EXPECT_EQ(messenger_.priority(key), ChannelPriority::kInteractive);
+  messenger_.SetMessageHandler(key, Logger("key"));
+  for (int i = 0; i < 5; i++) {
+    messenger_.HandleMessage(bulk, Bytes(std::to_string(i) +
+                                         std::string(2000, ' ')), 0);
+  }
+  messenger_.HandleMessage(key, Bytes("k"), 0);
+  // The first bulk message had credit and nothing ahead of it.
+  EXPECT_EQ(log_, (std::vector<std::string>{"bulk:0", "key:k"}));
+  EXPECT_EQ(messenger_.lanes()->size(ChannelPriority::kBulk), 4u);
+  EXPECT_EQ(scheduled_, 1);
+
+  EXPECT_EQ(messenger_.DispatchQueued(3), 3u);
+  // Comes back for the rest.
+  EXPECT_EQ(scheduled_, 2);
+  EXPECT_EQ(messenger_.DispatchQueued(), 1u);
+  EXPECT_EQ(scheduled_, 2);
+  EXPECT_EQ(log_, (std::vector<std::string>{"bulk:0", "key:k", "bulk:1",
+                                            "bulk:2", "bulk:3", "bulk:4"}));
+  EXPECT_EQ(messenger_.lanes()->stats(ChannelPriority::kBulk).dispatched,
+            5u);
+}
+
+TEST_F(LaneMessengerTest, KeepsQueuedMessagesAheadOfBufferedOnes) {
+  ChannelBufferOptions options;
+  options.max_messages = 8;
+  messenger_.set_default_buffer_options(options);
+  ChannelId bulk = messenger_.Channel("platzi/upload");
+  ChannelId other = messenger_.Channel("platzi/other");
+  messenger_.SetChannelPriority(bulk, ChannelPriority::kBulk);
+  messenger_.SetMessageHandler(bulk, Logger("bulk"));
+  messenger_.SetMessageHandler(other, Logger("other"));
+  // Each more than a quantum, so that all are queued.
+  std::string padding(6000, ' ');
+  for (int i = 0; i < 3; i++) {
+    messenger_.HandleMessage(bulk, Bytes(std::to_string(i) + padding), 0);
+  }
+  messenger_.HandleMessage(other, Bytes("o"), 0);
+  EXPECT_EQ(messenger_.lanes()->size(ChannelPriority::kBulk), 3u);
+
+  messenger_.SetMessageHandler(bulk, nullptr);
+  EXPECT_TRUE(messenger_.lanes()->empty());
+  messenger_.HandleMessage(bulk, Bytes("5" + padding), 0);
+  messenger_.SetMessageHandler(bulk, Logger("bulk"));
+  while (messenger_.DispatchQueued() > 0) {
+  }
+  EXPECT_EQ(log_, (std::vector<std::string>{"other:o", "bulk:0", "bulk:1",
+                                            "bulk:2", "bulk:5"}));
+}
+
+TEST_F(LaneMessengerTest, DropsQueuedMessagesOverTheBufferLimits) {
+  ChannelId bulk = messenger_.Channel("platzi/upload");
+  messenger_.SetChannelPriority(bulk, ChannelPriority::kBulk);
+  messenger_.SetMessageHandler(bulk, Logger("bulk"));
+  std::string padding(6000, ' ');
+  for (uint32_t id = 1; id <= 4; id++) {
+    messenger_.HandleMessage(bulk, Bytes(std::to_string(id) + padding), id);
+  }
+  // The default buffer holds one message: the newest stays.
+  messenger_.SetMessageHandler(bulk, nullptr);
+  ASSERT_EQ(transport_.replies.size(), 3u);
+  EXPECT_EQ(transport_.replies[0].first, 1u);
+  EXPECT_EQ(transport_.replies[2].first, 3u);
+  EXPECT_EQ(transport_.replies[2].second, "<nil>");
+  EXPECT_EQ(messenger_.buffer(bulk)->size(), 1u);
+  EXPECT_EQ(messenger_.buffer(bulk)->dropped(), 3u);
+  messenger_.SetMessageHandler(bulk, Logger("bulk"));
+  EXPECT_EQ(log_, std::vector<std::string>{"bulk:4"});
+}
+
+TEST_F(LaneMessengerTest, KeepsQueuedEmptyMessagesApartFromNil) {
+  ChannelId bulk = messenger_.Channel("platzi/upload");
+  messenger_.SetChannelPriority(bulk, ChannelPriority::kBulk);
+  std::vector<std::string> received;
+  messenger_.SetMessageHandler(
+      bulk, [&](BinaryMessage message, MessageReply) {
+        received.push_back(Text(message).substr(0, 5));
+      });
+  messenger_.HandleMessage(bulk, Bytes(std::string(6000, ' ')), 0);
+  messenger_.HandleMessage(bulk, Bytes(""), 0);
+  messenger_.HandleMessage(bulk, BinaryMessage(), 0);
+  messenger_.DispatchQueued();
+  EXPECT_EQ(received, (std::vector<std::string>{"     ", "", "<nil>"}));
+}
+
+}  // namespace
+}  // namespace platzi
@@ -0,0 +1,85 @@
+#include "messenger/channel_buffer.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "tests/messenger_testing.h"
+
+namespace platzi {
+namespace {
+
+std::string PopText(ChannelBuffer* buffer) {
+  bool nil = buffer->front().nil;
+  std::vector<uint8_t> bytes;
+  buffer->PopFront(&bytes);
+  return nil ? "<nil>" : std::string(bytes.begin(), bytes.end());
+}
+
+TEST(ChannelBufferTest, KeepsOrderAcrossWrapsAndGrowth) {
+  ChannelBufferOptions options;
+  options.max_messages = 100;
+  ChannelBuffer buffer(options);
+  int pushed = 0;
+  int popped = 0;
+  // Alternately fill and half drain, so that the ring wraps as it grows.
+  for (int round = 1; round <= 6; round++) {
+    for (int i = 0; i < round * 3; i++) {
+      std::string text = std::to_string(pushed++);
+      buffer.Push(Bytes(text), static_cast<uint32_t>(pushed));
+    }
+    while (buffer.size() > static_cast<size_t>(round)) {
+      EXPECT_EQ(buffer.front().response_id, static_cast<uint32_t>(popped + 1));
+      EXPECT_EQ(PopText(&buffer), std::to_string(popped++));
+    }
+  }
+  while (!buffer.empty()) {
+    EXPECT_EQ(PopText(&buffer), std::to_string(popped++));
+  }
+  EXPECT_EQ(popped, pushed);
+  EXPECT_EQ(buffer.byte_size(), 0u);
+}
+
+TEST(ChannelBufferTest, PushesToTheFrontOverTheLimits) {
+  ChannelBuffer buffer(ChannelBufferOptions{});
+  buffer.Push(Bytes("newest"), 0);
+  std::vector<uint8_t> bytes = {'o', 'l', 'd'};
+  buffer.PushFront(false, 9, &bytes);
+  EXPECT_TRUE(bytes.empty());
+  std::vector<uint8_t> none;
+  buffer.PushFront(true, 0, &none);
+  EXPECT_EQ(buffer.size(), 3u);
+  EXPECT_EQ(buffer.byte_size(), 9u);
+  EXPECT_TRUE(buffer.OverLimits());
+  EXPECT_FALSE(buffer.Fits(0));
+  EXPECT_EQ(PopText(&buffer), "<nil>");
+  EXPECT_EQ(buffer.front().response_id, 9u);
+  EXPECT_EQ(PopText(&buffer), "old");
+  EXPECT_EQ(PopText(&buffer), "newest");
+}
+
+TEST(ChannelBufferTest, ChecksMessageAndByteLimits) {
+  ChannelBufferOptions options;
+  options.max_messages = 3;
+  options.max_bytes = 10;
+  ChannelBuffer buffer(options);
+  EXPECT_TRUE(buffer.CanEverFit(10));
+  EXPECT_FALSE(buffer.CanEverFit(11));
+  buffer.Push(Bytes("123456"), 0);
+  EXPECT_TRUE(buffer.Fits(4));
+  EXPECT_FALSE(buffer.Fits(5));
+  buffer.Push(Bytes(""), 0);
+  buffer.Push(BinaryMessage(), 0);
+  EXPECT_FALSE(buffer.Fits(0));
+  EXPECT_FALSE(buffer.OverLimits());
+  options.max_bytes = 5;
+  buffer.set_options(options);
+  EXPECT_TRUE(buffer.OverLimits());
+  options.max_messages = 0;
+  buffer.set_options(options);
+  EXPECT_FALSE(buffer.CanEverFit(0));
+}
+
+}  // namespace
+}  // namespace platzi
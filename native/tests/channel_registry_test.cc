@@ -0,0 +1,60 @@
+#include "messenger/channel_registry.h"
+
+#include <gtest/gtest.h>
+
+#include <iterator>
+#include <string>
+
+namespace platzi {
+namespace {
+
+TEST(ChannelRegistryTest, InternsNamesDensely) {
+  ChannelRegistry registry;
+  // Enough names to grow the table several times.
+  for (int i = 0; i < 1000; i++) {
+    std::string name = "plugins.flutter.io/channel_" + std::to_string(i);
+    ASSERT_EQ(registry.Intern(name), static_cast<ChannelId>(i));
+  }
+  EXPECT_EQ(registry.size(), 1000u);
+  for (int i = 999; i >= 0; i--) {
+    std::string name = "plugins.flutter.io/channel_" + std::to_string(i);
+    EXPECT_EQ(registry.Intern(name), static_cast<ChannelId>(i));
+    EXPECT_EQ(registry.Find(name), static_cast<ChannelId>(i));
+    EXPECT_EQ(registry.NameOf(i), name);
+  }
+  EXPECT_EQ(registry.size(), 1000u);
+}
+
+TEST(ChannelRegistryTest, KeepsItsOwnCopyOfNames) {
+  ChannelRegistry registry;
+  std::string name = "flutter/lifecycle";
+  ChannelId channel = registry.Intern(name);
+  name.assign(name.size(), 'x');
+  EXPECT_EQ(registry.NameOf(channel), "flutter/lifecycle");
+  EXPECT_EQ(registry.Find("flutter/lifecycle"), channel);
+  EXPECT_EQ(registry.Find(name), kNoChannel);
+}
+
+TEST(ChannelRegistryTest, FindsOnlyExactNames) {
+  ChannelRegistry registry;
+  // Names that differ only past the first eight bytes, in length, or by a
+  // trailing zero byte.
+  const std::string names[] = {"flutter/textinput",
+                               "flutter/textinpuT",
+                               "flutter/",
+                               "flutter",
+                               std::string("flutter\0", 8),
+                               ""};
+  for (const std::string& name : names) {
+    EXPECT_EQ(registry.Find(name), kNoChannel);
+    registry.Intern(name);
+  }
+  for (size_t i = 0; i < std::size(names); i++) {
+    EXPECT_EQ(registry.Find(names[i]), static_cast<ChannelId>(i));
+  }
+  EXPECT_EQ(registry.Find("flutter/textinput2"), kNoChannel);
+  EXPECT_EQ(registry.size(), std::size(names));
+}
+
+}  // namespace
+}  // namespace platzi
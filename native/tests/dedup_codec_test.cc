@@ -0,0 +1,176 @@
+#include "codec/dedup_codec.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "codec/standard_message_codec.h"
+#include "tests/value_testing.h"
+
+namespace platzi {
+namespace {
+
+constexpr uint8_t kDefinition = static_cast<uint8_t>(SharedField::kDefinition);
+constexpr uint8_t kReference = static_cast<uint8_t>(SharedField::kReference);
+
+// A list of places whose descriptions are separate but equal copies, each
+// with the same list of tags, as a plugin building them one by one would.
+struct Places {
+  std::string description = "a long description of the place";
+  std::vector<Value> tags;
+  std::vector<MapEntry> fields;
+  std::vector<Value> items;
+  Value root;
+
+  explicit Places(int count) {
+    tags.reserve(count * 3);
+    fields.reserve(count * 3);
+    for (int i = 0; i < count; i++) {
+      tags.push_back(Value::String("restaurant"));
+      tags.push_back(Value::String("outdoor seating"));
+      tags.push_back(Value::Int32(4));
+    }
+    for (int i = 0; i < count; i++) {
+      fields.push_back({Value::String("id"), Value::Int32(i)});
+      fields.push_back(
+          {Value::String("description"), Value::String(description)});
+      fields.push_back({Value::String("tags"), Value::List(&tags[3 * i], 3)});
+    }
+    for (int i = 0; i < count; i++) {
+      items.push_back(Value::Map(&fields[3 * i], 3));
+    }
+    root = Value::List(items.data(), items.size());
+  }
+};
+
+TEST(DedupCodecTest, SharesRepeatedValues) {
+  Places places(50);
+  std::vector<uint8_t> standard;
+  std::vector<uint8_t> dedup;
+  ASSERT_TRUE(StandardMessageCodec::EncodeMessage(places.root, &standard));
+  ASSERT_TRUE(DedupMessageCodec::EncodeMessage(places.root, &dedup));
+  EXPECT_LT(dedup.size() * 3, standard.size());
+
+  for (DecodeMode mode : {DecodeMode::kBorrow, DecodeMode::kCopy}) {
+    Arena arena;
+    const Value* decoded =
+        DedupMessageCodec::DecodeMessage(dedup.data(), dedup.size(), &arena,
+                                         mode);
+    ASSERT_NE(decoded, nullptr);
+    EXPECT_TRUE(ValuesEqual(places.root, *decoded));
+    // Repeats decode to the storage of the first.
+    const Value& first = decoded->list[0].map[2].value;
+    const Value& last = decoded->list[49].map[2].value;
+    EXPECT_EQ(first.list.data, last.list.data);
+  }
+}
+
+TEST(DedupCodecTest, EncodesMessagesWithoutRepeatsAsTheStandardCodec) {
+  // Repeats too short to be worth a reference, and distinct long values.
+  Value items[] = {Value::String("short"), Value::String("short"),
+                   Value::String("a long string"),
+                   Value::String("a longer string"), Value::Int64(1ll << 40),
+                   Value::Int64(1ll << 40)};
+  Value root = Value::List(items, 6);
+  std::vector<uint8_t> standard;
+  std::vector<uint8_t> dedup;
+  ASSERT_TRUE(StandardMessageCodec::EncodeMessage(root, &standard));
+  ASSERT_TRUE(DedupMessageCodec::EncodeMessage(root, &dedup));
+  EXPECT_EQ(dedup, standard);
+}
+
+TEST(DedupCodecTest, SharesValuesReachedTwice) {
+  // The same list twice, and as a map key.
+  Value tags[] = {Value::String("one tag"), Value::String("another tag")};
+  Value list = Value::List(tags, 2);
+  MapEntry entries[] = {{list, Value::Null()}};
+  Value items[] = {list, Value::Map(entries, 1), list};
+  Value root = Value::List(items, 3);
+  std::vector<uint8_t> bytes;
+  ASSERT_TRUE(DedupMessageCodec::EncodeMessage(root, &bytes));
+  Arena arena;
+  const Value* decoded =
+      DedupMessageCodec::DecodeMessage(bytes.data(), bytes.size(), &arena);
+  ASSERT_NE(decoded, nullptr);
+  EXPECT_TRUE(ValuesEqual(root, *decoded));
+  EXPECT_EQ(decoded->list[0].list.data, decoded->list[2].list.data);
+  EXPECT_EQ(decoded->list[0].list.data, decoded->list[1].map[0].key.list.data);
+}
+
+TEST(DedupCodecTest, PlansEachMessageAfreshWithAKeptPlanner) {
+  // A larger message, then smaller ones sharing different values.
+  Places many(50);
+  Places few(3);
+  Value tags[] = {Value::String("one tag"), Value::String("one tag")};
+  Value pair = Value::List(tags, 2);
+  DedupPlanner planner;
+  for (const Value* root : {&many.root, &few.root, &pair, &few.root}) {
+    std::vector<uint8_t> fresh;
+    DedupWriter fresh_writer(&fresh);
+    fresh_writer.Plan(*root);
+    fresh_writer.WriteValue(*root);
+    std::vector<uint8_t> kept;
+    DedupWriter kept_writer(&kept, &planner);
+    kept_writer.Plan(*root);
+    kept_writer.WriteValue(*root);
+    EXPECT_EQ(kept, fresh);
+  }
+}
+
+TEST(DedupCodecTest, RefusesExtensionValues) {
+  int object = 0;
+  Value items[] = {Value::Null(), Value::Extension(&object)};
+  std::vector<uint8_t> bytes;
+  EXPECT_FALSE(DedupMessageCodec::EncodeMessage(Value::List(items, 2), &bytes));
+}
+
+TEST(DedupCodecTest, RejectsEveryTruncation) {
+  Places places(3);
+  std::vector<uint8_t> bytes;
+  ASSERT_TRUE(DedupMessageCodec::EncodeMessage(places.root, &bytes));
+  for (size_t size = 0; size < bytes.size(); size++) {
+    Arena arena;
+    EXPECT_EQ(DedupMessageCodec::DecodeMessage(bytes.data(), size, &arena),
+              nullptr)
+        << "size " << size;
+  }
+  bytes.push_back(0);
+  Arena arena;
+  EXPECT_EQ(
+      DedupMessageCodec::DecodeMessage(bytes.data(), bytes.size(), &arena),
+      nullptr);
+}
+
+TEST(DedupCodecTest, RejectsMalformedReferences) {
+  const std::vector<std::vector<uint8_t>> malformed = {
+      // A reference with nothing defined.
+      {kReference, 0},
+      // A reference past the last definition.
+      {12, 2, kDefinition, 7, 1, 'a', kReference, 1},
+      // A list referring to itself, which is only defined once it ends.
+      {kDefinition, 12, 1, kReference, 0},
+      // Definitions of definitions and of references.
+      {kDefinition, kDefinition, 7, 1, 'a'},
+      {12, 2, kDefinition, 7, 1, 'a', kDefinition, kReference, 0},
+      // A reference whose varint never ends.
+      {12, 2, kDefinition, 7, 1, 'a', kReference, 0x80, 0x80},
+  };
+  for (const std::vector<uint8_t>& message : malformed) {
+    Arena arena;
+    EXPECT_EQ(DedupMessageCodec::DecodeMessage(message.data(), message.size(),
+                                               &arena),
+              nullptr)
+        << "size " << message.size();
+  }
+  // The well-formed message they were made from.
+  const uint8_t valid[] = {12, 2, kDefinition, 7, 1, 'a', kReference, 0};
+  Arena arena;
+  const Value* decoded =
+      DedupMessageCodec::DecodeMessage(valid, sizeof(valid), &arena);
+  ASSERT_NE(decoded, nullptr);
+  EXPECT_EQ(decoded->list[1].string, "a");
+}
+
+}  // namespace
+}  // namespace platzi
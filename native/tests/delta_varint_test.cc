@@ -0,0 +1,129 @@
+#include "codec/delta_varint.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "codec/standard_message_codec.h"
+#include "tests/value_testing.h"
+
+namespace platzi {
+namespace {
+
+std::vector<uint8_t> Pack(const std::vector<int64_t>& values) {
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(values.data());
+  std::vector<uint8_t> packed(PackedSizeOfInt64Deltas(bytes, values.size()));
+  PackInt64Deltas(bytes, values.size(), packed.data(), packed.size());
+  return packed;
+}
+
+// Lists taking the one-byte, two-byte and general paths, and mixing them
+// within a group of eight, at every length around the group boundaries.
+std::vector<std::vector<int64_t>> Lists() {
+  std::vector<std::vector<int64_t>> lists;
+  for (int64_t step : {1ll, -3ll, 100ll, -5000ll, 1ll << 40}) {
+    for (size_t count = 0; count <= 25; count++) {
+      std::vector<int64_t> list;
+      for (size_t i = 0; i < count; i++) {
+        list.push_back(1700000000000ll + static_cast<int64_t>(i) * step);
+      }
+      lists.push_back(list);
+    }
+  }
+  std::vector<int64_t> mixed;
+  for (int i = 0; i < 64; i++) {
+    mixed.push_back(i % 5 == 0 ? i * 1000 : i);
+  }
+  lists.push_back(mixed);
+  lists.push_back({std::numeric_limits<int64_t>::min(),
+                   std::numeric_limits<int64_t>::max(), 0, -1,
+                   std::numeric_limits<int64_t>::min(), 1});
+  return lists;
+}
+
+TEST(DeltaVarintTest, RoundTrips) {
+  for (const std::vector<int64_t>& list : Lists()) {
+    std::vector<uint8_t> packed = Pack(list);
+    std::vector<int64_t> unpacked(list.size());
+    ASSERT_TRUE(UnpackInt64Deltas(packed.data(), packed.size(), list.size(),
+                                  unpacked.data()))
+        << "count " << list.size();
+    EXPECT_EQ(unpacked, list);
+  }
+}
+
+TEST(DeltaVarintTest, PacksSmallStepsSmall) {
+  std::vector<int64_t> ascending;
+  std::vector<int64_t> descending;
+  for (int64_t i = 0; i < 1000; i++) {
+    ascending.push_back(1700000000000ll + i);
+    descending.push_back(-i * 100);
+  }
+  // The first element is a difference from zero.
+  EXPECT_EQ(Pack(ascending).size(), 6 + 999u);
+  // A group of eight packs at one width, so the leading zero takes two
+  // bytes along with the rest of its group.
+  EXPECT_EQ(Pack(descending).size(), 1000 * 2u);
+  EXPECT_EQ(Pack({std::numeric_limits<int64_t>::min()}).size(),
+            kMaxVarint64Length);
+}
+
+TEST(DeltaVarintTest, RoundTripsThroughTheStandardCodec) {
+  std::vector<int64_t> list = Lists().back();
+  TypedDataView packed = TypedDataView::Of(list.data(), list.size());
+  packed.type = StandardField::kInt64DeltaData;
+  std::vector<uint8_t> bytes;
+  ASSERT_TRUE(
+      StandardMessageCodec::EncodeMessage(Value::TypedData(packed), &bytes));
+  Arena arena;
+  const Value* decoded =
+      StandardMessageCodec::DecodeMessage(bytes.data(), bytes.size(), &arena);
+  ASSERT_NE(decoded, nullptr);
+  EXPECT_TRUE(ValuesEqual(Value::TypedData(packed), *decoded));
+  for (size_t size = 0; size < bytes.size(); size++) {
+    EXPECT_EQ(StandardMessageCodec::DecodeMessage(bytes.data(), size, &arena),
+              nullptr)
+        << "size " << size;
+  }
+}
+
+TEST(DeltaVarintTest, RejectsTruncatedOrTrailingBytes) {
+  std::vector<int64_t> list = Lists()[3 * 26 + 20];
+  std::vector<uint8_t> packed = Pack(list);
+  std::vector<int64_t> unpacked(list.size() + 1);
+  for (size_t size = 0; size < packed.size(); size++) {
+    EXPECT_FALSE(
+        UnpackInt64Deltas(packed.data(), size, list.size(), unpacked.data()))
+        << "size " << size;
+  }
+  packed.push_back(0);
+  EXPECT_FALSE(UnpackInt64Deltas(packed.data(), packed.size(), list.size(),
+                                 unpacked.data()));
+  // One element fewer than was packed leaves bytes over.
+  packed.pop_back();
+  EXPECT_FALSE(UnpackInt64Deltas(packed.data(), packed.size(),
+                                 list.size() - 1, unpacked.data()));
+}
+
+TEST(DeltaVarintTest, RejectsMalformedVarints) {
+  int64_t out[2];
+  // Eleven bytes, and ten whose last carries more than the top bit.
+  const uint8_t too_long[] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+                              0xFF, 0xFF, 0xFF, 0xFF, 0x01};
+  const uint8_t overflowing[] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+                                 0xFF, 0xFF, 0xFF, 0xFF, 0x02};
+  const uint8_t widest[] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+                            0xFF, 0xFF, 0xFF, 0xFF, 0x01};
+  EXPECT_FALSE(UnpackInt64Deltas(too_long, sizeof(too_long), 1, out));
+  EXPECT_FALSE(UnpackInt64Deltas(overflowing, sizeof(overflowing), 1, out));
+  ASSERT_TRUE(UnpackInt64Deltas(widest, sizeof(widest), 1, out));
+  EXPECT_EQ(out[0], std::numeric_limits<int64_t>::min());
+  // A continuation bit on the last byte.
+  const uint8_t unterminated[] = {0x02, 0x80};
+  EXPECT_FALSE(UnpackInt64Deltas(unterminated, sizeof(unterminated), 2, out));
+}
+
+}  // namespace
+}  // namespace platzi
@@ -0,0 +1,179 @@
+#include "codec/extension_registry.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "codec/standard_message_codec.h"
+
+namespace platzi {
+namespace {
+
+struct Point {
+  double x;
+  double y;
+};
+
+// Two points, written as nested extension values.
+struct Segment {
+  const Point* from;
+  const Point* to;
+};
+
+void EncodePoint(const void* object, StandardWriter* writer) {
+  const auto* point = static_cast<const Point*>(object);
+  writer->WriteValue(Value::Float64(point->x));
+  writer->WriteValue(Value::Float64(point->y));
+}
+
+const void* DecodePoint(StandardReader* reader,
+                        Arena* arena,
+                        DecodeMode mode) {
+  const Value* x = DecodeValue(reader, arena, mode);
+  const Value* y = DecodeValue(reader, arena, mode);
+  if (x == nullptr || y == nullptr || x->type != ValueType::kFloat64 ||
+      y->type != ValueType::kFloat64) {
+    return nullptr;
+  }
+  return arena->New<Point>(Point{x->float64, y->float64});
+}
+
+void EncodeSegment(const void* object, StandardWriter* writer) {
+  const auto* segment = static_cast<const Segment*>(object);
+  writer->WriteValue(Value::Extension(segment->from));
+  writer->WriteValue(Value::Extension(segment->to));
+}
+
+const void* DecodeSegment(StandardReader* reader,
+                          Arena* arena,
+                          DecodeMode mode) {
+  const Value* from = DecodeValue(reader, arena, mode);
+  const Value* to = DecodeValue(reader, arena, mode);
+  for (const Value* point : {from, to}) {
+    if (point == nullptr || point->type != ValueType::kExtension ||
+        point->extension.type_id != ExtensionTypeId<Point>()) {
+      return nullptr;
+    }
+  }
+  return arena->New<Segment>(
+      Segment{static_cast<const Point*>(from->extension.object),
+              static_cast<const Point*>(to->extension.object)});
+}
+
+constexpr uint8_t kPointCode = kFirstExtensionType + 3;
+constexpr uint8_t kSegmentCode = 255;
+
+class ExtensionRegistryTest : public ::testing::Test {
+ protected:
+  ExtensionRegistryTest() : codec_(&registry_) {
+    registry_.Register<Point>(kPointCode, EncodePoint, DecodePoint);
+    registry_.Register<Segment>(kSegmentCode, EncodeSegment, DecodeSegment);
+  }
+
+  ExtensionRegistry registry_;
+  ExtensionMessageCodec codec_;
+};
+
+TEST_F(ExtensionRegistryTest, RefusesConflictingRegistrations) {
+  EXPECT_EQ(registry_.size(), 2u);
+  EXPECT_FALSE(registry_.Register<Point>(kPointCode + 1, EncodePoint,
+                                         DecodePoint));
+  EXPECT_FALSE(registry_.Register<int>(kPointCode, EncodePoint, DecodePoint));
+  EXPECT_FALSE(registry_.Register<int>(kFirstExtensionType - 1, EncodePoint,
+                                       DecodePoint));
+  EXPECT_TRUE(registry_.Register<int>(kFirstExtensionType, EncodePoint,
+                                      DecodePoint));
+  EXPECT_EQ(registry_.size(), 3u);
+}
+
+TEST_F(ExtensionRegistryTest, RoundTripsNestedExtensionValues) {
+  Point from{1.5, -2};
+  Point to{0.25, 1e300};
+  Segment segment{&from, &to};
+  MapEntry entries[] = {{Value::String("point"), Value::Extension(&to)},
+                        {Value::Extension(&from), Value::Int32(7)}};
+  Value items[] = {Value::Extension(&segment), Value::Map(entries, 2)};
+  std::vector<uint8_t> bytes;
+  ASSERT_TRUE(codec_.EncodeMessage(Value::List(items, 2), &bytes));
+  // The list's type byte and size, then the segment's own type byte.
+  EXPECT_EQ(bytes[2], kSegmentCode);
+
+  for (DecodeMode mode : {DecodeMode::kBorrow, DecodeMode::kCopy}) {
+    Arena arena;
+    const Value* decoded =
+        codec_.DecodeMessage(bytes.data(), bytes.size(), &arena, mode);
+    ASSERT_NE(decoded, nullptr);
+    ASSERT_EQ(decoded->list.size, 2u);
+    const Value& first = decoded->list[0];
+    ASSERT_EQ(first.extension.type_id, ExtensionTypeId<Segment>());
+    const auto* decoded_segment =
+        static_cast<const Segment*>(first.extension.object);
+    EXPECT_EQ(decoded_segment->from->x, 1.5);
+    EXPECT_EQ(decoded_segment->to->y, 1e300);
+    const Value& key = decoded->list[1].map[1].key;
+    ASSERT_EQ(key.extension.type_id, ExtensionTypeId<Point>());
+    EXPECT_EQ(static_cast<const Point*>(key.extension.object)->y, -2);
+  }
+}
+
+TEST_F(ExtensionRegistryTest, RefusesUnregisteredTypes) {
+  int unregistered = 0;
+  Value items[] = {Value::Int32(1), Value::Extension(&unregistered)};
+  std::vector<uint8_t> bytes;
+  EXPECT_FALSE(codec_.EncodeMessage(Value::List(items, 2), &bytes));
+
+  // Points are unknown to a reader without the registry, and to one with a
+  // registry that lacks them.
+  Point point{1, 2};
+  ASSERT_TRUE(codec_.EncodeMessage(Value::Extension(&point), &bytes));
+  Arena arena;
+  EXPECT_EQ(
+      StandardMessageCodec::DecodeMessage(bytes.data(), bytes.size(), &arena),
+      nullptr);
+  ExtensionRegistry other_registry;
+  other_registry.Register<Point>(kPointCode + 1, EncodePoint, DecodePoint);
+  ExtensionMessageCodec other_codec(&other_registry);
+  EXPECT_EQ(other_codec.DecodeMessage(bytes.data(), bytes.size(), &arena),
+            nullptr);
+}
+
+TEST_F(ExtensionRegistryTest, RejectsEveryTruncation) {
+  Point from{1, 2};
+  Point to{3, 4};
+  Segment segment{&from, &to};
+  std::vector<uint8_t> bytes;
+  ASSERT_TRUE(codec_.EncodeMessage(Value::Extension(&segment), &bytes));
+  for (size_t size = 0; size < bytes.size(); size++) {
+    Arena arena;
+    EXPECT_EQ(codec_.DecodeMessage(bytes.data(), size, &arena), nullptr)
+        << "size " << size;
+  }
+}
+
+TEST_F(ExtensionRegistryTest, RejectsMalformedPayloads) {
+  Arena arena;
+  // A point whose payload holds a third value its decoder leaves unread.
+  Point point{1, 2};
+  std::vector<uint8_t> trailing;
+  ASSERT_TRUE(codec_.EncodeMessage(Value::Extension(&point), &trailing));
+  ASSERT_NE(codec_.DecodeMessage(trailing.data(), trailing.size(), &arena),
+            nullptr);
+  ASSERT_LT(trailing[1], 253);
+  trailing[1]++;
+  trailing.push_back(0);
+  EXPECT_EQ(codec_.DecodeMessage(trailing.data(), trailing.size(), &arena),
+            nullptr);
+  // A point of strings, which its decoder refuses.
+  const uint8_t strings[] = {kPointCode, 6, 7, 1, 'a', 7, 1, 'b'};
+  EXPECT_EQ(codec_.DecodeMessage(strings, sizeof(strings), &arena), nullptr);
+  // A payload size beyond the end of the message.
+  const uint8_t oversized[] = {kPointCode, 200, 0, 0};
+  EXPECT_EQ(codec_.DecodeMessage(oversized, sizeof(oversized), &arena),
+            nullptr);
+  // A segment of two nulls.
+  const uint8_t nulls[] = {kSegmentCode, 2, 0, 0};
+  EXPECT_EQ(codec_.DecodeMessage(nulls, sizeof(nulls), &arena), nullptr);
+}
+
+}  // namespace
+}  // namespace platzi
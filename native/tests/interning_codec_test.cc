@@ -0,0 +1,199 @@
+#include "codec/interning_codec.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "codec/standard_message_codec.h"
+#include "tests/value_testing.h"
+
+namespace platzi {
+namespace {
+
+// A list of records with the same keys, as a channel sends over and over.
+struct Records {
+  MapEntry entries[3][2];
+  Value items[3];
+  Value root;
+
+  explicit Records(const char* kind) {
+    for (int i = 0; i < 3; i++) {
+      entries[i][0] = {Value::String("identifier"), Value::Int32(i)};
+      entries[i][1] = {Value::String("kind"), Value::String(kind)};
+      items[i] = Value::Map(entries[i], 2);
+    }
+    root = Value::List(items, 3);
+  }
+};
+
+TEST(InterningCodecTest, RoundTripsAndShrinksRepeatedKeys) {
+  InterningMessageCodec sender;
+  InterningMessageCodec receiver;
+  Records records("restaurant");
+  std::vector<uint8_t> first;
+  std::vector<uint8_t> second;
+  ASSERT_TRUE(sender.EncodeMessage(records.root, &first));
+  ASSERT_TRUE(sender.EncodeMessage(records.root, &second));
+  EXPECT_LT(second.size(), first.size());
+  EXPECT_EQ(sender.encoder_table().size(), 2u);
+
+  for (const std::vector<uint8_t>* message : {&first, &second}) {
+    Arena arena;
+    const Value* decoded =
+        receiver.DecodeMessage(message->data(), message->size(), &arena);
+    ASSERT_NE(decoded, nullptr);
+    EXPECT_TRUE(ValuesEqual(records.root, *decoded));
+  }
+  EXPECT_FALSE(receiver.needs_peer_reset());
+}
+
+TEST(InterningCodecTest, InternsValuesOnlyWhenAsked) {
+  InterningOptions options;
+  options.intern_values = true;
+  InterningMessageCodec sender(options);
+  InterningMessageCodec receiver(options);
+  Records records("cafe");
+  std::vector<uint8_t> bytes;
+  ASSERT_TRUE(sender.EncodeMessage(records.root, &bytes));
+  EXPECT_EQ(sender.encoder_table().size(), 3u);
+  Arena arena;
+  const Value* decoded =
+      receiver.DecodeMessage(bytes.data(), bytes.size(), &arena);
+  ASSERT_NE(decoded, nullptr);
+  EXPECT_TRUE(ValuesEqual(records.root, *decoded));
+}
+
+TEST(InterningCodecTest, RespectsTheTableLimits) {
+  InterningOptions options;
+  options.max_length = 4;
+  options.max_entries = 1;
+  InterningMessageCodec sender(options);
+  InterningMessageCodec receiver(options);
+  MapEntry entries[] = {{Value::String("long key"), Value::Null()},
+                        {Value::String("a"), Value::Null()},
+                        {Value::String("b"), Value::Null()}};
+  Value map = Value::Map(entries, 3);
+  std::vector<uint8_t> bytes;
+  ASSERT_TRUE(sender.EncodeMessage(map, &bytes));
+  EXPECT_EQ(sender.encoder_table().size(), 1u);
+  Arena arena;
+  const Value* decoded =
+      receiver.DecodeMessage(bytes.data(), bytes.size(), &arena);
+  ASSERT_NE(decoded, nullptr);
+  EXPECT_TRUE(ValuesEqual(map, *decoded));
+}
+
+TEST(InterningCodecTest, InternedStringsOutliveTheMessage) {
+  InterningMessageCodec sender;
+  InterningMessageCodec receiver;
+  Records records("bar");
+  std::vector<uint8_t> bytes;
+  ASSERT_TRUE(sender.EncodeMessage(records.root, &bytes));
+  Arena arena;
+  const Value* decoded =
+      receiver.DecodeMessage(bytes.data(), bytes.size(), &arena);
+  ASSERT_NE(decoded, nullptr);
+  bytes.assign(bytes.size(), 0);
+  EXPECT_EQ(decoded->list[2].map[0].key.string, "identifier");
+}
+
+TEST(InterningCodecTest, FallsOutOfSyncOnAMissedMessageUntilReset) {
+  InterningMessageCodec sender;
+  InterningMessageCodec receiver;
+  Records first("first");
+  MapEntry entries[] = {{Value::String("new key"), Value::Int32(1)}};
+  Value second = Value::Map(entries, 1);
+  std::vector<uint8_t> bytes;
+  ASSERT_TRUE(sender.EncodeMessage(first.root, &bytes));
+  Arena arena;
+  ASSERT_NE(receiver.DecodeMessage(bytes.data(), bytes.size(), &arena),
+            nullptr);
+
+  // Lost on the way: defines "new key".
+  ASSERT_TRUE(sender.EncodeMessage(second, &bytes));
+  // Refers to it.
+  ASSERT_TRUE(sender.EncodeMessage(second, &bytes));
+  EXPECT_EQ(receiver.DecodeMessage(bytes.data(), bytes.size(), &arena),
+            nullptr);
+  EXPECT_TRUE(receiver.needs_peer_reset());
+
+  // Even messages it could decode are refused until the peer resets.
+  ASSERT_TRUE(sender.EncodeMessage(first.root, &bytes));
+  EXPECT_EQ(receiver.DecodeMessage(bytes.data(), bytes.size(), &arena),
+            nullptr);
+
+  sender.ResetEncoder();
+  ASSERT_TRUE(sender.EncodeMessage(second, &bytes));
+  const Value* decoded =
+      receiver.DecodeMessage(bytes.data(), bytes.size(), &arena);
+  ASSERT_NE(decoded, nullptr);
+  EXPECT_TRUE(ValuesEqual(second, *decoded));
+  EXPECT_FALSE(receiver.needs_peer_reset());
+}
+
+TEST(InterningCodecTest, RejectsMessagesFromAnotherEpoch) {
+  InterningMessageCodec sender;
+  InterningMessageCodec other_sender;
+  InterningMessageCodec receiver;
+  std::vector<uint8_t> bytes;
+  ASSERT_TRUE(sender.EncodeMessage(Value::Null(), &bytes));
+  Arena arena;
+  ASSERT_NE(receiver.DecodeMessage(bytes.data(), bytes.size(), &arena),
+            nullptr);
+  ASSERT_TRUE(other_sender.EncodeMessage(Value::Null(), &bytes));
+  ASSERT_TRUE(other_sender.EncodeMessage(Value::Null(), &bytes));
+  ASSERT_NE(sender.encoder_table().epoch(),
+            other_sender.encoder_table().epoch());
+  EXPECT_EQ(receiver.DecodeMessage(bytes.data(), bytes.size(), &arena),
+            nullptr);
+}
+
+TEST(InterningCodecTest, RejectsEveryTruncation) {
+  Records records("truncated");
+  InterningMessageCodec sender;
+  std::vector<uint8_t> bytes;
+  ASSERT_TRUE(sender.EncodeMessage(records.root, &bytes));
+  for (size_t size = 0; size < bytes.size(); size++) {
+    InterningMessageCodec receiver;
+    Arena arena;
+    EXPECT_EQ(receiver.DecodeMessage(bytes.data(), size, &arena), nullptr)
+        << "size " << size;
+    EXPECT_TRUE(receiver.needs_peer_reset());
+  }
+}
+
+TEST(InterningCodecTest, RejectsUnknownAndOutOfOrderIds) {
+  // A reset header, then a reference to a string never defined.
+  const uint8_t reference[] = {1, 0, 0, 0, 0,
+                               static_cast<uint8_t>(InternedField::kReference),
+                               0};
+  // A definition skipping ID 0.
+  const uint8_t skipped[] = {1, 0, 0, 0, 0,
+                             static_cast<uint8_t>(InternedField::kDefinition),
+                             1, 1, 'a'};
+  for (const auto& message : {std::vector<uint8_t>(std::begin(reference),
+                                                   std::end(reference)),
+                              std::vector<uint8_t>(std::begin(skipped),
+                                                   std::end(skipped))}) {
+    InterningMessageCodec receiver;
+    Arena arena;
+    EXPECT_EQ(receiver.DecodeMessage(message.data(), message.size(), &arena),
+              nullptr);
+  }
+}
+
+TEST(InterningCodecTest, RejectsDefinitionsBeyondTheLimits) {
+  InterningOptions options;
+  options.max_length = 2;
+  const uint8_t too_long[] = {1, 0, 0, 0, 0,
+                              static_cast<uint8_t>(InternedField::kDefinition),
+                              0, 3, 'a', 'b', 'c'};
+  InterningMessageCodec receiver(options);
+  Arena arena;
+  EXPECT_EQ(receiver.DecodeMessage(too_long, sizeof(too_long), &arena),
+            nullptr);
+}
+
+}  // namespace
+}  // namespace platzi
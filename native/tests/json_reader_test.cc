@@ -0,0 +1,184 @@
+#include "codec/json_reader.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "codec/json_message_codec.h"
+#include "tests/value_testing.h"
+
+namespace platzi {
+namespace {
+
+class JsonReaderTest : public ::testing::Test {
+ protected:
+  // Copies strings, as |json| is usually a temporary.
+  const Value* Decode(const std::string& json) {
+    return reader_.Decode(reinterpret_cast<const uint8_t*>(json.data()),
+                          json.size(), &arena_, DecodeMode::kCopy);
+  }
+
+  JsonReader reader_;
+  Arena arena_;
+};
+
+TEST_F(JsonReaderTest, DecodesScalars) {
+  EXPECT_TRUE(ValuesEqual(Value::Null(), *Decode("null")));
+  EXPECT_TRUE(ValuesEqual(Value::Bool(true), *Decode(" true ")));
+  EXPECT_TRUE(ValuesEqual(Value::Bool(false), *Decode("\n\tfalse")));
+  EXPECT_TRUE(ValuesEqual(Value::String("hi"), *Decode("\"hi\"")));
+  EXPECT_TRUE(ValuesEqual(Value::Float64(-0.0), *Decode("-0.0")));
+  EXPECT_TRUE(ValuesEqual(Value::Float64(0.0), *Decode("1e-400")));
+  EXPECT_TRUE(ValuesEqual(Value::Float64(1.5e3), *Decode("1.5E+3")));
+}
+
+TEST_F(JsonReaderTest, PicksTheNarrowestIntegerType) {
+  EXPECT_TRUE(ValuesEqual(Value::Int32(0), *Decode("0")));
+  EXPECT_TRUE(ValuesEqual(Value::Int32(std::numeric_limits<int32_t>::max()),
+                          *Decode("2147483647")));
+  EXPECT_TRUE(ValuesEqual(Value::Int64(2147483648ll), *Decode("2147483648")));
+  EXPECT_TRUE(ValuesEqual(Value::Int32(std::numeric_limits<int32_t>::min()),
+                          *Decode("-2147483648")));
+  EXPECT_TRUE(ValuesEqual(Value::Int64(std::numeric_limits<int64_t>::min()),
+                          *Decode("-9223372036854775808")));
+  EXPECT_TRUE(ValuesEqual(Value::Float64(9223372036854775808.0),
+                          *Decode("9223372036854775808")));
+  EXPECT_TRUE(ValuesEqual(Value::Float64(1e20),
+                          *Decode("100000000000000000000")));
+}
+
+TEST_F(JsonReaderTest, UnescapesStrings) {
+  const Value* value =
+      Decode(R"("a\"b\\c\/d\b\f\n\r\t\u00e9\u65e5\ud83d\ude00")");
+  ASSERT_NE(value, nullptr);
+  EXPECT_EQ(value->string,
+            "a\"b\\c/d\b\f\n\r\t\xC3\xA9\xE6\x97\xA5\xF0\x9F\x98\x80");
+  // Unpaired surrogates become U+FFFD.
+  value = Decode(R"(["\ud800x", "\udc00"])");
+  ASSERT_NE(value, nullptr);
+  EXPECT_EQ(value->list[0].string, "\xEF\xBF\xBDx");
+  EXPECT_EQ(value->list[1].string, "\xEF\xBF\xBD");
+}
+
+TEST_F(JsonReaderTest, KeepsTheFirstPositionAndLastValueOfDuplicateKeys) {
+  const Value* value = Decode(R"({"a": 1, "b": 2, "a": 3})");
+  ASSERT_NE(value, nullptr);
+  MapEntry entries[] = {{Value::String("a"), Value::Int32(3)},
+                        {Value::String("b"), Value::Int32(2)}};
+  EXPECT_TRUE(ValuesEqual(Value::Map(entries, 2), *value));
+
+  // Large maps take another path.
+  std::string json = "{";
+  for (int i = 0; i < 100; i++) {
+    json += "\"k" + std::to_string(i % 50) + "\": " + std::to_string(i) + ",";
+  }
+  json.back() = '}';
+  value = Decode(json);
+  ASSERT_NE(value, nullptr);
+  ASSERT_EQ(value->map.size, 50u);
+  EXPECT_EQ(value->map[7].key.string, "k7");
+  EXPECT_EQ(value->map[7].value.int32, 57);
+}
+
+TEST_F(JsonReaderTest, RoundTripsThroughTheCodec) {
+  // Long enough to span several blocks of the first pass, with escapes and
+  // multi-byte characters straddling their boundaries.
+  std::vector<std::string> strings;
+  for (int i = 0; i < 40; i++) {
+    strings.push_back(std::string(i, 'x') + "\"\\\u00e9\u65e5" +
+                      std::string(i % 7, '\\'));
+  }
+  std::vector<Value> items;
+  for (const std::string& string : strings) {
+    items.push_back(Value::String(string));
+    items.push_back(Value::Int64(-(1ll << 40) - items.size()));
+    // Integral doubles are written without a fraction, so they would come
+    // back as integers.
+    items.push_back(Value::Float64(0.25 + items.size()));
+  }
+  MapEntry entries[] = {
+      {Value::String("items"), Value::List(items.data(), items.size())},
+      {Value::String("empty"), Value::Map(nullptr, 0)},
+      {Value::String("none"), Value::Null()},
+  };
+  Value message = Value::Map(entries, 3);
+  std::vector<uint8_t> bytes;
+  ASSERT_TRUE(JsonMessageCodec::EncodeMessage(message, &bytes));
+  for (DecodeMode mode : {DecodeMode::kBorrow, DecodeMode::kCopy}) {
+    const Value* decoded =
+        JsonMessageCodec::DecodeMessage(bytes.data(), bytes.size(), &arena_,
+                                        mode);
+    ASSERT_NE(decoded, nullptr);
+    EXPECT_TRUE(ValuesEqual(message, *decoded));
+  }
+}
+
+TEST_F(JsonReaderTest, DecodesDeepNesting) {
+  std::string json = std::string(100000, '[') + std::string(100000, ']');
+  const Value* value = Decode(json);
+  ASSERT_NE(value, nullptr);
+  EXPECT_EQ(value->type, ValueType::kList);
+}
+
+TEST_F(JsonReaderTest, RejectsMalformedInput) {
+  const char* malformed[] = {
+      "",
+      "   ",
+      "nul",
+      "nulll",
+      "True",
+      "01",
+      "-",
+      "1.",
+      ".5",
+      "1e",
+      "+1",
+      "0x10",
+      "1 2",
+      "[1,]",
+      "[1 2]",
+      "[",
+      "]",
+      "[1}",
+      "{\"a\"}",
+      "{\"a\":}",
+      "{\"a\" 1}",
+      "{1: 2}",
+      "{\"a\": 1,}",
+      "\"unterminated",
+      "\"tab\there\"",
+      "\"\\x\"",
+      "\"\\u12\"",
+      "\"\\u12g4\"",
+      "\"\xC3\x28\"",
+      "\"\xED\xA0\x80\"",
+      "1e999",
+  };
+  for (const char* json : malformed) {
+    EXPECT_EQ(Decode(json), nullptr) << json;
+  }
+}
+
+TEST_F(JsonReaderTest, RejectsEveryTruncation) {
+  std::string json = R"({"list": [1, -2.5e3, "str\u00e9", true, null], )"
+                     R"("nested": {"a": [[], {}]}})";
+  ASSERT_NE(Decode(json), nullptr);
+  for (size_t size = 0; size < json.size(); size++) {
+    EXPECT_EQ(Decode(json.substr(0, size)), nullptr) << "size " << size;
+  }
+}
+
+TEST_F(JsonReaderTest, CodecMapsNoBytesToNull) {
+  const Value* value = JsonMessageCodec::DecodeMessage(nullptr, 0, &arena_);
+  ASSERT_NE(value, nullptr);
+  EXPECT_TRUE(value->is_null());
+  std::vector<uint8_t> bytes = {1};
+  ASSERT_TRUE(JsonMessageCodec::EncodeMessage(Value::Null(), &bytes));
+  EXPECT_TRUE(bytes.empty());
+}
+
+}  // namespace
+}  // namespace platzi
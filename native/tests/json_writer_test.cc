@@ -0,0 +1,129 @@
+#include "codec/json_writer.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "codec/json_reader.h"
+
+namespace platzi {
+namespace {
+
+std::string Write(const Value& value) {
+  std::vector<uint8_t> bytes;
+  JsonWriter writer(&bytes);
+  EXPECT_TRUE(writer.WriteValue(value));
+  return std::string(bytes.begin(), bytes.end());
+}
+
+TEST(JsonWriterTest, FormatsIntegers) {
+  EXPECT_EQ(Write(Value::Int32(0)), "0");
+  EXPECT_EQ(Write(Value::Int32(-7)), "-7");
+  EXPECT_EQ(Write(Value::Int32(std::numeric_limits<int32_t>::min())),
+            "-2147483648");
+  EXPECT_EQ(Write(Value::Int64(std::numeric_limits<int64_t>::max())),
+            "9223372036854775807");
+  EXPECT_EQ(Write(Value::Int64(std::numeric_limits<int64_t>::min())),
+            "-9223372036854775808");
+  for (int64_t value = 1; value < 1000000000000000000ll; value *= 10) {
+    EXPECT_EQ(Write(Value::Int64(value)), std::to_string(value));
+    EXPECT_EQ(Write(Value::Int64(value - 1)), std::to_string(value - 1));
+  }
+}
+
+TEST(JsonWriterTest, FormatsDoublesShortest) {
+  EXPECT_EQ(Write(Value::Float64(0.1)), "0.1");
+  EXPECT_EQ(Write(Value::Float64(-2.5)), "-2.5");
+  EXPECT_EQ(Write(Value::Float64(1e21)), "1e+21");
+  EXPECT_EQ(Write(Value::Float64(1.5e-7)), "1.5e-07");
+  EXPECT_EQ(Write(Value::Float64(5e-324)), "5e-324");
+  EXPECT_EQ(Write(Value::Float64(std::numeric_limits<double>::max())),
+            "1.7976931348623157e+308");
+}
+
+TEST(JsonWriterTest, FormatsIntegralDoublesAsIntegers) {
+  EXPECT_EQ(Write(Value::Float64(0.0)), "0");
+  EXPECT_EQ(Write(Value::Float64(-0.0)), "-0.0");
+  EXPECT_EQ(Write(Value::Float64(375.0)), "375");
+  EXPECT_EQ(Write(Value::Float64(9007199254740992.0)), "9007199254740992");
+  // Beyond 2^53 the digits would claim a precision the double lacks.
+  EXPECT_EQ(Write(Value::Float64(1e17)), "1e+17");
+}
+
+TEST(JsonWriterTest, DoublesReadBackExactly) {
+  uint64_t state = 0x9E3779B97F4A7C15ull;
+  for (int i = 0; i < 10000; i++) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    double value;
+    std::memcpy(&value, &state, sizeof(value));
+    if (!std::isfinite(value)) {
+      continue;
+    }
+    std::string json = Write(Value::Float64(value));
+    double read = std::strtod(json.c_str(), nullptr);
+    EXPECT_EQ(std::memcmp(&read, &value, sizeof(value)), 0) << json;
+  }
+}
+
+TEST(JsonWriterTest, EscapesStrings) {
+  EXPECT_EQ(Write(Value::String("a\"b\\c/d")), R"("a\"b\\c/d")");
+  EXPECT_EQ(Write(Value::String(std::string("\b\t\n\f\r\x01\x1F\0", 8))),
+            R"("\b\t\n\f\r\u0001\u001f\u0000")");
+  EXPECT_EQ(Write(Value::String("h\xC3\xA9llo")), "\"h\xC3\xA9llo\"");
+  // Runs longer than the 16 bytes scanned at a time.
+  std::string long_string = std::string(40, 'x') + "\n" + std::string(17, 'y');
+  EXPECT_EQ(Write(Value::String(long_string)),
+            "\"" + std::string(40, 'x') + "\\n" + std::string(17, 'y') + "\"");
+}
+
+TEST(JsonWriterTest, WritesCompactContainers) {
+  Value items[] = {Value::Int32(1), Value::Null(), Value::Bool(false),
+                   Value::List(nullptr, 0)};
+  MapEntry entries[] = {{Value::String("a"), Value::List(items, 4)},
+                        {Value::String("b"), Value::Map(nullptr, 0)}};
+  EXPECT_EQ(Write(Value::Map(entries, 2)),
+            R"({"a":[1,null,false,[]],"b":{}})");
+}
+
+TEST(JsonWriterTest, RefusesValuesJsonCannotHold) {
+  const uint8_t bytes[] = {1, 2};
+  MapEntry int_key[] = {{Value::Int32(1), Value::Null()}};
+  const Value refused[] = {
+      Value::Float64(std::numeric_limits<double>::quiet_NaN()),
+      Value::Float64(-std::numeric_limits<double>::infinity()),
+      Value::TypedData(TypedDataView::Of(bytes, 2)),
+      Value::Map(int_key, 1),
+  };
+  for (const Value& value : refused) {
+    std::vector<uint8_t> output;
+    JsonWriter writer(&output);
+    EXPECT_FALSE(writer.WriteValue(value));
+  }
+}
+
+TEST(JsonWriterTest, RoundTripsThroughTheReader) {
+  Value items[] = {Value::Float64(0.30000000000000004), Value::Float64(1e300),
+                   Value::Int64(-(1ll << 60)), Value::String("\x7F\"")};
+  std::string json = Write(Value::List(items, 4));
+  JsonReader reader;
+  Arena arena;
+  const Value* value = reader.Decode(
+      reinterpret_cast<const uint8_t*>(json.data()), json.size(), &arena);
+  ASSERT_NE(value, nullptr);
+  ASSERT_EQ(value->list.size, 4u);
+  EXPECT_EQ(value->list[0].float64, 0.30000000000000004);
+  EXPECT_EQ(value->list[1].float64, 1e300);
+  EXPECT_EQ(value->list[2].int64, -(1ll << 60));
+  EXPECT_EQ(value->list[3].string, "\x7F\"");
+}
+
+}  // namespace
+}  // namespace platzi
@@ -0,0 +1,151 @@
+#include "codec/lazy_value.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "codec/standard_message_codec.h"
+#include "tests/value_testing.h"
+
+namespace platzi {
+namespace {
+
+// A map of 100 places, each a map with a name and a list of tags, plus a
+// duplicate key and a non-string key.
+struct Places {
+  std::vector<std::string> names;
+  std::vector<std::string> keys;
+  std::vector<Value> tags;
+  std::vector<MapEntry> fields;
+  std::vector<MapEntry> entries;
+  Value root;
+
+  Places() {
+    for (int i = 0; i < 100; i++) {
+      names.push_back("place " + std::to_string(i));
+      keys.push_back("id" + std::to_string(i));
+    }
+    for (int i = 0; i < 100; i++) {
+      tags.push_back(Value::Int32(i));
+      tags.push_back(Value::Int32(-i));
+    }
+    for (int i = 0; i < 100; i++) {
+      fields.push_back({Value::String("name"), Value::String(names[i])});
+      fields.push_back({Value::String("tags"), Value::List(&tags[2 * i], 2)});
+    }
+    for (int i = 0; i < 100; i++) {
+      entries.push_back(
+          {Value::String(keys[i]), Value::Map(&fields[2 * i], 2)});
+    }
+    entries.push_back({Value::Int32(5), Value::String("int key")});
+    entries.push_back({Value::String("id3"), Value::Null()});
+    root = Value::Map(entries.data(), entries.size());
+  }
+};
+
+TEST(LazyValueTest, FindsNestedValues) {
+  Places places;
+  std::vector<uint8_t> bytes;
+  ASSERT_TRUE(StandardMessageCodec::EncodeMessage(places.root, &bytes));
+  LazyMessage message(bytes.data(), bytes.size());
+  LazyValue root = message.root();
+  ASSERT_TRUE(root.is_map());
+  EXPECT_EQ(root.size(), 102u);
+
+  // Backwards first, so that later lookups hit the index.
+  for (int i = 99; i >= 0; i--) {
+    LazyValue place = root.Find("id" + std::to_string(i));
+    ASSERT_TRUE(place.is_map()) << i;
+    EXPECT_EQ(place.Find("name").token().string, places.names[i]);
+    EXPECT_EQ(place.Find("tags").At(1).token().int32, -i);
+  }
+  // The first of duplicate keys wins.
+  EXPECT_TRUE(root.Find("id3").is_map());
+  EXPECT_EQ(root.KeyAt(100).token().int32, 5);
+  EXPECT_EQ(root.ValueAt(100).token().string, "int key");
+  EXPECT_EQ(root.ValueAt(101).type(), StandardField::kNil);
+}
+
+TEST(LazyValueTest, DecodesSubtrees) {
+  Places places;
+  std::vector<uint8_t> bytes;
+  ASSERT_TRUE(StandardMessageCodec::EncodeMessage(places.root, &bytes));
+  LazyMessage message(bytes.data(), bytes.size());
+  Arena arena;
+  const Value* whole = message.root().Decode(&arena);
+  ASSERT_NE(whole, nullptr);
+  EXPECT_TRUE(ValuesEqual(places.root, *whole));
+  const Value* place = message.root().Find("id42").Decode(&arena);
+  ASSERT_NE(place, nullptr);
+  EXPECT_TRUE(ValuesEqual(places.entries[42].value, *place));
+}
+
+TEST(LazyValueTest, MissingLookupsChainToInvalid) {
+  Value items[] = {Value::Int32(1), Value::String("a")};
+  std::vector<uint8_t> bytes;
+  ASSERT_TRUE(
+      StandardMessageCodec::EncodeMessage(Value::List(items, 2), &bytes));
+  LazyMessage message(bytes.data(), bytes.size());
+  LazyValue root = message.root();
+  EXPECT_TRUE(root.At(1).valid());
+  EXPECT_FALSE(root.At(2).valid());
+  EXPECT_FALSE(root.Find("a").valid());
+  EXPECT_FALSE(root.KeyAt(0).valid());
+  EXPECT_FALSE(root.At(0).At(0).valid());
+  EXPECT_FALSE(root.At(7).Find("x").At(3).valid());
+  EXPECT_EQ(root.At(7).size(), 0u);
+  Arena arena;
+  EXPECT_EQ(root.At(7).Decode(&arena), nullptr);
+}
+
+TEST(LazyValueTest, ReadsWhatPrecedesATruncation) {
+  Places places;
+  std::vector<uint8_t> bytes;
+  ASSERT_TRUE(StandardMessageCodec::EncodeMessage(places.root, &bytes));
+  // Cut the message in the middle.
+  LazyMessage message(bytes.data(), bytes.size() / 2);
+  LazyValue root = message.root();
+  ASSERT_TRUE(root.is_map());
+  EXPECT_TRUE(root.Find("id1").Find("name").valid());
+  EXPECT_FALSE(root.Find("id99").valid());
+  // Once a scan runs into the truncation the map is known to be malformed,
+  // and even entries before it are no longer handed out.
+  EXPECT_FALSE(root.ValueAt(101).valid());
+  EXPECT_FALSE(root.Find("id1").valid());
+  Arena arena;
+  EXPECT_EQ(root.Decode(&arena), nullptr);
+}
+
+TEST(LazyValueTest, RejectsEveryTruncationOfTheLastValue) {
+  Places places;
+  std::vector<uint8_t> bytes;
+  ASSERT_TRUE(StandardMessageCodec::EncodeMessage(places.entries[7].value,
+                                                  &bytes));
+  for (size_t size = 0; size < bytes.size(); size++) {
+    LazyMessage message(bytes.data(), size);
+    LazyValue tags = message.root().Find("tags");
+    EXPECT_FALSE(tags.valid() && tags.At(1).valid()) << "size " << size;
+  }
+}
+
+TEST(LazyValueTest, RejectsMalformedHeaders) {
+  const uint8_t unknown[] = {100};
+  LazyMessage unknown_message(unknown, sizeof(unknown));
+  EXPECT_FALSE(unknown_message.root().valid());
+
+  LazyMessage empty_message(nullptr, 0);
+  EXPECT_FALSE(empty_message.root().valid());
+
+  // A map claiming far more entries than it holds is refused before its
+  // index is allocated.
+  const uint8_t huge[] = {13, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 7, 1, 'a', 0};
+  LazyMessage huge_message(huge, sizeof(huge));
+  LazyValue root = huge_message.root();
+  ASSERT_TRUE(root.is_map());
+  EXPECT_FALSE(root.Find("a").valid());
+  EXPECT_FALSE(root.ValueAt(0).valid());
+}
+
+}  // namespace
+}  // namespace platzi
@@ -0,0 +1,284 @@
+#include "codec/lz_block.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "codec/binary_codec.h"
+#include "codec/compressed_codec.h"
+#include "codec/interning_codec.h"
+#include "codec/standard_message_codec.h"
+#include "codec/string_codec.h"
+#include "tests/value_testing.h"
+
+namespace platzi {
+namespace {
+
+std::vector<uint8_t> Random(size_t size, uint32_t seed) {
+  std::vector<uint8_t> bytes(size);
+  for (uint8_t& byte : bytes) {
+    seed = seed * 1664525 + 1013904223;
+    byte = static_cast<uint8_t>(seed >> 24);
+  }
+  return bytes;
+}
+
+// Inputs exercising literals only, short and long matches, overlapping
+// matches at every small offset, and matches at the 64 KB window edge.
+std::vector<std::vector<uint8_t>> Inputs() {
+  std::vector<std::vector<uint8_t>> inputs;
+  for (size_t size : {0, 1, 4, 15, 16, 17, 100, 5000}) {
+    inputs.push_back(Random(size, static_cast<uint32_t>(size)));
+    inputs.push_back(std::vector<uint8_t>(size, 'z'));
+  }
+  for (size_t period = 1; period <= 20; period++) {
+    std::vector<uint8_t> periodic;
+    for (size_t i = 0; i < 1000; i++) {
+      periodic.push_back(static_cast<uint8_t>('a' + i % period));
+    }
+    inputs.push_back(periodic);
+  }
+  std::string text;
+  for (int i = 0; i < 500; i++) {
+    text += "{\"id\":" + std::to_string(i) + ",\"name\":\"place " +
+            std::to_string(i * 7 % 13) + "\"},";
+  }
+  inputs.emplace_back(text.begin(), text.end());
+  std::vector<uint8_t> window = Random(70000, 7);
+  std::vector<uint8_t> block = Random(64, 8);
+  window.insert(window.begin(), block.begin(), block.end());
+  window.insert(window.begin() + 65535, block.begin(), block.end());
+  window.insert(window.end(), block.begin(), block.end());
+  inputs.push_back(window);
+  return inputs;
+}
+
+TEST(LzBlockTest, RoundTrips) {
+  for (const std::vector<uint8_t>& input : Inputs()) {
+    std::vector<uint8_t> compressed(LzCompressBound(input.size()));
+    size_t compressed_size =
+        LzCompress(input.data(), input.size(), compressed.data());
+    ASSERT_LE(compressed_size, compressed.size());
+    // Exactly the room needed, so that chunked copies must stay inside.
+    std::vector<uint8_t> output(input.size());
+    size_t output_size;
+    ASSERT_TRUE(LzDecompress(compressed.data(), compressed_size,
+                             output.data(), output.size(), &output_size))
+        << "size " << input.size();
+    EXPECT_EQ(output_size, input.size());
+    EXPECT_EQ(output, input);
+  }
+}
+
+TEST(LzBlockTest, CompressesRedundantInput) {
+  std::vector<uint8_t> zeros(100000, 0);
+  std::vector<uint8_t> compressed(LzCompressBound(zeros.size()));
+  EXPECT_LT(LzCompress(zeros.data(), zeros.size(), compressed.data()), 1000u);
+}
+
+TEST(LzBlockTest, RejectsOutputThatDoesNotFit) {
+  std::vector<uint8_t> input(1000, 'q');
+  std::vector<uint8_t> compressed(LzCompressBound(input.size()));
+  size_t compressed_size =
+      LzCompress(input.data(), input.size(), compressed.data());
+  std::vector<uint8_t> output(999);
+  size_t output_size;
+  EXPECT_FALSE(LzDecompress(compressed.data(), compressed_size, output.data(),
+                            output.size(), &output_size));
+}
+
+TEST(LzBlockTest, RejectsMalformedBlocks) {
+  const std::vector<std::vector<uint8_t>> malformed = {
+      {},
+      // Five literals promised, one present.
+      {0x50, 'a'},
+      // A literal length tail that never ends.
+      {0xF0, 0xFF, 0xFF},
+      // A match at offset zero.
+      {0x10, 'a', 0x00, 0x00},
+      // A match reaching back before the output.
+      {0x10, 'a', 0x02, 0x00},
+      // A truncated offset.
+      {0x10, 'a', 0x01},
+      // A match length tail that never ends.
+      {0x1F, 'a', 0x01, 0x00, 0xFF},
+  };
+  for (const std::vector<uint8_t>& block : malformed) {
+    uint8_t output[64];
+    size_t output_size;
+    EXPECT_FALSE(LzDecompress(block.data(), block.size(), output,
+                              sizeof(output), &output_size))
+        << "size " << block.size();
+  }
+}
+
+TEST(LzBlockTest, SurvivesCorruptBlocks) {
+  std::vector<uint8_t> input = Inputs().back();
+  std::vector<uint8_t> compressed(LzCompressBound(input.size()));
+  compressed.resize(LzCompress(input.data(), input.size(), compressed.data()));
+  std::vector<uint8_t> output(input.size());
+  for (uint32_t seed = 0; seed < 200; seed++) {
+    std::vector<uint8_t> corrupt = compressed;
+    std::vector<uint8_t> noise = Random(8, seed);
+    for (size_t i = 0; i < noise.size(); i += 2) {
+      corrupt[(noise[i] * 257 + noise[i + 1] * seed) % corrupt.size()] ^=
+          noise[i + 1] | 1;
+    }
+    size_t output_size;
+    // Either outcome is fine, as long as nothing is read or written out of
+    // bounds, which the sanitizers check.
+    LzDecompress(corrupt.data(), corrupt.size(), output.data(), output.size(),
+                 &output_size);
+    LzDecompress(corrupt.data(), corrupt.size() / 2, output.data(),
+                 output.size(), &output_size);
+  }
+}
+
+TEST(CompressedFrameTest, StoresSmallOrIncompressiblePayloads) {
+  std::vector<uint8_t> small(100, 'a');
+  std::vector<uint8_t> frame;
+  EncodeFrame(small.data(), small.size(), &frame);
+  bool compressed;
+  size_t payload_size;
+  ASSERT_TRUE(
+      ReadFrameHeader(frame.data(), frame.size(), &compressed, &payload_size));
+  EXPECT_FALSE(compressed);
+  EXPECT_EQ(payload_size, small.size());
+
+  std::vector<uint8_t> noise = Random(10000, 3);
+  EncodeFrame(noise.data(), noise.size(), &frame);
+  ASSERT_TRUE(
+      ReadFrameHeader(frame.data(), frame.size(), &compressed, &payload_size));
+  EXPECT_FALSE(compressed);
+  EXPECT_EQ(frame.size(), kFrameHeaderSize + noise.size());
+}
+
+TEST(CompressedFrameTest, RoundTripsCompressedPayloads) {
+  std::vector<uint8_t> text = Inputs()[Inputs().size() - 2];
+  std::vector<uint8_t> frame;
+  EncodeFrame(text.data(), text.size(), &frame);
+  bool compressed;
+  size_t payload_size;
+  ASSERT_TRUE(
+      ReadFrameHeader(frame.data(), frame.size(), &compressed, &payload_size));
+  EXPECT_TRUE(compressed);
+  ASSERT_EQ(payload_size, text.size());
+  std::vector<uint8_t> payload(payload_size);
+  ASSERT_TRUE(
+      DecodeFrame(frame.data(), frame.size(), payload.data(), payload.size()));
+  EXPECT_EQ(payload, text);
+}
+
+TEST(CompressedFrameTest, RejectsMalformedHeaders) {
+  bool compressed;
+  size_t payload_size;
+  uint8_t header[kFrameHeaderSize] = {};
+  EXPECT_FALSE(ReadFrameHeader(header, kFrameHeaderSize - 1, &compressed,
+                               &payload_size));
+  header[0] = 2;
+  EXPECT_FALSE(
+      ReadFrameHeader(header, kFrameHeaderSize, &compressed, &payload_size));
+
+  // A compressed size no block of this length could expand to.
+  std::vector<uint8_t> frame(kFrameHeaderSize + 4, 0);
+  frame[0] = kCompressedFrameFlag;
+  frame[6] = 1;
+  EXPECT_FALSE(
+      ReadFrameHeader(frame.data(), frame.size(), &compressed, &payload_size));
+}
+
+TEST(CompressedFrameTest, RejectsPayloadsOfTheWrongSize) {
+  std::vector<uint8_t> text = Inputs()[Inputs().size() - 2];
+  std::vector<uint8_t> frame;
+  EncodeFrame(text.data(), text.size(), &frame);
+  // Claim one byte more than the block holds.
+  uint32_t size = static_cast<uint32_t>(text.size() + 1);
+  std::memcpy(frame.data() + 4, &size, sizeof(size));
+  std::vector<uint8_t> payload(size);
+  EXPECT_FALSE(
+      DecodeFrame(frame.data(), frame.size(), payload.data(), payload.size()));
+  EXPECT_FALSE(DecodeFrame(frame.data(), frame.size(), payload.data(),
+                           text.size()));
+}
+
+TEST(CompressedFrameTest, WrapsAMessageCodec) {
+  std::vector<Value> items(2000, Value::String("repeated"));
+  Value message = Value::List(items.data(), items.size());
+  using Codec = CompressedMessageCodec<StandardMessageCodec>;
+  std::vector<uint8_t> bytes;
+  ASSERT_TRUE(Codec::EncodeMessage(message, &bytes));
+  EXPECT_EQ(bytes[0], kCompressedFrameFlag);
+  for (DecodeMode mode : {DecodeMode::kBorrow, DecodeMode::kCopy}) {
+    Arena arena;
+    const Value* decoded =
+        Codec::DecodeMessage(bytes.data(), bytes.size(), &arena, mode);
+    ASSERT_NE(decoded, nullptr);
+    EXPECT_TRUE(ValuesEqual(message, *decoded));
+  }
+  for (size_t size = 0; size < bytes.size(); size++) {
+    Arena arena;
+    EXPECT_EQ(Codec::DecodeMessage(bytes.data(), size, &arena), nullptr)
+        << "size " << size;
+  }
+}
+
+TEST(CompressedFrameTest, WrapsByteAndStringCodecs) {
+  std::string text;
+  for (int i = 0; i < 1000; i++) {
+    text += "line " + std::to_string(i % 10) + "\n";
+  }
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(text.data());
+  std::vector<uint8_t> frame;
+  using Binary = CompressedMessageCodec<BinaryCodec>;
+  ASSERT_TRUE(Binary::EncodeMessage(bytes, text.size(), &frame));
+  EXPECT_EQ(frame[0], kCompressedFrameFlag);
+  Arena arena;
+  ByteSpan message = Binary::DecodeMessage(frame.data(), frame.size(), &arena);
+  EXPECT_EQ(std::string(reinterpret_cast<const char*>(message.data),
+                        message.size),
+            text);
+  EXPECT_EQ(Binary::DecodeMessage(frame.data(), 4, &arena).data, nullptr);
+
+  using String = CompressedMessageCodec<StringCodec>;
+  ASSERT_TRUE(String::EncodeMessage(std::string_view(text), &frame));
+  std::string_view decoded;
+  ASSERT_TRUE(
+      String::DecodeMessage(frame.data(), frame.size(), &arena, &decoded));
+  EXPECT_EQ(decoded, text);
+  std::u16string wide;
+  ASSERT_TRUE(String::DecodeMessage(frame.data(), frame.size(), &arena, &wide));
+  EXPECT_EQ(wide.size(), text.size());
+  EXPECT_FALSE(String::DecodeMessage(frame.data(), 4, &arena, &decoded));
+}
+
+TEST(CompressedFrameTest, WrapsStatefulCodecs) {
+  std::vector<MapEntry> entries;
+  for (int i = 0; i < 1000; i++) {
+    entries.push_back({Value::String("a key to intern"), Value::Int32(i)});
+  }
+  std::vector<Value> items;
+  for (const MapEntry& entry : entries) {
+    items.push_back(Value::Map(&entry, 1));
+  }
+  Value message = Value::List(items.data(), items.size());
+  using Codec = CompressedMessageCodec<InterningMessageCodec>;
+  InterningMessageCodec sender;
+  InterningMessageCodec receiver;
+  // Twice, so that the second message refers to the table the first built.
+  for (int i = 0; i < 2; i++) {
+    std::vector<uint8_t> frame;
+    ASSERT_TRUE(Codec::EncodeMessage(&sender, message, &frame));
+    EXPECT_EQ(frame[0], kCompressedFrameFlag);
+    Arena arena;
+    const Value* decoded = Codec::DecodeMessage(&receiver, frame.data(),
+                                                frame.size(), &arena);
+    ASSERT_NE(decoded, nullptr);
+    EXPECT_TRUE(ValuesEqual(message, *decoded));
+  }
+}
+
+}  // namespace
+}  // namespace platzi
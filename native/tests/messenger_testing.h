@@ -0,0 +1,57 @@
+#ifndef NATIVE_TESTS_MESSENGER_TESTING_H_
+#define NATIVE_TESTS_MESSENGER_TESTING_H_
+
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "messenger/binary_messenger.h"
+
+namespace platzi {
+
+// The bytes of |text| as a message, borrowed like those of a transport.
+inline BinaryMessage Bytes(const std::string& text) {
+  return BinaryMessage{reinterpret_cast<const uint8_t*>(text.data()),
+                       text.size()};
+}
+
+// The bytes of |message| as text, or "<nil>" for a nil message.
+inline std::string Text(BinaryMessage message) {
+  return message.data == nullptr
+             ? "<nil>"
+             : std::string(reinterpret_cast<const char*>(message.data),
+                           message.size);
+}
+
+// Records what the messenger sends to the peer.
+class RecordingTransport : public MessengerTransport {
+ public:
+  struct Sent {
+    ChannelId channel;
+    std::string name;
+    std::string message;
+    uint32_t response_id;
+  };
+
+  void SendMessage(ChannelId channel,
+                   std::string_view name,
+                   BinaryMessage message,
+                   uint32_t response_id) override {
+    sent.push_back({channel, std::string(name), Text(message), response_id});
+  }
+
+  void SendReply(uint32_t response_id, BinaryMessage reply) override {
+    replies.push_back({response_id, Text(reply)});
+  }
+
+  void ResumeReceiving() override { resumed++; }
+
+  std::vector<Sent> sent;
+  std::vector<std::pair<uint32_t, std::string>> replies;
+  int resumed = 0;
+};
+
+}  // namespace platzi
+
+#endif  // NATIVE_TESTS_MESSENGER_TESTING_H_
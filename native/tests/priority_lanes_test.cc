@@ -0,0 +1,181 @@
+#include "messenger/priority_lanes.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <vector>
+
+namespace platzi {
+namespace {
+
+using Clock = PriorityLanes::Clock;
+
+constexpr ChannelPriority kInteractive = ChannelPriority::kInteractive;
+constexpr ChannelPriority kDefault = ChannelPriority::kDefault;
+constexpr ChannelPriority kBulk = ChannelPriority::kBulk;
+
+// A message that costs |cost| to dispatch, message cost included.
+std::vector<uint8_t> Costing(size_t cost) {
+  return std::vector<uint8_t>(cost - PriorityLaneOptions::kMessageCost);
+}
+
+void Push(PriorityLanes* lanes,
+          ChannelPriority lane,
+          ChannelId channel,
+          const std::vector<uint8_t>& bytes,
+          Clock::time_point now = Clock::time_point()) {
+  lanes->Push(lane, channel, ByteSpan{bytes.data(), bytes.size()}, 0, now);
+}
+
+// The channels of the messages popped until the lanes are empty.
+std::vector<ChannelId> PopAll(PriorityLanes* lanes) {
+  std::vector<ChannelId> channels;
+  PriorityLanes::Entry entry;
+  while (lanes->Pop(&entry, Clock::time_point())) {
+    channels.push_back(entry.channel);
+  }
+  return channels;
+}
+
+TEST(PriorityLanesTest, PopsHigherLanesFirstWithinTheirCredit) {
+  PriorityLanes lanes{PriorityLaneOptions()};
+  EXPECT_TRUE(lanes.empty());
+  std::vector<uint8_t> message(1000);
+  // Channels named after their lanes.
+  for (int i = 0; i < 3; i++) {
+    Push(&lanes, kBulk, 3, message);
+  }
+  Push(&lanes, kDefault, 2, message);
+  Push(&lanes, kInteractive, 1, message);
+  EXPECT_EQ(lanes.size(kBulk), 3u);
+  EXPECT_EQ(lanes.byte_size(kBulk), 3000u);
+  EXPECT_EQ(PopAll(&lanes), (std::vector<ChannelId>{1, 2, 3, 3, 3}));
+  EXPECT_TRUE(lanes.empty());
+  EXPECT_EQ(lanes.byte_size(kBulk), 0u);
+}
+
+TEST(PriorityLanesTest, SharesByQuantumUnderLoad) {
+  PriorityLaneOptions options;
+  options.quantum[0] = 2000;
+  options.quantum[2] = 1000;
+  PriorityLanes lanes(options);
+  std::vector<uint8_t> message = Costing(1000);
+  for (int i = 0; i < 10; i++) {
+    Push(&lanes, kInteractive, 1, message);
+    Push(&lanes, kBulk, 3, message);
+  }
+  // Two interactive messages for each bulk one, and bulk ones are not
+  // starved.
+  std::vector<ChannelId> expected;
+  for (int i = 0; i < 5; i++) {
+    expected.insert(expected.end(), {1, 1, 3});
+  }
+  expected.insert(expected.end(), 5, 3);
+  EXPECT_EQ(PopAll(&lanes), expected);
+}
+
+TEST(PriorityLanesTest, PopsMessagesManyQuantaLarge) {
+  PriorityLanes lanes{PriorityLaneOptions()};
+  Push(&lanes, kBulk, 3, std::vector<uint8_t>(1 << 20));
+  std::vector<uint8_t> small(10);
+  Push(&lanes, kBulk, 3, small);
+  PriorityLanes::Entry entry;
+  ASSERT_TRUE(lanes.Pop(&entry, Clock::time_point()));
+  EXPECT_EQ(entry.bytes.size(), size_t{1} << 20);
+  ASSERT_TRUE(lanes.Pop(&entry, Clock::time_point()));
+  EXPECT_EQ(entry.bytes.size(), 10u);
+  EXPECT_FALSE(lanes.Pop(&entry, Clock::time_point()));
+}
+
+TEST(PriorityLanesTest, KeepsNilAndEmptyMessagesApart) {
+  PriorityLanes lanes{PriorityLaneOptions()};
+  lanes.Push(kDefault, 1, ByteSpan(), 7, Clock::time_point());
+  // An empty vector's data may be null, which would make it nil.
+  const uint8_t byte = 0;
+  lanes.Push(kDefault, 1, ByteSpan{&byte, 0}, 0, Clock::time_point());
+  PriorityLanes::Entry entry;
+  ASSERT_TRUE(lanes.Pop(&entry, Clock::time_point()));
+  EXPECT_TRUE(entry.nil);
+  EXPECT_EQ(entry.response_id, 7u);
+  ASSERT_TRUE(lanes.Pop(&entry, Clock::time_point()));
+  EXPECT_FALSE(entry.nil);
+  EXPECT_EQ(entry.response_id, 0u);
+}
+
+TEST(PriorityLanesTest, DispatchesAtOnceOnlyWhatWouldBeNext) {
+  PriorityLanes lanes{PriorityLaneOptions()};
+  EXPECT_TRUE(lanes.DispatchNow(kDefault, 8 * 1024));
+  // The rest of the round's credit.
+  EXPECT_TRUE(lanes.DispatchNow(kDefault, 8 * 1024 - 512));
+  EXPECT_FALSE(lanes.DispatchNow(kDefault, 0));
+  EXPECT_EQ(lanes.stats(kDefault).dispatched, 2u);
+
+  std::vector<uint8_t> message(10);
+  Push(&lanes, kBulk, 3, message);
+  // Behind a message of its own lane, but not of a lower one.
+  EXPECT_FALSE(lanes.DispatchNow(kBulk, 0));
+  EXPECT_TRUE(lanes.DispatchNow(kInteractive, 0));
+  Push(&lanes, kInteractive, 1, message);
+  EXPECT_FALSE(lanes.DispatchNow(kInteractive, 0));
+  EXPECT_FALSE(lanes.DispatchNow(kDefault, 0));
+}
+
+TEST(PriorityLanesTest, TakesAChannelInTheOrderItWasQueued) {
+  PriorityLanes lanes{PriorityLaneOptions()};
+  Clock::time_point start;
+  std::vector<uint8_t> message(100);
+  // Wraps the default lane's ring first.
+  for (int i = 0; i < 3; i++) {
+    Push(&lanes, kDefault, 9, message, start);
+  }
+  EXPECT_EQ(PopAll(&lanes).size(), 3u);
+  // Channel 1 changed lanes along the way.
+  for (int i = 0; i < 6; i++) {
+    std::vector<uint8_t> bytes(i + 1);
+    Push(&lanes, i < 3 ? kDefault : kBulk, i % 2 == 0 ? 1 : 2, bytes,
+         start + std::chrono::seconds(i));
+  }
+  std::vector<PriorityLanes::Entry> taken;
+  lanes.TakeChannel(1, &taken);
+  ASSERT_EQ(taken.size(), 3u);
+  EXPECT_EQ(taken[0].bytes.size(), 1u);
+  EXPECT_EQ(taken[1].bytes.size(), 3u);
+  EXPECT_EQ(taken[2].bytes.size(), 5u);
+  EXPECT_EQ(lanes.size(kDefault), 1u);
+  EXPECT_EQ(lanes.byte_size(kDefault), 2u);
+  EXPECT_EQ(lanes.byte_size(kBulk), 10u);
+
+  // What stays keeps its order, and new messages go behind it.
+  Push(&lanes, kDefault, 2, std::vector<uint8_t>(7));
+  PriorityLanes::Entry entry;
+  std::vector<size_t> sizes;
+  while (lanes.Pop(&entry, Clock::time_point())) {
+    EXPECT_EQ(entry.channel, 2u);
+    sizes.push_back(entry.bytes.size());
+  }
+  EXPECT_EQ(sizes, (std::vector<size_t>{2, 7, 4, 6}));
+  taken.clear();
+  lanes.TakeChannel(2, &taken);
+  EXPECT_TRUE(taken.empty());
+}
+
+TEST(PriorityLanesTest, CountsQueueingDelays) {
+  PriorityLanes lanes{PriorityLaneOptions()};
+  Clock::time_point start;
+  std::vector<uint8_t> message(10);
+  Push(&lanes, kBulk, 3, message, start);
+  Push(&lanes, kBulk, 3, message, start + std::chrono::milliseconds(1));
+  PriorityLanes::Entry entry;
+  ASSERT_TRUE(lanes.Pop(&entry, start + std::chrono::milliseconds(4)));
+  ASSERT_TRUE(lanes.Pop(&entry, start + std::chrono::milliseconds(5)));
+  const LaneStats& stats = lanes.stats(kBulk);
+  EXPECT_EQ(stats.dispatched, 2u);
+  EXPECT_EQ(stats.total_delay, std::chrono::milliseconds(8));
+  EXPECT_EQ(stats.max_delay, std::chrono::milliseconds(4));
+  lanes.ResetStats();
+  EXPECT_EQ(lanes.stats(kBulk).dispatched, 0u);
+  EXPECT_EQ(lanes.stats(kBulk).max_delay, Clock::duration(0));
+}
+
+}  // namespace
+}  // namespace platzi
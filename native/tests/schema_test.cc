@@ -0,0 +1,221 @@
+#include "codec/schema.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "codec/standard_writer.h"
+
+namespace schema_test {
+
+struct Review {
+  std::string author;
+  double rating = 0;
+};
+
+struct Place {
+  std::string name;
+  int32_t stars = 0;
+  int64_t visits = 0;
+  bool open = false;
+  std::optional<std::string> phone;
+  std::vector<bool> days;
+  std::vector<Review> reviews;
+};
+
+struct Series {
+  platzi::TypedDataView samples;
+};
+
+struct SeriesCopy {
+  std::vector<int64_t> samples;
+};
+
+}  // namespace schema_test
+
+PLATZI_SCHEMA(schema_test::Review,
+              PLATZI_FIELD(schema_test::Review, author),
+              PLATZI_FIELD(schema_test::Review, rating));
+PLATZI_SCHEMA(schema_test::Place,
+              PLATZI_FIELD(schema_test::Place, name),
+              PLATZI_FIELD(schema_test::Place, stars),
+              PLATZI_FIELD(schema_test::Place, visits),
+              PLATZI_FIELD(schema_test::Place, open),
+              PLATZI_FIELD(schema_test::Place, phone),
+              PLATZI_FIELD(schema_test::Place, days),
+              PLATZI_FIELD(schema_test::Place, reviews));
+PLATZI_SCHEMA(schema_test::Series,
+              PLATZI_FIELD(schema_test::Series, samples));
+PLATZI_SCHEMA(schema_test::SeriesCopy,
+              PLATZI_FIELD(schema_test::SeriesCopy, samples));
+
+namespace platzi {
+namespace {
+
+using schema_test::Place;
+using schema_test::Review;
+using schema_test::Series;
+using schema_test::SeriesCopy;
+
+std::vector<uint8_t> Encode(const Value& value) {
+  std::vector<uint8_t> bytes;
+  StandardWriter writer(&bytes);
+  writer.WriteValue(value);
+  return bytes;
+}
+
+Place SamplePlace() {
+  Place place;
+  place.name = "Café";
+  place.stars = 4;
+  place.visits = 1ll << 40;
+  place.open = true;
+  place.days = {true, false, true, true, false, false, true};
+  place.reviews = {{"ana", 4.5}, {"bo", 2}};
+  return place;
+}
+
+void ExpectPlacesEqual(const Place& expected, const Place& actual) {
+  EXPECT_EQ(actual.name, expected.name);
+  EXPECT_EQ(actual.stars, expected.stars);
+  EXPECT_EQ(actual.visits, expected.visits);
+  EXPECT_EQ(actual.open, expected.open);
+  EXPECT_EQ(actual.phone, expected.phone);
+  EXPECT_EQ(actual.days, expected.days);
+  ASSERT_EQ(actual.reviews.size(), expected.reviews.size());
+  for (size_t i = 0; i < expected.reviews.size(); i++) {
+    EXPECT_EQ(actual.reviews[i].author, expected.reviews[i].author);
+    EXPECT_EQ(actual.reviews[i].rating, expected.reviews[i].rating);
+  }
+}
+
+TEST(SchemaTest, RoundTrips) {
+  for (bool with_phone : {false, true}) {
+    Place place = SamplePlace();
+    if (with_phone) {
+      place.phone = "+57 1 555";
+    }
+    std::vector<uint8_t> bytes;
+    EncodeSchemaMessage(place, &bytes);
+    Place decoded;
+    decoded.phone = "stale";
+    ASSERT_TRUE(DecodeSchemaMessage(bytes.data(), bytes.size(), &decoded));
+    ExpectPlacesEqual(place, decoded);
+  }
+}
+
+TEST(SchemaTest, EncodesWhatTheGenericWriterDoes) {
+  Review review{"ana", 4.5};
+  std::vector<uint8_t> bytes;
+  EncodeSchemaMessage(review, &bytes);
+
+  MapEntry entries[] = {{Value::String("author"), Value::String("ana")},
+                        {Value::String("rating"), Value::Float64(4.5)}};
+  std::vector<uint8_t> expected = Encode(Value::Map(entries, 2));
+  EXPECT_EQ(bytes, expected);
+}
+
+TEST(SchemaTest, DecodesKeysInAnyOrderAndSkipsUnknownOnes) {
+  Value extra[] = {Value::Int32(1), Value::String("x")};
+  MapEntry entries[] = {
+      {Value::String("stars"), Value::Int64(5)},
+      {Value::String("unknown"), Value::List(extra, 2)},
+      {Value::String("name"), Value::String("Bar")},
+  };
+  std::vector<uint8_t> bytes = Encode(Value::Map(entries, 3));
+  Place place;
+  place.visits = 9;
+  ASSERT_TRUE(DecodeSchemaMessage(bytes.data(), bytes.size(), &place));
+  EXPECT_EQ(place.name, "Bar");
+  EXPECT_EQ(place.stars, 5);
+  // Absent fields are left alone.
+  EXPECT_EQ(place.visits, 9);
+}
+
+TEST(SchemaTest, RejectsEveryTruncation) {
+  std::vector<uint8_t> bytes;
+  EncodeSchemaMessage(SamplePlace(), &bytes);
+  for (size_t size = 0; size < bytes.size(); size++) {
+    Place place;
+    EXPECT_FALSE(DecodeSchemaMessage(bytes.data(), size, &place))
+        << "size " << size;
+  }
+}
+
+TEST(SchemaTest, RejectsMismatchedTypes) {
+  const Value wrong[] = {
+      Value::Int64(1ll << 40),  // Out of range for stars.
+      Value::String("4"),
+      Value::Float64(4.0),
+  };
+  for (const Value& value : wrong) {
+    MapEntry entries[] = {{Value::String("stars"), value}};
+    std::vector<uint8_t> bytes = Encode(Value::Map(entries, 1));
+    Place place;
+    EXPECT_FALSE(DecodeSchemaMessage(bytes.data(), bytes.size(), &place));
+  }
+
+  MapEntry key[] = {{Value::Int32(1), Value::Int32(1)}};
+  std::vector<uint8_t> bytes = Encode(Value::Map(key, 1));
+  Place place;
+  EXPECT_FALSE(DecodeSchemaMessage(bytes.data(), bytes.size(), &place));
+}
+
+TEST(SchemaTest, LeavesFieldsUntouchedOnError) {
+  Value days[] = {Value::Bool(false), Value::Int32(0)};
+  MapEntry entries[] = {{Value::String("days"), Value::List(days, 2)}};
+  std::vector<uint8_t> bytes = Encode(Value::Map(entries, 1));
+  Place place;
+  place.days = {true, true};
+  EXPECT_FALSE(DecodeSchemaMessage(bytes.data(), bytes.size(), &place));
+  EXPECT_EQ(place.days, (std::vector<bool>{true, true}));
+
+  const uint8_t not_bool[] = {static_cast<uint8_t>(StandardField::kInt32)};
+  StandardReader reader(not_bool, sizeof(not_bool));
+  bool open = true;
+  EXPECT_FALSE(FieldCodec<bool>::Decode(&reader, &open));
+  EXPECT_TRUE(open);
+}
+
+TEST(SchemaTest, RejectsListsLongerThanTheMessage) {
+  const uint8_t bytes[] = {static_cast<uint8_t>(StandardField::kList), 0xFF,
+                           0xFF, 0xFF, 0xFF, 0xFF};
+  StandardReader reader(bytes, sizeof(bytes));
+  std::vector<int32_t> value;
+  EXPECT_FALSE(FieldCodec<std::vector<int32_t>>::Decode(&reader, &value));
+}
+
+TEST(SchemaTest, RoundTripsDeltaListsThroughInt64Vectors) {
+  const int64_t samples[] = {1000, 1001, 999, -(1ll << 40), 7};
+  Series series;
+  series.samples = TypedDataView::Of(samples, 5);
+  series.samples.type = StandardField::kInt64DeltaData;
+  std::vector<uint8_t> bytes;
+  EncodeSchemaMessage(series, &bytes);
+  MapEntry entries[] = {
+      {Value::String("samples"), Value::TypedData(series.samples)}};
+  EXPECT_EQ(bytes, Encode(Value::Map(entries, 1)));
+
+  SeriesCopy copy;
+  ASSERT_TRUE(DecodeSchemaMessage(bytes.data(), bytes.size(), &copy));
+  EXPECT_EQ(copy.samples, std::vector<int64_t>(samples, samples + 5));
+  // A view has no storage for the unpacked elements.
+  Series view;
+  EXPECT_FALSE(DecodeSchemaMessage(bytes.data(), bytes.size(), &view));
+
+  // Plain Int64Data lists decode into vectors too.
+  series.samples.type = StandardField::kInt64Data;
+  bytes.clear();
+  EncodeSchemaMessage(series, &bytes);
+  copy.samples.clear();
+  ASSERT_TRUE(DecodeSchemaMessage(bytes.data(), bytes.size(), &copy));
+  EXPECT_EQ(copy.samples, std::vector<int64_t>(samples, samples + 5));
+  ASSERT_TRUE(DecodeSchemaMessage(bytes.data(), bytes.size(), &view));
+  EXPECT_EQ(view.samples.Get<int64_t>(3), -(1ll << 40));
+}
+
+}  // namespace
+}  // namespace platzi
@@ -0,0 +1,180 @@
+#include "messenger/send_coalescer.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "codec/standard_message_codec.h"
+#include "tests/messenger_testing.h"
+
+namespace platzi {
+namespace {
+
+class SendCoalescerTest : public ::testing::Test {
+ protected:
+  SendCoalescerTest()
+      : messenger_(&transport_),
+        coalescer_(&messenger_,
+                   [this](SendCoalescer::Clock::duration delay) {
+                     delays_.push_back(delay);
+                   },
+                   std::chrono::milliseconds(8)),
+        location_(messenger_.Channel("platzi/location")),
+        counter_(messenger_.Channel("platzi/counter")),
+        events_(messenger_.Channel("platzi/events")) {}
+
+  std::vector<std::string> Sent() const {
+    std::vector<std::string> sent;
+    for (const RecordingTransport::Sent& message : transport_.sent) {
+      sent.push_back(message.name + " " + message.message);
+    }
+    return sent;
+  }
+
+  RecordingTransport transport_;
+  BinaryMessenger messenger_;
+  std::vector<SendCoalescer::Clock::duration> delays_;
+  SendCoalescer coalescer_;
+  ChannelId location_;
+  ChannelId counter_;
+  ChannelId events_;
+};
+
+// Sums messages holding decimal numbers.
+void AddNumbers(BinaryMessage pending,
+                BinaryMessage message,
+                std::vector<uint8_t>* merged) {
+  std::string sum =
+      std::to_string(std::stoi(Text(pending)) + std::stoi(Text(message)));
+  merged->assign(sum.begin(), sum.end());
+}
+
+TEST_F(SendCoalescerTest, SendsOtherChannelsAtOnce) {
+  coalescer_.Send(location_, Bytes("a"));
+  coalescer_.Send(location_, BinaryMessage());
+  EXPECT_EQ(Sent(), (std::vector<std::string>{"platzi/location a",
+                                              "platzi/location <nil>"}));
+  EXPECT_TRUE(delays_.empty());
+}
+
+TEST_F(SendCoalescerTest, KeepsTheLatestAndMergesUntilAFlush) {
+  coalescer_.SetPolicy(location_, CoalescePolicy::kKeepLatest);
+  coalescer_.SetPolicy(counter_, CoalescePolicy::kMerge, AddNumbers);
+  for (int i = 1; i <= 100; i++) {
+    coalescer_.Send(counter_, Bytes(std::to_string(i)));
+    coalescer_.Send(location_, Bytes("fix " + std::to_string(i)));
+  }
+  coalescer_.Send(location_, BinaryMessage());
+  EXPECT_TRUE(transport_.sent.empty());
+  // One flush asked for, however many messages are held.
+  ASSERT_EQ(delays_.size(), 1u);
+  EXPECT_EQ(delays_[0], std::chrono::milliseconds(8));
+
+  coalescer_.Flush();
+  // In the order the channels started holding messages.
+  EXPECT_EQ(Sent(), (std::vector<std::string>{"platzi/counter 5050",
+                                              "platzi/location <nil>"}));
+  EXPECT_EQ(coalescer_.messages_received(), 201u);
+  EXPECT_EQ(coalescer_.messages_sent(), 2u);
+
+  coalescer_.Flush();
+  EXPECT_EQ(transport_.sent.size(), 2u);
+  coalescer_.Send(counter_, Bytes("1"));
+  EXPECT_EQ(delays_.size(), 2u);
+}
+
+TEST_F(SendCoalescerTest, KeepsEmptyMessagesApartFromNil) {
+  coalescer_.SetPolicy(location_, CoalescePolicy::kKeepLatest);
+  std::vector<std::string> merged;
+  coalescer_.SetPolicy(
+      counter_, CoalescePolicy::kMerge,
+      [&](BinaryMessage pending, BinaryMessage message,
+          std::vector<uint8_t>* result) {
+        merged.push_back(Text(pending) + "+" + Text(message));
+        result->assign(message.begin(), message.end());
+      });
+  coalescer_.Send(location_, Bytes(""));
+  coalescer_.Send(counter_, Bytes(""));
+  coalescer_.Send(counter_, BinaryMessage());
+  coalescer_.Flush();
+  EXPECT_EQ(merged, std::vector<std::string>{"+<nil>"});
+  EXPECT_EQ(Sent(), (std::vector<std::string>{"platzi/location ",
+                                              "platzi/counter "}));
+}
+
+TEST_F(SendCoalescerTest, BatchesIntoAStandardList) {
+  coalescer_.SetPolicy(events_, CoalescePolicy::kBatch);
+  // Enough elements for the list size to take three bytes.
+  for (int i = 0; i < 300; i++) {
+    if (i == 7) {
+      coalescer_.Send(events_, BinaryMessage());
+    } else {
+      coalescer_.Send(events_, Bytes("event " + std::to_string(i)));
+    }
+  }
+  coalescer_.Flush(events_);
+  ASSERT_EQ(transport_.sent.size(), 1u);
+  const std::string& batch = transport_.sent[0].message;
+  Arena arena;
+  const Value* list = StandardMessageCodec::DecodeMessage(
+      reinterpret_cast<const uint8_t*>(batch.data()), batch.size(), &arena);
+  ASSERT_NE(list, nullptr);
+  ASSERT_EQ(list->type, ValueType::kList);
+  ASSERT_EQ(list->list.size, 300u);
+  EXPECT_TRUE(list->list[7].is_null());
+  for (int i : {0, 8, 299}) {
+    const TypedDataView& element = list->list[i].typed_data;
+    ASSERT_EQ(element.type, StandardField::kUInt8Data);
+    EXPECT_EQ(std::string(reinterpret_cast<const char*>(element.bytes),
+                          element.element_count),
+              "event " + std::to_string(i));
+  }
+
+  // A batch of one is still a list.
+  coalescer_.Send(events_, Bytes(""));
+  coalescer_.Flush();
+  const std::string& single = transport_.sent[1].message;
+  list = StandardMessageCodec::DecodeMessage(
+      reinterpret_cast<const uint8_t*>(single.data()), single.size(), &arena);
+  ASSERT_NE(list, nullptr);
+  ASSERT_EQ(list->list.size, 1u);
+  EXPECT_EQ(list->list[0].typed_data.element_count, 0u);
+}
+
+TEST_F(SendCoalescerTest, SendsMessagesExpectingRepliesInOrder) {
+  coalescer_.SetPolicy(location_, CoalescePolicy::kKeepLatest);
+  coalescer_.Send(location_, Bytes("held"));
+  std::vector<std::string> replies;
+  coalescer_.Send(location_, Bytes("query"), [&](BinaryMessage reply) {
+    replies.push_back(Text(reply));
+  });
+  EXPECT_EQ(Sent(), (std::vector<std::string>{"platzi/location held",
+                                              "platzi/location query"}));
+  messenger_.HandleReply(transport_.sent[1].response_id, Bytes("answer"));
+  EXPECT_EQ(replies, std::vector<std::string>{"answer"});
+  // Nothing is held any more.
+  coalescer_.Flush();
+  EXPECT_EQ(transport_.sent.size(), 2u);
+}
+
+TEST_F(SendCoalescerTest, FlushesWhenThePolicyChangesAndOnDestruction) {
+  coalescer_.SetPolicy(location_, CoalescePolicy::kKeepLatest);
+  coalescer_.Send(location_, Bytes("before"));
+  coalescer_.SetPolicy(location_, CoalescePolicy::kNone);
+  coalescer_.Send(location_, Bytes("after"));
+  EXPECT_EQ(Sent(), (std::vector<std::string>{"platzi/location before",
+                                              "platzi/location after"}));
+  {
+    SendCoalescer coalescer(&messenger_);
+    coalescer.SetPolicy(counter_, CoalescePolicy::kMerge, AddNumbers);
+    coalescer.Send(counter_, Bytes("2"));
+    coalescer.Send(counter_, Bytes("3"));
+  }
+  ASSERT_EQ(transport_.sent.size(), 3u);
+  EXPECT_EQ(transport_.sent[2].message, "5");
+}
+
+}  // namespace
+}  // namespace platzi
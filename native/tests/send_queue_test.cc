@@ -0,0 +1,180 @@
+#include "messenger/send_queue.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "messenger/mpsc_queue.h"
+#include "tests/messenger_testing.h"
+
+namespace platzi {
+namespace {
+
+struct Item : MpscNode {
+  int producer = 0;
+  int sequence = 0;
+};
+
+TEST(MpscQueueTest, PopsInOrderAndReusesNodes) {
+  MpscQueue queue;
+  EXPECT_EQ(queue.Pop(), nullptr);
+  Item items[3];
+  for (int round = 0; round < 3; round++) {
+    for (Item& item : items) {
+      queue.Push(&item);
+    }
+    for (Item& item : items) {
+      EXPECT_EQ(queue.Pop(), &item);
+    }
+    EXPECT_EQ(queue.Pop(), nullptr);
+  }
+  // Pushed while the last node is being handed out.
+  queue.Push(&items[0]);
+  EXPECT_EQ(queue.Pop(), &items[0]);
+  queue.Push(&items[1]);
+  queue.Push(&items[0]);
+  EXPECT_EQ(queue.Pop(), &items[1]);
+  EXPECT_EQ(queue.Pop(), &items[0]);
+  EXPECT_EQ(queue.Pop(), nullptr);
+}
+
+TEST(MpscQueueTest, KeepsTheOrderOfEachProducer) {
+  constexpr int kProducers = 4;
+  constexpr int kItems = 20000;
+  std::vector<Item> items(kProducers * kItems);
+  MpscQueue queue;
+  std::vector<std::thread> producers;
+  for (int producer = 0; producer < kProducers; producer++) {
+    producers.emplace_back([&, producer] {
+      for (int i = 0; i < kItems; i++) {
+        Item& item = items[producer * kItems + i];
+        item.producer = producer;
+        item.sequence = i;
+        queue.Push(&item);
+      }
+    });
+  }
+  // A pop may come up empty while a push is in progress; the consumer
+  // retries rather than waiting to be woken.
+  std::vector<int> next(kProducers, 0);
+  for (int popped = 0; popped < kProducers * kItems;) {
+    MpscNode* node = queue.Pop();
+    if (node == nullptr) {
+      std::this_thread::yield();
+      continue;
+    }
+    Item* item = static_cast<Item*>(node);
+    ASSERT_EQ(item->sequence, next[item->producer]++);
+    popped++;
+  }
+  for (std::thread& producer : producers) {
+    producer.join();
+  }
+  EXPECT_EQ(queue.Pop(), nullptr);
+}
+
+class SendQueueTest : public ::testing::Test {
+ protected:
+  SendQueueTest()
+      : messenger_(&transport_),
+        queue_(&messenger_, [this] { scheduled_++; }) {}
+
+  RecordingTransport transport_;
+  BinaryMessenger messenger_;
+  std::atomic<int> scheduled_{0};
+  SendQueue queue_;
+};
+
+TEST_F(SendQueueTest, SchedulesOneDrainPerBurst) {
+  ChannelId channel = messenger_.Channel("platzi/sensors");
+  std::vector<std::string> replies;
+  queue_.Send(channel, Bytes("a"));
+  queue_.Send(channel, BinaryMessage(),
+              [&](BinaryMessage reply) { replies.push_back(Text(reply)); });
+  queue_.Send(channel, Bytes(""));
+  EXPECT_EQ(scheduled_, 1);
+  EXPECT_TRUE(transport_.sent.empty());
+
+  EXPECT_EQ(queue_.Drain(), 3u);
+  ASSERT_EQ(transport_.sent.size(), 3u);
+  EXPECT_EQ(transport_.sent[0].message, "a");
+  // Nil and empty messages stay apart.
+  EXPECT_EQ(transport_.sent[1].message, "<nil>");
+  EXPECT_EQ(transport_.sent[2].message, "");
+  EXPECT_EQ(transport_.sent[0].name, "platzi/sensors");
+  messenger_.HandleReply(transport_.sent[1].response_id, Bytes("done"));
+  EXPECT_EQ(replies, std::vector<std::string>{"done"});
+
+  EXPECT_EQ(queue_.Drain(), 0u);
+  queue_.Send(channel, Bytes("b"));
+  EXPECT_EQ(scheduled_, 2);
+}
+
+TEST_F(SendQueueTest, SchedulesAnotherDrainAtTheLimit) {
+  ChannelId channel = messenger_.Channel("platzi/sensors");
+  for (int i = 0; i < 5; i++) {
+    queue_.Send(channel, Bytes(std::to_string(i)));
+  }
+  EXPECT_EQ(queue_.Drain(2), 2u);
+  EXPECT_EQ(scheduled_, 2);
+  EXPECT_EQ(queue_.Drain(2), 2u);
+  EXPECT_EQ(queue_.Drain(2), 1u);
+  EXPECT_EQ(scheduled_, 3);
+  ASSERT_EQ(transport_.sent.size(), 5u);
+  EXPECT_EQ(transport_.sent[4].message, "4");
+}
+
+TEST_F(SendQueueTest, FreesWhatWasNeverDrained) {
+  ChannelId channel = messenger_.Channel("platzi/sensors");
+  bool called = false;
+  {
+    SendQueue queue(&messenger_, [] {});
+    queue.Send(channel, Bytes(std::string(1000, 'x')),
+               [&](BinaryMessage) { called = true; });
+  }
+  // Leaks would show under the sanitizers.
+  EXPECT_FALSE(called);
+  EXPECT_TRUE(transport_.sent.empty());
+}
+
+TEST_F(SendQueueTest, SendsEveryMessageFromManyThreads) {
+  constexpr int kProducers = 4;
+  constexpr int kMessages = 5000;
+  std::vector<ChannelId> channels;
+  for (int producer = 0; producer < kProducers; producer++) {
+    channels.push_back(
+        messenger_.Channel("platzi/producer" + std::to_string(producer)));
+  }
+  std::vector<std::thread> producers;
+  for (int producer = 0; producer < kProducers; producer++) {
+    producers.emplace_back([&, producer] {
+      for (int i = 0; i < kMessages; i++) {
+        queue_.Send(channels[producer], Bytes(std::to_string(i)));
+      }
+    });
+  }
+  // Drains whenever one was scheduled, as the platform thread would.
+  int drained_schedules = 0;
+  while (transport_.sent.size() < kProducers * kMessages) {
+    if (scheduled_ > drained_schedules) {
+      drained_schedules++;
+      queue_.Drain(100);
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  for (std::thread& producer : producers) {
+    producer.join();
+  }
+  std::vector<int> next(kProducers, 0);
+  for (const RecordingTransport::Sent& sent : transport_.sent) {
+    EXPECT_EQ(sent.message, std::to_string(next[sent.channel]++));
+  }
+  EXPECT_EQ(queue_.Drain(), 0u);
+}
+
+}  // namespace
+}  // namespace platzi
@@ -0,0 +1,193 @@
+#include "messenger/shm_ring.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+namespace platzi {
+namespace {
+
+constexpr size_t kCapacity = 4096;
+
+// Storage as aligned as the header's cache lines, like a mapping.
+struct alignas(64) Line {
+  uint8_t bytes[64];
+};
+
+std::vector<Line> ZeroedRegion() {
+  return std::vector<Line>(ShmRing::RegionSize(kCapacity) / sizeof(Line));
+}
+
+// A region shared by a producer and a consumer in the same process, as two
+// processes would map it.
+class ShmRingTest : public ::testing::Test {
+ protected:
+  ShmRingTest()
+      : region_(ZeroedRegion()),
+        producer_((ShmRing::Initialize(region_.data()), region_.data()),
+                  kCapacity),
+        consumer_(region_.data(), kCapacity) {}
+
+  // Where the records start, which the frames of crafted records go at.
+  uint8_t* data() {
+    return region_.data()->bytes + ShmRing::RegionSize(kCapacity) -
+           kCapacity;
+  }
+
+  // Writes a frame header at |offset| into the records.
+  void WriteFrame(size_t offset, uint32_t size, uint32_t kind) {
+    uint32_t frame[2] = {size, kind};
+    std::memcpy(data() + offset, frame, sizeof(frame));
+  }
+
+  bool Send(size_t size, uint8_t fill) {
+    uint8_t* room = producer_.Reserve(size);
+    if (room == nullptr) {
+      return false;
+    }
+    std::memset(room, fill, size);
+    producer_.Commit();
+    return true;
+  }
+
+  std::vector<Line> region_;
+  ShmRing producer_;
+  ShmRing consumer_;
+};
+
+TEST_F(ShmRingTest, CarriesRecordsAcrossTheEnd) {
+  size_t size = 0;
+  EXPECT_EQ(consumer_.Peek(&size), nullptr);
+  // Sizes that are not multiples of 8 and do not divide the capacity, so
+  // that records wrap at every alignment.
+  uint8_t fill = 0;
+  for (int i = 0; i < 500; i++) {
+    size_t record_size = 1 + (i * 37) % 700;
+    ASSERT_TRUE(Send(record_size, ++fill)) << i;
+    const uint8_t* record = consumer_.Peek(&size);
+    ASSERT_NE(record, nullptr) << i;
+    // Sizes come back rounded up to the alignment.
+    EXPECT_EQ(size, (record_size + 7) & ~size_t{7});
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(record) % 8, 0u);
+    EXPECT_EQ(record[0], fill);
+    EXPECT_EQ(record[record_size - 1], fill);
+    consumer_.Release();
+  }
+  EXPECT_EQ(consumer_.Peek(&size), nullptr);
+  EXPECT_FALSE(consumer_.corrupt());
+}
+
+TEST_F(ShmRingTest, FillsUpAndWakesTheWaitingProducer) {
+  EXPECT_EQ(producer_.Reserve(producer_.max_record_size() + 1), nullptr);
+  int sent = 0;
+  while (Send(1000, static_cast<uint8_t>(sent))) {
+    sent++;
+  }
+  EXPECT_EQ(sent, 4);
+  EXPECT_TRUE(producer_.PrepareToWaitForRoom(1000));
+  // Room for something smaller withdraws the wait.
+  EXPECT_FALSE(producer_.PrepareToWaitForRoom(8));
+  EXPECT_TRUE(producer_.PrepareToWaitForRoom(1000));
+
+  size_t size;
+  ASSERT_NE(consumer_.Peek(&size), nullptr);
+  consumer_.Release();
+  EXPECT_TRUE(consumer_.TakeProducerWaiter());
+  EXPECT_FALSE(consumer_.TakeProducerWaiter());
+  EXPECT_TRUE(Send(1000, 9));
+  for (int i = 0; i < 4; i++) {
+    ASSERT_NE(consumer_.Peek(&size), nullptr);
+    consumer_.Release();
+  }
+  EXPECT_EQ(consumer_.Peek(&size), nullptr);
+}
+
+TEST_F(ShmRingTest, WakesTheConsumerOnlyWhenItWaits) {
+  // A consumer that never polled counts as waiting.
+  ASSERT_TRUE(Send(8, 1));
+  EXPECT_TRUE(producer_.TakeConsumerWaiter());
+  ASSERT_TRUE(Send(8, 2));
+  EXPECT_FALSE(producer_.TakeConsumerWaiter());
+  // Records are there, so the consumer does not wait.
+  EXPECT_FALSE(consumer_.PrepareToWaitForRecords());
+  size_t size;
+  for (int i = 0; i < 2; i++) {
+    ASSERT_NE(consumer_.Peek(&size), nullptr);
+    consumer_.Release();
+  }
+  EXPECT_TRUE(consumer_.PrepareToWaitForRecords());
+  ASSERT_TRUE(Send(8, 3));
+  EXPECT_TRUE(producer_.TakeConsumerWaiter());
+}
+
+TEST_F(ShmRingTest, ResumesWhereTheOtherSideIs) {
+  size_t size;
+  ASSERT_TRUE(Send(16, 1));
+  ASSERT_NE(consumer_.Peek(&size), nullptr);
+  consumer_.Release();
+  ASSERT_TRUE(Send(16, 2));
+  // A consumer mapping the region afresh starts at the oldest record.
+  ShmRing late_consumer(region_.data(), kCapacity);
+  const uint8_t* record = late_consumer.Peek(&size);
+  ASSERT_NE(record, nullptr);
+  EXPECT_EQ(record[0], 2);
+}
+
+TEST_F(ShmRingTest, MarksMalformedFramesCorrupt) {
+  struct Case {
+    uint32_t size;
+    uint32_t kind;
+  };
+  // The record committed is 32 bytes with its frame.
+  const Case cases[] = {
+      {0, 1},   // Too short to hold its own frame.
+      {12, 1},  // Not a multiple of 8.
+      {40, 1},  // Beyond what was committed.
+      {32, 3},  // An unknown kind.
+      {32, 0},
+  };
+  for (const Case& bad : cases) {
+    std::vector<Line> region = ZeroedRegion();
+    ShmRing::Initialize(region.data());
+    ShmRing producer(region.data(), kCapacity);
+    ShmRing consumer(region.data(), kCapacity);
+    ASSERT_NE(producer.Reserve(24), nullptr);
+    producer.Commit();
+    uint32_t frame[2] = {bad.size, bad.kind};
+    uint8_t* data =
+        region.data()->bytes + ShmRing::RegionSize(kCapacity) - kCapacity;
+    std::memcpy(data, frame, sizeof(frame));
+    size_t size;
+    EXPECT_EQ(consumer.Peek(&size), nullptr) << bad.size << " " << bad.kind;
+    EXPECT_TRUE(consumer.corrupt());
+    // For good: fixing the frame does not bring it back.
+    frame[0] = 32;
+    frame[1] = 1;
+    std::memcpy(data, frame, sizeof(frame));
+    EXPECT_EQ(consumer.Peek(&size), nullptr);
+  }
+}
+
+TEST_F(ShmRingTest, MarksFramesPastTheEndCorrupt) {
+  // Four records leave 64 bytes at the end, which the fifth skips with a
+  // wrap marker.
+  size_t size;
+  for (int i = 0; i < 4; i++) {
+    ASSERT_TRUE(Send(1000, 1));
+  }
+  for (int i = 0; i < 3; i++) {
+    ASSERT_NE(consumer_.Peek(&size), nullptr);
+    consumer_.Release();
+  }
+  ASSERT_TRUE(Send(1000, 2));
+  // Committed, but reaching past the end.
+  WriteFrame(kCapacity - 64, 72, 2);
+  ASSERT_NE(consumer_.Peek(&size), nullptr);
+  consumer_.Release();
+  EXPECT_EQ(consumer_.Peek(&size), nullptr);
+  EXPECT_TRUE(consumer_.corrupt());
+}
+
+}  // namespace
+}  // namespace platzi
@@ -0,0 +1,301 @@
+#include "messenger/shm_transport.h"
+
+#include <gtest/gtest.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tests/messenger_testing.h"
+
+namespace platzi {
+namespace {
+
+constexpr size_t kCapacity = 4096;
+
+// Two transports of one connection, both ends in this process.
+class ShmTransportTest : public ::testing::Test {
+ protected:
+  ShmTransportTest()
+      : left_messenger_(&left_), right_messenger_(&right_) {}
+
+  void SetUp() override {
+    ShmEndpoint first;
+    ShmEndpoint second;
+    ASSERT_TRUE(ShmTransport::CreateConnection(kCapacity, &first, &second));
+    ASSERT_TRUE(left_.Open(&first));
+    ASSERT_TRUE(right_.Open(&second));
+    left_.set_messenger(&left_messenger_);
+    right_.set_messenger(&right_messenger_);
+  }
+
+  // Collects the messages |messenger| gets on |name|, replying to each
+  // with its text and a "!".
+  void Record(BinaryMessenger* messenger,
+              const std::string& name,
+              std::vector<std::string>* received) {
+    messenger->SetMessageHandler(
+        messenger->Channel(name),
+        [received, name](BinaryMessage message, MessageReply reply) {
+          received->push_back(name + " " + Text(message));
+          std::string answer = Text(message) + "!";
+          reply.Send(Bytes(answer));
+        });
+  }
+
+  ShmTransport left_;
+  ShmTransport right_;
+  BinaryMessenger left_messenger_;
+  BinaryMessenger right_messenger_;
+};
+
+TEST_F(ShmTransportTest, CarriesMessagesAndRepliesBothWays) {
+  // Interned in a different order on each side, so that the IDs differ.
+  ChannelId left_a = left_messenger_.Channel("platzi/a");
+  ChannelId left_b = left_messenger_.Channel("platzi/b");
+  std::vector<std::string> received;
+  Record(&right_messenger_, "platzi/b", &received);
+  Record(&right_messenger_, "platzi/a", &received);
+  std::vector<std::string> replies;
+  auto reply = [&](BinaryMessage message) {
+    replies.push_back(Text(message));
+  };
+
+  left_messenger_.Send(left_a, Bytes("one"), reply);
+  left_messenger_.Send(left_b, Bytes("two"), reply);
+  // Sent by ID alone from here on.
+  left_messenger_.Send(left_a, BinaryMessage(), reply);
+  left_messenger_.Send(left_b, Bytes(""));
+  EXPECT_TRUE(received.empty());
+  EXPECT_TRUE(right_.Poll());
+  EXPECT_EQ(received,
+            (std::vector<std::string>{"platzi/a one", "platzi/b two",
+                                      "platzi/a <nil>", "platzi/b "}));
+  EXPECT_TRUE(replies.empty());
+  EXPECT_TRUE(left_.Poll());
+  EXPECT_EQ(replies, (std::vector<std::string>{"one!", "two!", "<nil>!"}));
+
+  // And the other way.
+  std::vector<std::string> back;
+  Record(&left_messenger_, "platzi/a", &back);
+  right_messenger_.Send(right_messenger_.Channel("platzi/a"), Bytes("three"));
+  EXPECT_TRUE(left_.Poll());
+  EXPECT_EQ(back, std::vector<std::string>{"platzi/a three"});
+  EXPECT_EQ(left_.dropped(), 0u);
+  EXPECT_EQ(right_.dropped(), 0u);
+}
+
+TEST_F(ShmTransportTest, WritesReservedMessagesInPlace) {
+  std::vector<std::string> received;
+  Record(&right_messenger_, "platzi/a", &received);
+  ChannelId channel = left_messenger_.Channel("platzi/a");
+  uint8_t* room = left_.ReserveMessage(channel, 5);
+  ASSERT_NE(room, nullptr);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(room) % 8, 0u);
+  std::memcpy(room, "hello", 5);
+  left_.CommitMessage();
+  EXPECT_TRUE(right_.Poll());
+  EXPECT_EQ(received, std::vector<std::string>{"platzi/a hello"});
+  EXPECT_EQ(left_.ReserveMessage(channel, left_.max_message_size() + 1),
+            nullptr);
+}
+
+TEST_F(ShmTransportTest, RepliesNilToMessagesTooLarge) {
+  ChannelId channel = left_messenger_.Channel("platzi/a");
+  std::string large(left_.max_message_size(), 'x');
+  std::vector<std::string> replies;
+  left_messenger_.Send(channel, Bytes(large), [&](BinaryMessage message) {
+    replies.push_back(Text(message));
+  });
+  EXPECT_EQ(left_.dropped(), 1u);
+  // Delivered from the run loop rather than from within |Send|.
+  EXPECT_TRUE(replies.empty());
+  EXPECT_TRUE(left_.Poll());
+  EXPECT_EQ(replies, std::vector<std::string>{"<nil>"});
+
+  // One leaving room for the channel name, which the refused message did
+  // not announce, goes through.
+  large.resize(left_.max_message_size() - 16);
+  std::vector<std::string> received;
+  Record(&right_messenger_, "platzi/a", &received);
+  left_messenger_.Send(channel, Bytes(large));
+  EXPECT_EQ(left_.dropped(), 1u);
+  EXPECT_TRUE(right_.Poll());
+  EXPECT_EQ(received.size(), 1u);
+}
+
+TEST_F(ShmTransportTest, KeepsOrderThroughTheBacklog) {
+  std::vector<std::string> received;
+  Record(&right_messenger_, "platzi/a", &received);
+  ChannelId channel = left_messenger_.Channel("platzi/a");
+  for (int i = 0; i < 10; i++) {
+    left_messenger_.Send(channel,
+                         Bytes(std::to_string(i) + std::string(1000, ' ')));
+  }
+  EXPECT_GT(left_.backlog(), 0u);
+  // Each side polls in turn, as woken.
+  for (int round = 0; round < 20 && received.size() < 10; round++) {
+    ASSERT_TRUE(right_.Poll());
+    ASSERT_TRUE(left_.Poll());
+  }
+  ASSERT_EQ(received.size(), 10u);
+  for (int i = 0; i < 10; i++) {
+    EXPECT_EQ(received[i].substr(0, received[i].find(' ', 9)),
+              "platzi/a " + std::to_string(i));
+  }
+  EXPECT_EQ(left_.backlog(), 0u);
+}
+
+TEST_F(ShmTransportTest, StopsAtTheLimitAndComesBack) {
+  std::vector<std::string> received;
+  Record(&right_messenger_, "platzi/a", &received);
+  ChannelId channel = left_messenger_.Channel("platzi/a");
+  for (int i = 0; i < 3; i++) {
+    left_messenger_.Send(channel, Bytes(std::to_string(i)));
+  }
+  EXPECT_TRUE(right_.Poll(2));
+  EXPECT_EQ(received.size(), 2u);
+  // The descriptor is left readable.
+  uint64_t signals = 0;
+  EXPECT_EQ(::read(right_.wake_fd(), &signals, sizeof(signals)),
+            static_cast<ssize_t>(sizeof(signals)));
+  EXPECT_TRUE(right_.Poll(2));
+  EXPECT_EQ(received.size(), 3u);
+}
+
+// The record header, as a peer writes it.
+struct RawHeader {
+  uint8_t kind;
+  uint8_t flags;
+  uint16_t name_size;
+  uint32_t channel;
+  uint32_t response_id;
+  uint32_t message_size;
+};
+
+// A transport reading records written by hand into its inbound ring, as a
+// misbehaving peer would.
+class ShmTransportRecordTest : public ::testing::Test {
+ protected:
+  ShmTransportRecordTest() : messenger_(&transport_) {}
+
+  void SetUp() override {
+    ShmEndpoint first;
+    ShmEndpoint second;
+    ASSERT_TRUE(ShmTransport::CreateConnection(kCapacity, &first, &second));
+    size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    size_t offset = (ShmRing::RegionSize(kCapacity) + page - 1) & ~(page - 1);
+    mapping_size_ = 2 * offset;
+    mapping_ = ::mmap(nullptr, mapping_size_, PROT_READ | PROT_WRITE,
+                      MAP_SHARED, first.memory_fd, 0);
+    ShmTransport::CloseEndpoint(&first);
+    ASSERT_NE(mapping_, MAP_FAILED);
+    // The first side writes the ring at the start of the memory.
+    peer_ring_ = std::make_unique<ShmRing>(mapping_, kCapacity);
+    ASSERT_TRUE(transport_.Open(&second));
+    transport_.set_messenger(&messenger_);
+    messenger_.SetMessageHandler(
+        messenger_.Channel("platzi/raw"),
+        [this](BinaryMessage message, MessageReply) {
+          received_.push_back(Text(message));
+        });
+  }
+
+  void TearDown() override {
+    peer_ring_.reset();
+    if (mapping_ != MAP_FAILED) {
+      ::munmap(mapping_, mapping_size_);
+    }
+  }
+
+  // Writes a record of |header|, then |body|, |size| bytes long in all.
+  void Write(const RawHeader& header, const std::string& body, size_t size) {
+    uint8_t* record = peer_ring_->Reserve(size);
+    ASSERT_NE(record, nullptr);
+    std::memset(record, 0, size);
+    std::memcpy(record, &header, std::min(size, sizeof(header)));
+    if (size > sizeof(header)) {
+      std::memcpy(record + sizeof(header), body.data(),
+                  std::min(body.size(), size - sizeof(header)));
+    }
+    peer_ring_->Commit();
+  }
+
+  // Announces channel 7 as "platzi/raw" with a first message.
+  void Announce() {
+    // The message starts at the next multiple of 8 after the name.
+    Write({1, 2, 10, 7, 0, 2}, "platzi/raw" + std::string(6, '\0') + "ok",
+          16 + 16 + 2);
+  }
+
+  ShmTransport transport_;
+  BinaryMessenger messenger_;
+  void* mapping_ = MAP_FAILED;
+  size_t mapping_size_ = 0;
+  std::unique_ptr<ShmRing> peer_ring_;
+  std::vector<std::string> received_;
+};
+
+TEST_F(ShmTransportRecordTest, ReadsWellFormedRecords) {
+  Announce();
+  // By ID alone, then nil.
+  Write({1, 0, 0, 7, 0, 3}, "abc", 16 + 3);
+  Write({1, 1, 0, 7, 0, 0}, "", 16);
+  EXPECT_TRUE(transport_.Poll());
+  EXPECT_EQ(received_, (std::vector<std::string>{"ok", "abc", "<nil>"}));
+}
+
+TEST_F(ShmTransportRecordTest, FailsOnRecordsShorterThanTheirHeader) {
+  Write({1, 0, 0, 7, 0, 0}, "", 8);
+  EXPECT_FALSE(transport_.Poll());
+}
+
+TEST_F(ShmTransportRecordTest, FailsOnMessagesPastTheRecord) {
+  Announce();
+  Write({1, 0, 0, 7, 0, 9}, "abc", 16 + 8);
+  EXPECT_FALSE(transport_.Poll());
+  // The records before the malformed one were handed over.
+  EXPECT_EQ(received_, std::vector<std::string>{"ok"});
+  // For good.
+  EXPECT_FALSE(transport_.Poll());
+}
+
+TEST_F(ShmTransportRecordTest, FailsOnNamesPastTheRecord) {
+  Write({1, 2, 200, 7, 0, 0}, "platzi/raw", 16 + 16);
+  EXPECT_FALSE(transport_.Poll());
+}
+
+TEST_F(ShmTransportRecordTest, FailsOnUnknownKinds) {
+  Write({3, 0, 0, 7, 0, 0}, "", 16);
+  EXPECT_FALSE(transport_.Poll());
+}
+
+TEST_F(ShmTransportRecordTest, FailsOnChannelsOutOfRange) {
+  Write({1, 2, 10, 1u << 20, 0, 0}, "platzi/raw", 16 + 16);
+  EXPECT_FALSE(transport_.Poll());
+}
+
+TEST_F(ShmTransportRecordTest, FailsOnChannelsNeverAnnounced) {
+  Announce();
+  Write({1, 0, 0, 8, 0, 0}, "", 16);
+  EXPECT_FALSE(transport_.Poll());
+  EXPECT_EQ(received_, std::vector<std::string>{"ok"});
+}
+
+TEST_F(ShmTransportRecordTest, FailsOnCorruptFrames) {
+  Announce();
+  // Overwrites the frame the ring put before the record.
+  uint32_t frame[2] = {kCapacity * 2, 1};
+  std::memcpy(static_cast<uint8_t*>(mapping_) +
+                  ShmRing::RegionSize(kCapacity) - kCapacity,
+              frame, sizeof(frame));
+  EXPECT_FALSE(transport_.Poll());
+  EXPECT_TRUE(received_.empty());
+}
+
+}  // namespace
+}  // namespace platzi
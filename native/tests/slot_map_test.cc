@@ -0,0 +1,113 @@
+#include "messenger/slot_map.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace platzi {
+namespace {
+
+TEST(SlotMapTest, InsertsFindsAndTakes) {
+  SlotMap<std::string> map;
+  uint32_t a = map.Insert("a");
+  uint32_t b = map.Insert("b");
+  ASSERT_NE(a, 0u);
+  ASSERT_NE(b, 0u);
+  ASSERT_NE(a, b);
+  EXPECT_EQ(map.size(), 2u);
+  ASSERT_NE(map.Find(a), nullptr);
+  EXPECT_EQ(*map.Find(a), "a");
+  std::string value;
+  EXPECT_TRUE(map.Take(b, &value));
+  EXPECT_EQ(value, "b");
+  EXPECT_FALSE(map.Take(b, &value));
+  EXPECT_EQ(map.Find(b), nullptr);
+  EXPECT_EQ(map.Find(0), nullptr);
+  EXPECT_EQ(map.Find(a + 100), nullptr);
+  EXPECT_EQ(map.size(), 1u);
+}
+
+TEST(SlotMapTest, StaleIdsMissReusedSlots) {
+  SlotMap<int> map;
+  uint32_t first = map.Insert(1);
+  int value;
+  ASSERT_TRUE(map.Take(first, &value));
+  uint32_t second = map.Insert(2);
+  // Same slot, next generation.
+  EXPECT_EQ(second & (SlotMap<int>::kMaxEntries - 1),
+            first & (SlotMap<int>::kMaxEntries - 1));
+  EXPECT_NE(second, first);
+  EXPECT_EQ(map.Find(first), nullptr);
+  EXPECT_FALSE(map.Take(first, &value));
+  ASSERT_NE(map.Find(second), nullptr);
+  EXPECT_EQ(*map.Find(second), 2);
+}
+
+TEST(SlotMapTest, WrapsGenerationsWithoutIdZero) {
+  SlotMap<int> map;
+  uint32_t first = map.Insert(0);
+  std::set<uint32_t> ids = {first};
+  int value;
+  uint32_t id = first;
+  // Every generation of the slot once, then back to the first.
+  for (int i = 1; i < 4095; i++) {
+    ASSERT_TRUE(map.Take(id, &value));
+    id = map.Insert(i);
+    ASSERT_NE(id, 0u);
+    ids.insert(id);
+  }
+  EXPECT_EQ(ids.size(), 4095u);
+  ASSERT_TRUE(map.Take(id, &value));
+  EXPECT_EQ(map.Insert(0), first);
+}
+
+TEST(SlotMapTest, ReleasesValuesWhenTaken) {
+  SlotMap<std::shared_ptr<int>> map;
+  auto shared = std::make_shared<int>(7);
+  uint32_t id = map.Insert(shared);
+  EXPECT_EQ(shared.use_count(), 2);
+  std::shared_ptr<int> taken;
+  ASSERT_TRUE(map.Take(id, &taken));
+  taken.reset();
+  EXPECT_EQ(shared.use_count(), 1);
+}
+
+TEST(SlotMapTest, SweepsEntriesOlderThanAPeriod) {
+  SlotMap<int> map;
+  uint32_t old_id = map.Insert(1);
+  map.Sweep([](uint32_t, const int&, uint32_t) { FAIL(); });
+  uint32_t new_id = map.Insert(2);
+  std::vector<std::pair<uint32_t, uint32_t>> visited;
+  auto record = [&](uint32_t id, const int&, uint32_t sweeps) {
+    visited.push_back({id, sweeps});
+  };
+  map.Sweep(record);
+  EXPECT_EQ(visited, (std::vector<std::pair<uint32_t, uint32_t>>{
+                         {old_id, 1}}));
+  visited.clear();
+  map.Sweep(record);
+  EXPECT_EQ(visited, (std::vector<std::pair<uint32_t, uint32_t>>{
+                         {old_id, 2}, {new_id, 1}}));
+}
+
+TEST(SlotMapTest, RefusesEntriesWhenFull) {
+  SlotMap<uint8_t> map;
+  uint32_t id = 0;
+  for (uint32_t i = 0; i < SlotMap<uint8_t>::kMaxEntries; i++) {
+    id = map.Insert(1);
+    ASSERT_NE(id, 0u);
+  }
+  EXPECT_TRUE(map.full());
+  EXPECT_EQ(map.Insert(1), 0u);
+  uint8_t value;
+  ASSERT_TRUE(map.Take(id, &value));
+  EXPECT_FALSE(map.full());
+  EXPECT_NE(map.Insert(1), 0u);
+}
+
+}  // namespace
+}  // namespace platzi
@@ -0,0 +1,168 @@
+#include "codec/standard_method_codec.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "tests/value_testing.h"
+
+namespace platzi {
+namespace {
+
+TEST(StandardMethodCodecTest, RoundTripsSingleCallsAndEnvelopes) {
+  Value arguments[] = {Value::Int32(1), Value::String("two")};
+  MethodCall call{"search", Value::List(arguments, 2)};
+  std::vector<uint8_t> bytes;
+  ASSERT_TRUE(StandardMethodCodec::EncodeMethodCall(call, &bytes));
+  EXPECT_FALSE(StandardMethodCodec::IsBatch(bytes.data(), bytes.size()));
+  Arena arena;
+  MethodCall decoded;
+  ASSERT_TRUE(StandardMethodCodec::DecodeMethodCall(bytes.data(), bytes.size(),
+                                                    &arena, &decoded));
+  EXPECT_EQ(decoded.method, "search");
+  EXPECT_TRUE(ValuesEqual(call.arguments, decoded.arguments));
+
+  MethodError error{"NOT_FOUND", Value::Null(), Value::Int32(404)};
+  ASSERT_TRUE(StandardMethodCodec::EncodeErrorEnvelope(error, &bytes));
+  Envelope envelope;
+  ASSERT_TRUE(StandardMethodCodec::DecodeEnvelope(bytes.data(), bytes.size(),
+                                                  &arena, &envelope));
+  EXPECT_TRUE(envelope.is_error);
+  EXPECT_EQ(envelope.error.code, "NOT_FOUND");
+  EXPECT_TRUE(envelope.error.message.is_null());
+  EXPECT_TRUE(ValuesEqual(error.details, envelope.error.details));
+}
+
+TEST(StandardMethodCodecTest, RoundTripsBatches) {
+  MethodCall calls[] = {{"a", Value::Null()},
+                        {"b", Value::Float64(0.5)},
+                        {"c", Value::String("x")}};
+  std::vector<uint8_t> bytes;
+  ASSERT_TRUE(StandardMethodCodec::EncodeMethodCallBatch(calls, 3, &bytes));
+  EXPECT_TRUE(StandardMethodCodec::IsBatch(bytes.data(), bytes.size()));
+  Arena arena;
+  Span<MethodCall> decoded_calls;
+  ASSERT_TRUE(StandardMethodCodec::DecodeMethodCallBatch(
+      bytes.data(), bytes.size(), &arena, &decoded_calls));
+  ASSERT_EQ(decoded_calls.size, 3u);
+  for (size_t i = 0; i < 3; i++) {
+    EXPECT_EQ(decoded_calls[i].method, calls[i].method);
+    EXPECT_TRUE(ValuesEqual(calls[i].arguments, decoded_calls[i].arguments));
+  }
+
+  Envelope envelopes[2];
+  envelopes[0].result = Value::Int64(1ll << 40);
+  envelopes[1].is_error = true;
+  envelopes[1].error = {"E", Value::String("failed"), Value::Null()};
+  ASSERT_TRUE(StandardMethodCodec::EncodeEnvelopeBatch(envelopes, 2, &bytes));
+  Span<Envelope> decoded_envelopes;
+  ASSERT_TRUE(StandardMethodCodec::DecodeEnvelopeBatch(
+      bytes.data(), bytes.size(), &arena, &decoded_envelopes));
+  ASSERT_EQ(decoded_envelopes.size, 2u);
+  EXPECT_FALSE(decoded_envelopes[0].is_error);
+  EXPECT_EQ(decoded_envelopes[0].result.int64, 1ll << 40);
+  EXPECT_TRUE(decoded_envelopes[1].is_error);
+  EXPECT_EQ(decoded_envelopes[1].error.message.string, "failed");
+}
+
+// Answers "echo" with its arguments and anything else with an error.
+class EchoHandler : public MethodCallHandler {
+ public:
+  void HandleMethodCall(const MethodCall& call, Envelope* reply) override {
+    methods.push_back(std::string(call.method));
+    if (call.method == "echo") {
+      reply->result = call.arguments;
+    } else {
+      reply->is_error = true;
+      reply->error.code = "UNKNOWN";
+    }
+  }
+
+  std::vector<std::string> methods;
+};
+
+TEST(StandardMethodCodecTest, DispatchesBatchesInOrder) {
+  MethodCall calls[] = {{"echo", Value::Int32(1)},
+                        {"nope", Value::Null()},
+                        {"echo", Value::Int32(3)}};
+  std::vector<uint8_t> bytes;
+  ASSERT_TRUE(StandardMethodCodec::EncodeMethodCallBatch(calls, 3, &bytes));
+  Arena arena;
+  EchoHandler handler;
+  std::vector<uint8_t> reply;
+  ASSERT_TRUE(StandardMethodCodec::DispatchMethodCalls(
+      bytes.data(), bytes.size(), &arena, &handler, &reply));
+  EXPECT_EQ(handler.methods,
+            (std::vector<std::string>{"echo", "nope", "echo"}));
+  Span<Envelope> envelopes;
+  ASSERT_TRUE(StandardMethodCodec::DecodeEnvelopeBatch(
+      reply.data(), reply.size(), &arena, &envelopes));
+  ASSERT_EQ(envelopes.size, 3u);
+  EXPECT_EQ(envelopes[0].result.int32, 1);
+  EXPECT_TRUE(envelopes[1].is_error);
+  EXPECT_EQ(envelopes[2].result.int32, 3);
+
+  // A single call gets a single envelope.
+  ASSERT_TRUE(StandardMethodCodec::EncodeMethodCall(calls[0], &bytes));
+  ASSERT_TRUE(StandardMethodCodec::DispatchMethodCalls(
+      bytes.data(), bytes.size(), &arena, &handler, &reply));
+  EXPECT_FALSE(StandardMethodCodec::IsBatch(reply.data(), reply.size()));
+}
+
+TEST(StandardMethodCodecTest, RejectsEveryTruncation) {
+  MethodCall calls[] = {{"first", Value::String("arg")},
+                        {"second", Value::Int64(7)}};
+  std::vector<uint8_t> bytes;
+  ASSERT_TRUE(StandardMethodCodec::EncodeMethodCallBatch(calls, 2, &bytes));
+  for (size_t size = 0; size < bytes.size(); size++) {
+    Arena arena;
+    Span<MethodCall> decoded;
+    EXPECT_FALSE(StandardMethodCodec::DecodeMethodCallBatch(
+        bytes.data(), size, &arena, &decoded))
+        << "size " << size;
+    EchoHandler handler;
+    std::vector<uint8_t> reply = {42};
+    EXPECT_FALSE(StandardMethodCodec::DispatchMethodCalls(
+        bytes.data(), size, &arena, &handler, &reply));
+    EXPECT_EQ(reply, std::vector<uint8_t>{42});
+  }
+}
+
+TEST(StandardMethodCodecTest, RejectsMalformedMessages) {
+  Arena arena;
+  // A batch claiming more calls than it has bytes for.
+  const uint8_t huge_batch[] = {2, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+  Span<MethodCall> calls;
+  EXPECT_FALSE(StandardMethodCodec::DecodeMethodCallBatch(
+      huge_batch, sizeof(huge_batch), &arena, &calls));
+  EXPECT_LT(arena.bytes_used(), 1024u);
+
+  // A method name that is not a string.
+  const uint8_t int_method[] = {3, 1, 0, 0, 0, 0};
+  MethodCall call;
+  EXPECT_FALSE(StandardMethodCodec::DecodeMethodCall(
+      int_method, sizeof(int_method), &arena, &call));
+
+  // An unknown envelope flag, and an error message that is not a string.
+  const uint8_t bad_flag[] = {3, 0};
+  const uint8_t int_message[] = {1, 7, 1, 'E', 3, 0, 0, 0, 0, 0};
+  Envelope envelope;
+  EXPECT_FALSE(StandardMethodCodec::DecodeEnvelope(
+      bad_flag, sizeof(bad_flag), &arena, &envelope));
+  EXPECT_FALSE(StandardMethodCodec::DecodeEnvelope(
+      int_message, sizeof(int_message), &arena, &envelope));
+
+  // A single call where a batch is expected, and trailing bytes.
+  std::vector<uint8_t> bytes;
+  ASSERT_TRUE(StandardMethodCodec::EncodeMethodCall({"m", Value::Null()},
+                                                    &bytes));
+  EXPECT_FALSE(StandardMethodCodec::DecodeMethodCallBatch(
+      bytes.data(), bytes.size(), &arena, &calls));
+  bytes.push_back(0);
+  EXPECT_FALSE(StandardMethodCodec::DecodeMethodCall(
+      bytes.data(), bytes.size(), &arena, &call));
+}
+
+}  // namespace
+}  // namespace platzi
@@ -0,0 +1,236 @@
+#include "codec/standard_reader.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+#include "codec/standard_writer.h"
+
+namespace platzi {
+namespace {
+
+std::vector<uint8_t> Encode(const Value& value) {
+  std::vector<uint8_t> bytes;
+  StandardWriter writer(&bytes);
+  writer.WriteValue(value);
+  return bytes;
+}
+
+TEST(StandardReaderTest, RoundTripsScalars) {
+  Value list[] = {Value::Null(),          Value::Bool(true),
+                  Value::Bool(false),     Value::Int32(-7),
+                  Value::Int64(1ll << 40), Value::Float64(2.5),
+                  Value::String("héllo")};
+  std::vector<uint8_t> bytes = Encode(Value::List(list, 7));
+
+  StandardReader reader(bytes.data(), bytes.size());
+  StandardToken token;
+  ASSERT_TRUE(reader.ReadValue(&token));
+  EXPECT_EQ(token.type, StandardField::kList);
+  EXPECT_EQ(token.count, 7u);
+  ASSERT_TRUE(reader.ReadValue(&token));
+  EXPECT_EQ(token.type, StandardField::kNil);
+  ASSERT_TRUE(reader.ReadValue(&token));
+  EXPECT_EQ(token.type, StandardField::kTrue);
+  EXPECT_TRUE(token.boolean);
+  ASSERT_TRUE(reader.ReadValue(&token));
+  EXPECT_EQ(token.type, StandardField::kFalse);
+  EXPECT_FALSE(token.boolean);
+  ASSERT_TRUE(reader.ReadValue(&token));
+  EXPECT_EQ(token.type, StandardField::kInt32);
+  EXPECT_EQ(token.int32, -7);
+  ASSERT_TRUE(reader.ReadValue(&token));
+  EXPECT_EQ(token.type, StandardField::kInt64);
+  EXPECT_EQ(token.int64, 1ll << 40);
+  ASSERT_TRUE(reader.ReadValue(&token));
+  EXPECT_EQ(token.type, StandardField::kFloat64);
+  EXPECT_EQ(token.float64, 2.5);
+  EXPECT_EQ(reader.position() % 8, 0u);
+  ASSERT_TRUE(reader.ReadValue(&token));
+  EXPECT_EQ(token.type, StandardField::kString);
+  EXPECT_EQ(token.string, "héllo");
+  EXPECT_FALSE(reader.HasMore());
+}
+
+TEST(StandardReaderTest, StringsPointIntoTheMessage) {
+  std::vector<uint8_t> bytes = Encode(Value::String("abc"));
+  StandardReader reader(bytes.data(), bytes.size());
+  StandardToken token;
+  ASSERT_TRUE(reader.ReadValue(&token));
+  EXPECT_EQ(reinterpret_cast<const uint8_t*>(token.string.data()),
+            bytes.data() + 2);
+}
+
+TEST(StandardReaderTest, RoundTripsSizes) {
+  for (uint32_t size : {0u, 253u, 254u, 0xFFFFu, 0x10000u, 0xFFFFFFFFu}) {
+    std::vector<uint8_t> bytes;
+    StandardWriter writer(&bytes);
+    writer.WriteSize(size);
+    EXPECT_EQ(bytes.size(), EncodedSizeOfSize(size));
+    StandardReader reader(bytes.data(), bytes.size());
+    uint32_t read;
+    ASSERT_TRUE(reader.ReadSize(&read));
+    EXPECT_EQ(read, size);
+    EXPECT_FALSE(reader.HasMore());
+  }
+}
+
+TEST(StandardReaderTest, RoundTripsVarints) {
+  for (uint32_t value : {0u, 127u, 128u, 0x3FFFu, 0x4000u, 0xFFFFFFFFu}) {
+    std::vector<uint8_t> bytes;
+    StandardWriter writer(&bytes);
+    writer.WriteVarint(value);
+    StandardReader reader(bytes.data(), bytes.size());
+    uint32_t read;
+    ASSERT_TRUE(reader.ReadVarint(&read));
+    EXPECT_EQ(read, value);
+  }
+}
+
+TEST(StandardReaderTest, RoundTripsTypedData) {
+  alignas(8) const int32_t elements[] = {1, -2, 3};
+  // The list header, a bool, the type byte and the count take five bytes,
+  // so the elements are padded to start at eight.
+  Value list[] = {Value::Bool(true),
+                  Value::TypedData(TypedDataView::Of(elements, 3))};
+  std::vector<uint8_t> bytes = Encode(Value::List(list, 2));
+
+  StandardReader reader(bytes.data(), bytes.size());
+  StandardToken token;
+  ASSERT_TRUE(reader.ReadValue(&token));
+  ASSERT_TRUE(reader.ReadValue(&token));
+  ASSERT_TRUE(reader.ReadValue(&token));
+  EXPECT_EQ(token.type, StandardField::kInt32Data);
+  EXPECT_EQ(token.typed_data.element_count, 3u);
+  EXPECT_EQ(token.typed_data.bytes - bytes.data(), 8);
+  EXPECT_EQ(std::memcmp(token.typed_data.bytes, elements, sizeof(elements)),
+            0);
+}
+
+TEST(StandardReaderTest, SkipsNestedValues) {
+  Value inner[] = {Value::String("a"), Value::Int32(1)};
+  MapEntry entries[] = {{Value::String("k"), Value::List(inner, 2)}};
+  Value outer[] = {Value::Map(entries, 1), Value::Int32(42)};
+  std::vector<uint8_t> bytes = Encode(Value::List(outer, 2));
+
+  StandardReader reader(bytes.data(), bytes.size());
+  StandardToken token;
+  ASSERT_TRUE(reader.ReadValue(&token));
+  ASSERT_TRUE(reader.SkipValue());
+  ASSERT_TRUE(reader.ReadValue(&token));
+  EXPECT_EQ(token.int32, 42);
+  EXPECT_FALSE(reader.HasMore());
+}
+
+TEST(StandardReaderTest, ReadsHandEncodedMessage) {
+  // [42, "hi", Int32List[1, 2], {null: true}], as the engine encodes it.
+  const uint8_t bytes[] = {
+      12, 4,                   // A list of four.
+      3, 42, 0, 0, 0,          // An int32.
+      7, 2, 'h', 'i',          // A string.
+      9, 2, 0, 0, 0,           // Int32 data, padded to 16.
+      1, 0, 0, 0, 2, 0, 0, 0,  //
+      13, 1, 0, 1,             // A map of one entry.
+  };
+  StandardReader reader(bytes, sizeof(bytes));
+  StandardToken token;
+  ASSERT_TRUE(reader.ReadValue(&token));
+  EXPECT_EQ(token.type, StandardField::kList);
+  EXPECT_EQ(token.count, 4u);
+  ASSERT_TRUE(reader.ReadValue(&token));
+  EXPECT_EQ(token.type, StandardField::kInt32);
+  EXPECT_EQ(token.int32, 42);
+  ASSERT_TRUE(reader.ReadValue(&token));
+  EXPECT_EQ(token.string, "hi");
+  EXPECT_EQ(token.string.data(), reinterpret_cast<const char*>(bytes + 9));
+  ASSERT_TRUE(reader.ReadValue(&token));
+  EXPECT_EQ(token.typed_data.type, StandardField::kInt32Data);
+  EXPECT_EQ(token.typed_data.element_count, 2u);
+  EXPECT_EQ(token.typed_data.bytes, bytes + 16);
+  ASSERT_TRUE(reader.ReadValue(&token));
+  EXPECT_EQ(token.type, StandardField::kMap);
+  EXPECT_EQ(token.count, 1u);
+  ASSERT_TRUE(reader.ReadValue(&token));
+  EXPECT_EQ(token.type, StandardField::kNil);
+  ASSERT_TRUE(reader.ReadValue(&token));
+  EXPECT_EQ(token.type, StandardField::kTrue);
+  EXPECT_FALSE(reader.HasMore());
+}
+
+TEST(StandardReaderTest, RejectsEmptyMessage) {
+  StandardReader reader(nullptr, 0);
+  StandardToken token;
+  EXPECT_FALSE(reader.ReadValue(&token));
+}
+
+TEST(StandardReaderTest, RejectsEveryTruncation) {
+  Value inner[] = {Value::Int64(5), Value::Float64(1.0),
+                   Value::String("truncated")};
+  MapEntry entries[] = {{Value::String("key"), Value::List(inner, 3)}};
+  std::vector<uint8_t> bytes = Encode(Value::Map(entries, 1));
+  for (size_t size = 0; size < bytes.size(); size++) {
+    StandardReader reader(bytes.data(), size);
+    EXPECT_FALSE(reader.SkipValue()) << "size " << size;
+  }
+}
+
+TEST(StandardReaderTest, RejectsUnknownTypes) {
+  for (uint8_t type = 19; type < kFirstExtensionType; type++) {
+    StandardReader reader(&type, 1);
+    StandardToken token;
+    EXPECT_FALSE(reader.ReadValue(&token)) << "type " << int{type};
+  }
+}
+
+TEST(StandardReaderTest, RejectsSizesPastTheEnd) {
+  const uint8_t string[] = {7, 254, 0xFF, 0xFF, 'a'};
+  StandardReader string_reader(string, sizeof(string));
+  StandardToken token;
+  EXPECT_FALSE(string_reader.ReadValue(&token));
+
+  const uint8_t data[] = {11, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+  StandardReader data_reader(data, sizeof(data));
+  EXPECT_FALSE(data_reader.ReadValue(&token));
+
+  // A list claiming more elements than the message holds.
+  const uint8_t list[] = {12, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0};
+  StandardReader list_reader(list, sizeof(list));
+  EXPECT_FALSE(list_reader.SkipValue());
+}
+
+TEST(StandardReaderTest, RejectsOverlongVarints) {
+  const uint8_t too_large[] = {0xFF, 0xFF, 0xFF, 0xFF, 0x10};
+  StandardReader large_reader(too_large, sizeof(too_large));
+  uint32_t value;
+  EXPECT_FALSE(large_reader.ReadVarint(&value));
+
+  const uint8_t unterminated[] = {0x80, 0x80};
+  StandardReader unterminated_reader(unterminated, sizeof(unterminated));
+  EXPECT_FALSE(unterminated_reader.ReadVarint(&value));
+}
+
+TEST(StandardReaderTest, ValidatesUtf8OnRequest) {
+  const uint8_t bytes[] = {7, 2, 0xC3, 0x28};
+  StandardToken token;
+  StandardReader lenient(bytes, sizeof(bytes));
+  EXPECT_TRUE(lenient.ReadValue(&token));
+  StandardReader strict(bytes, sizeof(bytes));
+  strict.set_validate_utf8(true);
+  EXPECT_FALSE(strict.ReadValue(&token));
+}
+
+TEST(StandardReaderTest, SeeksWithinTheMessage) {
+  const uint8_t bytes[] = {0, 1};
+  StandardReader reader(bytes, sizeof(bytes));
+  EXPECT_TRUE(reader.Seek(2));
+  EXPECT_FALSE(reader.HasMore());
+  EXPECT_FALSE(reader.Seek(3));
+  EXPECT_TRUE(reader.Seek(1));
+  StandardToken token;
+  ASSERT_TRUE(reader.ReadValue(&token));
+  EXPECT_EQ(token.type, StandardField::kTrue);
+}
+
+}  // namespace
+}  // namespace platzi
@@ -0,0 +1,137 @@
+#include "codec/standard_writer.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "codec/standard_message_codec.h"
+#include "codec/tensor.h"
+
+namespace platzi {
+namespace {
+
+// Values whose sizes depend on padding and on the width of their sizes.
+std::vector<Value> SizingCases() {
+  static const std::string long_string(300, 'x');
+  static const std::string huge_string(70000, 'y');
+  static const double floats[] = {1, 2, 3};
+  static const int16_t shorts[] = {1, 2, 3, 4, 5};
+  static const int64_t deltas[] = {0, 1, -1, 1ll << 60, 5};
+  static const uint32_t shape[] = {1, 5};
+  static const TensorView tensor = TensorView::Of(shorts, shape, 2);
+  static TypedDataView packed = TypedDataView::Of(deltas, 5);
+  packed.type = StandardField::kInt64DeltaData;
+  static const Value items[] = {Value::Bool(true), Value::Float64(0.5),
+                                Value::String(long_string)};
+  static const MapEntry entries[] = {
+      {Value::String("a"), Value::TypedData(TypedDataView::Of(floats, 3))},
+      {Value::Int32(1), Value::List(items, 3)},
+  };
+  return {
+      Value::Null(),
+      Value::Int64(-1),
+      Value::Float64(1.25),
+      Value::String(""),
+      Value::String(long_string),
+      Value::String(huge_string),
+      Value::TypedData(TypedDataView::Of(shorts, 5)),
+      Value::TypedData(packed),
+      Value::Tensor(&tensor),
+      Value::Map(entries, 2),
+  };
+}
+
+TEST(StandardWriterTest, SizeOfMatchesWhatIsWrittenAtEveryOffset) {
+  for (const Value& value : SizingCases()) {
+    for (size_t offset = 0; offset < 8; offset++) {
+      std::vector<uint8_t> bytes(offset);
+      StandardWriter writer(&bytes);
+      writer.WriteValue(value);
+      ASSERT_TRUE(writer.ok());
+      EXPECT_EQ(EncodedSizeOf(value, offset), bytes.size() - offset)
+          << "type " << static_cast<int>(value.type) << " at " << offset;
+    }
+  }
+}
+
+TEST(StandardWriterTest, FixedBuffersMatchGrowableOnes) {
+  for (const Value& value : SizingCases()) {
+    std::vector<uint8_t> expected;
+    ASSERT_TRUE(StandardMessageCodec::EncodeMessage(value, &expected));
+    std::vector<uint8_t> buffer(expected.size());
+    size_t size;
+    ASSERT_TRUE(StandardMessageCodec::EncodeMessage(value, buffer.data(),
+                                                    buffer.size(), &size));
+    EXPECT_EQ(size, expected.size());
+    EXPECT_EQ(buffer, expected);
+  }
+}
+
+TEST(StandardWriterTest, RefusesBuffersTooSmallWithoutWriting) {
+  for (const Value& value : SizingCases()) {
+    size_t needed = EncodedSizeOf(value);
+    std::vector<uint8_t> buffer(needed, 0xAA);
+    size_t size;
+    EXPECT_FALSE(StandardMessageCodec::EncodeMessage(value, buffer.data(),
+                                                     needed - 1, &size));
+    EXPECT_EQ(size, needed);
+    EXPECT_EQ(buffer, std::vector<uint8_t>(needed, 0xAA));
+  }
+}
+
+TEST(StandardWriterTest, FixedWritersStopAtTheEnd) {
+  uint8_t buffer[4] = {};
+  StandardWriter writer(buffer, 3);
+  writer.WriteValue(Value::Int32(7));
+  EXPECT_FALSE(writer.ok());
+  EXPECT_EQ(buffer[3], 0);
+}
+
+TEST(StandardWriterTest, SizeOfFlagsExtensionValues) {
+  static const int object = 0;
+  Value items[] = {Value::Int32(1), Value::Extension(&object)};
+  Value list = Value::List(items, 2);
+  bool holds_extension = false;
+  EncodedSizeOf(list, 0, &holds_extension);
+  EXPECT_TRUE(holds_extension);
+  EncodedSizeOf(items[0], 0, &holds_extension);
+  EXPECT_FALSE(holds_extension);
+
+  uint8_t buffer[64];
+  size_t size;
+  EXPECT_FALSE(StandardMessageCodec::EncodeMessage(list, buffer,
+                                                   sizeof(buffer), &size));
+}
+
+TEST(StandardWriterTest, WritesTreesDeeperThanTheInlineStack) {
+  // Each level is a list of the next one and its depth, so that containers
+  // close on both sides of where the stack spills.
+  const int depth = 100;
+  std::vector<Value> levels(2 * depth);
+  Value inner = Value::Null();
+  for (int i = depth - 1; i >= 0; i--) {
+    levels[2 * i] = inner;
+    levels[2 * i + 1] = Value::Int32(i);
+    inner = Value::List(&levels[2 * i], 2);
+  }
+  std::vector<uint8_t> expected;
+  for (int i = 0; i < depth; i++) {
+    expected.insert(expected.end(),
+                    {static_cast<uint8_t>(StandardField::kList), 2});
+  }
+  expected.push_back(static_cast<uint8_t>(StandardField::kNil));
+  for (int i = depth - 1; i >= 0; i--) {
+    expected.insert(expected.end(),
+                    {static_cast<uint8_t>(StandardField::kInt32),
+                     static_cast<uint8_t>(i), 0, 0, 0});
+  }
+  std::vector<uint8_t> bytes;
+  StandardWriter writer(&bytes);
+  writer.WriteValue(inner);
+  EXPECT_EQ(bytes, expected);
+  EXPECT_EQ(EncodedSizeOf(inner, 0), expected.size());
+}
+
+}  // namespace
+}  // namespace platzi
@@ -0,0 +1,245 @@
+#include "codec/streaming_reader.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "codec/standard_writer.h"
+
+namespace platzi {
+namespace {
+
+// Returns a line describing |token|, without its payload.
+std::string Describe(const StandardToken& token) {
+  std::string line = std::to_string(static_cast<int>(token.type));
+  switch (token.type) {
+    case StandardField::kNil:
+      break;
+    case StandardField::kTrue:
+    case StandardField::kFalse:
+      line += token.boolean ? " true" : " false";
+      break;
+    case StandardField::kInt32:
+      line += " " + std::to_string(token.int32);
+      break;
+    case StandardField::kInt64:
+      line += " " + std::to_string(token.int64);
+      break;
+    case StandardField::kFloat64:
+      line += " " + std::to_string(token.float64);
+      break;
+    case StandardField::kTensor:
+      line += " " + std::to_string(static_cast<int>(token.typed_data.type)) +
+              " #" + std::to_string(token.typed_data.element_count);
+      for (uint32_t i = 0; i < token.count; i++) {
+        uint32_t dimension;
+        std::memcpy(&dimension, token.payload.data + 4 * i, 4);
+        line += " " + std::to_string(dimension);
+      }
+      break;
+    default:
+      line += " #" + std::to_string(token.count);
+      break;
+  }
+  return line + "\n";
+}
+
+// Records the callbacks as text, joining the pieces of each payload.
+class RecordingHandler : public StreamingHandler {
+ public:
+  void OnValue(const StandardToken& token) override {
+    transcript += Describe(token);
+  }
+  void OnBytes(const uint8_t* bytes, size_t size, bool last) override {
+    payload.append(reinterpret_cast<const char*>(bytes), size);
+    if (last) {
+      transcript += "bytes " + payload + "\n";
+      payload.clear();
+    }
+  }
+  void OnContainerEnd() override { transcript += "end\n"; }
+
+  std::string transcript;
+  std::string payload;
+};
+
+// The transcript |RecordingHandler| should see, from a |StandardReader|.
+std::string ExpectedTranscript(const std::vector<uint8_t>& bytes) {
+  std::string transcript;
+  StandardReader reader(bytes.data(), bytes.size());
+  std::vector<uint64_t> open;
+  StandardToken token;
+  while (reader.ReadValue(&token)) {
+    // Only the streaming reader announces the length of strings.
+    if (token.type == StandardField::kString) {
+      token.count = static_cast<uint32_t>(token.string.size());
+    }
+    transcript += Describe(token);
+    uint64_t values = 0;
+    if (token.type == StandardField::kList) {
+      values = token.count;
+    } else if (token.type == StandardField::kMap) {
+      values = 2ull * token.count;
+    } else if (token.type == StandardField::kString) {
+      transcript += "bytes " + std::string(token.string) + "\n";
+    } else if (IsTypedDataField(token.type) ||
+               token.type == StandardField::kTensor) {
+      transcript += "bytes " +
+                    std::string(reinterpret_cast<const char*>(
+                                    token.typed_data.bytes),
+                                token.typed_data.byte_size()) +
+                    "\n";
+    } else if (token.type == StandardField::kInt64DeltaData) {
+      transcript += "bytes " +
+                    std::string(reinterpret_cast<const char*>(
+                                    token.payload.data),
+                                token.payload.size) +
+                    "\n";
+    }
+    if (values > 0) {
+      open.push_back(values);
+      continue;
+    }
+    if (token.type == StandardField::kList ||
+        token.type == StandardField::kMap) {
+      transcript += "end\n";
+    }
+    while (!open.empty() && --open.back() == 0) {
+      open.pop_back();
+      transcript += "end\n";
+    }
+  }
+  return transcript;
+}
+
+std::vector<uint8_t> SampleMessage() {
+  static const double floats[] = {0.5, -2};
+  static const int64_t deltas[] = {100, 101, 99, -(1ll << 40)};
+  static const uint8_t large[300] = {1, 2, 3};
+  static const Value empty[1];
+  static const int16_t elements[] = {1, -2, 3, -4, 5, -6};
+  static const uint32_t shape[] = {2, 3};
+  static const TensorView tensor = TensorView::Of(elements, shape, 2);
+  static const TensorView scalar = TensorView::Of(elements, shape, 0);
+  static const Value inner[] = {
+      Value::Float64(3.25),
+      Value::TypedData(TypedDataView::Of(floats, 2)),
+      Value::List(empty, 0),
+      Value::Tensor(&tensor),
+      Value::TypedData(TypedDataView::Of(large, 300)),
+      Value::Tensor(&scalar),
+      Value::Null(),
+  };
+  static TypedDataView packed = TypedDataView::Of(deltas, 4);
+  packed.type = StandardField::kInt64DeltaData;
+  static const MapEntry entries[] = {
+      {Value::String("inner"), Value::List(inner, 7)},
+      {Value::Int32(-3), Value::Int64(1ll << 33)},
+      {Value::Bool(true), Value::String("")},
+      {Value::String("deltas"), Value::TypedData(packed)},
+  };
+  std::vector<uint8_t> bytes;
+  StandardWriter writer(&bytes);
+  writer.WriteValue(Value::Map(entries, 4));
+  return bytes;
+}
+
+TEST(StreamingReaderTest, MatchesStandardReaderWhole) {
+  std::vector<uint8_t> bytes = SampleMessage();
+  RecordingHandler handler;
+  StreamingReader reader(&handler);
+  ASSERT_TRUE(reader.Feed(bytes.data(), bytes.size()));
+  EXPECT_TRUE(reader.AtValueBoundary());
+  EXPECT_EQ(handler.transcript, ExpectedTranscript(bytes));
+}
+
+TEST(StreamingReaderTest, MatchesStandardReaderInChunksOfEverySize) {
+  std::vector<uint8_t> bytes = SampleMessage();
+  std::string expected = ExpectedTranscript(bytes);
+  for (size_t chunk = 1; chunk <= 17; chunk++) {
+    RecordingHandler handler;
+    StreamingReader reader(&handler);
+    for (size_t i = 0; i < bytes.size(); i += chunk) {
+      EXPECT_EQ(reader.AtValueBoundary(), i == 0);
+      size_t size = std::min(chunk, bytes.size() - i);
+      ASSERT_TRUE(reader.Feed(bytes.data() + i, size));
+    }
+    EXPECT_TRUE(reader.AtValueBoundary()) << "chunk " << chunk;
+    EXPECT_EQ(handler.transcript, expected) << "chunk " << chunk;
+  }
+}
+
+TEST(StreamingReaderTest, AlignsRelativeToTheFirstByteAfterReset) {
+  std::vector<uint8_t> bytes;
+  StandardWriter writer(&bytes);
+  writer.WriteValue(Value::Float64(1.5));
+  RecordingHandler handler;
+  StreamingReader reader(&handler);
+  const uint8_t nil = 0;
+  ASSERT_TRUE(reader.Feed(&nil, 1));
+  reader.Reset();
+  handler.transcript.clear();
+  ASSERT_TRUE(reader.Feed(bytes.data(), bytes.size()));
+  EXPECT_TRUE(reader.AtValueBoundary());
+  EXPECT_EQ(handler.transcript, ExpectedTranscript(bytes));
+}
+
+TEST(StreamingReaderTest, FailsOnUnknownTypesForGood) {
+  RecordingHandler handler;
+  StreamingReader reader(&handler);
+  const uint8_t bytes[] = {12, 2, 0, 100, 0};
+  EXPECT_FALSE(reader.Feed(bytes, sizeof(bytes)));
+  EXPECT_TRUE(reader.failed());
+  const uint8_t nil = 0;
+  EXPECT_FALSE(reader.Feed(&nil, 1));
+  reader.Reset();
+  EXPECT_TRUE(reader.Feed(&nil, 1));
+}
+
+TEST(StreamingReaderTest, FailsOnMalformedTensors) {
+  constexpr uint8_t kTensor = static_cast<uint8_t>(StandardField::kTensor);
+  constexpr uint8_t kFloat32 =
+      static_cast<uint8_t>(StandardField::kFloat32Data);
+  const std::vector<std::vector<uint8_t>> malformed = {
+      // Not a typed data element type.
+      {kTensor, static_cast<uint8_t>(StandardField::kString), 0},
+      // Beyond the maximum rank.
+      {kTensor, kFloat32, kMaxTensorRank + 1},
+      // 2^16 x 2^16 elements, more than a list can hold, after a byte of
+      // padding.
+      {kTensor, kFloat32, 2, 0, 0, 0, 1, 0, 0, 0, 1, 0},
+  };
+  for (const std::vector<uint8_t>& bytes : malformed) {
+    RecordingHandler handler;
+    StreamingReader reader(&handler);
+    EXPECT_FALSE(reader.Feed(bytes.data(), bytes.size())) << int{bytes[1]};
+    EXPECT_TRUE(handler.transcript.empty());
+  }
+}
+
+TEST(StreamingReaderTest, FailsOnDeltaListsOfImpossibleLength) {
+  // Three elements cannot fit in two bytes of varints, nor in forty.
+  for (uint8_t length : {2, 40}) {
+    RecordingHandler handler;
+    StreamingReader reader(&handler);
+    const uint8_t bytes[] = {
+        static_cast<uint8_t>(StandardField::kInt64DeltaData), 3, length};
+    EXPECT_FALSE(reader.Feed(bytes, sizeof(bytes))) << int{length};
+  }
+}
+
+TEST(StreamingReaderTest, IsMidValueForEveryTruncation) {
+  std::vector<uint8_t> bytes = SampleMessage();
+  for (size_t size = 1; size < bytes.size(); size++) {
+    RecordingHandler handler;
+    StreamingReader reader(&handler);
+    ASSERT_TRUE(reader.Feed(bytes.data(), size));
+    EXPECT_FALSE(reader.AtValueBoundary()) << "size " << size;
+  }
+}
+
+}  // namespace
+}  // namespace platzi
@@ -0,0 +1,177 @@
+#include "codec/tensor.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+#include "codec/standard_message_codec.h"
+#include "tests/value_testing.h"
+
+namespace platzi {
+namespace {
+
+// A 4 x 5 x 3 image of int16 pixels whose value encodes their coordinates.
+struct Image {
+  static constexpr uint32_t kRows = 4;
+  static constexpr uint32_t kColumns = 5;
+  static constexpr uint32_t kChannels = 3;
+
+  int16_t pixels[kRows * kColumns * kChannels];
+  uint32_t shape[3] = {kRows, kColumns, kChannels};
+
+  Image() {
+    for (uint32_t row = 0; row < kRows; row++) {
+      for (uint32_t column = 0; column < kColumns; column++) {
+        for (uint32_t channel = 0; channel < kChannels; channel++) {
+          pixels[(row * kColumns + column) * kChannels + channel] =
+              static_cast<int16_t>(row * 100 + column * 10 + channel);
+        }
+      }
+    }
+  }
+
+  TensorView view() const { return TensorView::Of(pixels, shape, 3); }
+};
+
+const Value* RoundTrip(const TensorView& tensor,
+                       std::vector<uint8_t>* bytes,
+                       Arena* arena) {
+  EXPECT_TRUE(
+      StandardMessageCodec::EncodeMessage(Value::Tensor(&tensor), bytes));
+  return StandardMessageCodec::DecodeMessage(bytes->data(), bytes->size(),
+                                             arena);
+}
+
+TEST(TensorTest, RoundTripsContiguousTensorsAsViews) {
+  Image image;
+  TensorView tensor = image.view();
+  EXPECT_TRUE(tensor.IsContiguous());
+  EXPECT_EQ(tensor.element_count(), 60u);
+  std::vector<uint8_t> bytes;
+  Arena arena;
+  const Value* decoded = RoundTrip(tensor, &bytes, &arena);
+  ASSERT_NE(decoded, nullptr);
+  EXPECT_TRUE(ValuesEqual(Value::Tensor(&tensor), *decoded));
+  const TensorView& view = *decoded->tensor;
+  EXPECT_GE(view.data, bytes.data());
+  EXPECT_LT(view.data, bytes.data() + bytes.size());
+  const uint32_t index[] = {3, 1, 2};
+  EXPECT_EQ(view.Get<int16_t>(index), 312);
+  EXPECT_EQ(view.Flat().element_count, 60u);
+}
+
+TEST(TensorTest, SendsStridedTensorsContiguous) {
+  Image image;
+  const int64_t row = Image::kColumns * Image::kChannels * 2;
+  const int64_t column = Image::kChannels * 2;
+  // Rows 1 and 2, columns 1 to 3: a crop whose channels stay contiguous.
+  const uint32_t crop_shape[] = {2, 3, 3};
+  const int64_t crop_strides[] = {row, column, 2};
+  TensorView crop = image.view();
+  crop.data += row + column;
+  crop.shape = crop_shape;
+  crop.strides = crop_strides;
+  // Channels first: nothing contiguous at all.
+  const uint32_t planar_shape[] = {3, 4, 5};
+  const int64_t planar_strides[] = {2, row, column};
+  TensorView planar = image.view();
+  planar.shape = planar_shape;
+  planar.strides = planar_strides;
+
+  for (const TensorView& tensor : {crop, planar}) {
+    EXPECT_FALSE(tensor.IsContiguous());
+    std::vector<uint8_t> bytes;
+    Arena arena;
+    const Value* decoded = RoundTrip(tensor, &bytes, &arena);
+    ASSERT_NE(decoded, nullptr);
+    const TensorView& view = *decoded->tensor;
+    ASSERT_EQ(view.rank, 3);
+    ASSERT_EQ(std::memcmp(view.shape, tensor.shape, 3 * 4), 0);
+    EXPECT_TRUE(view.IsContiguous());
+    uint32_t index[3];
+    for (index[0] = 0; index[0] < tensor.shape[0]; index[0]++) {
+      for (index[1] = 0; index[1] < tensor.shape[1]; index[1]++) {
+        for (index[2] = 0; index[2] < tensor.shape[2]; index[2]++) {
+          ASSERT_EQ(view.Get<int16_t>(index), tensor.Get<int16_t>(index));
+        }
+      }
+    }
+  }
+  const uint32_t corner[] = {1, 2, 0};
+  EXPECT_EQ(crop.Get<int16_t>(corner), 230);
+  EXPECT_EQ(planar.Get<int16_t>(corner), 201);
+}
+
+TEST(TensorTest, IgnoresTheStridesOfSingleElementDimensions) {
+  const float elements[] = {1, 2, 3};
+  const uint32_t shape[] = {1, 3, 1};
+  const int64_t strides[] = {1000, 4, -7};
+  TensorView tensor = TensorView::Of(elements, shape, 3);
+  tensor.strides = strides;
+  EXPECT_TRUE(tensor.IsContiguous());
+  const uint32_t index[] = {0, 2, 0};
+  EXPECT_EQ(tensor.OffsetOf(index), 8);
+}
+
+TEST(TensorTest, RoundTripsScalarsAndEmptyTensors) {
+  const double scalar = 2.5;
+  const uint32_t empty_shape[] = {1000000, 0, 1000000};
+  const TensorView tensors[] = {TensorView::Of(&scalar, nullptr, 0),
+                                TensorView::Of(&scalar, empty_shape, 3)};
+  for (const TensorView& tensor : tensors) {
+    std::vector<uint8_t> bytes;
+    Arena arena;
+    const Value* decoded = RoundTrip(tensor, &bytes, &arena);
+    ASSERT_NE(decoded, nullptr) << "rank " << static_cast<int>(tensor.rank);
+    EXPECT_TRUE(ValuesEqual(Value::Tensor(&tensor), *decoded));
+    EXPECT_EQ(decoded->tensor->element_count(), tensor.element_count());
+  }
+}
+
+TEST(TensorTest, RejectsEveryTruncation) {
+  Image image;
+  TensorView tensor = image.view();
+  std::vector<uint8_t> bytes;
+  ASSERT_TRUE(
+      StandardMessageCodec::EncodeMessage(Value::Tensor(&tensor), &bytes));
+  for (size_t size = 0; size < bytes.size(); size++) {
+    Arena arena;
+    EXPECT_EQ(StandardMessageCodec::DecodeMessage(bytes.data(), size, &arena),
+              nullptr)
+        << "size " << size;
+  }
+}
+
+TEST(TensorTest, RejectsMalformedHeaders) {
+  Image image;
+  TensorView tensor = image.view();
+  std::vector<uint8_t> valid;
+  ASSERT_TRUE(
+      StandardMessageCodec::EncodeMessage(Value::Tensor(&tensor), &valid));
+  // The type byte, the dtype, the rank, a byte of padding and the shape.
+  ASSERT_EQ(valid[1], static_cast<uint8_t>(StandardField::kInt16Data));
+  ASSERT_EQ(valid[2], 3);
+
+  std::vector<std::vector<uint8_t>> malformed(6, valid);
+  malformed[0][1] = static_cast<uint8_t>(StandardField::kString);
+  malformed[1][1] = static_cast<uint8_t>(StandardField::kInt64DeltaData);
+  malformed[2][2] = kMaxTensorRank + 1;
+  // More elements than the message holds.
+  malformed[3][4] = Image::kRows + 1;
+  // Dimensions whose product overflows 64 bits.
+  for (size_t i = 4; i < 16; i++) {
+    malformed[4][i] = 0xFF;
+  }
+  // A wider dtype whose elements the message cannot hold either.
+  malformed[5][1] = static_cast<uint8_t>(StandardField::kFloat64Data);
+  for (const std::vector<uint8_t>& message : malformed) {
+    Arena arena;
+    EXPECT_EQ(StandardMessageCodec::DecodeMessage(message.data(),
+                                                  message.size(), &arena),
+              nullptr);
+  }
+}
+
+}  // namespace
+}  // namespace platzi
@@ -0,0 +1,102 @@
+#include "codec/typed_data.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "codec/standard_writer.h"
+#include "codec/value_decoder.h"
+#include "tests/value_testing.h"
+
+namespace platzi {
+namespace {
+
+TEST(TypedDataTest, CopiesAndSwapsElementsOfEverySize) {
+  for (uint8_t element_size : {1, 2, 4, 8}) {
+    for (size_t count = 0; count < 80; count++) {
+      std::vector<uint8_t> source(count * element_size);
+      for (size_t i = 0; i < source.size(); i++) {
+        source[i] = static_cast<uint8_t>(i * 31 + 7);
+      }
+      std::vector<uint8_t> expected = source;
+      for (size_t i = 0; i < count; i++) {
+        std::reverse(expected.begin() + i * element_size,
+                     expected.begin() + (i + 1) * element_size);
+      }
+      ByteOrder foreign = NeedsByteSwap(ByteOrder::kBigEndian)
+                              ? ByteOrder::kBigEndian
+                              : ByteOrder::kLittleEndian;
+      // Unaligned on purpose.
+      std::vector<uint8_t> destination(source.size() + 1);
+      CopyElements(source.data(), count, element_size, foreign,
+                   destination.data() + 1);
+      EXPECT_TRUE(std::equal(expected.begin(), expected.end(),
+                             destination.begin() + 1))
+          << int{element_size} << " x " << count;
+      CopyElements(source.data(), count, element_size, ByteOrder::kNative,
+                   destination.data());
+      EXPECT_TRUE(
+          std::equal(source.begin(), source.end(), destination.begin()));
+    }
+  }
+}
+
+TEST(TypedDataTest, RoundTripsEveryElementType) {
+  const float floats[] = {1.5f, -0.0f, 3e38f};
+  const int16_t shorts[] = {-32768, 0, 32767};
+  const uint16_t ushorts[] = {0, 1, 65535};
+  const int64_t longs[] = {-1, 1ll << 62};
+  Value list[] = {
+      Value::TypedData(TypedDataView::Of(floats, 3)),
+      Value::TypedData(TypedDataView::Of(shorts, 3)),
+      Value::TypedData(TypedDataView::Of(ushorts, 3)),
+      Value::TypedData(TypedDataView::Of(longs, 2)),
+  };
+  std::vector<uint8_t> bytes;
+  StandardWriter writer(&bytes);
+  writer.WriteValue(Value::List(list, 4));
+  Arena arena;
+  const Value* decoded = DecodeMessage(bytes.data(), bytes.size(), &arena);
+  ASSERT_NE(decoded, nullptr);
+  EXPECT_TRUE(ValuesEqual(Value::List(list, 4), *decoded));
+  EXPECT_EQ(decoded->list[0].typed_data.Get<float>(2), 3e38f);
+  EXPECT_EQ(decoded->list[1].typed_data.Get<int16_t>(0), -32768);
+}
+
+TEST(TypedDataTest, WritesForeignOrderElementsInNativeOrder) {
+  const uint8_t big_endian[] = {0x12, 0x34, 0x56, 0x78};
+  TypedDataView view;
+  view.type = StandardField::kUInt16Data;
+  view.bytes = big_endian;
+  view.element_count = 2;
+  view.element_size = 2;
+  std::vector<uint8_t> bytes;
+  StandardWriter writer(&bytes);
+  writer.WriteByte(static_cast<uint8_t>(view.type));
+  writer.WriteTypedData(view, ByteOrder::kBigEndian);
+
+  StandardReader reader(bytes.data(), bytes.size());
+  StandardToken token;
+  ASSERT_TRUE(reader.ReadValue(&token));
+  EXPECT_EQ(token.typed_data.Get<uint16_t>(0), 0x1234);
+  EXPECT_EQ(token.typed_data.Get<uint16_t>(1), 0x5678);
+}
+
+TEST(TypedDataTest, RejectsElementsPastTheEnd) {
+  // Two Float32 elements claimed, one present.
+  const uint8_t bytes[] = {static_cast<uint8_t>(StandardField::kFloat32Data),
+                           2, 0, 0, 0, 0, 0x80, 0x3F};
+  StandardReader reader(bytes, sizeof(bytes));
+  StandardToken token;
+  EXPECT_FALSE(reader.ReadValue(&token));
+
+  // The padding before the elements is missing.
+  const uint8_t padding[] = {static_cast<uint8_t>(StandardField::kInt32Data),
+                             1, 0};
+  StandardReader padding_reader(padding, sizeof(padding));
+  EXPECT_FALSE(padding_reader.ReadValue(&token));
+}
+
+}  // namespace
+}  // namespace platzi
@@ -0,0 +1,154 @@
+#include "codec/utf8.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+namespace platzi {
+namespace {
+
+// Encodes |code_points| the slow and obvious way.
+std::string ReferenceUtf8(const std::vector<char32_t>& code_points) {
+  std::string result;
+  for (char32_t c : code_points) {
+    if (c < 0x80) {
+      result += static_cast<char>(c);
+    } else if (c < 0x800) {
+      result += static_cast<char>(0xC0 | (c >> 6));
+      result += static_cast<char>(0x80 | (c & 0x3F));
+    } else if (c < 0x10000) {
+      result += static_cast<char>(0xE0 | (c >> 12));
+      result += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+      result += static_cast<char>(0x80 | (c & 0x3F));
+    } else {
+      result += static_cast<char>(0xF0 | (c >> 18));
+      result += static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+      result += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+      result += static_cast<char>(0x80 | (c & 0x3F));
+    }
+  }
+  return result;
+}
+
+std::u16string ReferenceUtf16(const std::vector<char32_t>& code_points) {
+  std::u16string result;
+  for (char32_t c : code_points) {
+    if (c < 0x10000) {
+      result += static_cast<char16_t>(c);
+    } else {
+      result += static_cast<char16_t>(0xD800 + ((c - 0x10000) >> 10));
+      result += static_cast<char16_t>(0xDC00 + ((c - 0x10000) & 0x3FF));
+    }
+  }
+  return result;
+}
+
+// Text long enough for the vector kernels, cycling through |alphabet|.
+std::vector<char32_t> Text(const std::vector<char32_t>& alphabet,
+                           size_t length) {
+  std::vector<char32_t> text;
+  for (size_t i = 0; i < length; i++) {
+    text.push_back(alphabet[(i * 7 + i / 3) % alphabet.size()]);
+  }
+  return text;
+}
+
+const uint8_t* Bytes(const std::string& string) {
+  return reinterpret_cast<const uint8_t*>(string.data());
+}
+
+void ExpectRoundTrip(const std::vector<char32_t>& text) {
+  std::string utf8 = ReferenceUtf8(text);
+  std::u16string utf16 = ReferenceUtf16(text);
+
+  EXPECT_TRUE(ValidateUtf8(Bytes(utf8), utf8.size()));
+  std::u16string decoded;
+  ASSERT_TRUE(Utf8ToUtf16(Bytes(utf8), utf8.size(), &decoded));
+  EXPECT_EQ(decoded, utf16);
+
+  ASSERT_EQ(Utf8LengthOfUtf16(utf16.data(), utf16.size()), utf8.size());
+  std::string encoded(utf8.size(), '\0');
+  size_t written = Utf16ToUtf8(
+      utf16.data(), utf16.size(), reinterpret_cast<uint8_t*>(&encoded[0]));
+  EXPECT_EQ(written, utf8.size());
+  EXPECT_EQ(encoded, utf8);
+}
+
+TEST(Utf8Test, RoundTripsEveryWidthAtEveryLength) {
+  const std::vector<std::vector<char32_t>> alphabets = {
+      {'a', 'b', 'z', '0', ' '},
+      {U'é', U'ß', U'Ж', U'ѣ', 0x7FF},
+      {U'日', U'本', 0x800, 0xFFFD, 0xFFFF},
+      {0x1F600, 0x10000, 0x10FFFF},
+      {'a', U'é', U'日', 0x1F600},
+      // Mostly ASCII, with the odd accented letter.
+      {'a', 'b', 'c', 'd', 'e', 'f', 'g', U'é'},
+  };
+  for (const std::vector<char32_t>& alphabet : alphabets) {
+    for (size_t length = 0; length < 200; length++) {
+      SCOPED_TRACE(length);
+      ExpectRoundTrip(Text(alphabet, length));
+    }
+  }
+}
+
+TEST(Utf8Test, RejectsMalformedSequencesAnywhere) {
+  const std::vector<std::string> malformed = {
+      "\x80",              // Continuation without a lead.
+      "\xC3",              // Truncated two-byte sequence.
+      "\xC0\xAF",          // Overlong slash.
+      "\xE0\x80\xAF",      // Overlong three-byte sequence.
+      "\xED\xA0\x80",      // Surrogate.
+      "\xE6\x97",          // Truncated three-byte sequence.
+      "\xF4\x90\x80\x80",  // Above U+10FFFF.
+      "\xF8\x88\x80\x80",  // Five-byte lead.
+      "\xC3\x28",          // Lead followed by ASCII.
+  };
+  std::string text = ReferenceUtf8(Text({'a', U'é', U'日'}, 100));
+  for (const std::string& bad : malformed) {
+    for (size_t at = 0; at <= text.size(); at += 13) {
+      // Only splice between code points, so that |bad| is the only error.
+      while (at < text.size() && (text[at] & 0xC0) == 0x80) {
+        at++;
+      }
+      std::string input = text.substr(0, at) + bad + text.substr(at);
+      SCOPED_TRACE(at);
+      EXPECT_FALSE(ValidateUtf8(Bytes(input), input.size()));
+      std::u16string decoded;
+      EXPECT_FALSE(Utf8ToUtf16(Bytes(input), input.size(), &decoded));
+    }
+  }
+}
+
+TEST(Utf8Test, ReplacesUnpairedSurrogates) {
+  const std::u16string inputs[] = {
+      u"a\xD800",
+      u"\xDC00z",
+      u"\xD800\xD800\xDC00",
+  };
+  const std::string expected[] = {
+      "a\xEF\xBF\xBD",
+      "\xEF\xBF\xBDz",
+      "\xEF\xBF\xBD\xF0\x90\x80\x80",
+  };
+  for (size_t i = 0; i < 3; i++) {
+    // Also surrounded by enough text for the vector kernels.
+    std::u16string padding(40, u'ж');
+    std::string padding_utf8 = ReferenceUtf8(Text({U'ж'}, 40));
+    for (bool padded : {false, true}) {
+      std::u16string input = padded ? padding + inputs[i] + padding : inputs[i];
+      std::string want =
+          padded ? padding_utf8 + expected[i] + padding_utf8 : expected[i];
+      ASSERT_EQ(Utf8LengthOfUtf16(input.data(), input.size()), want.size());
+      std::string encoded(want.size(), '\0');
+      EXPECT_EQ(Utf16ToUtf8(input.data(), input.size(),
+                            reinterpret_cast<uint8_t*>(&encoded[0])),
+                want.size());
+      EXPECT_EQ(encoded, want);
+    }
+  }
+}
+
+}  // namespace
+}  // namespace platzi
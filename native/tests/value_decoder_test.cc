@@ -0,0 +1,140 @@
+#include "codec/value_decoder.h"
+
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <vector>
+
+#include "codec/standard_writer.h"
+#include "tests/value_testing.h"
+
+namespace platzi {
+namespace {
+
+std::vector<uint8_t> Encode(const Value& value) {
+  std::vector<uint8_t> bytes;
+  StandardWriter writer(&bytes);
+  writer.WriteValue(value);
+  return bytes;
+}
+
+// A tree using every standard type, nested.
+struct Sample {
+  alignas(8) double floats[3] = {1.5, -0.0, 1e300};
+  uint8_t bytes[5] = {1, 2, 3, 4, 5};
+  Value inner[4];
+  MapEntry entries[3];
+  Value root;
+
+  Sample() {
+    inner[0] = Value::Float64(std::numeric_limits<double>::quiet_NaN());
+    inner[1] = Value::TypedData(TypedDataView::Of(bytes, 5));
+    inner[2] = Value::TypedData(TypedDataView::Of(floats, 3));
+    inner[3] = Value::List(nullptr, 0);
+    entries[0] = {Value::String("list"), Value::List(inner, 4)};
+    entries[1] = {Value::Int32(7), Value::Int64(-(1ll << 50))};
+    entries[2] = {Value::Null(), Value::Bool(false)};
+    root = Value::Map(entries, 3);
+  }
+};
+
+TEST(ValueDecoderTest, RoundTripsEveryStandardType) {
+  Sample sample;
+  std::vector<uint8_t> bytes = Encode(sample.root);
+  for (DecodeMode mode : {DecodeMode::kBorrow, DecodeMode::kCopy}) {
+    Arena arena;
+    const Value* decoded =
+        DecodeMessage(bytes.data(), bytes.size(), &arena, mode);
+    ASSERT_NE(decoded, nullptr);
+    EXPECT_TRUE(ValuesEqual(sample.root, *decoded));
+  }
+}
+
+TEST(ValueDecoderTest, DecodesHandEncodedMessage) {
+  // {"k": [1, 2.5]}, as the engine encodes it.
+  const uint8_t bytes[] = {
+      13, 1, 7, 1, 'k', 12, 2,  // The map, its key and the list.
+      3, 1, 0, 0, 0,            // An int32.
+      6, 0, 0, 0,               // A float64, padded to 16.
+      0, 0, 0, 0, 0, 0, 4, 0x40,
+  };
+  Value list[] = {Value::Int32(1), Value::Float64(2.5)};
+  MapEntry entries[] = {{Value::String("k"), Value::List(list, 2)}};
+  Arena arena;
+  const Value* decoded = DecodeMessage(bytes, sizeof(bytes), &arena);
+  ASSERT_NE(decoded, nullptr);
+  EXPECT_TRUE(ValuesEqual(Value::Map(entries, 1), *decoded));
+}
+
+TEST(ValueDecoderTest, BorrowsOrCopiesStrings) {
+  std::vector<uint8_t> bytes = {7, 3, 'a', 'b', 'c'};
+  Arena arena;
+  const Value* borrowed = DecodeMessage(bytes.data(), bytes.size(), &arena);
+  ASSERT_NE(borrowed, nullptr);
+  EXPECT_EQ(reinterpret_cast<const uint8_t*>(borrowed->string.data()),
+            bytes.data() + 2);
+
+  const Value* copied =
+      DecodeMessage(bytes.data(), bytes.size(), &arena, DecodeMode::kCopy);
+  ASSERT_NE(copied, nullptr);
+  bytes.assign(bytes.size(), 0);
+  EXPECT_EQ(copied->string, "abc");
+}
+
+TEST(ValueDecoderTest, DecodesDeepNestingWithoutRecursion) {
+  // A million nested single-element lists around a nil.
+  const size_t depth = 1000000;
+  std::vector<uint8_t> bytes;
+  for (size_t i = 0; i < depth; i++) {
+    bytes.push_back(static_cast<uint8_t>(StandardField::kList));
+    bytes.push_back(1);
+  }
+  bytes.push_back(static_cast<uint8_t>(StandardField::kNil));
+  Arena arena;
+  const Value* value = DecodeMessage(bytes.data(), bytes.size(), &arena);
+  ASSERT_NE(value, nullptr);
+  for (size_t i = 0; i < depth; i++) {
+    ASSERT_EQ(value->type, ValueType::kList);
+    value = &value->list[0];
+  }
+  EXPECT_TRUE(value->is_null());
+}
+
+TEST(ValueDecoderTest, RejectsEveryTruncation) {
+  Sample sample;
+  std::vector<uint8_t> bytes = Encode(sample.root);
+  for (size_t size = 0; size < bytes.size(); size++) {
+    Arena arena;
+    EXPECT_EQ(DecodeMessage(bytes.data(), size, &arena), nullptr)
+        << "size " << size;
+  }
+}
+
+TEST(ValueDecoderTest, RejectsTrailingBytes) {
+  const uint8_t bytes[] = {0, 0};
+  Arena arena;
+  EXPECT_EQ(DecodeMessage(bytes, sizeof(bytes), &arena), nullptr);
+  StandardReader reader(bytes, sizeof(bytes));
+  EXPECT_NE(DecodeValue(&reader, &arena), nullptr);
+  EXPECT_TRUE(reader.HasMore());
+}
+
+TEST(ValueDecoderTest, RejectsCountsLargerThanTheMessage) {
+  // Neither count can be satisfied, and neither may make the decoder
+  // allocate storage for it.
+  const uint8_t list[] = {12, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0, 0};
+  const uint8_t map[] = {13, 3, 0, 0, 0, 0, 0};
+  Arena arena;
+  EXPECT_EQ(DecodeMessage(list, sizeof(list), &arena), nullptr);
+  EXPECT_EQ(DecodeMessage(map, sizeof(map), &arena), nullptr);
+  EXPECT_LT(arena.bytes_used(), 1024u);
+}
+
+TEST(ValueDecoderTest, RejectsExtensionsWithoutARegistry) {
+  const uint8_t bytes[] = {kFirstExtensionType, 1, 42};
+  Arena arena;
+  EXPECT_EQ(DecodeMessage(bytes, sizeof(bytes), &arena), nullptr);
+}
+
+}  // namespace
+}  // namespace platzi
@@ -0,0 +1,128 @@
+#ifndef NATIVE_TESTS_VALUE_TESTING_H_
+#define NATIVE_TESTS_VALUE_TESTING_H_
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+#include "codec/tensor.h"
+#include "codec/value.h"
+
+namespace platzi {
+
+// Compares two value trees element by element. Doubles compare by their
+// bits, so NaNs and signed zeros must round-trip exactly. Typed data and
+// tensors compare by their elements, wherever they live; extension values
+// by their type and object pointer.
+inline ::testing::AssertionResult ValuesEqual(const Value& expected,
+                                              const Value& actual) {
+  if (expected.type != actual.type) {
+    return ::testing::AssertionFailure()
+           << "type " << static_cast<int>(actual.type) << ", expected "
+           << static_cast<int>(expected.type);
+  }
+  switch (expected.type) {
+    case ValueType::kNull:
+      break;
+    case ValueType::kBool:
+      if (expected.boolean != actual.boolean) {
+        return ::testing::AssertionFailure() << "bool " << actual.boolean;
+      }
+      break;
+    case ValueType::kInt32:
+      if (expected.int32 != actual.int32) {
+        return ::testing::AssertionFailure() << "int32 " << actual.int32;
+      }
+      break;
+    case ValueType::kInt64:
+      if (expected.int64 != actual.int64) {
+        return ::testing::AssertionFailure() << "int64 " << actual.int64;
+      }
+      break;
+    case ValueType::kFloat64:
+      if (std::memcmp(&expected.float64, &actual.float64, 8) != 0) {
+        return ::testing::AssertionFailure() << "float64 " << actual.float64;
+      }
+      break;
+    case ValueType::kString:
+      if (expected.string != actual.string) {
+        return ::testing::AssertionFailure()
+               << "string \"" << actual.string << "\", expected \""
+               << expected.string << "\"";
+      }
+      break;
+    case ValueType::kTypedData: {
+      const TypedDataView& a = expected.typed_data;
+      const TypedDataView& b = actual.typed_data;
+      if (a.type != b.type || a.element_count != b.element_count ||
+          a.element_size != b.element_size ||
+          (a.byte_size() > 0 &&
+           std::memcmp(a.bytes, b.bytes, a.byte_size()) != 0)) {
+        return ::testing::AssertionFailure() << "typed data differs";
+      }
+      break;
+    }
+    case ValueType::kList:
+      if (expected.list.size != actual.list.size) {
+        return ::testing::AssertionFailure()
+               << "list of " << actual.list.size << ", expected "
+               << expected.list.size;
+      }
+      for (size_t i = 0; i < expected.list.size; i++) {
+        ::testing::AssertionResult result =
+            ValuesEqual(expected.list[i], actual.list[i]);
+        if (!result) {
+          return result << " at list index " << i;
+        }
+      }
+      break;
+    case ValueType::kMap:
+      if (expected.map.size != actual.map.size) {
+        return ::testing::AssertionFailure()
+               << "map of " << actual.map.size << ", expected "
+               << expected.map.size;
+      }
+      for (size_t i = 0; i < expected.map.size; i++) {
+        ::testing::AssertionResult key =
+            ValuesEqual(expected.map[i].key, actual.map[i].key);
+        if (!key) {
+          return key << " at key " << i;
+        }
+        ::testing::AssertionResult value =
+            ValuesEqual(expected.map[i].value, actual.map[i].value);
+        if (!value) {
+          return value << " at value " << i;
+        }
+      }
+      break;
+    case ValueType::kExtension:
+      if (expected.extension.type_id != actual.extension.type_id ||
+          expected.extension.object != actual.extension.object) {
+        return ::testing::AssertionFailure() << "extension differs";
+      }
+      break;
+    case ValueType::kTensor: {
+      const TensorView& a = *expected.tensor;
+      const TensorView& b = *actual.tensor;
+      if (a.dtype != b.dtype || a.rank != b.rank ||
+          (a.rank > 0 &&
+           std::memcmp(a.shape, b.shape, a.rank * sizeof(uint32_t)) != 0)) {
+        return ::testing::AssertionFailure() << "tensor shape differs";
+      }
+      std::vector<uint8_t> a_bytes(a.byte_size());
+      std::vector<uint8_t> b_bytes(b.byte_size());
+      a.CopyContiguous(a_bytes.data());
+      b.CopyContiguous(b_bytes.data());
+      if (a_bytes != b_bytes) {
+        return ::testing::AssertionFailure() << "tensor elements differ";
+      }
+      break;
+    }
+  }
+  return ::testing::AssertionSuccess();
+}
+
+}  // namespace platzi
+
+#endif  // NATIVE_TESTS_VALUE_TESTING_H_